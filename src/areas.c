@@ -0,0 +1,156 @@
+/** @file
+ * Implementacja lasu zbiorów rozłącznych opisującego obszary graczy.
+ *
+ * @author Marcin Malejky
+ */
+
+#include <stddef.h>
+#include "areas.h"
+
+#define INITIAL_CAPACITY 64 /**< Początkowa liczba węzłów lasu. */
+
+/** @brief Zapisuje w dzienniku poprzednią wartość, jeśli las go ma.
+ * @param[in,out] a – wskaźnik na las,
+ * @param[in] kind  – rodzaj wartości,
+ * @param[in] id    – numer węzła,
+ * @param[in] old   – wartość sprzed zmiany.
+ */
+static void log_change(areas_t *a, journal_kind_t kind, uint32_t id,
+                       uint32_t old);
+
+/** @brief Podaje mniejszą z dwóch liczb.
+ * @param[in] a – pierwsza liczba,
+ * @param[in] b – druga liczba,
+ * @return Mniejsza z liczb.
+ */
+static uint64_t min(uint64_t a, uint64_t b);
+
+static void log_change(areas_t *a, journal_kind_t kind, uint32_t id,
+                       uint32_t old) {
+    if (a->journal != NULL) {
+        journal_log(a->journal, kind, id, old);
+    }
+}
+
+static uint64_t min(uint64_t a, uint64_t b) {
+    return a < b ? a : b;
+}
+
+bool areas_init(areas_t *a, page_pool_t *pool) {
+    a->size.base = NULL;
+    a->size.table = NULL;
+    a->journal = NULL;
+    if (!pages_init(&a->parent, pool, sizeof(uint32_t), INITIAL_CAPACITY, 0) ||
+        !pages_init(&a->size, pool, sizeof(uint32_t), INITIAL_CAPACITY, 0)) {
+        areas_free(a);
+        return false;
+    }
+    a->capacity = pages_count(&a->parent) * a->parent.per_page;
+    /* Węzeł zerowy opisuje puste pola. */
+    areas_set_parent(a, 0, 0);
+    areas_set_size(a, 0, 0);
+    a->count = 1;
+    return true;
+}
+
+void areas_free(areas_t *a) {
+    pages_free(&a->parent);
+    pages_free(&a->size);
+    a->count = 0;
+    a->capacity = 0;
+}
+
+void areas_clear(areas_t *a) {
+    areas_set_parent(a, 0, 0);
+    areas_set_size(a, 0, 0);
+    a->count = 1;
+}
+
+bool areas_reserve(areas_t *a, uint32_t n) {
+    if (a->capacity - a->count >= n) {
+        return true;
+    }
+    if (UINT32_MAX - a->count < n) {
+        return false;
+    }
+    uint64_t capacity = (uint64_t) a->capacity * 2;
+    if (capacity < (uint64_t) a->count + n) {
+        capacity = (uint64_t) a->count + n;
+    }
+    if (capacity > UINT32_MAX) {
+        capacity = UINT32_MAX;
+    }
+    if (!pages_grow(&a->parent, capacity, 0) ||
+        !pages_grow(&a->size, capacity, 0)) {
+        return false;
+    }
+    capacity = pages_count(&a->parent) * a->parent.per_page;
+    a->capacity = capacity < UINT32_MAX ? capacity : UINT32_MAX;
+    return true;
+}
+
+bool areas_share(areas_t *copy, areas_t *a, page_pool_t *pool) {
+    *copy = *a;
+    copy->journal = NULL;
+    copy->parent.base = NULL;
+    copy->parent.table = NULL;
+    copy->size.base = NULL;
+    copy->size.table = NULL;
+    return pages_share(&copy->parent, &a->parent, pool) &&
+           pages_share(&copy->size, &a->size, pool);
+}
+
+bool areas_prepare(areas_t *a) {
+    return pages_prepare(&a->parent) && pages_prepare(&a->size);
+}
+
+uint64_t areas_pages(const areas_t *a, uint64_t nodes) {
+    return min(nodes, pages_count(&a->parent)) +
+           min(nodes, pages_count(&a->size));
+}
+
+uint32_t areas_new(areas_t *a) {
+    uint32_t id = a->count;
+    log_change(a, JOURNAL_NODES, 0, a->count);
+    areas_set_parent(a, id, id);
+    areas_set_size(a, id, 0);
+    ++(a->count);
+    return id;
+}
+
+uint32_t areas_find(areas_t *a, uint32_t id) {
+    uint32_t root = id;
+    while (areas_parent(a, root) != root) {
+        root = areas_parent(a, root);
+    }
+    while (areas_parent(a, id) != root) {
+        uint32_t next = areas_parent(a, id);
+        /* Kompresja nie jest konieczna, więc nie kopiuje stron. */
+        if (pages_writable(&a->parent, id, sizeof(uint32_t))) {
+            log_change(a, JOURNAL_PARENT, id, next);
+            areas_set_parent(a, id, root);
+        }
+        id = next;
+    }
+    return root;
+}
+
+uint32_t areas_union(areas_t *a, uint32_t x, uint32_t y) {
+    if (x == y) {
+        return x;
+    }
+    if (areas_size(a, x) < areas_size(a, y)) {
+        uint32_t temp = x;
+        x = y;
+        y = temp;
+    }
+    log_change(a, JOURNAL_PARENT, y, areas_parent(a, y));
+    areas_set_parent(a, y, x);
+    areas_add_size(a, x, areas_size(a, y));
+    return x;
+}
+
+void areas_add_size(areas_t *a, uint32_t id, int64_t delta) {
+    log_change(a, JOURNAL_SIZE, id, areas_size(a, id));
+    areas_set_size(a, id, areas_size(a, id) + (uint32_t) delta);
+}
@@ -0,0 +1,157 @@
+/** @file
+ * Interfejs lasu zbiorów rozłącznych opisującego obszary graczy.
+ *
+ * @author Marcin Malejky
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "journal.h"
+#include "pages.h"
+
+#ifndef GAMMA_AREAS_H
+#define GAMMA_AREAS_H
+
+/**
+ * Las zbiorów rozłącznych (union-find) z kompresją ścieżek i łączeniem według
+ * rozmiaru. Każde pole planszy wskazuje na węzeł lasu, a dwa pola należą do
+ * tego samego obszaru wtedy i tylko wtedy, gdy ich węzły mają wspólny korzeń.
+ * Węzeł o numerze zero jest zarezerwowany dla pustych pól.
+ */
+typedef struct {
+    pages_t parent; /**< Tablica rodziców węzłów. */
+    pages_t size; /**< Tablica liczby pól zbioru (ważna tylko w korzeniu). */
+    uint32_t count; /**< Liczba utworzonych węzłów (następne wolne id). */
+    uint32_t capacity; /**< Liczba węzłów, na które zaalokowano pamięć. */
+    journal_t *journal; /**< Dziennik, w którym są zapisywane zmiany, lub
+                          *  NULL. */
+} areas_t;
+
+/** @brief Inicjalizuje pusty las bez dziennika zmian.
+ * @param[out] a   – wskaźnik na inicjalizowany las,
+ * @param[in] pool – pula stron do kopiowania współdzielonych stron,
+ * @return Wartość @p true, jeśli pomyślnie zaalokowano pamięć, a @p false
+ * w przeciwnym przypadku.
+ */
+bool areas_init(areas_t *a, page_pool_t *pool);
+
+/** @brief Zwalnia pamięć lasu.
+ * @param[in,out] a – wskaźnik na las.
+ */
+void areas_free(areas_t *a);
+
+/** @brief Usuwa wszystkie węzły poza zerowym, zachowując pamięć lasu.
+ * Las nie może współdzielić stron z innym lasem.
+ * @param[in,out] a – wskaźnik na las.
+ */
+void areas_clear(areas_t *a);
+
+/** @brief Rezerwuje miejsce na nowe węzły.
+ * Zapewnia, że kolejne @p n wywołań @ref areas_new nie będzie wymagało
+ * alokacji pamięci.
+ * @param[in,out] a – wskaźnik na las,
+ * @param[in] n     – liczba rezerwowanych węzłów,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy nie udało się
+ * zaalokować pamięci.
+ */
+bool areas_reserve(areas_t *a, uint32_t n);
+
+/** @brief Tworzy las współdzielący strony z lasem @p a.
+ * Nowy las nie ma dziennika zmian. Ciągłe tablice lasu @p a są przy
+ * pierwszej kopii dzielone na strony.
+ * @param[out] copy – wskaźnik na nowy las,
+ * @param[in,out] a – wskaźnik na kopiowany las,
+ * @param[in] pool  – pula stron nowego lasu,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy nie udało się
+ * zaalokować pamięci. Wtedy nowy las trzeba zwolnić przez @ref areas_free.
+ */
+bool areas_share(areas_t *copy, areas_t *a, page_pool_t *pool);
+
+/** @brief Przygotowuje las do zmian.
+ * Kopiuje współdzielone tabele stron lasu.
+ * @param[in,out] a – wskaźnik na las,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy nie udało się
+ * zaalokować pamięci.
+ */
+bool areas_prepare(areas_t *a);
+
+/** @brief Podaje liczbę stron, które może być trzeba skopiować.
+ * @param[in] a     – wskaźnik na las,
+ * @param[in] nodes – największa liczba zmienianych węzłów,
+ * @return Ograniczenie górne liczby stron kopiowanych przy zmianie rodzica
+ * i rozmiaru tylu węzłów.
+ */
+uint64_t areas_pages(const areas_t *a, uint64_t nodes);
+
+/** @brief Tworzy nowy jednoelementowy zbiór.
+ * Wymaga wcześniejszego zarezerwowania miejsca przez @ref areas_reserve.
+ * Rozmiar nowego zbioru wynosi zero.
+ * @param[in,out] a – wskaźnik na las,
+ * @return Id nowego węzła.
+ */
+uint32_t areas_new(areas_t *a);
+
+/** @brief Podaje korzeń zbioru zawierającego węzeł @p id.
+ * Po drodze kompresuje ścieżkę do korzenia, o ile nie trzeba przy tym
+ * kopiować współdzielonych stron.
+ * @param[in,out] a – wskaźnik na las,
+ * @param[in] id    – id węzła,
+ * @return Id korzenia.
+ */
+uint32_t areas_find(areas_t *a, uint32_t id);
+
+/** @brief Łączy zbiory o korzeniach @p x i @p y.
+ * Mniejszy zbiór jest podczepiany pod większy, a rozmiary są sumowane.
+ * @param[in,out] a – wskaźnik na las,
+ * @param[in] x     – korzeń pierwszego zbioru,
+ * @param[in] y     – korzeń drugiego zbioru,
+ * @return Korzeń połączonego zbioru.
+ */
+uint32_t areas_union(areas_t *a, uint32_t x, uint32_t y);
+
+/** @brief Zmienia rozmiar zbioru o korzeniu @p id.
+ * @param[in,out] a – wskaźnik na las,
+ * @param[in] id    – korzeń zbioru,
+ * @param[in] delta – zmiana rozmiaru.
+ */
+void areas_add_size(areas_t *a, uint32_t id, int64_t delta);
+
+/** @brief Podaje rodzica węzła.
+ * @param[in] a  – wskaźnik na las,
+ * @param[in] id – id węzła,
+ * @return Id rodzica.
+ */
+static inline uint32_t areas_parent(const areas_t *a, uint32_t id) {
+    return *(const uint32_t *) pages_read(&a->parent, id, sizeof(uint32_t));
+}
+
+/** @brief Podaje rozmiar zbioru węzła.
+ * @param[in] a  – wskaźnik na las,
+ * @param[in] id – id węzła,
+ * @return Rozmiar zbioru, ważny tylko dla korzenia.
+ */
+static inline uint32_t areas_size(const areas_t *a, uint32_t id) {
+    return *(const uint32_t *) pages_read(&a->size, id, sizeof(uint32_t));
+}
+
+/** @brief Ustawia rodzica węzła bez zapisywania zmiany w dzienniku.
+ * Wymaga wcześniejszego przygotowania lasu przez @ref areas_prepare.
+ * @param[in,out] a – wskaźnik na las,
+ * @param[in] id    – id węzła,
+ * @param[in] value – id rodzica.
+ */
+static inline void areas_set_parent(areas_t *a, uint32_t id, uint32_t value) {
+    *(uint32_t *) pages_write(&a->parent, id, sizeof(uint32_t)) = value;
+}
+
+/** @brief Ustawia rozmiar zbioru węzła bez zapisywania zmiany w dzienniku.
+ * Wymaga wcześniejszego przygotowania lasu przez @ref areas_prepare.
+ * @param[in,out] a – wskaźnik na las,
+ * @param[in] id    – id węzła,
+ * @param[in] value – rozmiar.
+ */
+static inline void areas_set_size(areas_t *a, uint32_t id, uint32_t value) {
+    *(uint32_t *) pages_write(&a->size, id, sizeof(uint32_t)) = value;
+}
+
+#endif //GAMMA_AREAS_H
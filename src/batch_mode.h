@@ -6,41 +6,20 @@
 
 #include <stdint.h>
 #include "gamma.h"
+#include "input.h"
 
 #ifndef GAMMA_BATCH_MODE_H
 #define GAMMA_BATCH_MODE_H
 
 /** @brief Rozpoczyna wsadowy tryb wejścia.
  * Rozpoczyna wsadowy tryb wejścia dla gry G. LINE_NUMBER to numer poprzednio
- * przeczytanego wiersza.
+ * przeczytanego wiersza. Wyniki są zbierane w buforze i wypisywane dużymi
+ * blokami, zawsze zanim program zacznie czekać na dalsze wejście, a przed
+ * każdym komunikatem o błędzie, więc kolejność wyjścia się nie zmienia.
  * @param[in,out] g           - wskaźnik na strukturę przechowującą stan gry,
+ * @param[in,out] in          - wskaźnik na wejście,
  * @param[in,out] line_number - wskaźnik na numer poprzednio wczytanej linii,
  */
-void batch_mode(gamma_t *g, uint32_t *line_number);
-
-/** @brief Zapisuje liczbę na *X.
- * Wykonuję próbę zapisu liczby do *X na podstawie następnego słowa z wejścia.
- * Wymaga porzedniego wywołania funkcji strtok.
- * @param[out] x - wskaźnik na liczbę do zapisania.
- * @return Wartość TRUE jeżeli udało się poprawnie zapisać liczbę na *X, FALSE
- * w przeciwnym przypadku.
- */
-bool to_number(uint32_t *x);
-
-/** @brief Sprawdza, czy wiersz LINE jest komentarzem lub jest pusty.
- * @param[in] line – wiersz,
- * @return Wartość @p true, jeśli @p line jest komentarzem lub jest pustym
- * wierszem, a @p false w przeciwnym przypadku.
- */
-bool omit(char *line);
-
-/** @brief Sprawdza, czy wiersz LINE składa się z poprawnych znaków.
- * Sprawdza, czy wiersz LINE o długości SIZE składa się z poprawnych znaków.
- * @param[in] line – wiersz,
- * @param[in] size – rozmiar wiersza,
- * @return Wartość TRUE, jeśli wiersz LINE składa się z poprawnych znaków,
- * a FALSE w przeciwnym przypadku.
- */
-bool correct_chars(char *line, ssize_t size);
+void batch_mode(gamma_t *g, input_t *in, uint32_t *line_number);
 
 #endif //GAMMA_BATCH_MODE_H
@@ -0,0 +1,131 @@
+/** @file
+ * Implementacja binarnego trybu wsadowego gry gamma.
+ *
+ * @author Marcin Malejky
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include "binary_mode.h"
+#include "mcts.h"
+
+/** @brief Odczytuje liczbę 32-bitową zapisaną w kolejności little-endian.
+ * @param[in] p – wskaźnik na pierwszy bajt liczby,
+ * @return Liczba.
+ */
+static uint32_t get32(const char *p);
+
+/** @brief Zapisuje liczbę 32-bitową w kolejności little-endian.
+ * @param[out] p    – wskaźnik na pierwszy bajt liczby,
+ * @param[in] value – liczba.
+ */
+static void put32(char *p, uint32_t value);
+
+/** @brief Zapisuje liczbę 64-bitową w kolejności little-endian.
+ * @param[out] p    – wskaźnik na pierwszy bajt liczby,
+ * @param[in] value – liczba.
+ */
+static void put64(char *p, uint64_t value);
+
+/** @brief Wykonuje polecenie z rekordu.
+ * @param[in,out] g    – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] record   – rekord polecenia,
+ * @param[out] result  – rekord wyniku bez numeru rekordu polecenia,
+ * @return Wartość @p true, jeśli rekord jest poprawny, a @p false
+ * w przeciwnym przypadku.
+ */
+static bool execute(gamma_t *g, const char *record, char *result);
+
+static uint32_t get32(const char *p) {
+    const unsigned char *u = (const unsigned char *) p;
+    return (uint32_t) u[0] | (uint32_t) u[1] << 8 | (uint32_t) u[2] << 16 |
+           (uint32_t) u[3] << 24;
+}
+
+static void put32(char *p, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        p[i] = (char) (value >> (8 * i));
+    }
+}
+
+static void put64(char *p, uint64_t value) {
+    put32(p, (uint32_t) value);
+    put32(p + 4, (uint32_t) (value >> 32));
+}
+
+static bool execute(gamma_t *g, const char *record, char *result) {
+    if (record[1] != 0 || record[2] != 0 || record[3] != 0) {
+        return false;
+    }
+    uint32_t player = get32(record + 4);
+    uint32_t x = get32(record + 8);
+    uint32_t y = get32(record + 12);
+    uint64_t value;
+    result[0] = record[0];
+    switch (record[0]) {
+        case 'm':
+            value = gamma_move(g, player, x, y);
+            break;
+        case 'g':
+            value = gamma_golden_move(g, player, x, y);
+            break;
+        case 'b':
+            value = gamma_busy_fields(g, player);
+            break;
+        case 'f':
+            value = gamma_free_fields(g, player);
+            break;
+        case 'q':
+            value = gamma_golden_possible(g, player);
+            break;
+        case 'A': {
+            mcts_config_t config;
+            mcts_defaults(&config);
+            config.budget_ms = x;
+            playout_stat_t move;
+            if (mcts_move(g, player, &config, &move, NULL)) {
+                result[0] = move.golden ? 'g' : 'm';
+                value = move.field.x | (uint64_t) move.field.y << 32;
+            } else {
+                result[0] = 0;
+                value = 0;
+            }
+            break;
+        }
+        default:
+            return false;
+    }
+    put64(result + 8, value);
+    return true;
+}
+
+void binary_mode(gamma_t *g, input_t *in) {
+    fflush(stdout);
+    output_t out;
+    output_init(&out, STDOUT_FILENO, OUTPUT_CAPACITY);
+    in->flush = &out;
+
+    uint32_t index = 0;
+    char result[BINARY_RECORD] = {0};
+    const char *records;
+    size_t count;
+    while ((count = input_records(in, BINARY_RECORD, &records)) > 0) {
+        for (size_t i = 0; i < count; ++i) {
+            ++index;
+            if (execute(g, records + i * BINARY_RECORD, result)) {
+                put32(result + 4, index);
+                output_write(&out, result, BINARY_RECORD);
+            } else {
+                output_flush(&out);
+                fprintf(stderr, "ERROR %d\n", index);
+            }
+        }
+    }
+    if (in->end > in->start) {
+        output_flush(&out);
+        fprintf(stderr, "ERROR %d\n", index + 1);
+    }
+
+    in->flush = NULL;
+    output_free(&out);
+}
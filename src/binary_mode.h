@@ -0,0 +1,47 @@
+/** @file
+ * Interfejs binarnego trybu wsadowego gry gamma.
+ *
+ * Tryb jest wybierany wierszem @p X @p width @p height @p players @p areas.
+ * Po nim na wejściu są już tylko rekordy poleceń, a na wyjściu rekordy
+ * wyników. Wszystkie liczby są zapisane w kolejności little-endian.
+ *
+ * Rekord polecenia ma 16 bajtów:
+ * - bajt 0: litera polecenia @p m, @p g, @p b, @p f, @p q lub @p A,
+ * - bajty 1-3: zera,
+ * - bajty 4-7: numer gracza,
+ * - bajty 8-11: numer kolumny, a dla @p A czas przeszukiwania w ms,
+ * - bajty 12-15: numer wiersza.
+ * Nieużywane argumenty są pomijane.
+ *
+ * Rekord wyniku ma 16 bajtów:
+ * - bajt 0: litera polecenia, a dla @p A litera wykonanego ruchu @p m lub
+ *   @p g albo 0, gdy ruchu nie wykonano,
+ * - bajty 1-3: zera,
+ * - bajty 4-7: numer rekordu polecenia,
+ * - bajty 8-15: wynik: 0 lub 1 dla @p m, @p g i @p q, liczba pól dla @p b
+ *   i @p f, a dla @p A numer kolumny ruchu w bajtach 8-11 i numer wiersza
+ *   w bajtach 12-15.
+ *
+ * Rekordy poleceń są numerowane od 1. Dla niepoprawnego rekordu, także dla
+ * niepełnego rekordu na końcu wejścia, zamiast wyniku na standardowe wyjście
+ * diagnostyczne jest wypisywany wiersz @p ERROR z numerem rekordu.
+ *
+ * @author Marcin Malejky
+ */
+
+#include <stdint.h>
+#include "gamma.h"
+#include "input.h"
+
+#ifndef GAMMA_BINARY_MODE_H
+#define GAMMA_BINARY_MODE_H
+
+#define BINARY_RECORD 16 /**< Długość rekordu polecenia i rekordu wyniku. */
+
+/** @brief Rozpoczyna binarny tryb wsadowy.
+ * @param[in,out] g  - wskaźnik na strukturę przechowującą stan gry,
+ * @param[in,out] in - wskaźnik na wejście, na którym zaczynają się rekordy,
+ */
+void binary_mode(gamma_t *g, input_t *in);
+
+#endif //GAMMA_BINARY_MODE_H
@@ -0,0 +1,301 @@
+/** @file
+ * Implementacja planszy gry gamma.
+ *
+ * @author Marcin Malejky
+ */
+
+#include <stddef.h>
+#include "board.h"
+
+#define CACHE_LINE 64 /**< Rozmiar linii pamięci podręcznej w bajtach. */
+
+/** @brief Zaokrągla liczbę w górę do wielokrotności rozmiaru linii.
+ * @param[in] n – liczba,
+ * @return Najmniejsza wielokrotność @ref CACHE_LINE niemniejsza od @p n.
+ */
+static uint64_t round_up(uint64_t n);
+
+/** @brief Przygotowuje tablice posiadaczy i węzłów obszarów.
+ * @param[in,out] b   – wskaźnik na planszę z ustalonymi wymiarami,
+ * @param[in] players – liczba graczy,
+ * @param[in] pool    – pula stron planszy,
+ * @return Wartość @p true, jeśli pomyślnie zaalokowano pamięć, a @p false
+ * w przeciwnym przypadku.
+ */
+static bool init_array(board_t *b, uint32_t players, page_pool_t *pool);
+
+/** @brief Przygotowuje płaszczyzny bitowe i rzadką tablicę węzłów obszarów.
+ * @param[in,out] b   – wskaźnik na planszę z ustalonymi wymiarami,
+ * @param[in] players – liczba graczy,
+ * @param[in] pool    – pula stron planszy,
+ * @return Wartość @p true, jeśli pomyślnie zaalokowano pamięć, a @p false
+ * w przeciwnym przypadku.
+ */
+static bool init_planes(board_t *b, uint32_t players, page_pool_t *pool);
+
+/** @brief Zeruje bity pól planszy we wszystkich płaszczyznach.
+ * Bity ramki pozostają ustawione.
+ * @param[in,out] b – wskaźnik na planszę w wariancie
+ *                    @ref BOARD_BACKEND_BIT_PLANES.
+ */
+static void clear_planes(board_t *b);
+
+/** @brief Podaje mniejszą z dwóch liczb.
+ * @param[in] a – pierwsza liczba,
+ * @param[in] b – druga liczba,
+ * @return Mniejsza z liczb.
+ */
+static uint64_t min(uint64_t a, uint64_t b);
+
+/** @brief Podaje słowo pól gracza lub zero dla słów spoza planszy.
+ * @param[in] b      – wskaźnik na planszę,
+ * @param[in] player – numer gracza,
+ * @param[in] word   – numer słowa, być może ujemny,
+ * @return Słowo jak dla @ref board_owned_word.
+ */
+static uint64_t owned_or_zero(const board_t *b, uint32_t player, int64_t word);
+
+/** @brief Podaje słowo pól gracza przesunięte o @p shift pól.
+ * @param[in] b      – wskaźnik na planszę,
+ * @param[in] player – numer gracza,
+ * @param[in] word   – numer słowa,
+ * @param[in] shift  – przesunięcie numeru pola,
+ * @return Słowo, którego bit @p i jest ustawiony, gdy pole
+ * @p BOARD_WORD_BITS * @p word + @p i + @p shift należy do gracza.
+ */
+static uint64_t owned_shifted(const board_t *b, uint32_t player, uint64_t word,
+                              int64_t shift);
+
+static uint64_t round_up(uint64_t n) {
+    return (n + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+}
+
+static uint64_t min(uint64_t a, uint64_t b) {
+    return a < b ? a : b;
+}
+
+static bool init_array(board_t *b, uint32_t players, page_pool_t *pool) {
+    if (players < UINT8_MAX) {
+        b->owner_size = sizeof(uint8_t);
+        b->border = UINT8_MAX;
+    } else if (players < UINT16_MAX) {
+        b->owner_size = sizeof(uint16_t);
+        b->border = UINT16_MAX;
+    } else {
+        b->owner_size = sizeof(uint32_t);
+        b->border = UINT32_MAX;
+    }
+    /* Numer ramki ma wszystkie bajty równe 0xFF. */
+    if (!pages_init(&b->owner, pool, b->owner_size, b->size, 0xFF) ||
+        !pages_init(&b->area_id, pool, sizeof(uint32_t), b->size, 0)) {
+        return false;
+    }
+    for (uint32_t y = 0; y < b->height; ++y) {
+        uint32_t first = board_field(b, 0, y);
+        for (uint32_t field = first; field < first + b->width; ++field) {
+            board_set_owner(b, field, 0);
+        }
+    }
+    return true;
+}
+
+static bool init_planes(board_t *b, uint32_t players, page_pool_t *pool) {
+    /* Ramka ma wszystkie bity ustawione, więc jej numer musi być większy od
+     * numerów graczy. */
+    b->planes = 0;
+    while (((uint64_t) players + 1) >> b->planes) {
+        ++(b->planes);
+    }
+    b->owner_size = 0;
+    b->border = (uint32_t) ((UINT64_C(1) << b->planes) - 1);
+    b->plane_words = round_up(b->words * sizeof(uint64_t)) / sizeof(uint64_t);
+    /* Bity za ostatnim polem też należą do ramki. */
+    if (!fieldmap_init(&b->area_map) ||
+        !pages_init(&b->owner, pool, sizeof(uint64_t),
+                    b->planes * b->plane_words, 0xFF)) {
+        return false;
+    }
+    clear_planes(b);
+    return true;
+}
+
+static void clear_planes(board_t *b) {
+    for (uint32_t y = 0; y < b->height; ++y) {
+        uint64_t first = board_field(b, 0, y);
+        uint64_t end = first + b->width;
+        while (first < end) {
+            uint64_t word = first / BOARD_WORD_BITS;
+            uint32_t bit = first % BOARD_WORD_BITS;
+            uint64_t count = end - first;
+            if (count > BOARD_WORD_BITS - bit) {
+                count = BOARD_WORD_BITS - bit;
+            }
+            uint64_t mask = count == BOARD_WORD_BITS
+                            ? UINT64_MAX
+                            : ((UINT64_C(1) << count) - 1) << bit;
+            for (uint32_t k = 0; k < b->planes; ++k) {
+                uint64_t *bits = pages_write(&b->owner,
+                                             k * b->plane_words + word,
+                                             sizeof(uint64_t));
+                *bits &= ~mask;
+            }
+            first += count;
+        }
+    }
+}
+
+bool board_init(board_t *b, uint32_t width, uint32_t height,
+                uint32_t players, board_backend_t backend, page_pool_t *pool) {
+    b->owner.base = NULL;
+    b->owner.table = NULL;
+    b->area_id.base = NULL;
+    b->area_id.table = NULL;
+    b->area_map.keys = NULL;
+    b->area_map.values = NULL;
+    uint64_t stride = (uint64_t) width + 2;
+    uint64_t size = stride * ((uint64_t) height + 2);
+    if (size > UINT32_MAX || players == UINT32_MAX) {
+        return false;
+    }
+    b->backend = backend;
+    b->width = width;
+    b->height = height;
+    b->stride = stride;
+    b->size = size;
+    b->side[0] = UINT32_MAX;
+    b->side[1] = 1;
+    b->side[2] = -b->stride;
+    b->side[3] = b->stride;
+    b->planes = 0;
+    b->words = ((uint64_t) size + BOARD_WORD_BITS - 1) / BOARD_WORD_BITS;
+    b->plane_words = 0;
+
+    bool ok = backend == BOARD_BACKEND_BIT_PLANES
+              ? init_planes(b, players, pool)
+              : init_array(b, players, pool);
+    if (!ok) {
+        board_free(b);
+    }
+    return ok;
+}
+
+void board_free(board_t *b) {
+    pages_free(&b->owner);
+    pages_free(&b->area_id);
+    fieldmap_free(&b->area_map);
+}
+
+void board_clear(board_t *b) {
+    if (b->backend == BOARD_BACKEND_BIT_PLANES) {
+        fieldmap_clear(&b->area_map);
+        clear_planes(b);
+        return;
+    }
+    for (uint32_t y = 0; y < b->height; ++y) {
+        uint32_t first = board_field(b, 0, y);
+        for (uint32_t field = first; field < first + b->width; ++field) {
+            board_set_owner(b, field, 0);
+            board_set_area_id(b, field, 0);
+        }
+    }
+}
+
+bool board_reserve(board_t *b, uint32_t n) {
+    return b->backend == BOARD_BACKEND_ARRAY ||
+           fieldmap_reserve(&b->area_map, n);
+}
+
+bool board_share(board_t *copy, board_t *b, page_pool_t *pool) {
+    *copy = *b;
+    copy->owner.base = NULL;
+    copy->owner.table = NULL;
+    copy->area_id.base = NULL;
+    copy->area_id.table = NULL;
+    copy->area_map.keys = NULL;
+    copy->area_map.values = NULL;
+    if (b->backend == BOARD_BACKEND_BIT_PLANES) {
+        return fieldmap_copy(&copy->area_map, &b->area_map) &&
+               pages_share(&copy->owner, &b->owner, pool);
+    }
+    return pages_share(&copy->owner, &b->owner, pool) &&
+           pages_share(&copy->area_id, &b->area_id, pool);
+}
+
+bool board_prepare(board_t *b) {
+    return pages_prepare(&b->owner) &&
+           (b->backend != BOARD_BACKEND_ARRAY || pages_prepare(&b->area_id));
+}
+
+uint64_t board_pages(const board_t *b, uint64_t owners, uint64_t ids) {
+    /* Posiadacz pola zapisanego w płaszczyznach zajmuje słowo w każdej. */
+    uint64_t words = b->planes > 0 ? b->planes : 1;
+    uint64_t pages = min(owners * words, pages_count(&b->owner));
+    if (b->backend == BOARD_BACKEND_ARRAY) {
+        pages += min(ids, pages_count(&b->area_id));
+    }
+    return pages;
+}
+
+uint64_t board_owned_word(const board_t *b, uint32_t player, uint64_t word) {
+    if (b->owner_size == 0) {
+        uint64_t mask = UINT64_MAX;
+        for (uint32_t k = 0; k < b->planes; ++k) {
+            uint64_t bits = *(const uint64_t *) pages_read(
+                    &b->owner, k * b->plane_words + word, sizeof(uint64_t));
+            mask &= player >> k & 1 ? bits : ~bits;
+        }
+        return mask;
+    }
+    uint64_t mask = 0;
+    uint64_t first = word * BOARD_WORD_BITS;
+    for (uint32_t i = 0; i < BOARD_WORD_BITS && first + i < b->size; ++i) {
+        if (board_owner(b, first + i) == player) {
+            mask |= UINT64_C(1) << i;
+        }
+    }
+    return mask;
+}
+
+static uint64_t owned_or_zero(const board_t *b, uint32_t player, int64_t word) {
+    if (word < 0 || (uint64_t) word >= b->words) {
+        return 0;
+    }
+    return board_owned_word(b, player, word);
+}
+
+static uint64_t owned_shifted(const board_t *b, uint32_t player, uint64_t word,
+                              int64_t shift) {
+    int64_t first = (int64_t) word * BOARD_WORD_BITS + shift;
+    /* Dzielenie z zaokrągleniem w dół także dla ujemnych pól. */
+    int64_t low = first >= 0 ? first / BOARD_WORD_BITS
+                             : -((-first + BOARD_WORD_BITS - 1) /
+                                 BOARD_WORD_BITS);
+    uint32_t bit = first - low * BOARD_WORD_BITS;
+    uint64_t mask = owned_or_zero(b, player, low) >> bit;
+    if (bit > 0) {
+        mask |= owned_or_zero(b, player, low + 1) << (BOARD_WORD_BITS - bit);
+    }
+    return mask;
+}
+
+uint64_t board_adjacent_word(const board_t *b, uint32_t player,
+                             uint64_t word) {
+    if (b->owner_size == 0) {
+        return owned_shifted(b, player, word, -1) |
+               owned_shifted(b, player, word, 1) |
+               owned_shifted(b, player, word, -(int64_t) b->stride) |
+               owned_shifted(b, player, word, b->stride);
+    }
+    uint64_t mask = 0;
+    uint64_t first = word * BOARD_WORD_BITS;
+    for (uint32_t i = 0; i < BOARD_WORD_BITS && first + i < b->size; ++i) {
+        for (uint32_t j = 0; j < BOARD_SIDES; ++j) {
+            uint32_t neighbour = first + i + b->side[j];
+            if (neighbour < b->size && board_owner(b, neighbour) == player) {
+                mask |= UINT64_C(1) << i;
+                break;
+            }
+        }
+    }
+    return mask;
+}
@@ -0,0 +1,294 @@
+/** @file
+ * Interfejs planszy gry gamma.
+ *
+ * @author Marcin Malejky
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "fieldmap.h"
+#include "pages.h"
+
+#ifndef GAMMA_BOARD_H
+#define GAMMA_BOARD_H
+
+#define BOARD_SIDES 4 /**< Liczba boków pola. */
+#define BOARD_WORD_BITS 64 /**< Liczba pól w jednym słowie płaszczyzny. */
+
+/**
+ * Sposób przechowywania planszy.
+ */
+typedef enum {
+    /** Tablice posiadaczy i węzłów obszarów wszystkich pól. */
+    BOARD_BACKEND_ARRAY,
+    /** Płaszczyzny bitowe posiadaczy i węzły obszarów tylko zajętych pól. */
+    BOARD_BACKEND_BIT_PLANES
+} board_backend_t;
+
+/**
+ * Plansza przechowywana w tablicach, które mogą być podzielone na strony.
+ * Pola są numerowane wierszami, a plansza jest otoczona ramką o szerokości
+ * jednego pola, której posiadaczem jest @ref board_t.border. Dzięki temu każde
+ * pole planszy ma czterech sąsiadów i sprawdzanie sąsiadów nie wymaga
+ * sprawdzania zakresu.
+ *
+ * W wariancie @ref BOARD_BACKEND_ARRAY posiadacze pól są zapisani w osobnej
+ * tablicy liczb o najmniejszej szerokości mieszczącej numery graczy, a id
+ * obszarów w drugiej tablicy.
+ *
+ * W wariancie @ref BOARD_BACKEND_BIT_PLANES bit @p k numeru posiadacza pola
+ * jest bitem płaszczyzny @p k, a ramka ma wszystkie bity ustawione. Plansza
+ * dwóch graczy zajmuje więc dwa bity na pole, a id obszarów są trzymane
+ * w rzadkiej tablicy tylko dla zajętych pól.
+ *
+ * Dopóki gra nie ma kopii, tablice są ciągłymi blokami pamięci. Pierwsza
+ * kopia dzieli je na strony, które są współdzielone między kopiami gry
+ * i kopiowane przy pierwszym zapisie, więc każda następna kopia planszy
+ * kosztuje tyle, co kilka liczników.
+ */
+typedef struct {
+    board_backend_t backend; /**< Sposób przechowywania planszy. */
+    uint32_t width; /**< Szerokość planszy. */
+    uint32_t height; /**< Wysokość planszy. */
+    uint32_t stride; /**< Odległość między sąsiednimi wierszami. */
+    uint32_t size; /**< Liczba pól razem z ramką. */
+    uint32_t owner_size; /**< Liczba bajtów posiadacza pola: 1, 2 lub 4,
+                           *  albo zero dla płaszczyzn bitowych. */
+    uint32_t border; /**< Posiadacz pól ramki. */
+    uint32_t side[BOARD_SIDES]; /**< Przesunięcia numeru pola do sąsiadów. */
+    uint32_t planes; /**< Liczba płaszczyzn bitowych. */
+    uint64_t words; /**< Liczba słów zawierających pola planszy. */
+    uint64_t plane_words; /**< Odległość między kolejnymi płaszczyznami. */
+    pages_t owner; /**< Tablica posiadaczy pól lub płaszczyzny bitowe. */
+    pages_t area_id; /**< Tablica węzłów obszarów pól, jeśli plansza jest
+                       *  w wariancie @ref BOARD_BACKEND_ARRAY. */
+    fieldmap_t area_map; /**< Węzły obszarów zajętych pól w wariancie
+                           *  @ref BOARD_BACKEND_BIT_PLANES. */
+} board_t;
+
+/** @brief Inicjalizuje pustą planszę.
+ * @param[out] b      – wskaźnik na planszę,
+ * @param[in] width   – szerokość planszy, liczba dodatnia,
+ * @param[in] height  – wysokość planszy, liczba dodatnia,
+ * @param[in] players – liczba graczy, mniejsza od @p UINT32_MAX,
+ * @param[in] backend – sposób przechowywania planszy,
+ * @param[in] pool    – pula stron do kopiowania współdzielonych stron,
+ * @return Wartość @p true, jeśli pomyślnie zaalokowano pamięć, a @p false
+ * w przeciwnym przypadku lub gdy plansza ma więcej niż @p UINT32_MAX pól
+ * razem z ramką.
+ */
+bool board_init(board_t *b, uint32_t width, uint32_t height,
+                uint32_t players, board_backend_t backend, page_pool_t *pool);
+
+/** @brief Zwalnia pamięć planszy.
+ * @param[in,out] b – wskaźnik na planszę.
+ */
+void board_free(board_t *b);
+
+/** @brief Opróżnia planszę, zachowując jej pamięć.
+ * Plansza nie może współdzielić stron z inną planszą.
+ * @param[in,out] b – wskaźnik na planszę.
+ */
+void board_clear(board_t *b);
+
+/** @brief Rezerwuje miejsce na węzły obszarów nowo zajętych pól.
+ * Zapewnia, że przypisanie węzła @p n polom, które go jeszcze nie mają,
+ * przez @ref board_set_area_id nie będzie wymagało alokacji pamięci.
+ * @param[in,out] b – wskaźnik na planszę,
+ * @param[in] n     – liczba pól,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy nie udało się
+ * zaalokować pamięci.
+ */
+bool board_reserve(board_t *b, uint32_t n);
+
+/** @brief Tworzy planszę współdzielącą strony z planszą @p b.
+ * Rzadka tablica węzłów obszarów płaszczyzn bitowych jest kopiowana,
+ * a ciągłe tablice planszy @p b są przy pierwszej kopii dzielone na strony.
+ * @param[out] copy – wskaźnik na nową planszę,
+ * @param[in,out] b – wskaźnik na kopiowaną planszę,
+ * @param[in] pool  – pula stron nowej planszy,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy nie udało się
+ * zaalokować pamięci. Wtedy nową planszę trzeba zwolnić przez
+ * @ref board_free.
+ */
+bool board_share(board_t *copy, board_t *b, page_pool_t *pool);
+
+/** @brief Przygotowuje planszę do zmian.
+ * Kopiuje współdzielone tabele stron planszy.
+ * @param[in,out] b – wskaźnik na planszę,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy nie udało się
+ * zaalokować pamięci.
+ */
+bool board_prepare(board_t *b);
+
+/** @brief Podaje liczbę stron, które może być trzeba skopiować.
+ * @param[in] b      – wskaźnik na planszę,
+ * @param[in] owners – największa liczba zmienianych posiadaczy pól,
+ * @param[in] ids    – największa liczba zmienianych węzłów obszarów pól,
+ * @return Ograniczenie górne liczby stron kopiowanych przy takich zmianach.
+ */
+uint64_t board_pages(const board_t *b, uint64_t owners, uint64_t ids);
+
+/** @brief Podaje słowo pól należących do gracza.
+ * @param[in] b      – wskaźnik na planszę,
+ * @param[in] player – numer gracza, zero dla pustych pól lub
+ *                     @ref board_t.border dla ramki,
+ * @param[in] word   – numer słowa, liczba mniejsza od @ref board_t.words,
+ * @return Słowo, którego bit @p i jest ustawiony, gdy pole
+ * @p BOARD_WORD_BITS * @p word + @p i należy do gracza @p player.
+ */
+uint64_t board_owned_word(const board_t *b, uint32_t player, uint64_t word);
+
+/** @brief Podaje słowo pól sąsiadujących z polem gracza.
+ * Dla płaszczyzn bitowych liczy je przesunięciami całych słów.
+ * @param[in] b      – wskaźnik na planszę,
+ * @param[in] player – numer gracza,
+ * @param[in] word   – numer słowa, liczba mniejsza od @ref board_t.words,
+ * @return Słowo, którego bit @p i jest ustawiony, gdy pole
+ * @p BOARD_WORD_BITS * @p word + @p i sąsiaduje bokiem z polem gracza.
+ */
+uint64_t board_adjacent_word(const board_t *b, uint32_t player, uint64_t word);
+
+/** @brief Podaje numer pola (@p x, @p y).
+ * @param[in] b – wskaźnik na planszę,
+ * @param[in] x – numer kolumny, liczba mniejsza od szerokości planszy,
+ * @param[in] y – numer wiersza, liczba mniejsza od wysokości planszy,
+ * @return Numer pola.
+ */
+static inline uint32_t board_field(const board_t *b, uint32_t x, uint32_t y) {
+    return (y + 1) * b->stride + x + 1;
+}
+
+/** @brief Podaje numer kolumny pola.
+ * @param[in] b     – wskaźnik na planszę,
+ * @param[in] field – numer pola,
+ * @return Numer kolumny.
+ */
+static inline uint32_t board_x(const board_t *b, uint32_t field) {
+    return field % b->stride - 1;
+}
+
+/** @brief Podaje numer wiersza pola.
+ * @param[in] b     – wskaźnik na planszę,
+ * @param[in] field – numer pola,
+ * @return Numer wiersza.
+ */
+static inline uint32_t board_y(const board_t *b, uint32_t field) {
+    return field / b->stride - 1;
+}
+
+/** @brief Podaje posiadacza pola zapisanego w płaszczyznach bitowych.
+ * @param[in] b     – wskaźnik na planszę,
+ * @param[in] field – numer pola,
+ * @return Numer posiadacza pola lub @ref board_t.border dla pól ramki.
+ */
+static inline uint32_t board_plane_owner(const board_t *b, uint32_t field) {
+    uint64_t word = field / BOARD_WORD_BITS;
+    uint32_t bit = field % BOARD_WORD_BITS;
+    uint32_t owner = 0;
+    for (uint32_t k = 0; k < b->planes; ++k) {
+        const uint64_t *bits = pages_read(&b->owner,
+                                          k * b->plane_words + word,
+                                          sizeof(uint64_t));
+        owner |= (uint32_t) (*bits >> bit & 1) << k;
+    }
+    return owner;
+}
+
+/** @brief Ustawia posiadacza pola zapisanego w płaszczyznach bitowych.
+ * @param[in,out] b   – wskaźnik na planszę,
+ * @param[in] field   – numer pola,
+ * @param[in] player  – numer gracza.
+ */
+static inline void board_set_plane_owner(board_t *b, uint32_t field,
+                                         uint32_t player) {
+    uint64_t word = field / BOARD_WORD_BITS;
+    uint64_t mask = UINT64_C(1) << field % BOARD_WORD_BITS;
+    for (uint32_t k = 0; k < b->planes; ++k) {
+        uint64_t *bits = pages_write(&b->owner, k * b->plane_words + word,
+                                     sizeof(uint64_t));
+        if (player >> k & 1) {
+            *bits |= mask;
+        } else {
+            *bits &= ~mask;
+        }
+    }
+}
+
+/** @brief Podaje posiadacza pola.
+ * @param[in] b     – wskaźnik na planszę,
+ * @param[in] field – numer pola,
+ * @return Numer posiadacza pola lub @ref board_t.border dla pól ramki.
+ */
+static inline uint32_t board_owner(const board_t *b, uint32_t field) {
+    switch (b->owner_size) {
+        case 0:
+            return board_plane_owner(b, field);
+        case sizeof(uint8_t):
+            return *(const uint8_t *) pages_read(&b->owner, field,
+                                                sizeof(uint8_t));
+        case sizeof(uint16_t):
+            return *(const uint16_t *) pages_read(&b->owner, field,
+                                                 sizeof(uint16_t));
+        default:
+            return *(const uint32_t *) pages_read(&b->owner, field,
+                                                 sizeof(uint32_t));
+    }
+}
+
+/** @brief Ustawia posiadacza pola.
+ * Wymaga wcześniejszego przygotowania planszy przez @ref board_prepare.
+ * @param[in,out] b   – wskaźnik na planszę,
+ * @param[in] field   – numer pola,
+ * @param[in] player  – numer gracza.
+ */
+static inline void board_set_owner(board_t *b, uint32_t field,
+                                   uint32_t player) {
+    switch (b->owner_size) {
+        case 0:
+            board_set_plane_owner(b, field, player);
+            break;
+        case sizeof(uint8_t):
+            *(uint8_t *) pages_write(&b->owner, field, sizeof(uint8_t)) = player;
+            break;
+        case sizeof(uint16_t):
+            *(uint16_t *) pages_write(&b->owner, field,
+                                     sizeof(uint16_t)) = player;
+            break;
+        default:
+            *(uint32_t *) pages_write(&b->owner, field,
+                                     sizeof(uint32_t)) = player;
+            break;
+    }
+}
+
+/** @brief Podaje węzeł obszaru pola.
+ * @param[in] b     – wskaźnik na planszę,
+ * @param[in] field – numer pola,
+ * @return Id węzła obszaru pola lub zero dla pustego pola.
+ */
+static inline uint32_t board_area_id(const board_t *b, uint32_t field) {
+    if (b->backend == BOARD_BACKEND_ARRAY) {
+        return *(const uint32_t *) pages_read(&b->area_id, field,
+                                             sizeof(uint32_t));
+    }
+    return fieldmap_get(&b->area_map, field);
+}
+
+/** @brief Ustawia węzeł obszaru pola.
+ * Przypisanie węzła polu, które go jeszcze nie ma, wymaga wcześniejszego
+ * zarezerwowania miejsca przez @ref board_reserve, a każda zmiana
+ * przygotowania planszy przez @ref board_prepare.
+ * @param[in,out] b – wskaźnik na planszę,
+ * @param[in] field – numer pola,
+ * @param[in] id    – id węzła.
+ */
+static inline void board_set_area_id(board_t *b, uint32_t field, uint32_t id) {
+    if (b->backend == BOARD_BACKEND_ARRAY) {
+        *(uint32_t *) pages_write(&b->area_id, field, sizeof(uint32_t)) = id;
+    } else {
+        fieldmap_set(&b->area_map, field, id);
+    }
+}
+
+#endif //GAMMA_BOARD_H
@@ -0,0 +1,170 @@
+/** @file
+ * Implementacja rozbioru i wykonywania poleceń tekstowych gry gamma.
+ *
+ * @author Marcin Malejky
+ */
+
+#include "command.h"
+#include "mcts.h"
+
+#define CHAR_INVALID 0 /**< Znak niedozwolony w poleceniu. */
+#define CHAR_SPACE 1 /**< Znak biały. */
+#define CHAR_DIGIT 2 /**< Cyfra. */
+#define CHAR_LETTER 3 /**< Litera polecenia. */
+
+/**
+ * Rodzaje znaków dozwolonych w poleceniach. Znaki białe są tymi samymi
+ * znakami, które rozpoznaje isspace.
+ */
+static const unsigned char char_kind[256] = {
+    [' '] = CHAR_SPACE, ['\t'] = CHAR_SPACE, ['\v'] = CHAR_SPACE,
+    ['\f'] = CHAR_SPACE, ['\r'] = CHAR_SPACE, ['\n'] = CHAR_SPACE,
+    ['0'] = CHAR_DIGIT, ['1'] = CHAR_DIGIT, ['2'] = CHAR_DIGIT,
+    ['3'] = CHAR_DIGIT, ['4'] = CHAR_DIGIT, ['5'] = CHAR_DIGIT,
+    ['6'] = CHAR_DIGIT, ['7'] = CHAR_DIGIT, ['8'] = CHAR_DIGIT,
+    ['9'] = CHAR_DIGIT,
+    ['B'] = CHAR_LETTER, ['I'] = CHAR_LETTER, ['m'] = CHAR_LETTER,
+    ['g'] = CHAR_LETTER, ['b'] = CHAR_LETTER, ['f'] = CHAR_LETTER,
+    ['q'] = CHAR_LETTER, ['p'] = CHAR_LETTER, ['A'] = CHAR_LETTER,
+    ['X'] = CHAR_LETTER, ['d'] = CHAR_LETTER, ['s'] = CHAR_LETTER
+};
+
+/** @brief Podaje liczbę argumentów polecenia.
+ * @param[in] kind – litera polecenia,
+ * @return Liczba argumentów lub -1, gdy znak nie jest literą polecenia.
+ */
+static int arity(char kind);
+
+/** @brief Wypisuje wartość logiczną jako liczbę i znak nowej linii.
+ * @param[in,out] out – wskaźnik na wyjście,
+ * @param[in] value   – wartość.
+ */
+static void print_bool(output_t *out, bool value);
+
+static int arity(char kind) {
+    switch (kind) {
+        case 'B':
+        case 'I':
+        case 'X':
+            return 4;
+        case 'm':
+        case 'g':
+            return 3;
+        case 'A':
+            return 2;
+        case 'b':
+        case 'f':
+        case 'q':
+            return 1;
+        case 'p':
+        case 'd':
+        case 's':
+            return 0;
+        default:
+            return -1;
+    }
+}
+
+command_status_t command_parse(const char *line, size_t size, command_t *c) {
+    if (size == 0) {
+        return COMMAND_ERROR;
+    }
+    if (line[0] == '\n' || line[0] == '#') {
+        return COMMAND_OMIT;
+    }
+    for (size_t i = 0; i < size; ++i) {
+        if (char_kind[(unsigned char) line[i]] == CHAR_INVALID) {
+            return COMMAND_ERROR;
+        }
+    }
+    int count = arity(line[0]);
+    if (line[size - 1] != '\n' || count < 0 ||
+        char_kind[(unsigned char) line[1]] != CHAR_SPACE) {
+        return COMMAND_ERROR;
+    }
+
+    c->kind = line[0];
+    size_t i = 1;
+    for (int k = 0; k < count; ++k) {
+        while (i < size && char_kind[(unsigned char) line[i]] == CHAR_SPACE) {
+            ++i;
+        }
+        if (i == size) {
+            return COMMAND_ERROR;
+        }
+        uint64_t value = 0;
+        for (; i < size && char_kind[(unsigned char) line[i]] != CHAR_SPACE;
+               ++i) {
+            if (char_kind[(unsigned char) line[i]] != CHAR_DIGIT) {
+                return COMMAND_ERROR;
+            }
+            value = value * 10 + (line[i] - '0');
+            if (value > UINT32_MAX) {
+                return COMMAND_ERROR;
+            }
+        }
+        c->args[k] = value;
+    }
+    while (i < size && char_kind[(unsigned char) line[i]] == CHAR_SPACE) {
+        ++i;
+    }
+    return i == size ? COMMAND_OK : COMMAND_ERROR;
+}
+
+bool command_space(char c) {
+    return char_kind[(unsigned char) c] == CHAR_SPACE;
+}
+
+static void print_bool(output_t *out, bool value) {
+    output_char(out, value ? '1' : '0');
+    output_char(out, '\n');
+}
+
+bool command_execute(gamma_t *g, const command_t *c, output_t *out,
+                     uint32_t threads) {
+    const uint32_t *a = c->args;
+    switch (c->kind) {
+        case 'm':
+            print_bool(out, gamma_move(g, a[0], a[1], a[2]));
+            return true;
+        case 'g':
+            print_bool(out, gamma_golden_move(g, a[0], a[1], a[2]));
+            return true;
+        case 'b':
+            output_uint(out, gamma_busy_fields(g, a[0]));
+            output_char(out, '\n');
+            return true;
+        case 'f':
+            output_uint(out, gamma_free_fields(g, a[0]));
+            output_char(out, '\n');
+            return true;
+        case 'q':
+            print_bool(out, gamma_golden_possible(g, a[0]));
+            return true;
+        case 'A': {
+            /* Drugą liczbą jest czas przeszukiwania w milisekundach. */
+            mcts_config_t config;
+            mcts_defaults(&config);
+            config.threads = threads;
+            config.budget_ms = a[1];
+            playout_stat_t move;
+            if (!mcts_move(g, a[0], &config, &move, NULL)) {
+                print_bool(out, false);
+                return true;
+            }
+            output_char(out, move.golden ? 'g' : 'm');
+            output_char(out, ' ');
+            output_uint(out, a[0]);
+            output_char(out, ' ');
+            output_uint(out, move.field.x);
+            output_char(out, ' ');
+            output_uint(out, move.field.y);
+            output_char(out, '\n');
+            return true;
+        }
+        case 'p':
+            return gamma_board_write(g, output_sink, out);
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,66 @@
+/** @file
+ * Interfejs rozbioru i wykonywania poleceń tekstowych gry gamma.
+ *
+ * @author Marcin Malejky
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "gamma.h"
+#include "output.h"
+
+#ifndef GAMMA_COMMAND_H
+#define GAMMA_COMMAND_H
+
+#define COMMAND_MAX_ARGS 4 /**< Największa liczba argumentów polecenia. */
+
+/**
+ * Wynik rozbioru wiersza.
+ */
+typedef enum {
+    COMMAND_OK, /**< Wiersz jest poprawnym poleceniem. */
+    COMMAND_OMIT, /**< Wiersz jest komentarzem lub jest pusty. */
+    COMMAND_ERROR /**< Wiersz jest niepoprawny. */
+} command_status_t;
+
+/**
+ * Polecenie.
+ */
+typedef struct {
+    char kind; /**< Litera polecenia. */
+    uint32_t args[COMMAND_MAX_ARGS]; /**< Argumenty polecenia. */
+} command_t;
+
+/** @brief Rozbiera wiersz z poleceniem.
+ * Rozpoznaje polecenia rozpoczęcia gry @p B, @p I i @p X z czterema
+ * argumentami oraz polecenia gry: @p m i @p g z trzema, @p A z dwoma, @p b,
+ * @p f, @p q z jednym i @p p bez argumentów, a także polecenia serwera
+ * @p d i @p s bez argumentów. Wiersz nie jest zmieniany, więc może
+ * leżeć w pamięci tylko do odczytu.
+ * @param[in] line – wiersz, zakończony znakiem nowej linii,
+ * @param[in] size – długość wiersza,
+ * @param[out] c   – wskaźnik na polecenie,
+ * @return Wynik rozbioru wiersza.
+ */
+command_status_t command_parse(const char *line, size_t size, command_t *c);
+
+/** @brief Sprawdza, czy znak jest znakiem białym polecenia.
+ * @param[in] c – znak,
+ * @return Wartość @p true, jeśli @ref command_parse traktuje znak jako
+ * odstęp, a @p false w przeciwnym przypadku.
+ */
+bool command_space(char c);
+
+/** @brief Wykonuje polecenie gry i wypisuje jego wynik.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] c       – wskaźnik na polecenie gry,
+ * @param[in,out] out – wskaźnik na wyjście,
+ * @param[in] threads – liczba wątków przeszukiwania polecenia @p A,
+ *                      0 oznacza liczbę procesorów,
+ * @return Wartość @p true, jeśli polecenie jest poleceniem gry, a @p false
+ * w przeciwnym przypadku lub gdy nie udało się wypisać planszy.
+ */
+bool command_execute(gamma_t *g, const command_t *c, output_t *out,
+                     uint32_t threads);
+
+#endif //GAMMA_COMMAND_H
@@ -0,0 +1,147 @@
+# Porównuje tryby programu gamma na tych samych losowych sesjach.
+#
+# Uruchamiany przez ctest poleceniem:
+#   cmake -DGAMMA=<gamma> -DSESSION=<gamma_session> -DWORK=<katalog>
+#         -DEXPECTED=<katalog> -P compare_modes.cmake
+#
+# Dla każdej sesji tryb wsadowy czytający standardowe wejście jest wzorcem,
+# z którym muszą się zgadzać co do bajtu odtwarzanie pliku (--replay),
+# przetwarzanie potokowe (--pipeline) i oba naraz, na standardowym wyjściu
+# i standardowym wyjściu diagnostycznym. Ta sama sesja zapisana dla serwera
+# musi dać te same wyniki po usunięciu numeru gry i te same błędy, które
+# serwer może jednak zgłosić w innej kolejności. Sesje binarnego
+# trybu wsadowego są porównywane tylko między sposobami czytania wejścia.
+#
+# Wyjścia trybu wsadowego dla małych sesji muszą się zgadzać co do bajtu,
+# razem z wierszami ERROR, z wyjściami pierwotnej wersji programu (commit
+# 45f7b3a), zapisanymi w katalogu EXPECTED jako baseline<ziarno>.out,
+# baseline<ziarno>.err i baseline<ziarno>.code. Sesje większe od tych,
+# które warto trzymać w repozytorium, są sprawdzane tylko między trybami.
+
+foreach (variable GAMMA SESSION WORK EXPECTED)
+    if (NOT DEFINED ${variable})
+        message(FATAL_ERROR "Brak zmiennej ${variable}.")
+    endif ()
+endforeach ()
+
+file(MAKE_DIRECTORY ${WORK})
+
+# Ziarno, liczba poleceń, wymiary planszy, liczba graczy i obszarów oraz
+# średnia liczba poleceń między wypisaniami planszy. Sesje z nieparzystym
+# ziarnem kończą się niepełnym wierszem.
+set(SESSIONS
+        "1 20000 30 20 3 4 500"
+        "2 20000 700 700 3 8 2000"
+        "3 5000 1 1 1 1 50"
+        "4 30000 40 30 12 3 1000"
+        "6 200000 4000 3000 2 2 0"
+        "7 50000 9 9 300 2 5000"
+        "11 3000 30 20 3 4 400"
+        "13 1500 1 1 1 1 50"
+        "14 4000 40 30 12 3 1500"
+        "15 3000 9 9 300 2 800"
+        "16 8000 300 200 2 2 0"
+        "17 2000 12 12 5 1 300")
+
+# Uruchamia program gamma i zapisuje jego wyjścia do plików.
+# name  – przedrostek nazw plików wyjść,
+# input – plik przekazywany na standardowe wejście,
+# ARGN  – argumenty programu.
+function(run_gamma name input)
+    execute_process(COMMAND ${GAMMA} ${ARGN}
+            INPUT_FILE ${input}
+            OUTPUT_FILE ${WORK}/${name}.out
+            ERROR_FILE ${WORK}/${name}.err
+            RESULT_VARIABLE result)
+    file(WRITE ${WORK}/${name}.code "${result}\n")
+endfunction()
+
+# Sprawdza, czy pliki wyjść dwóch uruchomień są takie same.
+function(expect_same expected actual)
+    foreach (suffix out err code)
+        execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files
+                ${WORK}/${expected}.${suffix} ${WORK}/${actual}.${suffix}
+                RESULT_VARIABLE different)
+        if (different)
+            message(FATAL_ERROR "${actual}.${suffix} różni się od "
+                    "${expected}.${suffix} w katalogu ${WORK}.")
+        endif ()
+    endforeach ()
+endfunction()
+
+# Tworzy sesję w danej formie.
+function(make_session form name parameters)
+    string(REPLACE " " ";" arguments "${parameters}")
+    execute_process(COMMAND ${SESSION} ${form} ${arguments}
+            OUTPUT_FILE ${WORK}/${name}
+            RESULT_VARIABLE result)
+    if (result)
+        message(FATAL_ERROR "Nie udało się utworzyć sesji ${name}.")
+    endif ()
+endfunction()
+
+# Usuwa pierwszy wiersz wyjścia, czyli potwierdzenie nagłówka, a dla
+# serwera także numer gry z początku pozostałych wierszy. Porządkuje też
+# błędy. Wyrażenia
+# regularne nie nadają się do tego, bo w REGEX REPLACE znak ^ pasuje też
+# za każdym zastąpionym fragmentem.
+# name   – przedrostek nazw plików wyjść,
+# server – czy wyjście pochodzi od serwera.
+function(strip_header name server)
+    file(READ ${WORK}/${name}.out text)
+    string(FIND "${text}" "\n" end)
+    math(EXPR begin "${end} + 1")
+    string(SUBSTRING "${text}" ${begin} -1 text)
+    if (server)
+        string(REPLACE "\n1 " "\n" text "\n${text}")
+        string(SUBSTRING "${text}" 1 -1 text)
+    endif ()
+    file(WRITE ${WORK}/${name}.out "${text}")
+    file(STRINGS ${WORK}/${name}.err errors)
+    list(SORT errors)
+    string(REPLACE ";" "\n" errors "${errors}")
+    file(WRITE ${WORK}/${name}.err "${errors}\n")
+endfunction()
+
+foreach (parameters IN LISTS SESSIONS)
+    string(REGEX MATCH "^[0-9]+" seed "${parameters}")
+    set(batch session${seed}.txt)
+    make_session(batch ${batch} "${parameters}")
+    run_gamma(batch${seed} ${WORK}/${batch})
+    run_gamma(replay${seed} ${WORK}/${batch} --replay ${WORK}/${batch})
+    run_gamma(pipeline${seed} ${WORK}/${batch} --pipeline)
+    run_gamma(pipeline_replay${seed} ${WORK}/${batch}
+            --pipeline --replay ${WORK}/${batch})
+    foreach (mode replay pipeline pipeline_replay)
+        expect_same(batch${seed} ${mode}${seed})
+    endforeach ()
+    if (EXISTS ${EXPECTED}/baseline${seed}.out)
+        foreach (suffix out err code)
+            configure_file(${EXPECTED}/baseline${seed}.${suffix}
+                    ${WORK}/baseline${seed}.${suffix} COPYONLY)
+        endforeach ()
+        expect_same(baseline${seed} batch${seed})
+    endif ()
+
+    set(server session${seed}_server.txt)
+    make_session(server ${server} "${parameters}")
+    run_gamma(server${seed} ${WORK}/${server} --server)
+    strip_header(server${seed} TRUE)
+    configure_file(${WORK}/batch${seed}.out ${WORK}/unheaded${seed}.out
+            COPYONLY)
+    configure_file(${WORK}/batch${seed}.err ${WORK}/unheaded${seed}.err
+            COPYONLY)
+    configure_file(${WORK}/batch${seed}.code ${WORK}/unheaded${seed}.code
+            COPYONLY)
+    strip_header(unheaded${seed} FALSE)
+    expect_same(unheaded${seed} server${seed})
+
+    set(binary session${seed}.bin)
+    make_session(binary ${binary} "${parameters}")
+    run_gamma(binary${seed} ${WORK}/${binary})
+    run_gamma(binary_replay${seed} ${WORK}/${binary}
+            --replay ${WORK}/${binary})
+    run_gamma(binary_pipeline${seed} ${WORK}/${binary} --pipeline)
+    expect_same(binary${seed} binary_replay${seed})
+    expect_same(binary${seed} binary_pipeline${seed})
+endforeach ()
@@ -0,0 +1,135 @@
+/** @file
+ * Implementacja rzadkiej tablicy wartości przypisanych polom planszy.
+ *
+ * @author Marcin Malejky
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "fieldmap.h"
+
+#define INITIAL_CAPACITY 64 /**< Początkowa liczba komórek tablicy. */
+#define NO_FIELD UINT32_MAX /**< Znacznik pustej komórki. */
+
+/** @brief Podaje komórkę, od której zaczyna się szukanie pola.
+ * @param[in] capacity – liczba komórek, potęga dwójki,
+ * @param[in] field    – numer pola,
+ * @return Numer komórki.
+ */
+static uint64_t slot_of(uint64_t capacity, uint32_t field);
+
+/** @brief Podaje komórkę pola lub pustą komórkę, w której powinno się znaleźć.
+ * @param[in] m     – wskaźnik na tablicę,
+ * @param[in] field – numer pola,
+ * @return Numer komórki.
+ */
+static uint64_t find(const fieldmap_t *m, uint32_t field);
+
+/** @brief Przenosi zawartość tablicy do tablicy o nowej liczbie komórek.
+ * @param[in,out] m    – wskaźnik na tablicę,
+ * @param[in] capacity – nowa liczba komórek, potęga dwójki,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy nie udało się
+ * zaalokować pamięci.
+ */
+static bool rehash(fieldmap_t *m, uint64_t capacity);
+
+static uint64_t slot_of(uint64_t capacity, uint32_t field) {
+    /* Mieszanie Fibonacciego rozprasza pola z sąsiednich wierszy. */
+    return ((field * UINT64_C(0x9E3779B97F4A7C15)) >> 32) & (capacity - 1);
+}
+
+static uint64_t find(const fieldmap_t *m, uint32_t field) {
+    uint64_t slot = slot_of(m->capacity, field);
+    while (m->keys[slot] != NO_FIELD && m->keys[slot] != field) {
+        slot = (slot + 1) & (m->capacity - 1);
+    }
+    return slot;
+}
+
+static bool rehash(fieldmap_t *m, uint64_t capacity) {
+    if (capacity > SIZE_MAX / sizeof(uint32_t)) {
+        return false;
+    }
+    uint32_t *keys = malloc(sizeof(uint32_t) * capacity);
+    uint32_t *values = malloc(sizeof(uint32_t) * capacity);
+    if (!keys || !values) {
+        free(keys);
+        free(values);
+        return false;
+    }
+    for (uint64_t i = 0; i < capacity; ++i) {
+        keys[i] = NO_FIELD;
+    }
+    fieldmap_t moved = {keys, values, m->count, capacity};
+    for (uint64_t i = 0; i < m->capacity; ++i) {
+        if (m->keys[i] != NO_FIELD) {
+            uint64_t slot = find(&moved, m->keys[i]);
+            keys[slot] = m->keys[i];
+            values[slot] = m->values[i];
+        }
+    }
+    fieldmap_free(m);
+    *m = moved;
+    return true;
+}
+
+bool fieldmap_init(fieldmap_t *m) {
+    m->keys = NULL;
+    m->values = NULL;
+    m->count = 0;
+    m->capacity = 0;
+    return rehash(m, INITIAL_CAPACITY);
+}
+
+bool fieldmap_copy(fieldmap_t *copy, const fieldmap_t *m) {
+    copy->keys = malloc(sizeof(uint32_t) * m->capacity);
+    copy->values = malloc(sizeof(uint32_t) * m->capacity);
+    if (!copy->keys || !copy->values) {
+        fieldmap_free(copy);
+        return false;
+    }
+    memcpy(copy->keys, m->keys, sizeof(uint32_t) * m->capacity);
+    memcpy(copy->values, m->values, sizeof(uint32_t) * m->capacity);
+    copy->count = m->count;
+    copy->capacity = m->capacity;
+    return true;
+}
+
+void fieldmap_free(fieldmap_t *m) {
+    free(m->keys);
+    free(m->values);
+    m->keys = NULL;
+    m->values = NULL;
+    m->count = 0;
+    m->capacity = 0;
+}
+
+bool fieldmap_reserve(fieldmap_t *m, uint64_t n) {
+    /* Tablica jest zapełniona najwyżej w połowie. */
+    uint64_t capacity = m->capacity;
+    while (2 * (m->count + n) > capacity) {
+        capacity *= 2;
+    }
+    return capacity == m->capacity || rehash(m, capacity);
+}
+
+uint32_t fieldmap_get(const fieldmap_t *m, uint32_t field) {
+    uint64_t slot = find(m, field);
+    return m->keys[slot] == NO_FIELD ? 0 : m->values[slot];
+}
+
+void fieldmap_set(fieldmap_t *m, uint32_t field, uint32_t value) {
+    uint64_t slot = find(m, field);
+    if (m->keys[slot] == NO_FIELD) {
+        m->keys[slot] = field;
+        ++(m->count);
+    }
+    m->values[slot] = value;
+}
+
+void fieldmap_clear(fieldmap_t *m) {
+    for (uint64_t i = 0; i < m->capacity; ++i) {
+        m->keys[i] = NO_FIELD;
+    }
+    m->count = 0;
+}
@@ -0,0 +1,77 @@
+/** @file
+ * Interfejs rzadkiej tablicy wartości przypisanych polom planszy.
+ *
+ * @author Marcin Malejky
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef GAMMA_FIELDMAP_H
+#define GAMMA_FIELDMAP_H
+
+/**
+ * Tablica mieszająca z adresowaniem otwartym przypisująca numerom pól
+ * niezerowe wartości. Pamięć zależy od liczby zapisanych pól, a nie od
+ * rozmiaru planszy. Pola bez zapisanej wartości mają wartość zero.
+ */
+typedef struct {
+    uint32_t *keys; /**< Tablica numerów pól lub @p UINT32_MAX. */
+    uint32_t *values; /**< Tablica wartości. */
+    uint64_t count; /**< Liczba zajętych komórek. */
+    uint64_t capacity; /**< Liczba komórek, potęga dwójki. */
+} fieldmap_t;
+
+/** @brief Inicjalizuje pustą tablicę.
+ * @param[out] m – wskaźnik na tablicę,
+ * @return Wartość @p true, jeśli pomyślnie zaalokowano pamięć, a @p false
+ * w przeciwnym przypadku.
+ */
+bool fieldmap_init(fieldmap_t *m);
+
+/** @brief Kopiuje tablicę.
+ * @param[out] copy – wskaźnik na nową tablicę,
+ * @param[in] m     – wskaźnik na kopiowaną tablicę,
+ * @return Wartość @p true, jeśli pomyślnie zaalokowano pamięć, a @p false
+ * w przeciwnym przypadku.
+ */
+bool fieldmap_copy(fieldmap_t *copy, const fieldmap_t *m);
+
+/** @brief Zwalnia pamięć tablicy.
+ * @param[in,out] m – wskaźnik na tablicę.
+ */
+void fieldmap_free(fieldmap_t *m);
+
+/** @brief Rezerwuje miejsce na nowe pola.
+ * Zapewnia, że zapisanie wartości @p n nowym polom przez @ref fieldmap_set
+ * nie będzie wymagało alokacji pamięci.
+ * @param[in,out] m – wskaźnik na tablicę,
+ * @param[in] n     – liczba rezerwowanych pól,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy nie udało się
+ * zaalokować pamięci.
+ */
+bool fieldmap_reserve(fieldmap_t *m, uint64_t n);
+
+/** @brief Podaje wartość pola.
+ * @param[in] m     – wskaźnik na tablicę,
+ * @param[in] field – numer pola, liczba mniejsza od @p UINT32_MAX,
+ * @return Wartość pola lub zero, jeśli jej nie zapisano.
+ */
+uint32_t fieldmap_get(const fieldmap_t *m, uint32_t field);
+
+/** @brief Zapisuje wartość pola.
+ * Zapisanie wartości polu, które jej jeszcze nie ma, wymaga wcześniejszego
+ * zarezerwowania miejsca przez @ref fieldmap_reserve.
+ * @param[in,out] m – wskaźnik na tablicę,
+ * @param[in] field – numer pola, liczba mniejsza od @p UINT32_MAX,
+ * @param[in] value – wartość.
+ */
+void fieldmap_set(fieldmap_t *m, uint32_t field, uint32_t value);
+
+/** @brief Usuwa wartości wszystkich pól.
+ * Nie zwalnia pamięci.
+ * @param[in,out] m – wskaźnik na tablicę.
+ */
+void fieldmap_clear(fieldmap_t *m);
+
+#endif //GAMMA_FIELDMAP_H
@@ -3,13 +3,23 @@
  * @author Marcin Malejky
  */
 
-#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "gamma.h"
+#include "render.h"
+#include "zobrist.h"
 
 #define NOBODY 0 /**< Domyślny posiadacz pustego pola. */
 #define EMPTY 0 /**< Domyślne id obszaru pustego pola. */
-#define SIDE_COUNT 4 /**< Liczba boków pola. */
+
+/**
+ * Argument funkcji @ref relabel_field.
+ */
+typedef struct {
+    gamma_t *g; /**< Wskaźnik na strukturę przechowującą stan gry. */
+    uint32_t id; /**< Nowy węzeł odciętej części. */
+    uint32_t root; /**< Korzeń dotychczasowego obszaru. */
+} relabel_t;
 
 /** @brief Sprawdza czy struktura stanu gry i numer gracza są poprawne.
  * Sprawdza, czy struktura @p g jest zaalokowana i czy numer gracza @p player
@@ -22,18 +32,6 @@
  */
 static bool player_correct(gamma_t *g, uint32_t player);
 
-/** @brief Inicjalizuje planszę.
- * Alokuje pamięć na posiadacza oraz id obszaru każdego pola na planszy
- * o szerokości @p width i wysokości @p height.
- * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
- * @param[in] width   – szerokość plaszy, liczba dodatnia,
- * @param[in] height  – wysokość plaszy, liczba dodatnia,
- * @return Wartość @p true, jeśli pomyślnie zaalokowano pamięć na planszę,
- * a @p false w przeciwnym przypadku lub gdy któryś z parametrów jest
- * niepoprawny.
- * */
-static bool initialize_board(gamma_t *g, uint32_t width, uint32_t height);
-
 /** @brief Podaje liczbę cyfr danej liczby.
  * Podaje liczbę cyfr danej liczby całkowitej w zapisie dziesiętnym.
  * @param[in] n       – liczba,
@@ -58,22 +56,108 @@ static uint32_t digit_count(uint32_t n);
 static uint32_t bordering_area_id(gamma_t *g, uint32_t player, uint32_t x,
                                   uint32_t y);
 
-/** @brief Łączy wszytkie sąsiadujące pola gracza w jeden obszar.
- * Łączy wszytkie sąsiadujące (z polem (@p x, @p y)) pola gracza @p player
- * w jeden obszar. Omija obszary o id w tablicy @p ids o długości @p length.
- * Id nowego obszaru ustala na ostatnią liczbę tablicy @p ids.
+/** @brief Ustawia posiadacza pola, zapisując zmianę w dzienniku.
  * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
- * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
- *                      @p players z funkcji @ref gamma_new,
- * @param[in] x       – numer kolumny, liczba nieujemna mniejsza od wartości
- *                      @p width z funkcji @ref gamma_new,
- * @param[in] y       – numer wiersza, liczba nieujemna mniejsza od wartości
- *                      @p height z funkcji @ref gamma_new.
- * @param[in] ids     - tablica id pomijanych obszarow o długości length,
- * @param[in] length  - liczba elementów tablicy ids,
+ * @param[in] field   – numer pola,
+ * @param[in] player  – numer nowego posiadacza.
+ * */
+static void set_owner(gamma_t *g, uint32_t field, uint32_t player);
+
+/** @brief Ustawia węzeł obszaru pola, zapisując zmianę w dzienniku.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] field   – numer pola,
+ * @param[in] id      – id węzła.
+ * */
+static void set_area_id(gamma_t *g, uint32_t field, uint32_t id);
+
+/** @brief Zapisuje w dzienniku liczniki gracza zmieniane przez ruch.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza.
+ * */
+static void log_counters(gamma_t *g, uint32_t player);
+
+/** @brief Aktualizuje skrót pozycji po ruchu.
+ * @param[in,out] g          – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player         – numer gracza wykonującego ruch,
+ * @param[in] x              – numer kolumny,
+ * @param[in] y              – numer wiersza,
+ * @param[in] previous_owner – poprzedni posiadacz pola,
+ * @param[in] golden         – czy ruch jest złotym ruchem.
+ */
+static void hash_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y,
+                      uint32_t previous_owner, bool golden);
+
+/** @brief Przywraca wartość sprzed zmiany zapisanej w dzienniku.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] entry   – wpis dziennika.
+ * */
+static void restore(gamma_t *g, const journal_entry_t *entry);
+
+/** @brief Zapewnia miejsce na stosie pól.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] n       – wymagana liczba pól na stosie,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy nie udało się
+ * zaalokować pamięci.
+ * */
+static bool reserve_stack(gamma_t *g, uint64_t n);
+
+/** @brief Przygotowuje współdzielone strony gry do zmian.
+ * Kopiuje współdzielone tabele stron i rezerwuje w puli strony na kopie
+ * stron zmienianych przez ruch, aby ruch nie mógł się nie udać w połowie.
+ * Nic nie robi, jeśli gra nigdy nie współdzieliła stron.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] owners  – największa liczba zmienianych posiadaczy pól,
+ * @param[in] ids     – największa liczba zmienianych węzłów obszarów pól,
+ * @param[in] nodes   – największa liczba zmienianych węzłów lasu obszarów,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy nie udało się
+ * zaalokować pamięci.
+ * */
+static bool prepare_pages(gamma_t *g, uint64_t owners, uint64_t ids,
+                          uint64_t nodes);
+
+/** @brief Podaje liczbę pól, którym ruch może zmienić węzeł obszaru.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza wykonującego ruch,
+ * @return Ograniczenie górne liczby pól gracza @p player i zajmowanego pola,
+ * którym dołączenie pola zmieni węzeł obszaru.
  * */
-static void merge_areas(gamma_t *g, uint32_t player, uint32_t x,
-                        uint32_t y, uint32_t const *ids, uint32_t length);
+static uint64_t joined_fields(gamma_t *g, uint32_t player);
+
+/** @brief Podaje korzeń obszaru pola.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] field   – numer pola,
+ * @return Id korzenia obszaru, do którego należy pole @p field.
+ * */
+static uint32_t area_of(gamma_t *g, uint32_t field);
+
+/** @brief Przenumerowuje obszar gracza.
+ * Ustawia id obszaru @p id wszystkim polom gracza @p player osiągalnym z pola
+ * @p field, których obszar ma inny korzeń. Przeszukuje planszę iteracyjnie,
+ * używając stosu z @p g.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza,
+ * @param[in] field   – numer pola,
+ * @param[in] id      – korzeń, do którego są przepinane pola,
+ * @return Liczba przenumerowanych pól.
+ * */
+static uint32_t fill_area(gamma_t *g, uint32_t player, uint32_t field,
+                          uint32_t id);
+
+/** @brief Dołącza pole do obszarów gracza.
+ * Łączy pole @p field, już należące do gracza @p player, ze wszystkimi
+ * sąsiadującymi obszarami gracza i aktualizuje liczbę jego obszarów.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza,
+ * @param[in] field   – numer pola.
+ * */
+static void join_areas(gamma_t *g, uint32_t player, uint32_t field);
+
+/** @brief Przepina pole do nowego obszaru po rozspójnieniu.
+ * Funkcja wywoływana dla pól odciętej części obszaru.
+ * @param[in,out] arg – wskaźnik na strukturę @ref relabel_t,
+ * @param[in] field   – numer pola.
+ * */
+static void relabel_field(void *arg, uint32_t field);
 
 /** @brief Dodaje element do tablicy jeżeli jest różny od zawartości.
  * Dodaje liczbę @p x do tablicy @p array o długości pod wskażnikiem @p length
@@ -85,21 +169,46 @@ static void merge_areas(gamma_t *g, uint32_t player, uint32_t x,
  * */
 static void add_distinct(uint32_t *array, uint32_t *length, uint32_t x);
 
-/** @brief Podaje liczbę różnych sąsiadujących obszarów gracza.
- * Podaje liczbę różnych obszarów gracza @p player sąsiadujących z polem
- * (@p x, @p y).
+/** @brief Podaje różne sąsiadujące obszary gracza.
+ * Zapisuje do tablicy @p ids korzenie różnych obszarów gracza @p player
+ * sąsiadujących z polem @p field.
  * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
- * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
- *                      @p players z funkcji @ref gamma_new,
- * @param[in] x       – numer kolumny, liczba nieujemna mniejsza od wartości
- *                      @p width z funkcji @ref gamma_new,
- * @param[in] y       – numer wiersza, liczba nieujemna mniejsza od wartości
- *                      @p height z funkcji @ref gamma_new.
- * @return Liczba różnych obszarów gracza @p player sąsiadujących z polem
- * (@p x, @p y) lub zero jeżeli któryś z parametrów jest nieporawny.
+ * @param[in] player  – numer gracza,
+ * @param[in] field   – numer pola,
+ * @param[out] ids    – tablica o długości co najmniej @ref BOARD_SIDES,
+ * @return Liczba zapisanych korzeni.
  * */
-static uint32_t distinct_neighbour_count(gamma_t *g, uint32_t player,
-                                         uint32_t x, uint32_t y);
+static uint32_t neighbour_areas(gamma_t *g, uint32_t player, uint32_t field,
+                                uint32_t *ids);
+
+/** @brief Podaje liczbę pól gracza sąsiadujących z polem.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza,
+ * @param[in] field   – numer pola,
+ * @return Liczba pól gracza @p player sąsiadujących z polem @p field.
+ * */
+static uint32_t neighbour_count(gamma_t *g, uint32_t player, uint32_t field);
+
+/** @brief Aktualizuje liczniki wolnych pól sąsiadujących po ruchu.
+ * Uwzględnia zajęcie wolnego pola @p field przez gracza @p player, które już
+ * nastąpiło. Odwiedza tylko sąsiadów pola.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza,
+ * @param[in] field   – numer pola.
+ * */
+static void frontier_after_move(gamma_t *g, uint32_t player, uint32_t field);
+
+/** @brief Aktualizuje liczniki wolnych pól sąsiadujących po złotym ruchu.
+ * Uwzględnia przejęcie pola @p field gracza @p previous_owner przez gracza
+ * @p player, które już nastąpiło. Odwiedza tylko sąsiadów pola.
+ * @param[in,out] g          – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player         – numer gracza wykonującego ruch,
+ * @param[in] previous_owner – numer poprzedniego właściciela pola,
+ * @param[in] field          – numer pola.
+ * */
+static void frontier_after_golden_move(gamma_t *g, uint32_t player,
+                                       uint32_t previous_owner,
+                                       uint32_t field);
 
 /** @brief Sprawdza poprawność parametrów dla funkcji gamma_golden_move.
  * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
@@ -115,10 +224,11 @@ static bool check_golden_move_parameters(gamma_t *g, uint32_t player,
                                          uint32_t x, uint32_t y);
 
 /** @brief Sprawdza czy możliwy jest złoty ruch.
- * Jeżeli parametry są poprawne wykonuje złoty ruch według parametrów i jeżeli
- * ruch nie łamie zasad gry to go nie cofa i zwraca TRUE. W przeciwnym wypadku
- * cofa ruch i zwraca false. Jeżeli ALWAYS_REVERSE to zawsze cofa ruch,
- * a podaje informacje czy ruch jest w pełni legalny.
+ * Sprawdza, czy złoty ruch według parametrów jest w pełni legalny, tj. czy
+ * parametry są poprawne i po usunięciu pionka poprzedni właściciel pola nie
+ * przekroczy limitu obszarów. Nie zmienia stanu gry poza stanem sprawdzania
+ * rozspójnienia. Na @p pieces zapisuje liczbę części obszaru poprzedniego
+ * właściciela.
  * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
  * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
  *                      @p players z funkcji @ref gamma_new,
@@ -126,13 +236,13 @@ static bool check_golden_move_parameters(gamma_t *g, uint32_t player,
  *                      @p width z funkcji @ref gamma_new,
  * @param[in] y       – numer wiersza, liczba nieujemna mniejsza od wartości
  *                      @p height z funkcji @ref gamma_new.
- * @param[in] always_reverse – czy zawsze cofać ruch
+ * @param[out] pieces – liczba części obszaru poprzedniego właściciela,
  * @return TRUE, jeżeli złoty ruch jest w pełni legalny, FALSE w przeciwnym
  * razie.
  * */
 static bool
 golden_move_possible(gamma_t *g, uint32_t player, uint32_t x, uint32_t y,
-                     bool always_reverse);
+                     uint32_t *pieces);
 
 static bool player_correct(gamma_t *g, uint32_t player) {
     if (!g || player == NOBODY || player > g->player_count) {
@@ -142,48 +252,6 @@ static bool player_correct(gamma_t *g, uint32_t player) {
     }
 }
 
-static bool initialize_board(gamma_t *g, uint32_t width, uint32_t height) {
-    if (!g || width < 1 || height < 1) {
-        return false;
-    }
-    g->owner = malloc(sizeof(uint32_t *) * height);
-    if (!g->owner) {
-        return false;
-    }
-    g->area_id = malloc(sizeof(uint32_t *) * height);
-    if (!g->area_id) {
-        free(g->owner);
-        return false;
-    }
-    bool ok = true;
-    uint32_t y;
-    for (y = 0; y < height && ok; ++y) {
-        g->owner[y] = malloc(sizeof(uint32_t) * width);
-        if (!g->owner[y]) {
-            ok = false;
-            g->area_id[y] = NULL;
-        } else {
-            g->area_id[y] = malloc(sizeof(uint32_t) * width);
-            if (!g->area_id[y]) {
-                ok = false;
-            }
-            for (uint32_t x = 0; x < width && ok; ++x) {
-                g->owner[y][x] = NOBODY;
-                g->area_id[y][x] = EMPTY;
-            }
-        }
-    }
-    if (!ok) {
-        for (uint32_t i = 0; i < y; ++i) {
-            free(g->owner[i]);
-            free(g->area_id[i]);
-        }
-        free(g->owner);
-        free(g->area_id);
-    }
-    return ok;
-}
-
 static uint32_t digit_count(uint32_t n) {
     if (n == 0) {
         return 1;
@@ -201,46 +269,192 @@ static uint32_t bordering_area_id(gamma_t *g, uint32_t player,
     if (!player_correct(g, player) || x >= g->width || y >= g->height) {
         return 0;
     }
+    uint32_t field = board_field(&g->board, x, y);
     uint32_t id = 0;
-    if (x > 0 && g->owner[y][x - 1] == player) {
-        id = g->area_id[y][x - 1];
+    for (uint32_t i = 0; i < BOARD_SIDES; ++i) {
+        uint32_t neighbour = field + g->board.side[i];
+        if (board_owner(&g->board, neighbour) == player) {
+            id = board_area_id(&g->board, neighbour);
+        }
     }
-    if (x < (g->width - 1) && g->owner[y][x + 1] == player) {
-        id = g->area_id[y][x + 1];
+    return id;
+}
+
+static void set_owner(gamma_t *g, uint32_t field, uint32_t player) {
+    journal_log(&g->journal, JOURNAL_OWNER, field,
+                board_owner(&g->board, field));
+    board_set_owner(&g->board, field, player);
+}
+
+static void set_area_id(gamma_t *g, uint32_t field, uint32_t id) {
+    journal_log(&g->journal, JOURNAL_AREA_ID, field,
+                board_area_id(&g->board, field));
+    board_set_area_id(&g->board, field, id);
+}
+
+static void log_counters(gamma_t *g, uint32_t player) {
+    journal_log(&g->journal, JOURNAL_AREA_COUNT, player,
+                g->area_count[player]);
+    journal_log(&g->journal, JOURNAL_OCCUPIED, player,
+                g->occupied_count[player]);
+    journal_log(&g->journal, JOURNAL_FRONTIER, player,
+                g->frontier_count[player]);
+}
+
+static void hash_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y,
+                      uint32_t previous_owner, bool golden) {
+    uint32_t players = g->player_count;
+    uint32_t turn = player % players + 1;
+    journal_log(&g->journal, JOURNAL_HASH, 0, g->hash);
+    journal_log(&g->journal, JOURNAL_TURN, 0, g->turn);
+    g->hash ^= zobrist_owner(g->width, players, x, y, previous_owner) ^
+               zobrist_owner(g->width, players, x, y, player) ^
+               zobrist_key(ZOBRIST_TURN, g->turn) ^
+               zobrist_key(ZOBRIST_TURN, turn);
+    if (golden) {
+        g->hash ^= zobrist_key(ZOBRIST_GOLDEN, player);
+    }
+    g->turn = turn;
+}
+
+static void restore(gamma_t *g, const journal_entry_t *entry) {
+    switch (entry->kind) {
+        case JOURNAL_OWNER:
+            board_set_owner(&g->board, entry->index, entry->old);
+            break;
+        case JOURNAL_AREA_ID:
+            board_set_area_id(&g->board, entry->index, entry->old);
+            break;
+        case JOURNAL_PARENT:
+            areas_set_parent(&g->areas, entry->index, entry->old);
+            break;
+        case JOURNAL_SIZE:
+            areas_set_size(&g->areas, entry->index, entry->old);
+            break;
+        case JOURNAL_NODES:
+            g->areas.count = entry->old;
+            break;
+        case JOURNAL_AREA_COUNT:
+            g->area_count[entry->index] = entry->old;
+            break;
+        case JOURNAL_OCCUPIED:
+            g->occupied_count[entry->index] = entry->old;
+            break;
+        case JOURNAL_FRONTIER:
+            g->frontier_count[entry->index] = entry->old;
+            break;
+        case JOURNAL_GOLDEN:
+            g->made_golden_move[entry->index] = entry->old;
+            break;
+        case JOURNAL_FREE:
+            g->free_count = entry->old;
+            break;
+        case JOURNAL_HASH:
+            g->hash = entry->old;
+            break;
+        case JOURNAL_TURN:
+            g->turn = entry->old;
+            break;
     }
-    if (y > 0 && g->owner[y - 1][x] == player) {
-        id = g->area_id[y - 1][x];
+}
+
+static bool reserve_stack(gamma_t *g, uint64_t n) {
+    if (g->area_engine != AREA_ENGINE_RELABEL || n <= g->stack_capacity) {
+        return true;
     }
-    if (y < (g->height - 1) && g->owner[y + 1][x] == player) {
-        id = g->area_id[y + 1][x];
+    uint64_t capacity = 2 * g->stack_capacity;
+    if (capacity < n) {
+        capacity = n;
     }
-    return id;
+    if (capacity > SIZE_MAX / sizeof(uint32_t)) {
+        return false;
+    }
+    uint32_t *stack = realloc(g->stack, sizeof(uint32_t) * capacity);
+    if (!stack) {
+        return false;
+    }
+    g->stack = stack;
+    g->stack_capacity = capacity;
+    return true;
 }
 
-static void merge_areas(gamma_t *g, uint32_t player, uint32_t x,
-                        uint32_t y, uint32_t const *ids, uint32_t length) {
-    if (!player_correct(g, player) || x >= g->width || y >= g->height ||
-        length < 1) {
-        return;
+static bool prepare_pages(gamma_t *g, uint64_t owners, uint64_t ids,
+                          uint64_t nodes) {
+    if (!g->shared) {
+        return true;
     }
-    if (g->owner[y][x] != player) {
-        return;
+    return board_prepare(&g->board) && areas_prepare(&g->areas) &&
+           page_pool_reserve(&g->pool,
+                             board_pages(&g->board, owners, ids) +
+                             areas_pages(&g->areas, nodes));
+}
+
+static uint64_t joined_fields(gamma_t *g, uint32_t player) {
+    /* Przenumerowanie może objąć wszystkie pola gracza. */
+    return g->area_engine == AREA_ENGINE_RELABEL
+           ? g->occupied_count[player] + 1 : 1;
+}
+
+static uint32_t area_of(gamma_t *g, uint32_t field) {
+    return areas_find(&g->areas, board_area_id(&g->board, field));
+}
+
+static uint32_t fill_area(gamma_t *g, uint32_t player, uint32_t field,
+                          uint32_t id) {
+    if (board_owner(&g->board, field) != player || area_of(g, field) == id) {
+        return 0;
     }
-    bool skip = false;
-    uint32_t previous_id = g->area_id[y][x];
-    for (uint32_t i = 0; i < length && !skip; ++i) {
-        if (previous_id == ids[i]) {
-            skip = true;
+    uint32_t filled = 1;
+    uint32_t top = 0;
+    set_area_id(g, field, id);
+    g->stack[top++] = field;
+    while (top > 0) {
+        uint32_t current = g->stack[--top];
+        for (uint32_t i = 0; i < BOARD_SIDES; ++i) {
+            uint32_t neighbour = current + g->board.side[i];
+            if (board_owner(&g->board, neighbour) == player &&
+                area_of(g, neighbour) != id) {
+                set_area_id(g, neighbour, id);
+                g->stack[top++] = neighbour;
+                ++filled;
+            }
         }
     }
-    if (skip) {
+    return filled;
+}
+
+static void join_areas(gamma_t *g, uint32_t player, uint32_t field) {
+    uint32_t ids[BOARD_SIDES];
+    uint32_t length = neighbour_areas(g, player, field, ids);
+    g->area_count[player] -= length - 1;
+    if (length == 0) {
+        uint32_t id = areas_new(&g->areas);
+        set_area_id(g, field, id);
+        areas_add_size(&g->areas, id, 1);
         return;
     }
-    g->area_id[y][x] = ids[length - 1];
-    merge_areas(g, player, x - 1, y, ids, length);
-    merge_areas(g, player, x + 1, y, ids, length);
-    merge_areas(g, player, x, y - 1, ids, length);
-    merge_areas(g, player, x, y + 1, ids, length);
+    uint32_t id = ids[0];
+    if (g->area_engine == AREA_ENGINE_UNION_FIND) {
+        for (uint32_t i = 1; i < length; ++i) {
+            id = areas_union(&g->areas, id, ids[i]);
+        }
+        set_area_id(g, field, id);
+        areas_add_size(&g->areas, id, 1);
+    } else {
+        set_area_id(g, field, id);
+        areas_add_size(&g->areas, id, 1);
+        for (uint32_t i = 0; i < BOARD_SIDES; ++i) {
+            areas_add_size(&g->areas, id,
+                           fill_area(g, player, field + g->board.side[i], id));
+        }
+    }
+}
+
+static void relabel_field(void *arg, uint32_t field) {
+    relabel_t *r = arg;
+    set_area_id(r->g, field, r->id);
+    areas_add_size(&r->g->areas, r->id, 1);
+    areas_add_size(&r->g->areas, r->root, -1);
 }
 
 static void add_distinct(uint32_t *array, uint32_t *length, uint32_t x) {
@@ -253,60 +467,96 @@ static void add_distinct(uint32_t *array, uint32_t *length, uint32_t x) {
     ++(*length);
 }
 
-static uint32_t distinct_neighbour_count(gamma_t *g, uint32_t player,
-                                         uint32_t x, uint32_t y) {
-    if (!player_correct(g, player) || x >= g->width || y >= g->height) {
-        return 0;
-    }
-    uint32_t ids[SIDE_COUNT]; /* Id różnych sąsiednich obszarów gracza. */
+static uint32_t neighbour_areas(gamma_t *g, uint32_t player, uint32_t field,
+                                uint32_t *ids) {
     uint32_t next = 0; /* Liczba elemntów tablicy ids. */
-    if (x > 0 && g->owner[y][x - 1] == player) {
-        add_distinct(ids, &next, g->area_id[y][x - 1]);
+    for (uint32_t i = 0; i < BOARD_SIDES; ++i) {
+        uint32_t neighbour = field + g->board.side[i];
+        if (board_owner(&g->board, neighbour) == player) {
+            add_distinct(ids, &next, area_of(g, neighbour));
+        }
     }
-    if (x < (g->width - 1) && g->owner[y][x + 1] == player) {
-        add_distinct(ids, &next, g->area_id[y][x + 1]);
+    return next;
+}
+
+static uint32_t neighbour_count(gamma_t *g, uint32_t player, uint32_t field) {
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < BOARD_SIDES; ++i) {
+        if (board_owner(&g->board, field + g->board.side[i]) == player) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+static void frontier_after_move(gamma_t *g, uint32_t player, uint32_t field) {
+    uint32_t owners[BOARD_SIDES]; /* Różni gracze na sąsiednich polach. */
+    uint32_t length = 0;
+    for (uint32_t i = 0; i < BOARD_SIDES; ++i) {
+        uint32_t neighbour = field + g->board.side[i];
+        uint32_t owner = board_owner(&g->board, neighbour);
+        if (owner == NOBODY) {
+            if (neighbour_count(g, player, neighbour) == 1) {
+                ++(g->frontier_count[player]);
+            }
+        } else if (owner != g->board.border) {
+            add_distinct(owners, &length, owner);
+        }
     }
-    if (y > 0 && g->owner[y - 1][x] == player) {
-        add_distinct(ids, &next, g->area_id[y - 1][x]);
+    /* Pole przestało być wolnym polem sąsiadującym z graczami obok. */
+    for (uint32_t i = 0; i < length; ++i) {
+        --(g->frontier_count[owners[i]]);
     }
-    if (y < (g->height - 1) && g->owner[y + 1][x] == player) {
-        add_distinct(ids, &next, g->area_id[y + 1][x]);
+}
+
+static void frontier_after_golden_move(gamma_t *g, uint32_t player,
+                                       uint32_t previous_owner,
+                                       uint32_t field) {
+    for (uint32_t i = 0; i < BOARD_SIDES; ++i) {
+        uint32_t neighbour = field + g->board.side[i];
+        if (board_owner(&g->board, neighbour) != NOBODY) {
+            continue;
+        }
+        if (neighbour_count(g, player, neighbour) == 1) {
+            ++(g->frontier_count[player]);
+        }
+        if (neighbour_count(g, previous_owner, neighbour) == 0) {
+            --(g->frontier_count[previous_owner]);
+        }
     }
-    return next;
 }
 
 gamma_t *gamma_new(uint32_t width, uint32_t height,
                    uint32_t players, uint32_t areas) {
+    return gamma_new_backend(width, height, players, areas,
+                             BOARD_BACKEND_ARRAY);
+}
+
+gamma_t *gamma_new_backend(uint32_t width, uint32_t height,
+                           uint32_t players, uint32_t areas,
+                           board_backend_t backend) {
     if (width < 1 || height < 1 || players < 1 || areas < 1) {
         return NULL;
     }
-    gamma_t *g = malloc(sizeof(gamma_t));
+    gamma_t *g = calloc(1, sizeof(gamma_t));
     if (!g) {
         return NULL;
     }
-    g->area_count = malloc(sizeof(uint32_t) * (players + 1));
-    if (!g->area_count) {
-        free(g);
+    page_pool_init(&g->pool);
+    if (!board_init(&g->board, width, height, players, backend, &g->pool)) {
+        gamma_delete(g);
         return NULL;
     }
+    g->area_count = malloc(sizeof(uint32_t) * (players + 1));
     g->made_golden_move = malloc(sizeof(bool) * (players + 1));
-    if (!g->made_golden_move) {
-        free(g->area_count);
-        free(g);
-        return NULL;
-    }
     g->occupied_count = malloc(sizeof(uint64_t) * (players + 1));
-    if (!g->occupied_count) {
-        free(g->made_golden_move);
-        free(g->area_count);
-        free(g);
-        return NULL;
-    }
-    if (!initialize_board(g, width, height)) {
-        free(g->occupied_count);
-        free(g->made_golden_move);
-        free(g->area_count);
-        free(g);
+    g->frontier_count = malloc(sizeof(uint64_t) * (players + 1));
+    if (!g->area_count || !g->made_golden_move || !g->occupied_count ||
+        !g->frontier_count || !areas_init(&g->areas, &g->pool) ||
+        !split_init(&g->split, g->board.size,
+                    backend == BOARD_BACKEND_BIT_PLANES) ||
+        !golden_init(&g->golden, players)) {
+        gamma_delete(g);
         return NULL;
     }
 
@@ -317,10 +567,14 @@ gamma_t *gamma_new(uint32_t width, uint32_t height,
         g->area_count[i] = 0;
         g->made_golden_move[i] = false;
         g->occupied_count[i] = 0;
+        g->frontier_count[i] = 0;
     }
     g->free_count = width;
     g->free_count *= height;
-    g->next_id = 1;
+    g->turn = 1;
+    g->hash = zobrist_key(ZOBRIST_TURN, g->turn);
+    g->area_engine = AREA_ENGINE_UNION_FIND;
+    journal_init(&g->journal);
     g->player_count = players;
     g->frame = digit_count(players);
     return g;
@@ -328,25 +582,106 @@ gamma_t *gamma_new(uint32_t width, uint32_t height,
 
 void gamma_delete(gamma_t *g) {
     if (g != NULL) {
-        if (g->owner != NULL) {
-            for (uint32_t y = 0; y < g->height; ++y) {
-                free(g->owner[y]);
-            }
-        }
-        if (g->area_id != NULL) {
-            for (uint32_t y = 0; y < g->height; ++y) {
-                free(g->area_id[y]);
-            }
-        }
-        free(g->owner);
-        free(g->area_id);
+        board_free(&g->board);
+        areas_free(&g->areas);
+        split_free(&g->split);
+        golden_free(&g->golden);
+        journal_free(&g->journal);
+        free(g->stack);
         free(g->area_count);
         free(g->made_golden_move);
         free(g->occupied_count);
+        free(g->frontier_count);
+        page_pool_free(&g->pool);
+        render_free(g);
         free(g);
     }
 }
 
+bool gamma_reset(gamma_t *g, uint32_t width, uint32_t height,
+                 uint32_t players, uint32_t areas) {
+    if (!g || g->shared || g->width != width || g->height != height ||
+        g->player_count != players || areas < 1) {
+        return false;
+    }
+    board_clear(&g->board);
+    areas_clear(&g->areas);
+    golden_clear(&g->golden);
+    gamma_set_journal(g, false);
+    g->areas_limit = areas;
+    for (uint32_t i = 0; i <= players; ++i) {
+        g->area_count[i] = 0;
+        g->made_golden_move[i] = false;
+        g->occupied_count[i] = 0;
+        g->frontier_count[i] = 0;
+    }
+    g->free_count = width;
+    g->free_count *= height;
+    g->turn = 1;
+    g->hash = zobrist_key(ZOBRIST_TURN, g->turn);
+    g->area_engine = AREA_ENGINE_UNION_FIND;
+    g->mode = 0;
+    g->x = 0;
+    g->y = 0;
+    g->player = 0;
+    g->counter = 0;
+    return true;
+}
+
+gamma_t *gamma_fork(gamma_t *g) {
+    if (!g) {
+        return NULL;
+    }
+    gamma_t *copy = calloc(1, sizeof(gamma_t));
+    if (!copy) {
+        return NULL;
+    }
+    uint32_t players = g->player_count;
+    page_pool_init(&copy->pool);
+    copy->area_count = malloc(sizeof(uint32_t) * (players + 1));
+    copy->made_golden_move = malloc(sizeof(bool) * (players + 1));
+    copy->occupied_count = malloc(sizeof(uint64_t) * (players + 1));
+    copy->frontier_count = malloc(sizeof(uint64_t) * (players + 1));
+    /* Kopia sprawdza rozspójnienie na rzadkich znacznikach, aby nie
+     * alokować tablicy rozmiaru planszy. */
+    if (!copy->area_count || !copy->made_golden_move ||
+        !copy->occupied_count || !copy->frontier_count ||
+        !board_share(&copy->board, &g->board, &copy->pool) ||
+        !areas_share(&copy->areas, &g->areas, &copy->pool) ||
+        !split_init(&copy->split, g->board.size, true) ||
+        !golden_share(&copy->golden, &g->golden)) {
+        gamma_delete(copy);
+        return NULL;
+    }
+    memcpy(copy->area_count, g->area_count, sizeof(uint32_t) * (players + 1));
+    memcpy(copy->made_golden_move, g->made_golden_move,
+           sizeof(bool) * (players + 1));
+    memcpy(copy->occupied_count, g->occupied_count,
+           sizeof(uint64_t) * (players + 1));
+    memcpy(copy->frontier_count, g->frontier_count,
+           sizeof(uint64_t) * (players + 1));
+
+    copy->area_engine = g->area_engine;
+    journal_init(&copy->journal);
+    gamma_set_journal(copy, g->journal.enabled);
+    copy->width = g->width;
+    copy->height = g->height;
+    copy->player_count = players;
+    copy->areas_limit = g->areas_limit;
+    copy->free_count = g->free_count;
+    copy->hash = g->hash;
+    copy->turn = g->turn;
+    copy->frame = g->frame;
+    copy->mode = g->mode;
+    copy->x = g->x;
+    copy->y = g->y;
+    copy->player = g->player;
+    copy->counter = g->counter;
+    g->shared = true;
+    copy->shared = true;
+    return copy;
+}
+
 bool gamma_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y) {
     if (!player_correct(g, player)) {
         return false;
@@ -354,24 +689,39 @@ bool gamma_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y) {
     if (x >= g->width || y >= g->height) {
         return false;
     }
-    if (g->owner[y][x] > NOBODY) {
+    uint32_t field = board_field(&g->board, x, y);
+    if (board_owner(&g->board, field) > NOBODY) {
         return false;
     }
     uint32_t id = bordering_area_id(g, player, x, y);
     if (!id && g->area_count[player] >= g->areas_limit) {
         return false;
     }
+    /* Nowy węzeł i korzenie sąsiednich obszarów. */
+    if (!areas_reserve(&g->areas, 1) || !board_reserve(&g->board, 1) ||
+        !reserve_stack(g, g->occupied_count[player] + 1) ||
+        !prepare_pages(g, 1, joined_fields(g, player), 1 + BOARD_SIDES)) {
+        return false;
+    }
 
-    g->area_count[player] -= distinct_neighbour_count(g, player, x, y) - 1;
-    g->owner[y][x] = player;
+    journal_begin(&g->journal, player, field, false);
+    journal_log(&g->journal, JOURNAL_FREE, 0, g->free_count);
+    log_counters(g, player);
+    for (uint32_t i = 0; i < BOARD_SIDES; ++i) {
+        uint32_t owner = board_owner(&g->board, field + g->board.side[i]);
+        if (owner != NOBODY && owner != g->board.border) {
+            journal_log(&g->journal, JOURNAL_FRONTIER, owner,
+                        g->frontier_count[owner]);
+        }
+    }
+    set_owner(g, field, player);
     ++(g->occupied_count[player]);
     --(g->free_count);
-
-    /* Ustala id łączonego obszaru na jeden z sąsiadujących lub nowy. */
-    id = id ? id : g->next_id;
-    ++(g->next_id);
-    uint32_t ids[1] = {id};
-    merge_areas(g, player, x, y, ids, 1);
+    frontier_after_move(g, player, field);
+    join_areas(g, player, field);
+    hash_move(g, player, x, y, NOBODY, false);
+    golden_touch(g, field, NOBODY);
+    journal_end(&g->journal);
 
     return true;
 }
@@ -387,7 +737,8 @@ static bool check_golden_move_parameters(gamma_t *g, uint32_t player,
     if (g->made_golden_move[player]) {
         return false;
     }
-    if (g->owner[y][x] == player || g->owner[y][x] == NOBODY) {
+    uint32_t owner = board_owner(&g->board, board_field(&g->board, x, y));
+    if (owner == player || owner == NOBODY) {
         return false;
     }
     if (!bordering_area_id(g, player, x, y) &&
@@ -399,48 +750,92 @@ static bool check_golden_move_parameters(gamma_t *g, uint32_t player,
 
 static bool
 golden_move_possible(gamma_t *g, uint32_t player, uint32_t x, uint32_t y,
-                     bool always_reverse) {
+                     uint32_t *pieces) {
     if (!check_golden_move_parameters(g, player, x, y)) {
         return false;
     }
-    uint32_t previous_owner = g->owner[y][x];
-    g->owner[y][x] = player;
-    uint32_t ids[SIDE_COUNT];
-    for (uint32_t i = 0; i < SIDE_COUNT; ++i) {
-        ids[i] = g->next_id;
-        ++(g->next_id);
-    }
-    merge_areas(g, previous_owner, x - 1, y, ids, 1);
-    merge_areas(g, previous_owner, x + 1, y, ids, 2);
-    merge_areas(g, previous_owner, x, y - 1, ids, 3);
-    merge_areas(g, previous_owner, x, y + 1, ids, 4);
-    uint32_t neighbours = distinct_neighbour_count(g, previous_owner, x, y);
-    if (always_reverse ||
-        g->area_count[previous_owner] + neighbours - 1 > g->areas_limit) {
-        g->owner[y][x] = previous_owner;
-        merge_areas(g, previous_owner, x, y, ids, 1);
+    uint32_t field = board_field(&g->board, x, y);
+    uint32_t previous_owner = board_owner(&g->board, field);
+    if (!split_check(g, field, pieces)) {
+        return false;
     }
-    return g->area_count[previous_owner] + neighbours - 1 <= g->areas_limit;
+    return g->area_count[previous_owner] + *pieces - 1 <= g->areas_limit;
 }
 
 bool gamma_golden_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y) {
-    if (!check_golden_move_parameters(g, player, x, y)) {
+    uint32_t pieces;
+    if (!golden_move_possible(g, player, x, y, &pieces)) {
         return false;
     }
-    uint32_t previous_owner = g->owner[y][x];
-    if (golden_move_possible(g, player, x, y, false)) {
-        uint32_t neighbours = distinct_neighbour_count(g, previous_owner, x, y);
-        g->area_count[player] -= distinct_neighbour_count(g, player, x, y) - 1;
-        g->area_count[previous_owner] += neighbours - 1;
-        ++(g->occupied_count[player]);
-        --(g->occupied_count[previous_owner]);
-        g->made_golden_move[player] = true;
-        uint32_t ids[] = {g->next_id};
-        ++(g->next_id);
-        merge_areas(g, player, x, y, ids, 1);
-        return true;
+    /* Każda część poza pierwszą i nowe pole gracza dostają nowy węzeł. */
+    if (!areas_reserve(&g->areas, BOARD_SIDES) ||
+        !reserve_stack(g, g->occupied_count[player] + 1) ||
+        !prepare_pages(g, 1,
+                       split_cut_size(&g->split) + joined_fields(g, player),
+                       1 + 3 * BOARD_SIDES)) {
+        return false;
+    }
+    uint32_t field = board_field(&g->board, x, y);
+    uint32_t previous_owner = board_owner(&g->board, field);
+    journal_begin(&g->journal, player, field, true);
+    log_counters(g, player);
+    log_counters(g, previous_owner);
+    journal_log(&g->journal, JOURNAL_GOLDEN, player,
+                g->made_golden_move[player]);
+    relabel_t relabel = {g, EMPTY, area_of(g, field)};
+    set_owner(g, field, player);
+    areas_add_size(&g->areas, relabel.root, -1);
+    /* Jedna z części zachowuje dotychczasowy korzeń. */
+    for (uint32_t part = 0; part + 1 < pieces; ++part) {
+        relabel.id = areas_new(&g->areas);
+        split_cut_fields(&g->split, part, relabel_field, &relabel);
+    }
+    g->area_count[previous_owner] += pieces - 1;
+    ++(g->occupied_count[player]);
+    --(g->occupied_count[previous_owner]);
+    frontier_after_golden_move(g, player, previous_owner, field);
+    g->made_golden_move[player] = true;
+    join_areas(g, player, field);
+    hash_move(g, player, x, y, previous_owner, true);
+    golden_touch(g, field, previous_owner);
+    journal_end(&g->journal);
+    return true;
+}
+
+bool gamma_undo(gamma_t *g) {
+    if (!g || g->journal.done == 0) {
+        return false;
+    }
+    journal_t *j = &g->journal;
+    const journal_move_t *move = &j->moves[j->done - 1];
+    uint64_t changes = j->length - move->first;
+    if (!prepare_pages(g, changes, changes, changes)) {
+        return false;
+    }
+    --(j->done);
+    while (j->length > move->first) {
+        restore(g, &j->entries[--(j->length)]);
+    }
+    golden_touch(g, move->field, move->player);
+    return true;
+}
+
+bool gamma_redo(gamma_t *g) {
+    if (!g || g->journal.done == g->journal.total) {
+        return false;
     }
-    return false;
+    journal_t *j = &g->journal;
+    journal_move_t move = j->moves[j->done];
+    uint64_t total = j->total;
+    uint32_t x = board_x(&g->board, move.field);
+    uint32_t y = board_y(&g->board, move.field);
+    bool done = move.golden ? gamma_golden_move(g, move.player, x, y)
+                            : gamma_move(g, move.player, x, y);
+    /* Powtórzony ruch nie usuwa kolejnych cofniętych ruchów. */
+    if (done && j->done > 0) {
+        j->total = total;
+    }
+    return done;
 }
 
 uint64_t gamma_busy_fields(gamma_t *g, uint32_t player) {
@@ -460,19 +855,7 @@ uint64_t gamma_free_fields(gamma_t *g, uint32_t player) {
     if (g->area_count[player] > g->areas_limit) {
         return 0;
     }
-
-    /* Licznik wolnych pól sąsiadujących z polem gracza player. */
-    uint64_t counter = 0;
-    for (uint32_t y = 0; y < g->height; ++y) {
-        for (uint32_t x = 0; x < g->width; ++x) {
-            if (g->owner[y][x] == NOBODY) {
-                if (bordering_area_id(g, player, x, y)) {
-                    ++counter;
-                }
-            }
-        }
-    }
-    return counter;
+    return g->frontier_count[player];
 }
 
 bool gamma_golden_possible(gamma_t *g, uint32_t player) {
@@ -482,14 +865,60 @@ bool gamma_golden_possible(gamma_t *g, uint32_t player) {
     if (g->made_golden_move[player]) {
         return false;
     }
-    for (uint32_t y = 0; y < g->height; ++y) {
-        for (uint32_t x = 0; x < g->width; ++x) {
-            if (golden_move_possible(g, player, x, y, true)) {
-                return true;
-            }
-        }
+    if (g->area_count[player] < g->areas_limit) {
+        /* Każdy obszar ma pole, którego usunięcie go nie rozspójnia, więc
+         * wystarczy, że inny gracz ma jakieś pole. */
+        uint64_t occupied = (uint64_t) g->width * g->height - g->free_count;
+        return occupied > g->occupied_count[player];
     }
-    return false;
+    return golden_bordering_possible(g, player);
+}
+
+bool gamma_can_move(gamma_t *g, uint32_t player) {
+    return gamma_free_fields(g, player) > 0 ||
+           gamma_golden_possible(g, player);
+}
+
+uint64_t gamma_hash(gamma_t *g) {
+    return g != NULL ? g->hash : 0;
+}
+
+uint64_t gamma_legal_moves(gamma_t *g, uint32_t player,
+                           gamma_field_t *buffer, uint64_t cap) {
+    uint64_t cursor = 0;
+    return gamma_legal_moves_next(g, player, &cursor, buffer, cap);
+}
+
+uint64_t gamma_legal_moves_next(gamma_t *g, uint32_t player, uint64_t *cursor,
+                                gamma_field_t *buffer, uint64_t cap) {
+    if (!player_correct(g, player) || !cursor || !buffer) {
+        return 0;
+    }
+    /* Liczniki mówią od razu, czy jest jakiekolwiek pole do zajęcia. */
+    uint64_t possible = g->area_count[player] < g->areas_limit
+                        ? g->free_count : g->frontier_count[player];
+    if (possible == 0) {
+        return 0;
+    }
+    return moves_list(g, player, false, cursor, buffer, cap);
+}
+
+uint64_t gamma_legal_golden_moves(gamma_t *g, uint32_t player,
+                                  gamma_field_t *buffer, uint64_t cap) {
+    uint64_t cursor = 0;
+    return gamma_legal_golden_moves_next(g, player, &cursor, buffer, cap);
+}
+
+uint64_t gamma_legal_golden_moves_next(gamma_t *g, uint32_t player,
+                                       uint64_t *cursor,
+                                       gamma_field_t *buffer, uint64_t cap) {
+    if (!player_correct(g, player) || !cursor || !buffer) {
+        return 0;
+    }
+    if (!gamma_golden_possible(g, player)) {
+        return 0;
+    }
+    return moves_list(g, player, true, cursor, buffer, cap);
 }
 
 char *gamma_board(gamma_t *g) {
@@ -497,41 +926,46 @@ char *gamma_board(gamma_t *g) {
         return NULL;
     }
 
-    size_t size = sizeof(char) * (g->frame * g->width + 1) * g->height + 1;
-
-    char *result = malloc(size);
+    size_t size = render_row_size(g) * g->height;
+    char *result = malloc(size + 1);
     if (result == NULL) {
         return NULL;
     }
+    render_rows(g, 0, g->height, result);
+    result[size] = '\0';
+    return result;
+}
 
-    /* Wskaźnik na niestworzony sufiks wyniku. */
-    char *buffer = result;
-    /* Indeks kolejnego znaku do wypełnienia. */
-    uint32_t next = 0;
-    for (uint32_t y = g->height; y > 0; --y) {
-        for (uint32_t x = 0; x < g->width; ++x) {
-            uint32_t owner = g->owner[y - 1][x];
-            if (owner > NOBODY) {
-                sprintf(buffer, "%-*d", g->frame, owner);
-                buffer += g->frame;
-                next += g->frame;
-            } else {
-                result[next] = '.';
-                ++next;
-                for (uint32_t i = 0; i < g->frame - 1; ++i) {
-                    result[next] = ' ';
-                    ++next;
-                }
-                buffer += g->frame;
-            }
-        }
-        sprintf(buffer, "\n");
-        ++buffer;
-        ++next;
+bool gamma_board_fd(gamma_t *g, int fd) {
+    return g != NULL && render_fd(g, fd);
+}
+
+bool gamma_board_write(gamma_t *g, gamma_board_sink_t sink, void *arg) {
+    return g != NULL && gamma_board_write_rows(g, 0, g->height, sink, arg);
+}
+
+bool gamma_board_write_rows(gamma_t *g, uint32_t from, uint32_t to,
+                            gamma_board_sink_t sink, void *arg) {
+    if (!g || !sink || from > to || to > g->height) {
+        return false;
     }
-    return result;
+    return render_write(g, g->height - to, to - from, sink, arg);
 }
 
 uint32_t get_owner(gamma_t *g, int x, int y) {
-    return g->owner[y][x];
+    return board_owner(&g->board, board_field(&g->board, x, y));
+}
+
+void gamma_set_area_engine(gamma_t *g, area_engine_t engine) {
+    if (g != NULL) {
+        g->area_engine = engine;
+    }
+}
+
+void gamma_set_journal(gamma_t *g, bool enabled) {
+    if (g != NULL) {
+        journal_clear(&g->journal);
+        g->journal.enabled = enabled;
+        g->areas.journal = enabled ? &g->journal : NULL;
+    }
 }
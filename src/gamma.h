@@ -7,17 +7,51 @@
  */
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
+#include "areas.h"
+#include "board.h"
+#include "split.h"
+#include "golden.h"
+#include "journal.h"
+#include "moves.h"
+#include "pages.h"
 
 #ifndef GAMMA_H
 #define GAMMA_H
 
+/**
+ * Sposób śledzenia obszarów graczy.
+ */
+typedef enum {
+    /** Łączenie obszarów w lesie zbiorów rozłącznych. */
+    AREA_ENGINE_UNION_FIND,
+    /** Przenumerowanie wszystkich pól łączonych obszarów. */
+    AREA_ENGINE_RELABEL
+} area_engine_t;
+
+/**
+ * Funkcja odbierająca kolejne kawałki wydruku planszy.
+ * Dostaje swój argument, początek kawałka i jego długość. Kawałki nie są
+ * zakończone znakiem '\0' i są ważne tylko w czasie wywołania. Wartość
+ * @p false przerywa wypisywanie.
+ */
+typedef bool (*gamma_board_sink_t)(void *arg, const char *data, size_t size);
+
 /**
  * Struktura przechowująca stan gry.
  */
-typedef struct {
-    uint32_t **owner; /**< Plansza posiadacza danego pola. */
-    uint32_t **area_id; /**< Plansza obszaru do którego należy dane pole. */
+typedef struct gamma {
+    board_t board; /**< Plansza posiadaczy i węzłów obszarów pól. */
+    areas_t areas; /**< Las zbiorów rozłącznych obszarów. */
+    area_engine_t area_engine; /**< Sposób śledzenia obszarów. */
+    split_t split; /**< Stan sprawdzania rozspójnienia obszarów. */
+    golden_t golden; /**< Indeks kandydatów na złoty ruch. */
+    journal_t journal; /**< Dziennik ruchów do cofania. */
+    page_pool_t pool; /**< Pula stron do kopiowania współdzielonych stron. */
+    bool shared; /**< Czy gra może współdzielić strony z inną kopią. */
+    uint32_t *stack; /**< Stos pól przy przeszukiwaniu planszy. */
+    uint64_t stack_capacity; /**< Pojemność stosu pól. */
     uint32_t width; /**< Szerokość planszy. */
     uint32_t height; /**< Wysokość planszy. */
 
@@ -26,11 +60,18 @@ typedef struct {
 
     uint32_t *area_count; /**< Tablica liczby obszarów danego gracza. */
     bool *made_golden_move; /**< Tablica czy dany gracz wykonał złoty ruch. */
-    uint32_t next_id; /**< Następne wolne id (dla nowego obszaru). */
     uint64_t *occupied_count; /**< Tablica liczby zajętych pól gracza. */
+    uint64_t *frontier_count; /**< Tablica liczby wolnych pól sąsiadujących
+                                * z polami gracza. */
     uint64_t free_count; /**< Liczba wolnych pół na planszy. */
+    uint64_t hash; /**< Skrót Zobrista posiadaczy pól, wykonanych złotych
+                     * ruchów i gracza na ruchu. */
+    uint32_t turn; /**< Gracz na ruchu, czyli następny po graczu, który
+                     * wykonał ostatni ruch. */
 
     uint32_t frame; /**< Szerokość jednego pola na wydruku planszy. */
+    char *labels; /**< Napisy pól kolejnych graczy na wydruku planszy lub
+                    * NULL, gdy jeszcze ich nie przygotowano. */
     char mode; /**< Tryb gry. */
     uint32_t x; /**< Odcięta kursora. */
     uint32_t y; /**< Rzędna kursora. */
@@ -52,6 +93,38 @@ typedef struct {
 gamma_t *gamma_new(uint32_t width, uint32_t height,
                    uint32_t players, uint32_t areas);
 
+/** @brief Tworzy strukturę przechowującą stan gry z wybraną planszą.
+ * Działa jak @ref gamma_new, ale pozwala wybrać sposób przechowywania
+ * planszy. Płaszczyzny bitowe zajmują kilka bitów na pole i opłacają się
+ * na dużych planszach z niewieloma graczami.
+ * @param[in] width   – szerokość planszy, liczba dodatnia,
+ * @param[in] height  – wysokość planszy, liczba dodatnia,
+ * @param[in] players – liczba graczy, liczba dodatnia,
+ * @param[in] areas   – maksymalna liczba obszarów,
+ *                      jakie może zająć jeden gracz,
+ * @param[in] backend – sposób przechowywania planszy.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ * zaalokować pamięci lub któryś z parametrów jest niepoprawny.
+ */
+gamma_t *gamma_new_backend(uint32_t width, uint32_t height,
+                           uint32_t players, uint32_t areas,
+                           board_backend_t backend);
+
+/** @brief Tworzy kopię stanu gry.
+ * Kopia współdzieli z grą @p g strony planszy i lasu obszarów oraz listy
+ * kandydatów na złoty ruch, a każda ze struktur kopiuje stronę dopiero przed
+ * pierwszą jej zmianą. Kopia kosztuje więc tyle, co tablice liczników graczy,
+ * niezależnie od rozmiaru planszy. Jedynie rzadka tablica węzłów obszarów
+ * płaszczyzn bitowych jest kopiowana od razu. Kopia nie zachowuje dziennika
+ * ruchów. Kopia, której się nie zmienia, jest migawką stanu gry.
+ * Gra i jej kopie mogą być używane jednocześnie w różnych wątkach, ale jedna
+ * struktura nie może być używana przez kilka wątków naraz.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @return Wskaźnik na kopię lub NULL, gdy nie udało się zaalokować pamięci
+ * lub parametr jest niepoprawny.
+ */
+gamma_t *gamma_fork(gamma_t *g);
+
 /** @brief Usuwa strukturę przechowującą stan gry.
  * Usuwa z pamięci strukturę wskazywaną przez @p g.
  * Nic nie robi, jeśli wskaźnik ten ma wartość NULL.
@@ -59,6 +132,22 @@ gamma_t *gamma_new(uint32_t width, uint32_t height,
  */
 void gamma_delete(gamma_t *g);
 
+/** @brief Przywraca początkowy stan gry o podanych parametrach.
+ * Używa pamięci gry @p g zamiast alokować nową, co jest możliwe tylko wtedy,
+ * gdy gra ma te same wymiary planszy i liczbę graczy oraz nigdy nie
+ * współdzieliła stron z kopią. Dziennik ruchów jest wyłączany.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] width   – szerokość planszy, liczba dodatnia,
+ * @param[in] height  – wysokość planszy, liczba dodatnia,
+ * @param[in] players – liczba graczy, liczba dodatnia,
+ * @param[in] areas   – maksymalna liczba obszarów,
+ *                      jakie może zająć jeden gracz.
+ * @return Wartość @p true, jeśli gra jest w stanie początkowym, a @p false,
+ * gdy nie da się jej użyć dla tych parametrów. Wtedy gra się nie zmienia.
+ */
+bool gamma_reset(gamma_t *g, uint32_t width, uint32_t height,
+                 uint32_t players, uint32_t areas);
+
 /** @brief Wykonuje ruch.
  * Ustawia pionek gracza @p player na polu (@p x, @p y).
  * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
@@ -122,6 +211,94 @@ uint64_t gamma_free_fields(gamma_t *g, uint32_t player);
  */
 bool gamma_golden_possible(gamma_t *g, uint32_t player);
 
+/** @brief Sprawdza, czy gracz może wykonać jakikolwiek ruch.
+ * Sprawdza, czy gracz @p player może postawić pionek na wolnym polu lub
+ * wykonać złoty ruch. Zapytanie o gracza, któremu od poprzedniego zapytania
+ * nie przybyło pól ani kandydatów na złoty ruch, nie przegląda ponownie jego
+ * sąsiadów, więc pomijanie graczy bez ruchu nie zależy od rozmiaru planszy.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new.
+ * @return Wartość @p true, jeśli gracz może wykonać ruch, a @p false
+ * w przeciwnym przypadku lub gdy któryś z parametrów jest niepoprawny.
+ */
+bool gamma_can_move(gamma_t *g, uint32_t player);
+
+/** @brief Podaje skrót pozycji gry.
+ * Skrót jest aktualizowany przy każdym ruchu i obejmuje posiadaczy
+ * wszystkich pól, graczy, którzy wykonali złoty ruch, oraz gracza na ruchu,
+ * czyli następnego po graczu, który wykonał ostatni ruch. Pozycje
+ * osiągnięte różnymi kolejnościami ruchów mają ten sam skrót. Cofnięcie
+ * ruchu przywraca poprzedni skrót.
+ * @param[in] g – wskaźnik na strukturę przechowującą stan gry,
+ * @return Skrót pozycji lub 0, gdy @p g jest NULL.
+ */
+uint64_t gamma_hash(gamma_t *g);
+
+/** @brief Wylicza pola, na których gracz może postawić pionek.
+ * Zapisuje do bufora @p buffer najwyżej @p cap pól, na których gracz
+ * @p player może wykonać ruch funkcją @ref gamma_move, w kolejności wierszy
+ * od zerowego. Jest równoważne wywołaniu @ref gamma_legal_moves_next
+ * z kursorem równym zero.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new,
+ * @param[out] buffer – tablica na co najmniej @p cap pól,
+ * @param[in] cap     – największa liczba zapisanych pól.
+ * @return Liczba zapisanych pól lub zero, jeśli któryś z parametrów jest
+ * niepoprawny.
+ */
+uint64_t gamma_legal_moves(gamma_t *g, uint32_t player,
+                           gamma_field_t *buffer, uint64_t cap);
+
+/** @brief Wylicza kolejną porcję pól, na których gracz może postawić pionek.
+ * Pozwala przeglądać legalne ruchy na dużych planszach porcjami w buforze
+ * stałego rozmiaru. Pierwsze wywołanie wymaga kursora równego zero, a każde
+ * następne zaczyna tam, gdzie skończyło poprzednie. Wszystkie ruchy zostały
+ * wyliczone, gdy funkcja zapisze mniej niż @p cap pól. Między wywołaniami
+ * nie wolno zmieniać stanu gry.
+ * @param[in,out] g      – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player     – numer gracza, liczba dodatnia niewiększa od
+ *                         wartości @p players z funkcji @ref gamma_new,
+ * @param[in,out] cursor – pozycja wyliczania,
+ * @param[out] buffer    – tablica na co najmniej @p cap pól,
+ * @param[in] cap        – największa liczba zapisanych pól.
+ * @return Liczba zapisanych pól lub zero, jeśli któryś z parametrów jest
+ * niepoprawny.
+ */
+uint64_t gamma_legal_moves_next(gamma_t *g, uint32_t player, uint64_t *cursor,
+                                gamma_field_t *buffer, uint64_t cap);
+
+/** @brief Wylicza pola, które gracz może przejąć złotym ruchem.
+ * Działa jak @ref gamma_legal_moves dla ruchów, które wykonałaby funkcja
+ * @ref gamma_golden_move.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new,
+ * @param[out] buffer – tablica na co najmniej @p cap pól,
+ * @param[in] cap     – największa liczba zapisanych pól.
+ * @return Liczba zapisanych pól lub zero, jeśli któryś z parametrów jest
+ * niepoprawny.
+ */
+uint64_t gamma_legal_golden_moves(gamma_t *g, uint32_t player,
+                                  gamma_field_t *buffer, uint64_t cap);
+
+/** @brief Wylicza kolejną porcję pól, które gracz może przejąć złotym ruchem.
+ * Działa jak @ref gamma_legal_moves_next dla ruchów, które wykonałaby
+ * funkcja @ref gamma_golden_move.
+ * @param[in,out] g      – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player     – numer gracza, liczba dodatnia niewiększa od
+ *                         wartości @p players z funkcji @ref gamma_new,
+ * @param[in,out] cursor – pozycja wyliczania,
+ * @param[out] buffer    – tablica na co najmniej @p cap pól,
+ * @param[in] cap        – największa liczba zapisanych pól.
+ * @return Liczba zapisanych pól lub zero, jeśli któryś z parametrów jest
+ * niepoprawny.
+ */
+uint64_t gamma_legal_golden_moves_next(gamma_t *g, uint32_t player,
+                                       uint64_t *cursor,
+                                       gamma_field_t *buffer, uint64_t cap);
+
 /** @brief Daje napis opisujący stan planszy.
  * Alokuje w pamięci bufor, w którym umieszcza napis zawierający tekstowy
  * opis aktualnego stanu planszy. Przykład znajduje się w pliku gamma_test.c.
@@ -132,6 +309,48 @@ bool gamma_golden_possible(gamma_t *g, uint32_t player);
  */
 char *gamma_board(gamma_t *g);
 
+/** @brief Wypisuje stan planszy do deskryptora pliku.
+ * Wypisuje ten sam napis co @ref gamma_board, ale kawałkami przez bufor
+ * stałego rozmiaru, bez alokowania pamięci na całą planszę.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] fd      – deskryptor pliku.
+ * @return Wartość @p true, jeśli wypisano całą planszę, a @p false, gdy
+ * któryś z parametrów jest niepoprawny, nie udało się zaalokować bufora
+ * lub zapis się nie powiódł.
+ */
+bool gamma_board_fd(gamma_t *g, int fd);
+
+/** @brief Przekazuje stan planszy kawałkami.
+ * Przekazuje funkcji @p sink ten sam napis co @ref gamma_board, kolejno,
+ * w kawałkach ograniczonej długości. Pamięć potrzebna do wypisania nie
+ * zależy od rozmiaru planszy.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] sink    – funkcja odbierająca kolejne kawałki,
+ * @param[in] arg     – pierwszy argument funkcji @p sink.
+ * @return Wartość @p true, jeśli przekazano całą planszę, a @p false, gdy
+ * któryś z parametrów jest niepoprawny, nie udało się zaalokować bufora
+ * lub funkcja @p sink przerwała wypisywanie.
+ */
+bool gamma_board_write(gamma_t *g, gamma_board_sink_t sink, void *arg);
+
+/** @brief Przekazuje kawałkami wiersze planszy z danego zakresu.
+ * Działa jak @ref gamma_board_write, ale tylko dla wierszy o numerach od
+ * @p from do @p to - 1, które są wypisywane, tak jak cała plansza, od
+ * najwyższego. Pozwala oglądać fragment dużej planszy.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] from    – numer najniższego wiersza,
+ * @param[in] to      – numer o jeden większy od numeru najwyższego wiersza,
+ *                      liczba niewiększa od wartości @p height z funkcji
+ *                      @ref gamma_new,
+ * @param[in] sink    – funkcja odbierająca kolejne kawałki,
+ * @param[in] arg     – pierwszy argument funkcji @p sink.
+ * @return Wartość @p true, jeśli przekazano wszystkie wiersze, a @p false,
+ * gdy któryś z parametrów jest niepoprawny, nie udało się zaalokować bufora
+ * lub funkcja @p sink przerwała wypisywanie.
+ */
+bool gamma_board_write_rows(gamma_t *g, uint32_t from, uint32_t to,
+                            gamma_board_sink_t sink, void *arg);
+
 /** @brief Daje numer gracza będącego właścicielem danego pola.
  * Daje numer gracza w grze G będącego właścicielem danego pola (X, Y).
  * @param[in] g       – wskaźnik na strukturę przechowującą stan gry.
@@ -143,4 +362,44 @@ char *gamma_board(gamma_t *g);
  */
 uint32_t get_owner(gamma_t *g, int x, int y);
 
+/** @brief Ustawia sposób śledzenia obszarów.
+ * Od następnego ruchu gra @p g łączy obszary zgodnie z @p engine. Zmiana jest
+ * możliwa w dowolnym momencie rozgrywki i nie wpływa na jej przebieg, a jedynie
+ * na koszt ruchów. Domyślnie używany jest @ref AREA_ENGINE_UNION_FIND.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] engine  – sposób śledzenia obszarów.
+ */
+void gamma_set_area_engine(gamma_t *g, area_engine_t engine);
+
+/** @brief Włącza lub wyłącza dziennik ruchów.
+ * Gdy dziennik jest włączony, każdy ruch zapisuje zmienione pola, liczniki
+ * graczy i zmiany obszarów, co pozwala go cofnąć funkcją @ref gamma_undo.
+ * Domyślnie dziennik jest wyłączony. Zmiana ustawienia usuwa dotychczasowy
+ * dziennik. Jeśli zabraknie pamięci na zapisanie ruchu, dziennik jest
+ * usuwany.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] enabled – czy zapisywać ruchy.
+ */
+void gamma_set_journal(gamma_t *g, bool enabled);
+
+/** @brief Cofa ostatni ruch.
+ * Przywraca stan gry sprzed ostatniego niecofniętego ruchu lub złotego
+ * ruchu zapisanego w dzienniku. Koszt jest proporcjonalny do liczby zmian
+ * wprowadzonych przez ten ruch.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @return Wartość @p true, jeśli ruch został cofnięty, a @p false, gdy
+ * w dzienniku nie ma ruchu do cofnięcia, nie udało się zaalokować pamięci
+ * lub parametr jest niepoprawny.
+ */
+bool gamma_undo(gamma_t *g);
+
+/** @brief Powtarza ostatnio cofnięty ruch.
+ * Wykonanie innego ruchu niż powtórzenie usuwa cofnięte ruchy z dziennika.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @return Wartość @p true, jeśli ruch został powtórzony, a @p false, gdy
+ * nie ma cofniętego ruchu, nie udało się zaalokować pamięci lub parametr
+ * jest niepoprawny.
+ */
+bool gamma_redo(gamma_t *g);
+
 #endif /* GAMMA_H */
@@ -0,0 +1,573 @@
+/** @file
+ * Mikrobenchmarki silnika gry gamma.
+ *
+ * Każde obciążenie jest uruchamiane dla kilku rozmiarów planszy, liczb
+ * graczy, sposobów przechowywania planszy i sposobów śledzenia obszarów
+ * w osobnym procesie potomnym,
+ * aby szczytowe zużycie pamięci dotyczyło tylko niego. Ruchy są losowane
+ * generatorem o stałym ziarnie, więc kolejne uruchomienia wykonują te same
+ * operacje. Czas jest mierzony dla całych pętli wywołań jednej funkcji
+ * silnika, a nie dla pojedynczych wywołań, więc obejmuje też losowanie
+ * współrzędnych. Obciążenie, w którym nie uda się wywołanie, które musi się
+ * udać, jest przerywane, a program kończy się kodem błędu.
+ *
+ * @author Marcin Malejky
+ */
+
+#define _POSIX_C_SOURCE 200809L /**< Dostęp do clock_gettime i fork. */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include "gamma.h"
+#include "playout.h"
+
+#define BENCH_SEED 2020 /**< Domyślne ziarno generatora. */
+#define BENCH_FILL 2 /**< Liczba prób ruchu na pole przy losowym
+                      * zapełnianiu planszy. */
+#define BENCH_GOLDEN 256 /**< Liczba prób złotego ruchu na gracza. */
+#define BENCH_QUERIES 1000000 /**< Przybliżona liczba zapytań o graczy. */
+#define BENCH_FORKS 1000 /**< Liczba kopii gry. */
+#define BENCH_PRINTS 4 /**< Liczba wydruków planszy. */
+#define BENCH_MOVES 4096 /**< Rozmiar bufora wyliczanych ruchów. */
+
+/**
+ * Parametry jednego uruchomienia obciążenia.
+ */
+typedef struct {
+    uint32_t width; /**< Szerokość planszy. */
+    uint32_t height; /**< Wysokość planszy. */
+    uint32_t players; /**< Liczba graczy. */
+    uint32_t areas; /**< Maksymalna liczba obszarów gracza. */
+    board_backend_t backend; /**< Sposób przechowywania planszy. */
+    area_engine_t engine; /**< Sposób śledzenia obszarów. */
+} bench_case_t;
+
+/**
+ * Funkcja wykonująca obciążenie silnika i wypisująca jego wyniki.
+ * Zwraca @p false, gdy obciążenie zostało przerwane.
+ */
+typedef bool (*bench_workload_t)(const bench_case_t *c, uint64_t seed);
+
+/** @brief Zapełnia losowo planszę.
+ * Mierzy ruchy na losowych polach wykonywane przez kolejnych graczy,
+ * a potem zapytania o liczbę pól graczy.
+ * @param[in] c    – wskaźnik na parametry uruchomienia,
+ * @param[in] seed – ziarno generatora,
+ * @return Wartość @p true, jeśli udało się utworzyć grę.
+ */
+static bool random_fill(const bench_case_t *c, uint64_t seed);
+
+/** @brief Buduje z pasów jeden wąż i cofa jego budowę.
+ * Gracz pierwszy zajmuje co drugi wiersz, a potem łączy kolejne pasy na
+ * przemian z prawej i lewej strony, więc każde połączenie scala duży obszar
+ * z następnym pasem. Cofnięcie i powtórzenie połączeń rozdziela i scala
+ * obszary z powrotem, a złote ruchy pozostałych graczy przecinają węża.
+ * Limit obszarów jest równy wysokości planszy, więc każde połączenie,
+ * cofnięcie i powtórzenie musi się udać.
+ * @param[in] c    – wskaźnik na parametry uruchomienia,
+ * @param[in] seed – ziarno generatora,
+ * @return Wartość @p true, jeśli wszystkie połączenia, cofnięcia
+ * i powtórzenia się udały, a @p false w przeciwnym przypadku.
+ */
+static bool snake(const bench_case_t *c, uint64_t seed);
+
+/** @brief Mierzy złote ruchy na zapełnionej planszy.
+ * Po losowym zapełnieniu planszy każdy gracz na zmianę próbuje złotego ruchu
+ * na losowym polu, dopóki go nie wykona albo nie wyczerpie prób.
+ * @param[in] c    – wskaźnik na parametry uruchomienia,
+ * @param[in] seed – ziarno generatora,
+ * @return Wartość @p true, jeśli udało się utworzyć grę.
+ */
+static bool golden_endgame(const bench_case_t *c, uint64_t seed);
+
+/** @brief Mierzy zapytania o ruchy graczy, którzy osiągnęli limit obszarów.
+ * Po losowym zapełnieniu planszy pyta wielokrotnie o wszystkich graczy.
+ * @param[in] c    – wskaźnik na parametry uruchomienia,
+ * @param[in] seed – ziarno generatora,
+ * @return Wartość @p true, jeśli udało się utworzyć grę.
+ */
+static bool limit_queries(const bench_case_t *c, uint64_t seed);
+
+/** @brief Mierzy funkcje odczytujące i kopiujące pozycję.
+ * Po losowych ruchach, które zostawiają wolne pola, mierzy skrót pozycji,
+ * wyliczanie wszystkich ruchów i złotych ruchów każdego gracza, wydruk
+ * planszy oraz kopie gry, z których każda wykonuje jeden ruch.
+ * @param[in] c    – wskaźnik na parametry uruchomienia,
+ * @param[in] seed – ziarno generatora,
+ * @return Wartość @p true, jeśli wszystkie wydruki i kopie się udały,
+ * a @p false w przeciwnym przypadku.
+ */
+static bool position(const bench_case_t *c, uint64_t seed);
+
+/** @brief Wykonuje losowe ruchy kolejnych graczy bez pomiaru czasu.
+ * @param[in,out] g     – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] c         – wskaźnik na parametry uruchomienia,
+ * @param[in,out] state – wskaźnik na stan generatora.
+ */
+static void scatter(gamma_t *g, const bench_case_t *c, uint64_t *state);
+
+/** @brief Tworzy grę o parametrach uruchomienia.
+ * @param[in] c – wskaźnik na parametry uruchomienia,
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się jej
+ * utworzyć.
+ */
+static gamma_t *bench_new(const bench_case_t *c);
+
+/** @brief Zapełnia planszę bez pomiaru czasu.
+ * Po losowych ruchach zajmuje po kolei pola, które ktoś jeszcze może zająć.
+ * @param[in,out] g     – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] c         – wskaźnik na parametry uruchomienia,
+ * @param[in,out] state – wskaźnik na stan generatora.
+ */
+static void fill(gamma_t *g, const bench_case_t *c, uint64_t *state);
+
+/** @brief Wylicza wszystkie ruchy gracza porcjami.
+ * @param[in,out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player – numer gracza,
+ * @param[in] golden – czy wyliczać złote ruchy zamiast zwykłych,
+ * @return Liczba ruchów.
+ */
+static uint64_t count_moves(gamma_t *g, uint32_t player, bool golden);
+
+/** @brief Zlicza znaki wydruku planszy.
+ * Ma postać funkcji odbierającej kawałki wydruku planszy.
+ * @param[in,out] arg – wskaźnik na licznik znaków,
+ * @param[in] data    – początek kawałka,
+ * @param[in] size    – długość kawałka,
+ * @return Wartość @p true.
+ */
+static bool count_chars(void *arg, const char *data, size_t size);
+
+/** @brief Zgłasza nieudane wywołanie, które musiało się udać.
+ * @param[in] done     – czy wszystkie wywołania się udały,
+ * @param[in] workload – nazwa obciążenia,
+ * @param[in] entry    – nazwa mierzonej funkcji,
+ * @param[in] c        – wskaźnik na parametry uruchomienia,
+ * @return Wartość @p done.
+ */
+static bool expect(bool done, const char *workload, const char *entry,
+                   const bench_case_t *c);
+
+/** @brief Podaje czas monotoniczny.
+ * @return Czas w nanosekundach.
+ */
+static uint64_t now_ns(void);
+
+/** @brief Wypisuje wynik pomiaru jednej funkcji silnika.
+ * @param[in] workload – nazwa obciążenia,
+ * @param[in] entry    – nazwa mierzonej funkcji,
+ * @param[in] c        – wskaźnik na parametry uruchomienia,
+ * @param[in] ops      – liczba wywołań,
+ * @param[in] ns       – łączny czas wywołań w nanosekundach.
+ */
+static void report(const char *workload, const char *entry,
+                   const bench_case_t *c, uint64_t ops, uint64_t ns);
+
+/** @brief Uruchamia obciążenie w procesie potomnym.
+ * Jeśli nie uda się utworzyć procesu, uruchamia obciążenie w bieżącym.
+ * @param[in] run  – obciążenie,
+ * @param[in] c    – wskaźnik na parametry uruchomienia,
+ * @param[in] seed – ziarno generatora,
+ * @return Wartość @p true, jeśli obciążenie się zakończyło, a @p false,
+ * gdy zostało przerwane.
+ */
+static bool run_isolated(bench_workload_t run, const bench_case_t *c,
+                         uint64_t seed);
+
+/**
+ * Wynik zapytań, który nie pozwala kompilatorowi pominąć wywołań.
+ */
+static volatile uint64_t sink;
+
+/**
+ * Mierzone obciążenia.
+ */
+static const bench_workload_t workloads[] = {
+    random_fill,
+    snake,
+    golden_endgame,
+    limit_queries,
+    position,
+};
+
+/**
+ * Parametry uruchomień każdego obciążenia.
+ */
+static const bench_case_t cases[] = {
+    {10, 10, 2, 2, BOARD_BACKEND_ARRAY, AREA_ENGINE_UNION_FIND},
+    {10, 10, 8, 2, BOARD_BACKEND_ARRAY, AREA_ENGINE_UNION_FIND},
+    {100, 100, 2, 4, BOARD_BACKEND_ARRAY, AREA_ENGINE_UNION_FIND},
+    {100, 100, 8, 4, BOARD_BACKEND_ARRAY, AREA_ENGINE_UNION_FIND},
+    {100, 100, 8, 4, BOARD_BACKEND_ARRAY, AREA_ENGINE_RELABEL},
+    {100, 100, 64, 2, BOARD_BACKEND_ARRAY, AREA_ENGINE_UNION_FIND},
+    {100, 100, 8, 4, BOARD_BACKEND_BIT_PLANES, AREA_ENGINE_UNION_FIND},
+    {1000, 1000, 8, 8, BOARD_BACKEND_ARRAY, AREA_ENGINE_UNION_FIND},
+    {1000, 1000, 8, 8, BOARD_BACKEND_ARRAY, AREA_ENGINE_RELABEL},
+    {1000, 1000, 64, 4, BOARD_BACKEND_ARRAY, AREA_ENGINE_UNION_FIND},
+    {1000, 1000, 8, 8, BOARD_BACKEND_BIT_PLANES, AREA_ENGINE_UNION_FIND},
+};
+
+/** @brief Uruchamia wszystkie mikrobenchmarki.
+ * Wypisuje dla każdej mierzonej funkcji silnika liczbę wywołań, średni czas
+ * wywołania, liczbę wywołań na sekundę i szczytowe zużycie pamięci procesu
+ * obciążenia w kilobajtach.
+ * @param[in] argc – liczba argumentów,
+ * @param[in] argv – argumenty: opcjonalne ziarno generatora,
+ * @return Zero, gdy wszystkie obciążenia się zakończyły, a jeden, gdy
+ * któreś zostało przerwane.
+ */
+int main(int argc, char *argv[]) {
+    uint64_t seed = argc > 1 ? strtoull(argv[1], NULL, 10) : BENCH_SEED;
+    printf("%-8s %-24s %-11s %4s %5s %-6s %-7s %10s %10s %12s %9s\n",
+           "workload", "entry", "board", "pl", "areas", "store", "engine",
+           "ops", "ns/op", "ops/s", "rss_kb");
+    size_t workload_count = sizeof(workloads) / sizeof(workloads[0]);
+    size_t case_count = sizeof(cases) / sizeof(cases[0]);
+    bool done = true;
+    for (size_t i = 0; i < workload_count; ++i) {
+        for (size_t j = 0; j < case_count; ++j) {
+            done &= run_isolated(workloads[i], &cases[j], seed);
+        }
+    }
+    return done ? 0 : 1;
+}
+
+static bool random_fill(const bench_case_t *c, uint64_t seed) {
+    gamma_t *g = bench_new(c);
+    if (!g) {
+        return expect(false, "new", "gamma_new_backend", c);
+    }
+    uint64_t state = seed;
+    uint64_t ops = (uint64_t) c->width * c->height * BENCH_FILL;
+    uint64_t start = now_ns();
+    for (uint64_t i = 0; i < ops; ++i) {
+        uint64_t r = playout_random(&state);
+        gamma_move(g, i % c->players + 1, r % c->width,
+                   (r >> 32) % c->height);
+    }
+    report("fill", "gamma_move", c, ops, now_ns() - start);
+
+    uint64_t rounds = BENCH_QUERIES / c->players;
+    uint64_t sum = 0;
+    start = now_ns();
+    for (uint64_t i = 0; i < rounds; ++i) {
+        for (uint32_t player = 1; player <= c->players; ++player) {
+            sum += gamma_busy_fields(g, player);
+        }
+    }
+    report("fill", "gamma_busy_fields", c, rounds * c->players,
+           now_ns() - start);
+    sink = sum;
+    gamma_delete(g);
+    return true;
+}
+
+static bool snake(const bench_case_t *c, uint64_t seed) {
+    (void) seed;
+    bench_case_t limited = *c;
+    limited.areas = c->height;
+    c = &limited;
+    gamma_t *g = bench_new(c);
+    if (!g) {
+        return expect(false, "new", "gamma_new_backend", c);
+    }
+    uint64_t start = now_ns();
+    for (uint32_t y = 0; y < c->height; y += 2) {
+        for (uint32_t x = 0; x < c->width; ++x) {
+            gamma_move(g, 1, x, y);
+        }
+    }
+    uint64_t stripes = (uint64_t) (c->height + 1) / 2 * c->width;
+    report("snake", "gamma_move", c, stripes, now_ns() - start);
+
+    /* Tylko połączenia trafiają do dziennika, więc cofnięcia rozdzielają
+     * węża z powrotem na pasy. */
+    gamma_set_journal(g, true);
+    uint64_t links = c->height / 2;
+    bool done = true;
+    start = now_ns();
+    for (uint32_t y = 1; y < c->height; y += 2) {
+        done &= gamma_move(g, 1, y % 4 == 1 ? c->width - 1 : 0, y);
+    }
+    uint64_t ns = now_ns() - start;
+    if (!expect(done, "snake", "gamma_move/merge", c)) {
+        gamma_delete(g);
+        return false;
+    }
+    report("snake", "gamma_move/merge", c, links, ns);
+
+    start = now_ns();
+    for (uint64_t i = 0; i < links; ++i) {
+        done &= gamma_undo(g);
+    }
+    ns = now_ns() - start;
+    if (!expect(done, "snake", "gamma_undo/split", c)) {
+        gamma_delete(g);
+        return false;
+    }
+    report("snake", "gamma_undo/split", c, links, ns);
+
+    start = now_ns();
+    for (uint64_t i = 0; i < links; ++i) {
+        done &= gamma_redo(g);
+    }
+    ns = now_ns() - start;
+    if (!expect(done, "snake", "gamma_redo/merge", c)) {
+        gamma_delete(g);
+        return false;
+    }
+    report("snake", "gamma_redo/merge", c, links, ns);
+
+    /* Każdy złoty ruch przecina jeden pas węża w połowie. */
+    uint64_t cuts = 0;
+    start = now_ns();
+    for (uint32_t player = 2; player <= c->players; ++player) {
+        uint32_t y = 2 * ((player - 2) % ((c->height + 1) / 2));
+        cuts += gamma_golden_move(g, player, c->width / 2, y);
+    }
+    report("snake", "gamma_golden_move/cut", c, c->players - 1,
+           now_ns() - start);
+    sink = cuts;
+    gamma_delete(g);
+    return true;
+}
+
+static bool golden_endgame(const bench_case_t *c, uint64_t seed) {
+    gamma_t *g = bench_new(c);
+    if (!g) {
+        return expect(false, "new", "gamma_new_backend", c);
+    }
+    uint64_t state = seed;
+    fill(g, c, &state);
+    uint64_t ops = 0;
+    uint64_t done = 0;
+    uint64_t start = now_ns();
+    for (uint32_t round = 0; round < BENCH_GOLDEN; ++round) {
+        for (uint32_t player = 1; player <= c->players; ++player) {
+            uint64_t r = playout_random(&state);
+            ++ops;
+            done += gamma_golden_move(g, player, r % c->width,
+                                      (r >> 32) % c->height);
+        }
+        if (done == c->players) {
+            break;
+        }
+    }
+    report("golden", "gamma_golden_move", c, ops, now_ns() - start);
+    sink = done;
+    gamma_delete(g);
+    return true;
+}
+
+static bool limit_queries(const bench_case_t *c, uint64_t seed) {
+    gamma_t *g = bench_new(c);
+    if (!g) {
+        return expect(false, "new", "gamma_new_backend", c);
+    }
+    uint64_t state = seed;
+    fill(g, c, &state);
+    uint64_t rounds = BENCH_QUERIES / c->players;
+    uint64_t ops = rounds * c->players;
+    uint64_t sum = 0;
+    uint64_t start = now_ns();
+    for (uint64_t i = 0; i < rounds; ++i) {
+        for (uint32_t player = 1; player <= c->players; ++player) {
+            sum += gamma_free_fields(g, player);
+        }
+    }
+    report("limit", "gamma_free_fields", c, ops, now_ns() - start);
+
+    start = now_ns();
+    for (uint64_t i = 0; i < rounds; ++i) {
+        for (uint32_t player = 1; player <= c->players; ++player) {
+            sum += gamma_golden_possible(g, player);
+        }
+    }
+    report("limit", "gamma_golden_possible", c, ops, now_ns() - start);
+
+    start = now_ns();
+    for (uint64_t i = 0; i < rounds; ++i) {
+        for (uint32_t player = 1; player <= c->players; ++player) {
+            sum += gamma_can_move(g, player);
+        }
+    }
+    report("limit", "gamma_can_move", c, ops, now_ns() - start);
+    sink = sum;
+    gamma_delete(g);
+    return true;
+}
+
+static bool position(const bench_case_t *c, uint64_t seed) {
+    gamma_t *g = bench_new(c);
+    if (!g) {
+        return expect(false, "new", "gamma_new_backend", c);
+    }
+    uint64_t state = seed;
+    scatter(g, c, &state);
+    uint64_t sum = 0;
+    uint64_t start = now_ns();
+    for (uint64_t i = 0; i < BENCH_QUERIES; ++i) {
+        sum += gamma_hash(g);
+    }
+    report("position", "gamma_hash", c, BENCH_QUERIES, now_ns() - start);
+
+    start = now_ns();
+    for (uint32_t player = 1; player <= c->players; ++player) {
+        sum += count_moves(g, player, false);
+    }
+    report("position", "gamma_legal_moves", c, c->players, now_ns() - start);
+
+    start = now_ns();
+    for (uint32_t player = 1; player <= c->players; ++player) {
+        sum += count_moves(g, player, true);
+    }
+    report("position", "gamma_legal_golden_moves", c, c->players,
+           now_ns() - start);
+
+    bool done = true;
+    start = now_ns();
+    for (uint32_t i = 0; i < BENCH_PRINTS; ++i) {
+        done &= gamma_board_write(g, count_chars, &sum);
+    }
+    uint64_t ns = now_ns() - start;
+    if (!expect(done, "position", "gamma_board_write", c)) {
+        gamma_delete(g);
+        return false;
+    }
+    report("position", "gamma_board_write", c, BENCH_PRINTS, ns);
+
+    /* Ruch kopii kopiuje strony, które zmienia. */
+    start = now_ns();
+    for (uint32_t i = 0; i < BENCH_FORKS && done; ++i) {
+        gamma_t *copy = gamma_fork(g);
+        done = copy != NULL;
+        uint64_t r = playout_random(&state);
+        sum += gamma_move(copy, i % c->players + 1, r % c->width,
+                          (r >> 32) % c->height);
+        gamma_delete(copy);
+    }
+    ns = now_ns() - start;
+    if (!expect(done, "position", "gamma_fork", c)) {
+        gamma_delete(g);
+        return false;
+    }
+    report("position", "gamma_fork", c, BENCH_FORKS, ns);
+    sink = sum;
+    gamma_delete(g);
+    return true;
+}
+
+static gamma_t *bench_new(const bench_case_t *c) {
+    gamma_t *g = gamma_new_backend(c->width, c->height, c->players,
+                                   c->areas, c->backend);
+    gamma_set_area_engine(g, c->engine);
+    return g;
+}
+
+static void scatter(gamma_t *g, const bench_case_t *c, uint64_t *state) {
+    uint64_t ops = (uint64_t) c->width * c->height * BENCH_FILL;
+    for (uint64_t i = 0; i < ops; ++i) {
+        uint64_t r = playout_random(state);
+        gamma_move(g, i % c->players + 1, r % c->width,
+                   (r >> 32) % c->height);
+    }
+}
+
+static void fill(gamma_t *g, const bench_case_t *c, uint64_t *state) {
+    scatter(g, c, state);
+    /* Przy małym limicie obszarów losowe ruchy szybko przestają się udawać,
+     * więc pozostałe pola zajmują po kolei gracze, którzy mogą je zająć,
+     * zaczynając od właściciela poprzedniego pola. */
+    uint32_t player = 1;
+    for (uint32_t y = 0; y < c->height; ++y) {
+        for (uint32_t x = 0; x < c->width; ++x) {
+            for (uint32_t i = 0; i < c->players; ++i) {
+                uint32_t next = (player + i - 1) % c->players + 1;
+                if (gamma_move(g, next, x, y)) {
+                    player = next;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+static uint64_t count_moves(gamma_t *g, uint32_t player, bool golden) {
+    gamma_field_t buffer[BENCH_MOVES];
+    uint64_t cursor = 0;
+    uint64_t count = 0;
+    uint64_t n;
+    do {
+        n = golden ? gamma_legal_golden_moves_next(g, player, &cursor,
+                                                   buffer, BENCH_MOVES)
+                   : gamma_legal_moves_next(g, player, &cursor,
+                                            buffer, BENCH_MOVES);
+        count += n;
+    } while (n == BENCH_MOVES);
+    return count;
+}
+
+static bool count_chars(void *arg, const char *data, size_t size) {
+    (void) data;
+    *(uint64_t *) arg += size;
+    return true;
+}
+
+static bool expect(bool done, const char *workload, const char *entry,
+                   const bench_case_t *c) {
+    if (!done) {
+        fprintf(stderr, "%s %s %" PRIu32 "x%" PRIu32 " %" PRIu32
+                " %" PRIu32 ": unexpected failure\n", workload, entry,
+                c->width, c->height, c->players, c->areas);
+    }
+    return done;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t) t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+static void report(const char *workload, const char *entry,
+                   const bench_case_t *c, uint64_t ops, uint64_t ns) {
+    struct rusage usage;
+    long rss = getrusage(RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss : 0;
+    double per_op = ops > 0 ? (double) ns / ops : 0;
+    double per_second = ns > 0 ? ops * 1e9 / ns : 0;
+    char board[24];
+    snprintf(board, sizeof(board), "%" PRIu32 "x%" PRIu32,
+             c->width, c->height);
+    printf("%-8s %-24s %-11s %4" PRIu32 " %5" PRIu32 " %-6s %-7s %10" PRIu64
+           " %10.1f %12.0f %9ld\n", workload, entry, board, c->players,
+           c->areas, c->backend == BOARD_BACKEND_ARRAY ? "array" : "planes",
+           c->engine == AREA_ENGINE_UNION_FIND ? "uf" : "relabel",
+           ops, per_op, per_second, rss);
+}
+
+static bool run_isolated(bench_workload_t run, const bench_case_t *c,
+                         uint64_t seed) {
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+        return run(c, seed);
+    }
+    if (pid == 0) {
+        bool done = run(c, seed);
+        fflush(stdout);
+        _exit(done ? 0 : 1);
+    }
+    int status;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
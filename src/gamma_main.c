@@ -3,49 +3,76 @@
  * @author Marcin Malejky
  */
 
-#define _GNU_SOURCE /**< Dostęp do getline. */
-
 #include <stdio.h>
 #include <stdlib.h>
-#include <string.h>
 #include <stdint.h>
-#include <ctype.h>
+#include <string.h>
+#include <unistd.h>
 #include "gamma.h"
+#include "command.h"
+#include "input.h"
 #include "interactive_mode.h"
 #include "batch_mode.h"
-
-#define WHITE_CHARS " \t\v\f\r\n" /**< Znaki białe. */
-#define MIN_CHAR_COUNT 10 /**< Minimalna długość wiersza z inicjacją gry. */
+#include "binary_mode.h"
+#include "pipeline.h"
+#include "server.h"
 
 /** @brief Wykonuje próbę inicjacji gry.
- * Wykonuje próbę inicjacji gry GAME na podstawie wiersza LINE długości SIZE
- * z wejścia. W razie niepowodzenia ustawia GAME->G na NULL.
+ * Wykonuje próbę inicjacji gry GAME na podstawie polecenia C rozpoczęcia
+ * gry. W razie niepowodzenia ustawia *GAME na NULL.
  * @param[out] game – wskaźnik na strukturę przechowującą grę,
- * @param[in] line  – wiersz,
- * @param[in] size  - rozmiar wiersza,
+ * @param[in] c     – wskaźnik na polecenie,
  */
-static void initiate(gamma_t **game, char *line, int size);
+static void initiate(gamma_t **game, const command_t *c);
 
 /** @brief Funkcja główna.
+ * Bez argumentów czyta polecenia ze standardowego wejścia. Z argumentami
+ * @p --replay @p plik odtwarza zapisaną sesję, czytając polecenia wprost
+ * z pliku odwzorowanego w pamięci; wynik jest taki sam jak po przekazaniu
+ * pliku na standardowe wejście. Poprzedzone argumentem @p --pipeline
+ * wykonuje polecenia trybu wsadowego w potoku wątków. Z argumentem
+ * @p --server i opcjonalną ścieżką gniazda prowadzi wiele gier naraz.
+ * @param[in] argc – liczba argumentów,
+ * @param[in] argv – argumenty,
  * @return Zwraca kod wykonania porgramu.
  */
-int main(void) {
+int main(int argc, char *argv[]) {
     gamma_t *g = NULL;
 
     uint32_t line_number = 0;
-    char *line = NULL;
-    size_t buffer_size = 0;
-    ssize_t read_size;
-    while ((read_size = getline(&line, &buffer_size, stdin)) != -1) {
+    input_t in;
+    int arg = 1;
+    bool pipelined = argc > arg && strcmp(argv[arg], "--pipeline") == 0;
+    if (pipelined) {
+        ++arg;
+    }
+    if (argc == arg + 2 && strcmp(argv[arg], "--replay") == 0) {
+        if (!input_open(&in, argv[arg + 1])) {
+            fprintf(stderr, "Nie można otworzyć pliku %s.\n", argv[arg + 1]);
+            return EXIT_FAILURE;
+        }
+    } else if (!pipelined && argc <= 3 && argc >= 2 &&
+               strcmp(argv[1], "--server") == 0) {
+        return server_run(argc == 3 ? argv[2] : NULL);
+    } else if (argc == arg) {
+        input_init(&in, STDIN_FILENO, NULL);
+    } else {
+        fprintf(stderr, "Użycie: %s [--pipeline] [--replay plik] | "
+                        "--server [gniazdo]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    const char *line;
+    size_t size;
+    command_t c;
+    while (input_line(&in, &line, &size)) {
         ++line_number;
-        if (omit(line)) {
+        command_status_t status = command_parse(line, size, &c);
+        if (status == COMMAND_OMIT) {
             continue;
         }
-        if (!correct_chars(line, read_size)) {
-            fprintf(stderr, "ERROR %d\n", line_number);
-            continue;
+        if (status == COMMAND_OK) {
+            initiate(&g, &c);
         }
-        initiate(&g, line, read_size);
         if (g != NULL) {
             if (g->mode == 'B') {
                 printf("OK %d\n", line_number);
@@ -55,47 +82,43 @@ int main(void) {
             fprintf(stderr, "ERROR %d\n", line_number);
         }
     }
-    free(line);
 
     if (g != NULL) {
         switch (g->mode) {
             case 'B':
-                batch_mode(g, &line_number);
+                if (pipelined) {
+                    pipeline_mode(g, &in, &line_number);
+                } else {
+                    batch_mode(g, &in, &line_number);
+                }
                 break;
             case 'I':
-                interactive_mode(g);
+                interactive_mode(g, &in);
+                break;
+            case 'X':
+                binary_mode(g, &in);
                 break;
             default:
                 break;
         }
     }
 
+    input_free(&in);
     gamma_delete(g);
     return 0;
 }
 
-static void initiate(gamma_t **g, char *line, int size) {
-    if (size < MIN_CHAR_COUNT || strchr("BI", line[0]) == NULL ||
-        !isspace(line[1]) || line[size - 1] != '\n') {
+static void initiate(gamma_t **g, const command_t *c) {
+    if (c->kind != 'B' && c->kind != 'I' && c->kind != 'X') {
         return;
     }
 
-    char temp_mode = line[0];
-    strtok(line, WHITE_CHARS);
-    uint32_t width = 0;
-    uint32_t height = 0;
-    uint32_t players = 0;
-    uint32_t areas = 0;
-
-    if (to_number(&width) && to_number(&height) && to_number(&players) &&
-        to_number(&areas) && strtok(NULL, WHITE_CHARS) == NULL) {
-        *g = gamma_new(width, height, players, areas);
-        if (*g != NULL) {
-            (*g)->mode = temp_mode;
-            (*g)->player = 1;
-            (*g)->counter = 0;
-            (*g)->x = 0;
-            (*g)->y = 0;
-        }
+    *g = gamma_new(c->args[0], c->args[1], c->args[2], c->args[3]);
+    if (*g != NULL) {
+        (*g)->mode = c->kind;
+        (*g)->player = 1;
+        (*g)->counter = 0;
+        (*g)->x = 0;
+        (*g)->y = 0;
     }
 }
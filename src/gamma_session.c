@@ -0,0 +1,288 @@
+/** @file
+ * Generator losowych sesji trybu wsadowego gry gamma.
+ *
+ * Wypisuje na standardowe wyjście sesję złożoną z poleceń poprawnych,
+ * poprawnych składniowo, ale z argumentami spoza zakresu, i niepoprawnych,
+ * a także komentarzy i pustych wierszy. Ta sama sesja może być zapisana
+ * w trybie wsadowym, w formie dla serwera albo w binarnym trybie wsadowym,
+ * więc pozwala porównywać tryby programu na tych samych danych.
+ *
+ * @author Marcin Malejky
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SESSION_LONG_LINE 300 /**< Długość najdłuższego wiersza sesji. */
+#define SESSION_RECORD 16 /**< Długość rekordu binarnego trybu wsadowego. */
+
+/**
+ * Forma zapisu sesji.
+ */
+typedef enum {
+    SESSION_BATCH, /**< Tryb wsadowy. */
+    SESSION_SERVER, /**< Polecenia jednej gry serwera. */
+    SESSION_BINARY /**< Binarny tryb wsadowy. */
+} session_form_t;
+
+/**
+ * Parametry sesji.
+ */
+typedef struct {
+    session_form_t form; /**< Forma zapisu sesji. */
+    uint64_t seed; /**< Stan generatora liczb losowych. */
+    uint64_t commands; /**< Liczba poleceń po nagłówku. */
+    uint32_t width; /**< Szerokość planszy. */
+    uint32_t height; /**< Wysokość planszy. */
+    uint32_t players; /**< Liczba graczy. */
+    uint32_t areas; /**< Maksymalna liczba obszarów gracza. */
+    uint32_t prints; /**< Co ile poleceń średnio jest polecenie @p p,
+                       *  albo zero, gdy sesja nie wypisuje planszy. */
+} session_t;
+
+/** @brief Losuje liczbę mniejszą od @p n.
+ * @param[in,out] s – wskaźnik na parametry sesji,
+ * @param[in] n     – liczba dodatnia,
+ * @return Liczba z przedziału [0, @p n).
+ */
+static uint32_t random_below(session_t *s, uint32_t n);
+
+/** @brief Losuje numer gracza, czasem spoza zakresu.
+ * @param[in,out] s – wskaźnik na parametry sesji,
+ * @return Numer gracza.
+ */
+static uint32_t random_player(session_t *s);
+
+/** @brief Losuje współrzędną, czasem spoza planszy.
+ * @param[in,out] s – wskaźnik na parametry sesji,
+ * @param[in] size  – szerokość lub wysokość planszy,
+ * @return Współrzędna.
+ */
+static uint32_t random_coordinate(session_t *s, uint32_t size);
+
+/** @brief Wypisuje wiersz polecenia gry.
+ * W formie dla serwera poprzedza go numerem gry.
+ * @param[in] s    – wskaźnik na parametry sesji,
+ * @param[in] line – wiersz bez znaku końca wiersza.
+ */
+static void put_command(const session_t *s, const char *line);
+
+/** @brief Wypisuje niepoprawny wiersz.
+ * Niepoprawne wiersze nie są poprzedzane numerem gry, bo serwer dopuszcza
+ * więcej odstępów po numerze niż tryb wsadowy na początku wiersza.
+ * @param[in,out] s – wskaźnik na parametry sesji.
+ */
+static void put_invalid(session_t *s);
+
+/** @brief Wypisuje wiersze przed nagłówkiem i nagłówek sesji.
+ * @param[in,out] s – wskaźnik na parametry sesji.
+ */
+static void put_header(session_t *s);
+
+/** @brief Wypisuje jedno losowe polecenie trybu wsadowego lub serwera.
+ * @param[in,out] s – wskaźnik na parametry sesji.
+ */
+static void put_text(session_t *s);
+
+/** @brief Wypisuje jeden losowy rekord binarnego trybu wsadowego.
+ * @param[in,out] s – wskaźnik na parametry sesji.
+ */
+static void put_record(session_t *s);
+
+/** @brief Wczytuje liczbę z argumentu programu.
+ * @param[in] arg    – argument,
+ * @param[out] value – wczytana liczba,
+ * @return Wartość @p true, jeśli argument jest liczbą dziesiętną, a @p false
+ * w przeciwnym przypadku.
+ */
+static bool parse_number(const char *arg, uint64_t *value);
+
+static uint32_t random_below(session_t *s, uint32_t n) {
+    s->seed ^= s->seed << 13;
+    s->seed ^= s->seed >> 7;
+    s->seed ^= s->seed << 17;
+    return (uint32_t) (s->seed % n);
+}
+
+static uint32_t random_player(session_t *s) {
+    return random_below(s, 16) == 0 ? random_below(s, s->players + 2)
+                                    : 1 + random_below(s, s->players);
+}
+
+static uint32_t random_coordinate(session_t *s, uint32_t size) {
+    return random_below(s, 32) == 0 ? size + random_below(s, 3)
+                                    : random_below(s, size);
+}
+
+static void put_command(const session_t *s, const char *line) {
+    if (s->form == SESSION_SERVER) {
+        printf("1 ");
+    }
+    printf("%s\n", line);
+}
+
+static void put_invalid(session_t *s) {
+    static const char *const lines[] = {
+            "x", "m", "m 1 2", "m 1 2 3 4", "m -1 2 3", "m 1 2 -3",
+            " m 1 1 1", "m1 1 1", "b", "b 1 1", "f", "q 1 2", "p 1",
+            "m 99999999999999999999 1 1", "g 1 4294967296 1", "B 5 5 2 2",
+            "I 5 5 2 2", "M 1 1 1", "m 1 1 1x", "m +1 1 1", "\t"
+    };
+    uint32_t kind = random_below(s, sizeof(lines) / sizeof(*lines) + 1);
+    if (kind < sizeof(lines) / sizeof(*lines)) {
+        printf("%s\n", lines[kind]);
+        return;
+    }
+    /* Wiersz dłuższy od bufora wiersza potoku. */
+    char line[SESSION_LONG_LINE + 1];
+    uint32_t length = 1 + random_below(s, SESSION_LONG_LINE);
+    line[0] = 'x';
+    for (uint32_t i = 1; i < length; ++i) {
+        line[i] = random_below(s, 2) == 0 ? ' ' : '1';
+    }
+    line[length] = '\0';
+    printf("%s\n", line);
+}
+
+static void put_header(session_t *s) {
+    printf("# Sesja %" PRIu64 "\n\n", s->seed);
+    /* Błędne nagłówki poprzedzają poprawny. */
+    put_command(s, "B 0 5 2 2");
+    put_command(s, "Q");
+    char line[64];
+    sprintf(line, "%c %" PRIu32 " %" PRIu32 " %" PRIu32 " %" PRIu32,
+            s->form == SESSION_BINARY ? 'X' : 'B',
+            s->width, s->height, s->players, s->areas);
+    put_command(s, line);
+}
+
+static void put_text(session_t *s) {
+    char line[SESSION_LONG_LINE + 64];
+    uint32_t kind = random_below(s, 100);
+    uint32_t player = random_player(s);
+    uint32_t x = random_coordinate(s, s->width);
+    uint32_t y = random_coordinate(s, s->height);
+    /* Rzadko argumenty są rozdzielone wieloma odstępami, przez co wiersz
+     * jest dłuższy od bufora wiersza potoku. */
+    int pad = random_below(s, 64) == 0 ? SESSION_LONG_LINE / 3 : 1;
+    if (s->prints > 0 && random_below(s, s->prints) == 0) {
+        put_command(s, "p");
+    } else if (kind < 58) {
+        sprintf(line, "%c%*s%" PRIu32 "%*s%" PRIu32 "%*s%" PRIu32,
+                kind < 50 ? 'm' : 'g', pad, "", player, pad, "", x, pad, "",
+                y);
+        put_command(s, line);
+    } else if (kind < 88) {
+        sprintf(line, "%c %" PRIu32, "bfq"[random_below(s, 3)], player);
+        put_command(s, line);
+    } else if (kind < 96) {
+        put_invalid(s);
+    } else if (kind < 98) {
+        printf("# komentarz %" PRIu32 "\n", random_below(s, 1000));
+    } else {
+        printf("\n");
+    }
+}
+
+static void put_record(session_t *s) {
+    unsigned char record[SESSION_RECORD] = {0};
+    uint32_t kind = random_below(s, 100);
+    uint32_t values[3] = {random_player(s), random_coordinate(s, s->width),
+                          random_coordinate(s, s->height)};
+    if (kind < 55) {
+        record[0] = 'm';
+    } else if (kind < 63) {
+        record[0] = 'g';
+    } else if (kind < 93) {
+        record[0] = "bfq"[random_below(s, 3)];
+    } else if (kind < 97) {
+        /* Nieznane polecenie. */
+        record[0] = "pBx"[random_below(s, 3)];
+    } else {
+        /* Niezerowe bajty dopełnienia. */
+        record[0] = 'm';
+        record[1 + random_below(s, 3)] = 1;
+    }
+    for (uint32_t i = 0; i < 3; ++i) {
+        for (uint32_t j = 0; j < 4; ++j) {
+            record[4 + 4 * i + j] = values[i] >> 8 * j & 0xFF;
+        }
+    }
+    fwrite(record, 1, SESSION_RECORD, stdout);
+}
+
+static bool parse_number(const char *arg, uint64_t *value) {
+    char *end;
+    if (*arg < '0' || *arg > '9') {
+        return false;
+    }
+    *value = strtoull(arg, &end, 10);
+    return *end == '\0';
+}
+
+/** @brief Wypisuje losową sesję.
+ * Argumenty to forma sesji (@p batch, @p server lub @p binary), ziarno
+ * generatora, liczba poleceń, wymiary planszy, liczba graczy, liczba
+ * obszarów i średnia liczba poleceń między wypisaniami planszy, przy czym
+ * zero oznacza sesję bez wypisywania planszy. Sesja z nieparzystym ziarnem
+ * kończy się niepełnym wierszem lub rekordem.
+ * @param[in] argc – liczba argumentów,
+ * @param[in] argv – argumenty,
+ * @return Zero lub kod błędu, gdy argumenty są niepoprawne.
+ */
+int main(int argc, char *argv[]) {
+    session_t s;
+    uint64_t numbers[7];
+    bool ok = argc == 9;
+    for (int i = 0; ok && i < 7; ++i) {
+        ok = parse_number(argv[i + 2], &numbers[i]) &&
+             (i < 2 || numbers[i] <= UINT32_MAX);
+    }
+    if (ok && strcmp(argv[1], "batch") == 0) {
+        s.form = SESSION_BATCH;
+    } else if (ok && strcmp(argv[1], "server") == 0) {
+        s.form = SESSION_SERVER;
+    } else if (ok && strcmp(argv[1], "binary") == 0) {
+        s.form = SESSION_BINARY;
+    } else {
+        ok = false;
+    }
+    if (!ok || numbers[0] == 0 || numbers[2] == 0 || numbers[3] == 0 ||
+        numbers[4] == 0 || numbers[5] == 0) {
+        fprintf(stderr, "Użycie: %s batch|server|binary ziarno polecenia "
+                        "szerokość wysokość gracze obszary wypisania\n",
+                argv[0]);
+        return EXIT_FAILURE;
+    }
+    s.seed = numbers[0];
+    s.commands = numbers[1];
+    s.width = numbers[2];
+    s.height = numbers[3];
+    s.players = numbers[4];
+    s.areas = numbers[5];
+    s.prints = numbers[6];
+
+    bool odd = s.seed % 2 == 1;
+    put_header(&s);
+    for (uint64_t i = 0; i < s.commands; ++i) {
+        if (s.form == SESSION_BINARY) {
+            put_record(&s);
+        } else {
+            put_text(&s);
+        }
+    }
+    if (odd) {
+        if (s.form == SESSION_BINARY) {
+            fwrite("m\0\0", 1, 3, stdout);
+        } else {
+            put_command(&s, "q 1");
+            /* Ostatni wiersz bez znaku końca wiersza. */
+            printf("%sm 1 0 0", s.form == SESSION_SERVER ? "1 " : "");
+        }
+    }
+    return ferror(stdout) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
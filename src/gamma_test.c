@@ -11,11 +11,17 @@
 #undef NDEBUG
 #endif
 
+#define _POSIX_C_SOURCE 200809L /**< Dostęp do pipe i read. */
+
 #include "gamma.h"
+#include "interactive_mode.h"
+#include "playout.h"
+#include "screen.h"
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 /**
  * Tak ma wyglądać plansza po wykonaniu wszystkich testów.
@@ -32,6 +38,1142 @@ static const char board[] =
   "1221......\n"
   "1.........\n";
 
+#define STATE_PLAYERS 4 /**< Największa liczba graczy zapisanego stanu gry. */
+
+/**
+ * Zapisany stan gry, czyli plansza i odpowiedzi na zapytania o graczy.
+ */
+typedef struct {
+  char *board; /**< Opis planszy. */
+  uint64_t busy[STATE_PLAYERS + 1]; /**< Liczby pól zajętych przez graczy. */
+  uint64_t free_fields[STATE_PLAYERS + 1]; /**< Liczby pól do zajęcia. */
+  bool golden[STATE_PLAYERS + 1]; /**< Czy gracze mogą wykonać złoty ruch. */
+  uint64_t hash; /**< Skrót pozycji. */
+} state_t;
+
+/**
+ * Bufor zbierający kawałki wypisywanej planszy.
+ */
+typedef struct {
+  char *data; /**< Zebrane dane. */
+  size_t length; /**< Liczba zebranych bajtów. */
+  size_t capacity; /**< Rozmiar bufora. */
+  uint32_t chunks; /**< Liczba przekazanych kawałków. */
+  uint32_t limit; /**< Liczba kawałków, po której wypisywanie jest
+                   *  przerywane, lub zero. */
+} collector_t;
+
+#define ORACLE_SIDE 8 /**< Największy bok planszy sprawdzanej
+                       *  przeszukiwaniem. */
+
+/**
+ * Plansza odczytana z @ref gamma_board, na której wzorcowe odpowiedzi są
+ * liczone przeszukiwaniem.
+ */
+typedef struct {
+  uint32_t width; /**< Szerokość planszy. */
+  uint32_t height; /**< Wysokość planszy. */
+  uint32_t owner[ORACLE_SIDE * ORACLE_SIDE]; /**< Właściciele pól, zero dla
+                                              *  wolnych pól. */
+} oracle_t;
+
+#define TERMINAL_ROWS 12 /**< Liczba wierszy terminala testu ekranu. */
+#define TERMINAL_COLS 40 /**< Liczba kolumn terminala testu ekranu. */
+
+/**
+ * Terminal odtwarzający sekwencje wypisane przez ekran.
+ */
+typedef struct {
+  cell_t cells[TERMINAL_ROWS * TERMINAL_COLS]; /**< Zawartość terminala. */
+  uint32_t row; /**< Wiersz kursora. */
+  uint32_t col; /**< Kolumna kursora. */
+  uint8_t fg; /**< Bieżący kolor tekstu. */
+  uint8_t bg; /**< Bieżący kolor tła. */
+} terminal_t;
+
+/** @brief Losuje liczbę mniejszą od @p n.
+ * Używa generatora xorshift, aby przebieg testów nie zależał od biblioteki
+ * standardowej.
+ * @param[in,out] seed – stan generatora, liczba niezerowa,
+ * @param[in] n        – liczba dodatnia.
+ * @return Liczba z przedziału [0, @p n).
+ */
+static uint32_t random_below(uint64_t *seed, uint32_t n) {
+  *seed ^= *seed << 13;
+  *seed ^= *seed >> 7;
+  *seed ^= *seed << 17;
+  return (uint32_t) (*seed % n);
+}
+
+/** @brief Sprawdza, czy dwie gry są w tym samym stanie.
+ * Porównuje planszę, skrót pozycji i odpowiedzi na zapytania o wszystkich
+ * graczy.
+ * @param[in] a       – wskaźnik na pierwszą grę,
+ * @param[in] b       – wskaźnik na drugą grę,
+ * @param[in] players – liczba graczy obu gier.
+ */
+static void assert_same(gamma_t *a, gamma_t *b, uint32_t players) {
+  assert(gamma_hash(a) == gamma_hash(b));
+  for (uint32_t player = 1; player <= players; ++player) {
+    assert(gamma_busy_fields(a, player) == gamma_busy_fields(b, player));
+    assert(gamma_free_fields(a, player) == gamma_free_fields(b, player));
+    assert(gamma_golden_possible(a, player) ==
+           gamma_golden_possible(b, player));
+  }
+  char *p = gamma_board(a);
+  char *q = gamma_board(b);
+  assert(p && q);
+  assert(strcmp(p, q) == 0);
+  free(p);
+  free(q);
+}
+
+/** @brief Rozgrywa te same losowe ruchy w dwóch grach.
+ * Co ósmy ruch jest złotym ruchem. Po każdym ruchu sprawdza, że obie gry
+ * dały ten sam wynik i są w tym samym stanie.
+ * @param[in,out] a    – wskaźnik na pierwszą grę,
+ * @param[in,out] b    – wskaźnik na drugą grę lub NULL, gdy ruchy mają być
+ *                       rozegrane tylko w pierwszej grze,
+ * @param[in,out] seed – stan generatora liczb losowych,
+ * @param[in] width    – szerokość planszy obu gier,
+ * @param[in] height   – wysokość planszy obu gier,
+ * @param[in] players  – liczba graczy obu gier,
+ * @param[in] moves    – liczba prób ruchu.
+ * @return Liczba wykonanych ruchów.
+ */
+static uint32_t play(gamma_t *a, gamma_t *b, uint64_t *seed, uint32_t width,
+                     uint32_t height, uint32_t players, uint32_t moves) {
+  uint32_t made = 0;
+  for (uint32_t i = 0; i < moves; ++i) {
+    uint32_t player = 1 + random_below(seed, players);
+    uint32_t x = random_below(seed, width);
+    uint32_t y = random_below(seed, height);
+    bool golden = random_below(seed, 8) == 0;
+    bool done = golden ? gamma_golden_move(a, player, x, y)
+                       : gamma_move(a, player, x, y);
+    if (b != NULL) {
+      assert(done == (golden ? gamma_golden_move(b, player, x, y)
+                             : gamma_move(b, player, x, y)));
+      assert_same(a, b, players);
+    }
+    made += done;
+  }
+  return made;
+}
+
+/** @brief Zapisuje stan gry.
+ * @param[in] g       – wskaźnik na grę,
+ * @param[in] players – liczba graczy, niewiększa od @ref STATE_PLAYERS,
+ * @param[out] s      – wskaźnik na stan, którego planszę trzeba zwolnić.
+ */
+static void save_state(gamma_t *g, uint32_t players, state_t *s) {
+  for (uint32_t player = 1; player <= players; ++player) {
+    s->busy[player] = gamma_busy_fields(g, player);
+    s->free_fields[player] = gamma_free_fields(g, player);
+    s->golden[player] = gamma_golden_possible(g, player);
+  }
+  s->hash = gamma_hash(g);
+  s->board = gamma_board(g);
+  assert(s->board);
+}
+
+/** @brief Sprawdza, czy gra jest w zapisanym stanie.
+ * @param[in] g       – wskaźnik na grę,
+ * @param[in] players – liczba graczy, niewiększa od @ref STATE_PLAYERS,
+ * @param[in] s       – wskaźnik na zapisany stan.
+ */
+static void assert_state(gamma_t *g, uint32_t players, const state_t *s) {
+  assert(gamma_hash(g) == s->hash);
+  for (uint32_t player = 1; player <= players; ++player) {
+    assert(gamma_busy_fields(g, player) == s->busy[player]);
+    assert(gamma_free_fields(g, player) == s->free_fields[player]);
+    assert(gamma_golden_possible(g, player) == s->golden[player]);
+  }
+  char *p = gamma_board(g);
+  assert(p);
+  assert(strcmp(p, s->board) == 0);
+  free(p);
+}
+
+/** @brief Porównuje sposoby śledzenia obszarów.
+ * Gra z @ref AREA_ENGINE_RELABEL, także przełączonym w trakcie rozgrywki,
+ * musi zachowywać się tak samo jak gra z domyślnym
+ * @ref AREA_ENGINE_UNION_FIND.
+ */
+static void test_area_engines(void) {
+  uint64_t seed = 1;
+  for (uint32_t round = 0; round < 40; ++round) {
+    uint32_t width = 1 + random_below(&seed, 12);
+    uint32_t height = 1 + random_below(&seed, 12);
+    uint32_t players = 1 + random_below(&seed, 4);
+    uint32_t areas = 1 + random_below(&seed, 4);
+    gamma_t *a = gamma_new(width, height, players, areas);
+    gamma_t *b = gamma_new(width, height, players, areas);
+    assert(a && b);
+    uint32_t moves = 4 * width * height;
+    if (round % 2 == 0) {
+      gamma_set_area_engine(b, AREA_ENGINE_RELABEL);
+      play(a, b, &seed, width, height, players, moves);
+    } else {
+      play(a, b, &seed, width, height, players, moves / 2);
+      gamma_set_area_engine(b, AREA_ENGINE_RELABEL);
+      play(a, b, &seed, width, height, players, moves / 2);
+    }
+    gamma_delete(a);
+    gamma_delete(b);
+  }
+}
+
+/** @brief Porównuje sposoby przechowywania planszy.
+ * Gra w wariancie @ref BOARD_BACKEND_BIT_PLANES musi zachowywać się tak samo
+ * jak gra w wariancie @ref BOARD_BACKEND_ARRAY, także dla liczby graczy,
+ * która nie mieści się w bajcie.
+ */
+static void test_backends(void) {
+  static const uint32_t players[] = {1, 2, 3, 7, 8, 300};
+  uint64_t seed = 2;
+  for (uint32_t round = 0; round < 36; ++round) {
+    uint32_t width = 1 + random_below(&seed, 70);
+    uint32_t height = 1 + random_below(&seed, 12);
+    uint32_t count = players[round % (sizeof(players) / sizeof(*players))];
+    uint32_t areas = 1 + random_below(&seed, 4);
+    gamma_t *a = gamma_new_backend(width, height, count, areas,
+                                   BOARD_BACKEND_ARRAY);
+    gamma_t *b = gamma_new_backend(width, height, count, areas,
+                                   BOARD_BACKEND_BIT_PLANES);
+    assert(a && b);
+    play(a, b, &seed, width, height, count, 2 * width * height);
+    gamma_delete(a);
+    gamma_delete(b);
+  }
+  assert(gamma_new_backend(0, 1, 1, 1, BOARD_BACKEND_BIT_PLANES) == NULL);
+}
+
+/** @brief Testuje cofanie i powtarzanie ruchów.
+ * Cofa wszystkie ruchy losowej rozgrywki, sprawdzając po drodze zapisane
+ * stany, a potem powtarza je wszystkie. Ruch wykonany po cofnięciu usuwa
+ * cofnięte ruchy.
+ */
+static void test_undo(void) {
+  uint64_t seed = 3;
+  for (uint32_t round = 0; round < 24; ++round) {
+    uint32_t width = 1 + random_below(&seed, 10);
+    uint32_t height = 1 + random_below(&seed, 10);
+    uint32_t players = 1 + random_below(&seed, STATE_PLAYERS);
+    uint32_t areas = 1 + random_below(&seed, 3);
+    gamma_t *g = gamma_new_backend(width, height, players, areas,
+                                   round % 4 < 2 ? BOARD_BACKEND_ARRAY
+                                                 : BOARD_BACKEND_BIT_PLANES);
+    assert(g);
+    if (round % 2 == 1) {
+      gamma_set_area_engine(g, AREA_ENGINE_RELABEL);
+    }
+    assert(gamma_move(g, 1, 0, 0));
+    assert(!gamma_undo(g));
+    gamma_set_journal(g, true);
+
+    uint32_t moves = 3 * width * height;
+    state_t *states = malloc(sizeof(state_t) * (moves + 1));
+    assert(states);
+    uint32_t count = 0;
+    save_state(g, players, &states[count++]);
+    for (uint32_t i = 0; i < moves; ++i) {
+      if (play(g, NULL, &seed, width, height, players, 1) == 1) {
+        save_state(g, players, &states[count++]);
+      }
+    }
+    assert(!gamma_redo(g));
+    for (uint32_t i = count - 1; i > 0; --i) {
+      assert(gamma_undo(g));
+      assert_state(g, players, &states[i - 1]);
+    }
+    assert(!gamma_undo(g));
+    for (uint32_t i = 1; i < count; ++i) {
+      assert(gamma_redo(g));
+      assert_state(g, players, &states[i]);
+    }
+    assert(!gamma_redo(g));
+
+    if (count > 1) {
+      assert(gamma_undo(g));
+      assert(gamma_redo(g));
+      assert(gamma_undo(g));
+      uint32_t made = 0;
+      for (uint32_t i = 0; i < moves && made == 0; ++i) {
+        made = play(g, NULL, &seed, width, height, players, 1);
+      }
+      if (made == 1) {
+        assert(!gamma_redo(g));
+        assert(gamma_undo(g));
+        assert_state(g, players, &states[count - 2]);
+      }
+    }
+    gamma_set_journal(g, false);
+    assert(!gamma_undo(g));
+
+    for (uint32_t i = 0; i < count; ++i) {
+      free(states[i].board);
+    }
+    free(states);
+    gamma_delete(g);
+  }
+}
+
+/** @brief Testuje kopie gry.
+ * Gra i jej kopia rozgrywają po rozwidleniu różne ruchy i każda z nich musi
+ * być w tym samym stanie co gra rozegrana od początku bez kopiowania.
+ * Niezmieniana kopia musi zachować stan z chwili rozwidlenia, także po
+ * usunięciu gry, z której powstała.
+ */
+static void test_fork(void) {
+  uint64_t seed = 4;
+  for (uint32_t round = 0; round < 16; ++round) {
+    uint32_t width = 1 + random_below(&seed, 300);
+    uint32_t height = 1 + random_below(&seed, 80);
+    uint32_t players = 1 + random_below(&seed, STATE_PLAYERS);
+    uint32_t areas = 1 + random_below(&seed, 4);
+    board_backend_t backend = round % 2 == 0 ? BOARD_BACKEND_ARRAY
+                                             : BOARD_BACKEND_BIT_PLANES;
+    gamma_t *a = gamma_new_backend(width, height, players, areas, backend);
+    gamma_t *ra = gamma_new_backend(width, height, players, areas, backend);
+    gamma_t *rb = gamma_new_backend(width, height, players, areas, backend);
+    assert(a && ra && rb);
+    uint32_t moves = width * height;
+    uint64_t prefix = seed + round;
+    uint64_t s = prefix;
+    play(a, NULL, &s, width, height, players, moves);
+    s = prefix;
+    play(ra, NULL, &s, width, height, players, moves);
+    s = prefix;
+    play(rb, NULL, &s, width, height, players, moves);
+
+    gamma_t *b = gamma_fork(a);
+    assert(b);
+    assert_same(a, b, players);
+    uint64_t left = s;
+    uint64_t right = s ^ UINT64_C(0x9E3779B97F4A7C15);
+    s = left;
+    play(a, NULL, &s, width, height, players, moves);
+    s = left;
+    play(ra, NULL, &s, width, height, players, moves);
+    s = right;
+    play(b, NULL, &s, width, height, players, moves);
+    s = right;
+    play(rb, NULL, &s, width, height, players, moves);
+    assert_same(a, ra, players);
+    assert_same(b, rb, players);
+
+    state_t snapshot;
+    gamma_t *c = gamma_fork(b);
+    assert(c);
+    save_state(c, players, &snapshot);
+    play(b, NULL, &s, width, height, players, moves);
+    assert_state(c, players, &snapshot);
+    gamma_delete(b);
+    assert_state(c, players, &snapshot);
+    s = right;
+    play(c, NULL, &s, width, height, players, moves);
+    s = right;
+    play(rb, NULL, &s, width, height, players, moves);
+    assert_same(c, rb, players);
+    free(snapshot.board);
+
+    gamma_set_journal(a, true);
+    uint32_t made = play(a, NULL, &s, width, height, players, moves);
+    gamma_t *d = gamma_fork(a);
+    assert(d);
+    assert(!gamma_undo(d));
+    assert(gamma_undo(a) == (made > 0));
+
+    gamma_delete(a);
+    gamma_delete(c);
+    gamma_delete(d);
+    gamma_delete(ra);
+    gamma_delete(rb);
+  }
+  assert(gamma_fork(NULL) == NULL);
+}
+
+/** @brief Sprawdza wyliczanie ruchów jednego rodzaju.
+ * Porównuje wynik wyliczania ze sprawdzeniem wszystkich pól po kolei na
+ * kopiach gry, także gdy ruchy są wyliczane małymi porcjami.
+ * @param[in,out] g  – wskaźnik na grę,
+ * @param[in] player – numer gracza,
+ * @param[in] width  – szerokość planszy,
+ * @param[in] height – wysokość planszy,
+ * @param[in] golden – czy sprawdzać złote ruchy.
+ */
+static void check_legal_moves(gamma_t *g, uint32_t player, uint32_t width,
+                              uint32_t height, bool golden) {
+  uint64_t fields = (uint64_t) width * height;
+  gamma_field_t *expected = malloc(sizeof(gamma_field_t) * fields);
+  gamma_field_t *found = malloc(sizeof(gamma_field_t) * (fields + 1));
+  assert(expected && found);
+  uint64_t count = 0;
+  for (uint32_t y = 0; y < height; ++y) {
+    for (uint32_t x = 0; x < width; ++x) {
+      gamma_t *copy = gamma_fork(g);
+      assert(copy);
+      if (golden ? gamma_golden_move(copy, player, x, y)
+                 : gamma_move(copy, player, x, y)) {
+        expected[count].x = x;
+        expected[count].y = y;
+        ++count;
+      }
+      gamma_delete(copy);
+    }
+  }
+
+  uint64_t n = golden ? gamma_legal_golden_moves(g, player, found, fields + 1)
+                      : gamma_legal_moves(g, player, found, fields + 1);
+  assert(n == count);
+  for (uint64_t i = 0; i < count; ++i) {
+    assert(found[i].x == expected[i].x && found[i].y == expected[i].y);
+  }
+
+  uint64_t cursor = 0;
+  uint64_t total = 0;
+  gamma_field_t chunk[3];
+  do {
+    n = golden ? gamma_legal_golden_moves_next(g, player, &cursor, chunk, 3)
+               : gamma_legal_moves_next(g, player, &cursor, chunk, 3);
+    for (uint64_t i = 0; i < n; ++i) {
+      assert(total < count);
+      assert(chunk[i].x == expected[total].x &&
+             chunk[i].y == expected[total].y);
+      ++total;
+    }
+  } while (n == 3);
+  assert(total == count);
+  free(expected);
+  free(found);
+}
+
+/** @brief Testuje wyliczanie legalnych ruchów.
+ * W losowych pozycjach obu wariantów planszy porównuje zwykłe i złote ruchy
+ * każdego gracza z ruchami, które przyjmują @ref gamma_move
+ * i @ref gamma_golden_move.
+ */
+static void test_legal_moves(void) {
+  uint64_t seed = 5;
+  for (uint32_t round = 0; round < 40; ++round) {
+    uint32_t width = 1 + random_below(&seed, 12);
+    uint32_t height = 1 + random_below(&seed, 12);
+    uint32_t players = 1 + random_below(&seed, 4);
+    uint32_t areas = 1 + random_below(&seed, 3);
+    gamma_t *g = gamma_new_backend(width, height, players, areas,
+                                   round % 2 == 0 ? BOARD_BACKEND_ARRAY
+                                                  : BOARD_BACKEND_BIT_PLANES);
+    assert(g);
+    play(g, NULL, &seed, width, height, players,
+         random_below(&seed, 2 * width * height + 1));
+    for (uint32_t player = 1; player <= players; ++player) {
+      check_legal_moves(g, player, width, height, false);
+      check_legal_moves(g, player, width, height, true);
+    }
+    gamma_field_t field;
+    assert(gamma_legal_moves(g, 0, &field, 1) == 0);
+    assert(gamma_legal_moves(g, players + 1, &field, 1) == 0);
+    assert(gamma_legal_golden_moves(NULL, 1, &field, 1) == 0);
+    gamma_delete(g);
+  }
+}
+
+/** @brief Testuje skrót pozycji.
+ * Pozycje osiągnięte różnymi kolejnościami ruchów mają ten sam skrót,
+ * a pozycje różniące się graczem na ruchu lub wykonanymi złotymi ruchami
+ * mają różne skróty. Zgodność skrótów kopii, cofniętych ruchów oraz
+ * wariantów planszy i śledzenia obszarów sprawdzają pozostałe testy.
+ */
+static void test_hash(void) {
+  gamma_t *a = gamma_new(5, 5, 2, 3);
+  gamma_t *b = gamma_new(5, 5, 2, 3);
+  gamma_t *c = gamma_new(5, 5, 2, 3);
+  assert(a && b && c);
+  assert(gamma_hash(a) == gamma_hash(b));
+  uint64_t empty = gamma_hash(a);
+
+  assert(gamma_move(a, 1, 0, 0));
+  assert(gamma_hash(a) != empty);
+  assert(gamma_move(a, 2, 4, 4));
+  assert(gamma_move(a, 1, 2, 2));
+  assert(gamma_move(b, 1, 2, 2));
+  assert(gamma_move(b, 2, 4, 4));
+  assert(gamma_move(b, 1, 0, 0));
+  assert(gamma_hash(a) == gamma_hash(b));
+  /* Te same pola, ale na ruchu jest inny gracz. */
+  assert(gamma_move(c, 1, 0, 0));
+  assert(gamma_move(c, 1, 2, 2));
+  assert(gamma_move(c, 2, 4, 4));
+  assert(gamma_hash(a) != gamma_hash(c));
+  gamma_delete(a);
+  gamma_delete(b);
+  gamma_delete(c);
+
+  /* Te same pola i gracz na ruchu, ale tylko jeden gracz ma złoty ruch. */
+  a = gamma_new(5, 5, 2, 3);
+  b = gamma_new(5, 5, 2, 3);
+  assert(a && b);
+  assert(gamma_move(a, 1, 0, 0));
+  assert(gamma_move(a, 2, 1, 0));
+  assert(gamma_golden_move(a, 1, 1, 0));
+  assert(gamma_move(b, 1, 0, 0));
+  assert(gamma_move(b, 1, 1, 0));
+  assert(gamma_hash(a) != gamma_hash(b));
+  gamma_delete(a);
+  gamma_delete(b);
+  assert(gamma_hash(NULL) == 0);
+}
+
+/** @brief Dopisuje kawałek planszy do bufora.
+ * @param[in,out] arg – wskaźnik na bufor typu @ref collector_t,
+ * @param[in] data    – kawałek planszy,
+ * @param[in] size    – długość kawałka.
+ * @return Wartość @p false, gdy bufor zebrał już @ref collector_t.limit
+ * kawałków, a @p true w przeciwnym przypadku.
+ */
+static bool collect(void *arg, const char *data, size_t size) {
+  collector_t *c = arg;
+  assert(size > 0);
+  if (c->length + size > c->capacity) {
+    c->capacity = 2 * (c->length + size);
+    c->data = realloc(c->data, c->capacity);
+    assert(c->data);
+  }
+  memcpy(c->data + c->length, data, size);
+  c->length += size;
+  ++(c->chunks);
+  return c->limit == 0 || c->chunks < c->limit;
+}
+
+/** @brief Sprawdza wypisanie wierszy planszy.
+ * @param[in] g      – wskaźnik na grę,
+ * @param[in] board  – napis z @ref gamma_board,
+ * @param[in] height – wysokość planszy,
+ * @param[in] from   – numer najniższego wiersza,
+ * @param[in] to     – numer o jeden większy od numeru najwyższego wiersza.
+ */
+static void check_rows(gamma_t *g, const char *board, uint32_t height,
+                       uint32_t from, uint32_t to) {
+  /* Wiersz y jest wierszem height - 1 - y napisu. */
+  const char *begin = board;
+  for (uint32_t line = 0; line < height - to; ++line) {
+    begin = strchr(begin, '\n') + 1;
+  }
+  const char *end = begin;
+  for (uint32_t line = 0; line < to - from; ++line) {
+    end = strchr(end, '\n') + 1;
+  }
+  collector_t c = {NULL, 0, 0, 0, 0};
+  assert(gamma_board_write_rows(g, from, to, collect, &c));
+  assert(c.length == (size_t) (end - begin));
+  assert(c.length == 0 || memcmp(c.data, begin, c.length) == 0);
+  free(c.data);
+}
+
+/** @brief Testuje wypisywanie planszy kawałkami.
+ * Kawałki całej planszy i dowolnego zakresu wierszy muszą dawać ten sam
+ * napis co @ref gamma_board, także dla numerów graczy dłuższych niż jedna
+ * cyfra i dla planszy większej niż jeden kawałek.
+ */
+static void test_board_write(void) {
+  uint64_t seed = 6;
+  gamma_t *g = gamma_new(9, 7, 12, 20);
+  assert(g);
+  play(g, NULL, &seed, 9, 7, 12, 40);
+  char *p = gamma_board(g);
+  assert(p);
+  for (uint32_t from = 0; from <= 7; ++from) {
+    for (uint32_t to = from; to <= 7; ++to) {
+      check_rows(g, p, 7, from, to);
+    }
+  }
+  free(p);
+  collector_t c = {NULL, 0, 0, 0, 0};
+  assert(!gamma_board_write_rows(g, 3, 2, collect, &c));
+  assert(!gamma_board_write_rows(g, 0, 8, collect, &c));
+  assert(!gamma_board_write_rows(g, 0, 7, NULL, &c));
+  assert(!gamma_board_write(NULL, collect, &c));
+  assert(c.chunks == 0);
+  gamma_delete(g);
+
+  g = gamma_new(1500, 1000, 2, 1000);
+  assert(g);
+  play(g, NULL, &seed, 1500, 1000, 2, 3000);
+  p = gamma_board(g);
+  assert(p);
+  assert(gamma_board_write(g, collect, &c));
+  assert(c.chunks > 1);
+  assert(c.length == strlen(p) && memcmp(c.data, p, c.length) == 0);
+  check_rows(g, p, 1000, 123, 877);
+  free(c.data);
+  free(p);
+
+  c = (collector_t) {NULL, 0, 0, 0, 1};
+  assert(!gamma_board_write(g, collect, &c));
+  assert(c.chunks == 1);
+  free(c.data);
+  gamma_delete(g);
+}
+
+/** @brief Testuje sprawdzanie, czy gracz może wykonać ruch.
+ * Po każdym ruchu losowej rozgrywki z małą liczbą obszarów porównuje
+ * @ref gamma_can_move losowo wybranych graczy z liczbą wolnych pól
+ * i złotych ruchów gracza. Gracze są pytani nieregularnie, aby zapamiętane
+ * odpowiedzi musiały uwzględniać ruchy wykonane między zapytaniami.
+ */
+static void test_can_move(void) {
+  uint64_t seed = 7;
+  for (uint32_t round = 0; round < 40; ++round) {
+    uint32_t width = 1 + random_below(&seed, 10);
+    uint32_t height = 1 + random_below(&seed, 10);
+    uint32_t players = 1 + random_below(&seed, 5);
+    uint32_t areas = 1 + random_below(&seed, 2);
+    gamma_t *g = gamma_new_backend(width, height, players, areas,
+                                   round % 2 == 0 ? BOARD_BACKEND_ARRAY
+                                                  : BOARD_BACKEND_BIT_PLANES);
+    assert(g);
+    for (uint32_t i = 0; i < 3 * width * height; ++i) {
+      play(g, NULL, &seed, width, height, players, 1);
+      for (uint32_t player = 1; player <= players; ++player) {
+        if (random_below(&seed, 3) == 0) {
+          continue;
+        }
+        gamma_field_t field;
+        bool expected = gamma_free_fields(g, player) > 0 ||
+                        gamma_legal_golden_moves(g, player, &field, 1) > 0;
+        assert(gamma_can_move(g, player) == expected);
+        assert(gamma_can_move(g, player) == expected);
+      }
+    }
+    assert(!gamma_can_move(g, 0));
+    assert(!gamma_can_move(g, players + 1));
+    gamma_delete(g);
+  }
+  assert(!gamma_can_move(NULL, 1));
+}
+
+/** @brief Testuje ponowne użycie gry.
+ * Gra po losowej rozgrywce i @ref gamma_reset musi się zachowywać jak nowa
+ * gra o tych samych parametrach, także przy innym limicie obszarów. Gra
+ * o innych wymiarach lub po utworzeniu kopii nie może zostać użyta.
+ */
+static void test_reset(void) {
+  uint64_t seed = 8;
+  for (uint32_t round = 0; round < 16; ++round) {
+    uint32_t width = 1 + random_below(&seed, 40);
+    uint32_t height = 1 + random_below(&seed, 20);
+    uint32_t players = 1 + random_below(&seed, STATE_PLAYERS);
+    uint32_t areas = 1 + random_below(&seed, 4);
+    board_backend_t backend = round % 2 == 0 ? BOARD_BACKEND_ARRAY
+                                             : BOARD_BACKEND_BIT_PLANES;
+    gamma_t *g = gamma_new_backend(width, height, players, areas, backend);
+    assert(g);
+    gamma_set_journal(g, round % 4 < 2);
+    play(g, NULL, &seed, width, height, players, 2 * width * height);
+    assert(!gamma_reset(g, width + 1, height, players, areas));
+    assert(!gamma_reset(g, width, height, players + 1, areas));
+    assert(!gamma_reset(g, width, height, players, 0));
+
+    areas = 1 + random_below(&seed, 4);
+    assert(gamma_reset(g, width, height, players, areas));
+    gamma_t *fresh = gamma_new_backend(width, height, players, areas,
+                                       backend);
+    assert(fresh);
+    assert_same(g, fresh, players);
+    assert(!gamma_undo(g));
+    play(g, fresh, &seed, width, height, players, 2 * width * height);
+
+    gamma_t *copy = gamma_fork(g);
+    assert(copy);
+    assert(!gamma_reset(g, width, height, players, areas));
+    assert(!gamma_reset(copy, width, height, players, areas));
+    gamma_delete(copy);
+    gamma_delete(fresh);
+    gamma_delete(g);
+  }
+  assert(!gamma_reset(NULL, 1, 1, 1, 1));
+}
+
+/** @brief Odczytuje planszę gry.
+ * @param[in] g  – wskaźnik na grę o co najwyżej dziewięciu graczach
+ *                 i bokach niewiększych od @ref ORACLE_SIDE,
+ * @param[out] o – wskaźnik na odczytaną planszę.
+ */
+static void oracle_read(gamma_t *g, oracle_t *o) {
+  char *p = gamma_board(g);
+  assert(p);
+  const char *c = p;
+  for (uint32_t y = o->height; y-- > 0;) {
+    for (uint32_t x = 0; x < o->width; ++x, ++c) {
+      o->owner[y * o->width + x] = *c == '.' ? 0 : (uint32_t) (*c - '0');
+    }
+    assert(*c++ == '\n');
+  }
+  free(p);
+}
+
+/** @brief Liczy obszary gracza przeszukiwaniem planszy.
+ * @param[in] o      – wskaźnik na planszę,
+ * @param[in] player – numer gracza.
+ * @return Liczba obszarów gracza.
+ */
+static uint32_t oracle_areas(const oracle_t *o, uint32_t player) {
+  bool seen[ORACLE_SIDE * ORACLE_SIDE] = {false};
+  uint32_t stack[ORACLE_SIDE * ORACLE_SIDE];
+  uint32_t size = o->width * o->height;
+  uint32_t count = 0;
+  for (uint32_t start = 0; start < size; ++start) {
+    if (o->owner[start] != player || seen[start]) {
+      continue;
+    }
+    ++count;
+    uint32_t top = 0;
+    stack[top++] = start;
+    seen[start] = true;
+    while (top > 0) {
+      uint32_t field = stack[--top];
+      uint32_t x = field % o->width;
+      uint32_t y = field / o->width;
+      uint32_t next[4] = {x > 0 ? field - 1 : field,
+                          x + 1 < o->width ? field + 1 : field,
+                          y > 0 ? field - o->width : field,
+                          y + 1 < o->height ? field + o->width : field};
+      for (int i = 0; i < 4; ++i) {
+        if (o->owner[next[i]] == player && !seen[next[i]]) {
+          seen[next[i]] = true;
+          stack[top++] = next[i];
+        }
+      }
+    }
+  }
+  return count;
+}
+
+/** @brief Sprawdza przeszukiwaniem, czy złoty ruch jest legalny.
+ * Pomija to, czy gracz wykonał już złoty ruch.
+ * @param[in,out] o  – wskaźnik na planszę, przywracaną po sprawdzeniu,
+ * @param[in] player – numer gracza,
+ * @param[in] areas  – maksymalna liczba obszarów gracza,
+ * @param[in] x      – numer kolumny,
+ * @param[in] y      – numer wiersza.
+ * @return Wartość @p true, jeśli po zajęciu pola innego gracza żaden z nich
+ * nie ma więcej niż @p areas obszarów, a @p false w przeciwnym przypadku.
+ */
+static bool oracle_golden(oracle_t *o, uint32_t player, uint32_t areas,
+                          uint32_t x, uint32_t y) {
+  uint32_t field = y * o->width + x;
+  uint32_t previous = o->owner[field];
+  if (previous == 0 || previous == player) {
+    return false;
+  }
+  o->owner[field] = player;
+  bool legal = oracle_areas(o, player) <= areas &&
+               oracle_areas(o, previous) <= areas;
+  o->owner[field] = previous;
+  return legal;
+}
+
+/** @brief Porównuje złote ruchy z przeszukiwaniem planszy.
+ * W losowych rozgrywkach na małych planszach każda próba złotego ruchu musi
+ * się udać dokładnie wtedy, gdy gracz nie wykonał jeszcze złotego ruchu,
+ * a po usunięciu pionka i postawieniu nowego liczby obszarów policzone
+ * przeszukiwaniem mieszczą się w limicie.
+ */
+static void test_golden_move(void) {
+  uint64_t seed = 9;
+  for (uint32_t round = 0; round < 200; ++round) {
+    oracle_t o;
+    o.width = 1 + random_below(&seed, ORACLE_SIDE);
+    o.height = 1 + random_below(&seed, ORACLE_SIDE);
+    uint32_t players = 2 + random_below(&seed, 4);
+    uint32_t areas = 1 + random_below(&seed, 3);
+    gamma_t *g = gamma_new_backend(o.width, o.height, players, areas,
+                                   round % 4 < 2 ? BOARD_BACKEND_ARRAY
+                                                 : BOARD_BACKEND_BIT_PLANES);
+    assert(g);
+    if (round % 2 == 1) {
+      gamma_set_area_engine(g, AREA_ENGINE_RELABEL);
+    }
+    bool used[6] = {false};
+    for (uint32_t i = 0; i < 6 * o.width * o.height; ++i) {
+      uint32_t player = 1 + random_below(&seed, players);
+      uint32_t x = random_below(&seed, o.width);
+      uint32_t y = random_below(&seed, o.height);
+      oracle_read(g, &o);
+      if (o.owner[y * o.width + x] == 0 && random_below(&seed, 4) != 0) {
+        gamma_move(g, player, x, y);
+        continue;
+      }
+      bool expected = !used[player] && oracle_golden(&o, player, areas, x, y);
+      assert(gamma_golden_move(g, player, x, y) == expected);
+      used[player] |= expected;
+    }
+    gamma_delete(g);
+  }
+}
+
+/** @brief Porównuje możliwość złotego ruchu z przeszukiwaniem planszy.
+ * Po każdym ruchu losowej rozgrywki na małej planszy gracz musi móc wykonać
+ * złoty ruch dokładnie wtedy, gdy jeszcze go nie wykonał i przeszukiwanie
+ * znajduje pole, na którym ten ruch jest legalny. Mały limit obszarów
+ * sprawdza przypadek, w którym gracz może zająć tylko pole sąsiadujące
+ * z jego obszarami.
+ */
+static void test_golden_possible(void) {
+  uint64_t seed = 10;
+  for (uint32_t round = 0; round < 200; ++round) {
+    oracle_t o;
+    o.width = 1 + random_below(&seed, ORACLE_SIDE);
+    o.height = 1 + random_below(&seed, ORACLE_SIDE);
+    uint32_t players = 2 + random_below(&seed, 4);
+    uint32_t areas = 1 + random_below(&seed, 2);
+    gamma_t *g = gamma_new_backend(o.width, o.height, players, areas,
+                                   round % 4 < 2 ? BOARD_BACKEND_ARRAY
+                                                 : BOARD_BACKEND_BIT_PLANES);
+    assert(g);
+    if (round % 2 == 1) {
+      gamma_set_area_engine(g, AREA_ENGINE_RELABEL);
+    }
+    bool used[6] = {false};
+    for (uint32_t i = 0; i < 4 * o.width * o.height; ++i) {
+      uint32_t player = 1 + random_below(&seed, players);
+      uint32_t x = random_below(&seed, o.width);
+      uint32_t y = random_below(&seed, o.height);
+      if (random_below(&seed, 16) == 0) {
+        used[player] |= gamma_golden_move(g, player, x, y);
+      } else {
+        gamma_move(g, player, x, y);
+      }
+      oracle_read(g, &o);
+      for (uint32_t p = 1; p <= players; ++p) {
+        bool expected = false;
+        for (uint32_t field = 0; !used[p] && !expected &&
+                                 field < o.width * o.height; ++field) {
+          expected = oracle_golden(&o, p, areas, field % o.width,
+                                   field / o.width);
+        }
+        assert(gamma_golden_possible(g, p) == expected);
+      }
+    }
+    gamma_delete(g);
+  }
+}
+
+/** @brief Testuje statystyki rozgrywek Monte Carlo.
+ * Po losowej rozgrywce na małej planszy ruchy początkowe muszą być
+ * wszystkimi legalnymi ruchami gracza, a rozgrywki rozłożone po równo
+ * między nie, z co najwyżej dwiema połówkami wygranych na rozgrywkę.
+ * Te same ustawienia muszą dać te same statystyki, a rozgrywki nie mogą
+ * zmienić gry.
+ */
+static void test_playouts(void) {
+  uint64_t seed = 11;
+  for (uint32_t round = 0; round < 12; ++round) {
+    uint32_t width = 1 + random_below(&seed, 6);
+    uint32_t height = 1 + random_below(&seed, 6);
+    uint32_t players = 1 + random_below(&seed, 3);
+    uint32_t areas = 1 + random_below(&seed, 2);
+    gamma_t *g = gamma_new(width, height, players, areas);
+    assert(g);
+    play(g, NULL, &seed, width, height, players, width * height);
+    uint32_t player = 1 + random_below(&seed, players);
+    uint64_t hash = gamma_hash(g);
+
+    playout_config_t config;
+    playout_defaults(&config);
+    config.threads = 1 + round % 3;
+    config.playouts = 50 + random_below(&seed, 100);
+    config.seed = round + 1;
+    config.policy = round % 2 == 0 ? PLAYOUT_RANDOM : PLAYOUT_HEURISTIC;
+    playout_result_t result, again;
+    assert(playout_run(g, player, &config, &result));
+    assert(playout_run(g, player, &config, &again));
+    assert(gamma_hash(g) == hash);
+
+    uint64_t legal = 0;
+    gamma_field_t *moves = malloc(sizeof(gamma_field_t) * width * height);
+    assert(moves);
+    legal += gamma_legal_moves(g, player, moves, width * height);
+    legal += gamma_legal_golden_moves(g, player, moves, width * height);
+    free(moves);
+    assert(result.count == legal);
+    assert(result.playouts == (legal > 0 ? config.playouts : 0));
+    assert(again.count == result.count);
+
+    uint64_t visits = 0;
+    for (uint64_t i = 0; i < result.count; ++i) {
+      const playout_stat_t *s = &result.moves[i];
+      assert(s->visits == config.playouts / legal ||
+             s->visits == config.playouts / legal + 1);
+      assert(s->wins <= 2 * s->visits);
+      assert(s->field.x == again.moves[i].field.x &&
+             s->field.y == again.moves[i].field.y &&
+             s->golden == again.moves[i].golden &&
+             s->visits == again.moves[i].visits &&
+             s->wins == again.moves[i].wins);
+      visits += s->visits;
+
+      gamma_t *copy = gamma_fork(g);
+      assert(copy);
+      assert(s->golden ? gamma_golden_move(copy, player, s->field.x,
+                                           s->field.y)
+                       : gamma_move(copy, player, s->field.x, s->field.y));
+      gamma_delete(copy);
+    }
+    assert(visits == result.playouts);
+
+    const playout_stat_t *best = playout_best(&result);
+    assert((best != NULL) == (legal > 0));
+    for (uint64_t i = 0; best != NULL && i < result.count; ++i) {
+      const playout_stat_t *s = &result.moves[i];
+      assert(s->wins * best->visits <= best->wins * s->visits);
+    }
+    playout_result_free(&result);
+    playout_result_free(&again);
+    gamma_delete(g);
+  }
+}
+
+/** @brief Odtwarza w terminalu sekwencje wypisane przez ekran.
+ * Rozumie tylko sekwencje używane przez ekran: czyszczenie terminala,
+ * ukrywanie i pokazywanie kursora, przesuwanie kursora i kolory.
+ * @param[in,out] t – wskaźnik na terminal,
+ * @param[in] data  – sekwencje,
+ * @param[in] size  – długość sekwencji.
+ */
+static void terminal_apply(terminal_t *t, const char *data, size_t size) {
+  const char *end = data + size;
+  while (data < end) {
+    if (*data != '\033') {
+      assert(t->col < TERMINAL_COLS);
+      cell_t cell = {*data++, t->fg, t->bg};
+      t->cells[t->row * TERMINAL_COLS + t->col++] = cell;
+      continue;
+    }
+    assert(++data < end && *data++ == '[');
+    bool private = data < end && *data == '?';
+    data += private;
+    uint32_t params[4] = {0};
+    uint32_t count = 1;
+    for (; data < end && (*data == ';' || (*data >= '0' && *data <= '9'));
+         ++data) {
+      if (*data == ';') {
+        assert(count < 4);
+        ++count;
+      } else {
+        params[count - 1] = 10 * params[count - 1] + (*data - '0');
+      }
+    }
+    assert(data < end);
+    char final = *data++;
+    if (private) {
+      assert(params[0] == 25 && (final == 'l' || final == 'h'));
+    } else if (final == 'J') {
+      assert(params[0] == 2);
+      cell_t blank = {' ', SCREEN_DEFAULT, SCREEN_DEFAULT};
+      for (uint32_t i = 0; i < TERMINAL_ROWS * TERMINAL_COLS; ++i) {
+        t->cells[i] = blank;
+      }
+    } else if (final == 'H') {
+      assert(count == 2 && params[0] >= 1 && params[0] <= TERMINAL_ROWS &&
+             params[1] >= 1 && params[1] <= TERMINAL_COLS);
+      t->row = params[0] - 1;
+      t->col = params[1] - 1;
+    } else if (final == 'C') {
+      assert(t->col + params[0] < TERMINAL_COLS);
+      t->col += params[0];
+    } else {
+      assert(final == 'm');
+      for (uint32_t i = 0; i < count; ++i) {
+        if (params[i] == 0) {
+          t->fg = SCREEN_DEFAULT;
+          t->bg = SCREEN_DEFAULT;
+        } else if (params[i] < 40) {
+          t->fg = params[i];
+        } else {
+          t->bg = params[i];
+        }
+      }
+    }
+  }
+}
+
+/** @brief Testuje różnicowe rysowanie ekranu.
+ * Sekwencje wypisane przez ekran dla losowych klatek, odtworzone w pustym
+ * terminalu, muszą dawać dokładnie komórki klatki. Gdy nic się nie
+ * zmieniło, klatka niczego nie wypisuje.
+ */
+static void test_screen(void) {
+  uint64_t seed = 12;
+  int fds[2];
+  assert(pipe(fds) == 0);
+  screen_t s;
+  assert(screen_init(&s, fds[1], TERMINAL_ROWS, TERMINAL_COLS));
+  terminal_t t;
+  memset(&t, 0, sizeof(t));
+  cell_t expected[TERMINAL_ROWS * TERMINAL_COLS];
+  static char data[1 << 16];
+  for (uint32_t frame = 0; frame < 200; ++frame) {
+    uint32_t changes = random_below(&seed, frame % 10 == 0 ? 400 : 20);
+    for (uint32_t i = 0; i < changes; ++i) {
+      uint32_t row = random_below(&seed, TERMINAL_ROWS + 1);
+      uint32_t col = random_below(&seed, TERMINAL_COLS + 1);
+      uint8_t fg = random_below(&seed, 4) == 0
+                   ? SCREEN_DEFAULT : 31 + random_below(&seed, 7);
+      uint8_t bg = random_below(&seed, 4) == 0
+                   ? SCREEN_DEFAULT : 41 + random_below(&seed, 7);
+      if (random_below(&seed, 16) == 0) {
+        screen_clear(&s, row, col);
+      } else if (random_below(&seed, 4) == 0) {
+        screen_text(&s, row, col, "abc def", fg, bg);
+      } else {
+        cell_t cell = {(char) ('a' + random_below(&seed, 3)), fg, bg};
+        screen_put(&s, row, col, cell);
+      }
+    }
+    memcpy(expected, s.back, sizeof(expected));
+    if (!screen_dirty(&s)) {
+      continue;
+    }
+    screen_flush(&s);
+    assert(!screen_dirty(&s));
+    ssize_t size = read(fds[0], data, sizeof(data));
+    assert(size >= 0 && (size_t) size < sizeof(data));
+    terminal_apply(&t, data, size);
+    for (uint32_t i = 0; i < TERMINAL_ROWS * TERMINAL_COLS; ++i) {
+      assert(t.cells[i].c == expected[i].c && t.cells[i].fg == expected[i].fg &&
+             t.cells[i].bg == expected[i].bg);
+    }
+  }
+  screen_free(&s);
+  close(fds[0]);
+  close(fds[1]);
+}
+
+/** @brief Testuje dopasowanie widocznych pól do rozmiaru terminala.
+ * Przy losowych rozmiarach terminala i położeniach kursora, także przy
+ * terminalu mniejszym od jednego pola, widoczne pola muszą się mieścić
+ * w terminalu i na planszy, obejmować pole pod kursorem i nie przesuwać
+ * się bez potrzeby.
+ */
+static void test_viewport(void) {
+  uint64_t seed = 13;
+  for (uint32_t round = 0; round < 40; ++round) {
+    uint32_t width = 1 + random_below(&seed, 60);
+    uint32_t height = 1 + random_below(&seed, 60);
+    uint32_t players = 1 + random_below(&seed, round % 2 == 0 ? 9 : 200);
+    gamma_t *g = gamma_new(width, height, players, 1);
+    assert(g);
+    viewport_t p = {0, 0, 0, 0};
+    for (uint32_t i = 0; i < 200; ++i) {
+      uint32_t rows = 1 + random_below(&seed, 70);
+      uint32_t cols = 1 + random_below(&seed, 150);
+      g->x = random_below(&seed, width);
+      g->y = random_below(&seed, height);
+      uint32_t row = height - 1 - g->y;
+      viewport_t before = p;
+      if (i == 0 || random_below(&seed, 2) == 0) {
+        interactive_fit(g, &p, rows, cols);
+        uint32_t visible = rows > 1 ? rows - 1 : 1;
+        uint32_t fields = cols / g->frame > 0 ? cols / g->frame : 1;
+        assert(p.rows == (visible < height ? visible : height));
+        assert(p.fields == (fields < width ? fields : width));
+      } else {
+        bool moved = interactive_scroll(g, &p);
+        assert(moved == (p.left != before.left || p.top != before.top));
+        assert(p.rows == before.rows && p.fields == before.fields);
+      }
+      assert(p.left + p.fields <= width && p.top + p.rows <= height);
+      assert(p.left <= g->x && g->x < p.left + p.fields);
+      assert(p.top <= row && row < p.top + p.rows);
+      if (before.left <= g->x && before.left + p.fields <= width &&
+          g->x < before.left + p.fields) {
+        assert(p.left == before.left);
+      }
+      if (before.top <= row && before.top + p.rows <= height &&
+          row < before.top + p.rows) {
+        assert(p.top == before.top);
+      }
+    }
+    gamma_delete(g);
+  }
+}
+
+/** @brief Odczytuje klawisze z danych przekazanych kawałkami.
+ * Każdy kawałek jest osobnym zapisem do potoku, po którym wejście wczytuje
+ * dane i podaje wszystkie całe klawisze.
+ * @param[in] data  – dane,
+ * @param[in] size  – długość danych,
+ * @param[in] cuts  – posortowane miejsca podziału danych,
+ * @param[in] count – liczba miejsc podziału,
+ * @param[out] keys – tablica na co najmniej @p size kodów klawiszy,
+ * @return Liczba klawiszy.
+ */
+static size_t read_keys(const char *data, size_t size, const size_t *cuts,
+                        size_t count, int *keys) {
+  int fds[2];
+  assert(pipe(fds) == 0);
+  input_t in;
+  input_init(&in, fds[0], NULL);
+  size_t done = 0;
+  size_t from = 0;
+  for (size_t i = 0; i <= count; ++i) {
+    size_t to = i < count ? cuts[i] : size;
+    if (to > from) {
+      assert(write(fds[1], data + from, to - from) == (ssize_t) (to - from));
+      assert(input_fill(&in));
+    }
+    from = to;
+    int key;
+    while ((key = interactive_key(&in)) != KEY_NONE) {
+      keys[done++] = key;
+    }
+  }
+  close(fds[1]);
+  assert(!input_fill(&in));
+  int key;
+  while ((key = interactive_key(&in)) != KEY_NONE) {
+    keys[done++] = key;
+  }
+  assert(in.start == in.end);
+  input_free(&in);
+  close(fds[0]);
+  return done;
+}
+
+/** @brief Testuje odczytywanie klawiszy w trybie interaktywnym.
+ * Sekwencje strzałek i innych klawiszy podzielone w losowych miejscach
+ * między kolejne odczyty muszą dawać te same klawisze co dane wczytane
+ * naraz. Niepełna sekwencja na końcu danych jest pomijana.
+ */
+static void test_keys(void) {
+  static const char data[] = "ab\033[A\033[B \033x\033[Cgc\033[D"
+                             "\004\033[Zq\033[";
+  static const int expected[] = {
+    'a', 'b', KEY_CSI + 'A', KEY_CSI + 'B', ' ', KEY_CSI + 'C', 'g', 'c',
+    KEY_CSI + 'D', 4, KEY_CSI + 'Z', 'q'
+  };
+  size_t size = sizeof(data) - 1;
+  size_t length = sizeof(expected) / sizeof(*expected);
+  int keys[sizeof(data)];
+  assert(read_keys(data, size, NULL, 0, keys) == length);
+  assert(memcmp(keys, expected, sizeof(expected)) == 0);
+
+  uint64_t seed = 14;
+  for (uint32_t round = 0; round < 300; ++round) {
+    size_t cuts[sizeof(data)];
+    size_t count = 0;
+    for (size_t i = 1; i < size; ++i) {
+      if (random_below(&seed, 3) == 0) {
+        cuts[count++] = i;
+      }
+    }
+    assert(read_keys(data, size, cuts, count, keys) == length);
+    assert(memcmp(keys, expected, sizeof(expected)) == 0);
+  }
+}
+
 /** @brief Testuje silnik gry gamma.
  * Przeprowadza przykładowe testy silnika gry gamma.
  * @return Zero, gdy wszystkie testy przebiegły poprawnie,
@@ -94,5 +1236,21 @@ int main() {
   free(p);
 
   gamma_delete(g);
+
+  test_area_engines();
+  test_backends();
+  test_undo();
+  test_fork();
+  test_legal_moves();
+  test_hash();
+  test_board_write();
+  test_can_move();
+  test_reset();
+  test_golden_move();
+  test_golden_possible();
+  test_playouts();
+  test_screen();
+  test_viewport();
+  test_keys();
   return 0;
 }
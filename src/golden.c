@@ -0,0 +1,389 @@
+/** @file
+ * Implementacja indeksu pól, które gracze mogą przejąć złotym ruchem.
+ *
+ * @author Marcin Malejky
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "gamma.h"
+#include "golden.h"
+
+#define NOBODY 0 /**< Domyślny posiadacz pustego pola. */
+#define INITIAL_CAPACITY 16 /**< Początkowa pojemność listy kandydatów. */
+
+/** @brief Usuwa odwołanie listy do współdzielonej tablicy kandydatów.
+ * Zwalnia tablicę, jeśli odwołanie było ostatnie.
+ * @param[in,out] list – wskaźnik na listę ze współdzieloną tablicą.
+ */
+static void release(candidates_t *list);
+
+/** @brief Zapewnia, że lista ma własną tablicę kandydatów.
+ * Jeśli nie uda się zaalokować pamięci, oznacza listę jako niepełną.
+ * @param[in,out] list – wskaźnik na listę.
+ */
+static void own(candidates_t *list);
+
+/** @brief Sprawdza, czy pole sąsiaduje z polem gracza.
+ * @param[in] g      – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player – numer gracza,
+ * @param[in] field  – numer pola,
+ * @return Wartość @p true, jeśli pole @p field sąsiaduje z polem gracza
+ * @p player, a @p false w przeciwnym przypadku.
+ */
+static bool borders(gamma_t *g, uint32_t player, uint32_t field);
+
+/** @brief Sprawdza, czy kandydat jest nadal aktualny.
+ * @param[in] g      – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player – numer gracza, do którego listy należy kandydat,
+ * @param[in] field  – numer pola,
+ * @return Wartość @p true, jeśli pole należy do innego gracza i sąsiaduje
+ * z polem gracza @p player.
+ */
+static bool still_candidate(gamma_t *g, uint32_t player, uint32_t field);
+
+/** @brief Sprawdza, czy przejęcie pola nie przekroczy limitu właściciela.
+ * Liczbę części obszaru po usunięciu pola zapamiętuje w kandydacie, dopóki
+ * obszary właściciela się nie zmienią.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in,out] c   – wskaźnik na kandydata,
+ * @return Wartość @p true, jeśli poprzedni właściciel nie przekroczy limitu.
+ */
+static bool safe(gamma_t *g, candidate_t *c);
+
+/** @brief Usuwa z listy kandydatów nieaktualne wpisy.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza.
+ */
+static void compact(gamma_t *g, uint32_t player);
+
+/** @brief Dodaje pole do listy kandydatów gracza.
+ * Jeśli nie uda się zaalokować pamięci, oznacza listę jako niepełną.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza,
+ * @param[in] field   – numer pola.
+ */
+static void push(gamma_t *g, uint32_t player, uint32_t field);
+
+/** @brief Sprawdza, czy zapamiętany brak kandydata jest nadal aktualny.
+ * @param[in] g      – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player – numer gracza,
+ * @return Wartość @p true, jeśli od sprawdzenia listy gracza nie dodano do
+ * niej pól i nie zmieniły się obszary właścicieli kandydatów.
+ */
+static bool still_blocked(gamma_t *g, uint32_t player);
+
+/** @brief Zapamiętuje, że żaden kandydat gracza nie jest bezpieczny.
+ * Zapisuje różnych właścicieli kandydatów z listy. Nie zapamiętuje wyniku,
+ * jeśli sprawdzenie któregoś kandydata lub zapis nie udały się z braku
+ * pamięci.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza.
+ */
+static void remember(gamma_t *g, uint32_t player);
+
+/** @brief Przeszukuje całą planszę w poszukiwaniu kandydata.
+ * Używane, gdy lista kandydatów gracza jest niepełna. Przegląda planszę
+ * słowami i sprawdza tylko pola, które sąsiadują z polem gracza.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza,
+ * @return Wartość jak dla @ref golden_bordering_possible.
+ */
+static bool scan(gamma_t *g, uint32_t player);
+
+bool golden_init(golden_t *index, uint32_t players) {
+    index->players = players;
+    index->candidates = calloc(players + 1, sizeof(candidates_t));
+    index->blocked = calloc(players + 1, sizeof(blocked_t));
+    index->version = malloc(sizeof(uint64_t) * (players + 1));
+    index->mark = calloc(players + 1, sizeof(uint64_t));
+    if (!index->candidates || !index->blocked || !index->version ||
+        !index->mark) {
+        golden_free(index);
+        return false;
+    }
+    for (uint32_t i = 0; i <= players; ++i) {
+        index->candidates[i].complete = true;
+        index->version[i] = 1;
+    }
+    index->checks = 0;
+    index->clock = 1;
+    return true;
+}
+
+void golden_free(golden_t *index) {
+    if (index->candidates != NULL) {
+        for (uint32_t i = 0; i <= index->players; ++i) {
+            if (index->candidates[i].refs != NULL) {
+                release(&index->candidates[i]);
+            } else {
+                free(index->candidates[i].items);
+            }
+        }
+    }
+    if (index->blocked != NULL) {
+        for (uint32_t i = 0; i <= index->players; ++i) {
+            free(index->blocked[i].owners);
+        }
+    }
+    free(index->candidates);
+    free(index->blocked);
+    free(index->version);
+    free(index->mark);
+    index->candidates = NULL;
+    index->blocked = NULL;
+    index->version = NULL;
+    index->mark = NULL;
+}
+
+void golden_clear(golden_t *index) {
+    for (uint32_t i = 0; i <= index->players; ++i) {
+        index->candidates[i].length = 0;
+        index->candidates[i].complete = true;
+        index->blocked[i].since = 0;
+        index->blocked[i].count = 0;
+        index->version[i] = 1;
+        index->mark[i] = 0;
+    }
+    index->checks = 0;
+    index->clock = 1;
+}
+
+bool golden_share(golden_t *copy, golden_t *index) {
+    if (!golden_init(copy, index->players)) {
+        return false;
+    }
+    memcpy(copy->version, index->version,
+           sizeof(uint64_t) * (index->players + 1));
+    copy->clock = index->clock;
+    for (uint32_t i = 0; i <= index->players; ++i) {
+        candidates_t *list = &index->candidates[i];
+        if (list->items == NULL) {
+            copy->candidates[i].complete = list->complete;
+            continue;
+        }
+        if (list->refs == NULL) {
+            list->refs = malloc(sizeof(atomic_uint));
+            if (!list->refs) {
+                copy->candidates[i].complete = false;
+                continue;
+            }
+            atomic_init(list->refs, 1);
+        }
+        atomic_fetch_add_explicit(list->refs, 1, memory_order_relaxed);
+        copy->candidates[i] = *list;
+    }
+    return true;
+}
+
+static void release(candidates_t *list) {
+    if (atomic_fetch_sub_explicit(list->refs, 1, memory_order_acq_rel) == 1) {
+        free(list->items);
+        free(list->refs);
+    }
+    list->refs = NULL;
+}
+
+static void own(candidates_t *list) {
+    if (list->refs == NULL) {
+        return;
+    }
+    if (atomic_load_explicit(list->refs, memory_order_acquire) == 1) {
+        free(list->refs);
+        list->refs = NULL;
+        return;
+    }
+    candidate_t *items = malloc(sizeof(candidate_t) * list->capacity);
+    if (items != NULL) {
+        memcpy(items, list->items, sizeof(candidate_t) * list->length);
+    }
+    release(list);
+    list->items = items;
+    if (!items) {
+        list->length = 0;
+        list->capacity = 0;
+        list->complete = false;
+    }
+}
+
+static bool borders(gamma_t *g, uint32_t player, uint32_t field) {
+    for (uint32_t i = 0; i < BOARD_SIDES; ++i) {
+        if (board_owner(&g->board, field + g->board.side[i]) == player) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool still_candidate(gamma_t *g, uint32_t player, uint32_t field) {
+    uint32_t owner = board_owner(&g->board, field);
+    return owner != NOBODY && owner != player && borders(g, player, field);
+}
+
+static bool safe(gamma_t *g, candidate_t *c) {
+    uint32_t owner = board_owner(&g->board, c->field);
+    /* Pole ma najwyżej SPLIT_MAX_PARTS sąsiadów. */
+    if (g->area_count[owner] + SPLIT_MAX_PARTS - 1 <= g->areas_limit) {
+        return true;
+    }
+    if (c->version != g->golden.version[owner]) {
+        if (!split_check(g, c->field, &c->pieces)) {
+            c->version = 0;
+            return false;
+        }
+        c->version = g->golden.version[owner];
+    }
+    return g->area_count[owner] + c->pieces - 1 <= g->areas_limit;
+}
+
+static void compact(gamma_t *g, uint32_t player) {
+    candidates_t *list = &g->golden.candidates[player];
+    uint64_t length = 0;
+    for (uint64_t i = 0; i < list->length; ++i) {
+        if (still_candidate(g, player, list->items[i].field)) {
+            list->items[length++] = list->items[i];
+        }
+    }
+    list->length = length;
+}
+
+static void push(gamma_t *g, uint32_t player, uint32_t field) {
+    candidates_t *list = &g->golden.candidates[player];
+    g->golden.blocked[player].since = 0;
+    own(list);
+    if (!list->complete) {
+        return;
+    }
+    if (list->length == list->capacity) {
+        compact(g, player);
+        /* Powiększa tablicę, jeśli po usunięciu nieaktualnych wpisów jest
+         * co najmniej w połowie pełna, aby koszt porządkowania rozłożył się
+         * na wiele wstawień. */
+        if (list->length >= list->capacity / 2) {
+            uint64_t capacity = list->capacity ? 2 * list->capacity
+                                               : INITIAL_CAPACITY;
+            candidate_t *items = realloc(list->items,
+                                         sizeof(candidate_t) * capacity);
+            if (!items) {
+                list->complete = false;
+                return;
+            }
+            list->items = items;
+            list->capacity = capacity;
+        }
+    }
+    candidate_t c = {field, 0, 0};
+    list->items[(list->length)++] = c;
+}
+
+void golden_touch(gamma_t *g, uint32_t field, uint32_t previous_owner) {
+    uint32_t owner = board_owner(&g->board, field);
+    g->golden.version[owner] = ++(g->golden.clock);
+    g->golden.version[previous_owner] = ++(g->golden.clock);
+    for (uint32_t i = 0; i < BOARD_SIDES; ++i) {
+        uint32_t other = field + g->board.side[i];
+        uint32_t neighbour = board_owner(&g->board, other);
+        if (owner != NOBODY && neighbour != NOBODY && neighbour != owner &&
+            neighbour != g->board.border) {
+            push(g, neighbour, field);
+            push(g, owner, other);
+        }
+    }
+}
+
+static bool still_blocked(gamma_t *g, uint32_t player) {
+    blocked_t *b = &g->golden.blocked[player];
+    if (b->since == 0) {
+        return false;
+    }
+    for (uint32_t i = 0; i < b->count; ++i) {
+        if (g->golden.version[b->owners[i]] > b->since) {
+            b->since = 0;
+            return false;
+        }
+    }
+    return true;
+}
+
+static void remember(gamma_t *g, uint32_t player) {
+    golden_t *index = &g->golden;
+    candidates_t *list = &index->candidates[player];
+    blocked_t *b = &index->blocked[player];
+    uint64_t check = ++(index->checks);
+    b->count = 0;
+    for (uint64_t i = 0; i < list->length; ++i) {
+        uint32_t owner = board_owner(&g->board, list->items[i].field);
+        /* Kandydat, dla którego nie policzono części, nie jest pewny. */
+        if (list->items[i].version == 0) {
+            return;
+        }
+        if (index->mark[owner] == check) {
+            continue;
+        }
+        index->mark[owner] = check;
+        if (b->count == b->capacity) {
+            uint32_t capacity = b->capacity ? 2 * b->capacity : BOARD_SIDES;
+            uint32_t *owners = realloc(b->owners, sizeof(uint32_t) * capacity);
+            if (!owners) {
+                return;
+            }
+            b->owners = owners;
+            b->capacity = capacity;
+        }
+        b->owners[(b->count)++] = owner;
+    }
+    b->since = index->clock;
+}
+
+static bool scan(gamma_t *g, uint32_t player) {
+    board_t *b = &g->board;
+    for (uint64_t word = 0; word < b->words; ++word) {
+        /* Zajęte pola innych graczy sąsiadujące z polem gracza. */
+        uint64_t mask = board_adjacent_word(b, player, word) &
+                        ~board_owned_word(b, NOBODY, word) &
+                        ~board_owned_word(b, player, word) &
+                        ~board_owned_word(b, b->border, word);
+        while (mask != 0) {
+            candidate_t c = {word * BOARD_WORD_BITS + __builtin_ctzll(mask),
+                             0, 0};
+            if (safe(g, &c)) {
+                return true;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return false;
+}
+
+bool golden_bordering_possible(gamma_t *g, uint32_t player) {
+    candidates_t *list = &g->golden.candidates[player];
+    own(list);
+    if (!list->complete) {
+        return scan(g, player);
+    }
+    if (still_blocked(g, player)) {
+        return false;
+    }
+    uint64_t i = 0;
+    while (i < list->length) {
+        if (!still_candidate(g, player, list->items[i].field)) {
+            list->items[i] = list->items[--(list->length)];
+            continue;
+        }
+        if (safe(g, &list->items[i])) {
+            /* Ostatnio znaleziony kandydat jest sprawdzany jako pierwszy. */
+            candidate_t temp = list->items[0];
+            list->items[0] = list->items[i];
+            list->items[i] = temp;
+            return true;
+        }
+        ++i;
+    }
+    remember(g, player);
+    return false;
+}
+
+bool golden_safe(gamma_t *g, uint32_t field) {
+    candidate_t c = {field, 0, 0};
+    return safe(g, &c);
+}
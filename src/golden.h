@@ -0,0 +1,131 @@
+/** @file
+ * Interfejs indeksu pól, które gracze mogą przejąć złotym ruchem.
+ *
+ * @author Marcin Malejky
+ */
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef GAMMA_GOLDEN_H
+#define GAMMA_GOLDEN_H
+
+struct gamma;
+
+/**
+ * Pole innego gracza sąsiadujące z polem danego gracza.
+ */
+typedef struct {
+    uint32_t field; /**< Numer pola. */
+    uint32_t pieces; /**< Liczba części obszaru po usunięciu pola. */
+    uint64_t version; /**< Wersja obszarów właściciela, dla której policzono
+                        *  @p pieces, lub zero. */
+} candidate_t;
+
+/**
+ * Lista kandydatów na złoty ruch jednego gracza.
+ * Wpisy są weryfikowane dopiero przy zapytaniu, więc lista może zawierać
+ * nieaktualne lub powtórzone pola. Tablica kandydatów może być współdzielona
+ * z kopiami gry i jest kopiowana przed pierwszą zmianą.
+ */
+typedef struct {
+    candidate_t *items; /**< Tablica kandydatów. */
+    uint64_t length; /**< Liczba kandydatów. */
+    uint64_t capacity; /**< Pojemność tablicy kandydatów. */
+    bool complete; /**< Czy lista zawiera wszystkich kandydatów. */
+    atomic_uint *refs; /**< Liczba list współdzielących tablicę kandydatów
+                         *  lub NULL, jeśli tablica nie jest współdzielona. */
+} candidates_t;
+
+/**
+ * Zapamiętany brak kandydata na złoty ruch jednego gracza.
+ * Wynik pozostaje aktualny, dopóki do listy gracza nie trafi nowe pole
+ * i nie zmienią się obszary żadnego z zapisanych właścicieli kandydatów.
+ */
+typedef struct {
+    uint64_t since; /**< Wersja, przy której sprawdzono listę, lub zero,
+                      *  jeśli wynik nie jest zapamiętany. */
+    uint32_t *owners; /**< Tablica różnych właścicieli kandydatów. */
+    uint32_t count; /**< Liczba właścicieli kandydatów. */
+    uint32_t capacity; /**< Pojemność tablicy właścicieli. */
+} blocked_t;
+
+/**
+ * Indeks kandydatów na złoty ruch wszystkich graczy.
+ */
+typedef struct {
+    candidates_t *candidates; /**< Tablica list kandydatów graczy. */
+    blocked_t *blocked; /**< Tablica zapamiętanych braków kandydatów. */
+    uint64_t *version; /**< Tablica wersji obszarów graczy. */
+    uint64_t *mark; /**< Numer ostatniego sprawdzenia, w którym zapisano
+                      *  gracza jako właściciela kandydata. */
+    uint64_t checks; /**< Liczba zapamiętanych sprawdzeń. */
+    uint64_t clock; /**< Ostatnio nadana wersja. */
+    uint32_t players; /**< Liczba graczy. */
+} golden_t;
+
+/** @brief Inicjalizuje pusty indeks.
+ * @param[out] index  – wskaźnik na indeks,
+ * @param[in] players – liczba graczy,
+ * @return Wartość @p true, jeśli pomyślnie zaalokowano pamięć, a @p false
+ * w przeciwnym przypadku.
+ */
+bool golden_init(golden_t *index, uint32_t players);
+
+/** @brief Zwalnia pamięć indeksu.
+ * @param[in,out] index – wskaźnik na indeks.
+ */
+void golden_free(golden_t *index);
+
+/** @brief Opróżnia indeks, zachowując pamięć list kandydatów.
+ * Indeks nie może współdzielić list z innym indeksem.
+ * @param[in,out] index – wskaźnik na indeks.
+ */
+void golden_clear(golden_t *index);
+
+/** @brief Tworzy indeks współdzielący listy kandydatów z indeksem @p index.
+ * Jeśli nie uda się zaalokować licznika współdzielenia listy, lista kopii
+ * jest oznaczana jako niepełna.
+ * @param[out] copy     – wskaźnik na nowy indeks,
+ * @param[in,out] index – wskaźnik na kopiowany indeks,
+ * @return Wartość @p true, jeśli pomyślnie zaalokowano pamięć, a @p false
+ * w przeciwnym przypadku.
+ */
+bool golden_share(golden_t *copy, golden_t *index);
+
+/** @brief Uwzględnia zmianę właściciela pola.
+ * Wywoływana po każdej zmianie posiadacza pola @p field, także po cofnięciu
+ * ruchu.
+ * Unieważnia zapamiętane wyniki dla obszarów nowego i poprzedniego
+ * właściciela oraz dodaje nowe pary sąsiadujących pól różnych graczy.
+ * @param[in,out] g          – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] field          – numer pola,
+ * @param[in] previous_owner – poprzedni właściciel pola lub zero.
+ */
+void golden_touch(struct gamma *g, uint32_t field, uint32_t previous_owner);
+
+/** @brief Sprawdza, czy gracz może przejąć któreś sąsiednie pole.
+ * Sprawdza, czy istnieje pole innego gracza sąsiadujące z polem gracza
+ * @p player, którego usunięcie nie spowoduje przekroczenia limitu obszarów
+ * przez jego właściciela. Nie sprawdza, czy gracz wykonał już złoty ruch.
+ * Wynik negatywny jest zapamiętywany, więc ponowne zapytanie o gracza bez
+ * ruchu kosztuje tyle, ilu graczy z nim sąsiaduje, a nie ile ma kandydatów.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza,
+ * @return Wartość @p true, jeśli takie pole istnieje, a @p false
+ * w przeciwnym przypadku.
+ */
+bool golden_bordering_possible(struct gamma *g, uint32_t player);
+
+/** @brief Sprawdza, czy przejęcie pola nie przekroczy limitu właściciela.
+ * Sprawdza, czy po usunięciu pola @p field jego właściciel będzie miał
+ * najwyżej tyle obszarów, ile pozwala limit.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] field   – numer pola zajętego przez gracza,
+ * @return Wartość @p true, jeśli właściciel nie przekroczy limitu, a @p false
+ * w przeciwnym przypadku lub gdy nie udało się zaalokować pamięci.
+ */
+bool golden_safe(struct gamma *g, uint32_t field);
+
+#endif //GAMMA_GOLDEN_H
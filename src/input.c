@@ -0,0 +1,184 @@
+/** @file
+ * Implementacja wczytywania wierszy z deskryptora pliku dużymi blokami.
+ *
+ * @author Marcin Malejky
+ */
+
+#define _POSIX_C_SOURCE 200809L /**< Dostęp do read, mmap i posix_madvise. */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "input.h"
+
+/** @brief Zapowiada wczytanie kolejnych bloków odwzorowanego pliku.
+ * @param[in,out] in – wskaźnik na wejście.
+ */
+static void prefetch(input_t *in);
+
+void input_init(input_t *in, int fd, output_t *flush) {
+    in->fd = fd;
+    in->data = NULL;
+    in->start = 0;
+    in->scan = 0;
+    in->end = 0;
+    in->capacity = 0;
+    in->eof = false;
+    in->mapped = false;
+    in->opened = false;
+    in->advised = 0;
+    in->flush = flush;
+}
+
+bool input_open(input_t *in, const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+    input_init(in, fd, NULL);
+    in->opened = true;
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+        return true;
+    }
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        return true;
+    }
+    posix_madvise(data, st.st_size, POSIX_MADV_SEQUENTIAL);
+    close(fd);
+    in->opened = false;
+    in->data = data;
+    in->end = st.st_size;
+    in->capacity = st.st_size;
+    in->eof = true;
+    in->mapped = true;
+    prefetch(in);
+    return true;
+}
+
+void input_free(input_t *in) {
+    if (in->mapped) {
+        munmap(in->data, in->capacity);
+    } else {
+        free(in->data);
+    }
+    if (in->opened) {
+        close(in->fd);
+    }
+    in->data = NULL;
+    in->capacity = 0;
+    in->mapped = false;
+    in->opened = false;
+}
+
+static void prefetch(input_t *in) {
+    /* Granice bloków są wielokrotnościami rozmiaru strony. */
+    size_t ahead = (in->start / INPUT_BLOCK + INPUT_PREFETCH) * INPUT_BLOCK;
+    if (in->advised >= in->end || in->advised > in->start + INPUT_BLOCK) {
+        return;
+    }
+    size_t end = ahead < in->end ? ahead : in->end;
+    posix_madvise(in->data + in->advised, end - in->advised,
+                  POSIX_MADV_WILLNEED);
+    in->advised = end;
+}
+
+bool input_fill(input_t *in) {
+    if (in->eof) {
+        return false;
+    }
+    if (in->start > 0) {
+        memmove(in->data, in->data + in->start, in->end - in->start);
+        in->end -= in->start;
+        in->scan -= in->start;
+        in->start = 0;
+    }
+    if (in->capacity - in->end < INPUT_BLOCK) {
+        size_t capacity = in->capacity < INPUT_BLOCK ?
+                          2 * INPUT_BLOCK : 2 * in->capacity;
+        char *data = realloc(in->data, capacity);
+        if (data == NULL) {
+            in->eof = true;
+            return false;
+        }
+        in->data = data;
+        in->capacity = capacity;
+    }
+    if (in->flush != NULL) {
+        output_flush(in->flush);
+    }
+    ssize_t size;
+    do {
+        size = read(in->fd, in->data + in->end, in->capacity - in->end);
+    } while (size < 0 && errno == EINTR);
+    if (size < 0 && errno == EAGAIN) {
+        return false;
+    }
+    if (size <= 0) {
+        in->eof = true;
+        return false;
+    }
+    in->end += size;
+    return true;
+}
+
+bool input_next(input_t *in, const char **line, size_t *size) {
+    char *newline = NULL;
+    if (in->scan < in->end) {
+        newline = memchr(in->data + in->scan, '\n', in->end - in->scan);
+    }
+    if (newline == NULL) {
+        in->scan = in->end;
+        return false;
+    }
+    if (in->mapped) {
+        prefetch(in);
+    }
+    size_t next = newline - in->data + 1;
+    *line = in->data + in->start;
+    *size = next - in->start;
+    in->start = next;
+    in->scan = next;
+    return true;
+}
+
+bool input_line(input_t *in, const char **line, size_t *size) {
+    while (!input_next(in, line, size)) {
+        if (!input_fill(in)) {
+            if (in->start == in->end) {
+                return false;
+            }
+            *line = in->data + in->start;
+            *size = in->end - in->start;
+            in->start = in->end;
+            in->scan = in->end;
+            return true;
+        }
+    }
+    return true;
+}
+
+size_t input_records(input_t *in, size_t size, const char **data) {
+    while (in->end - in->start < size) {
+        if (!input_fill(in)) {
+            return 0;
+        }
+    }
+    if (in->mapped) {
+        prefetch(in);
+    }
+    size_t count = (in->end - in->start) / size;
+    if (count * size > INPUT_BLOCK && size <= INPUT_BLOCK) {
+        count = INPUT_BLOCK / size;
+    }
+    *data = in->data + in->start;
+    in->start += count * size;
+    in->scan = in->start;
+    return count;
+}
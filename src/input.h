@@ -0,0 +1,107 @@
+/** @file
+ * Interfejs wczytywania wierszy z deskryptora pliku dużymi blokami.
+ *
+ * @author Marcin Malejky
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "output.h"
+
+#ifndef GAMMA_INPUT_H
+#define GAMMA_INPUT_H
+
+#define INPUT_BLOCK 1048576 /**< Rozmiar jednego odczytu z deskryptora. */
+#define INPUT_PREFETCH 4 /**< Liczba bloków czytanych z wyprzedzeniem. */
+
+/**
+ * Wejście czytane blokami.
+ * Wiersze są zwracane jako wskaźniki do bufora, bez kopiowania.
+ */
+typedef struct {
+    int fd; /**< Deskryptor pliku wejścia. */
+    char *data; /**< Bufor z wczytanymi danymi. */
+    size_t start; /**< Początek nieprzetworzonych danych w buforze. */
+    size_t scan; /**< Miejsce, od którego należy szukać końca wiersza. */
+    size_t end; /**< Koniec wczytanych danych w buforze. */
+    size_t capacity; /**< Rozmiar bufora. */
+    bool eof; /**< Czy osiągnięto koniec pliku. */
+    bool mapped; /**< Czy bufor jest plikiem odwzorowanym w pamięci. */
+    bool opened; /**< Czy deskryptor został otwarty przez wejście. */
+    size_t advised; /**< Koniec odwzorowania zapowiedzianego do wczytania. */
+    output_t *flush; /**< Wyjście opróżniane przed czekaniem na dane. */
+} input_t;
+
+/** @brief Inicjalizuje wejście.
+ * @param[out] in   – wskaźnik na wejście,
+ * @param[in] fd    – deskryptor pliku,
+ * @param[in] flush – wyjście do opróżnienia przed każdym odczytem
+ *                    z deskryptora lub NULL.
+ */
+void input_init(input_t *in, int fd, output_t *flush);
+
+/** @brief Otwiera plik jako wejście.
+ * Zwykły plik jest odwzorowywany w pamięci tylko do odczytu, a wiersze są
+ * zwracane wprost z odwzorowania. Jądro jest uprzedzane, że plik będzie
+ * czytany po kolei, i przed bieżącym miejscem zawsze jest wczytywanych
+ * kilka bloków. Innych plików, np. potoków, nie da się odwzorować, więc są
+ * czytane blokami jak deskryptor w @ref input_init.
+ * @param[out] in  – wskaźnik na wejście,
+ * @param[in] path – ścieżka do pliku,
+ * @return Wartość @p true, jeśli udało się otworzyć plik, a @p false
+ * w przeciwnym przypadku.
+ */
+bool input_open(input_t *in, const char *path);
+
+/** @brief Zwalnia bufor wejścia.
+ * Zamyka plik otwarty przez @ref input_open.
+ * @param[in,out] in – wskaźnik na wejście.
+ */
+void input_free(input_t *in);
+
+/** @brief Dopisuje do bufora kolejny blok danych.
+ * Wykonuje jeden odczyt z deskryptora. Przesuwa nieprzetworzone dane na
+ * początek bufora, a gdy to nie wystarcza, powiększa bufor.
+ * @param[in,out] in – wskaźnik na wejście,
+ * @return Wartość @p true, jeśli wczytano dane, a @p false na końcu wejścia
+ * (wtedy jest ustawiane @p eof), po błędzie odczytu, gdy nie udało się
+ * zaalokować pamięci lub gdy nieblokujący deskryptor nie ma teraz danych.
+ */
+bool input_fill(input_t *in);
+
+/** @brief Podaje następny cały wiersz, który jest już w buforze.
+ * Nie czyta z deskryptora.
+ * @param[in,out] in – wskaźnik na wejście,
+ * @param[out] line  – wskaźnik na początek wiersza,
+ * @param[out] size  – wskaźnik na długość wiersza,
+ * @return Wartość @p true, jeśli w buforze był cały wiersz, a @p false
+ * w przeciwnym przypadku.
+ */
+bool input_next(input_t *in, const char **line, size_t *size);
+
+/** @brief Podaje następny wiersz.
+ * Wiersz kończy się znakiem nowej linii, z wyjątkiem ostatniego wiersza
+ * pliku, i może zawierać znaki '\0'. Wiersz jest ważny do następnego
+ * wywołania.
+ * @param[in,out] in – wskaźnik na wejście,
+ * @param[out] line  – wskaźnik na początek wiersza,
+ * @param[out] size  – wskaźnik na długość wiersza,
+ * @return Wartość @p true, jeśli wczytano wiersz, a @p false na końcu
+ * wejścia, po błędzie odczytu lub gdy nie udało się zaalokować pamięci.
+ */
+bool input_line(input_t *in, const char **line, size_t *size);
+
+/** @brief Podaje kolejne rekordy stałej długości.
+ * Czeka, aż wczytany zostanie co najmniej jeden cały rekord, i podaje
+ * wszystkie całe rekordy z bufora, ale nie więcej niż mieści się w jednym
+ * bloku. Rekordy są ważne do następnego wywołania. Gdy wynikiem jest 0, na
+ * wejściu może pozostać niepełny rekord o długości @p end - @p start.
+ * @param[in,out] in – wskaźnik na wejście,
+ * @param[in] size   – długość rekordu,
+ * @param[out] data  – wskaźnik na początek pierwszego rekordu,
+ * @return Liczba rekordów lub 0 na końcu wejścia, po błędzie odczytu lub gdy
+ * nie udało się zaalokować pamięci.
+ */
+size_t input_records(input_t *in, size_t size, const char **data);
+
+#endif //GAMMA_INPUT_H
@@ -4,12 +4,26 @@
  * @author Marcin Malejky
  */
 
+#define _POSIX_C_SOURCE 200809L /**< Dostęp do sigaction, poll
+                                 * i clock_gettime. */
+
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <termios.h>
+#include <time.h>
+#include <sys/eventfd.h>
 #include <sys/ioctl.h>
 #include <unistd.h>
+#include <stdlib.h>
 #include "gamma.h"
 #include "interactive_mode.h"
+#include "mcts.h"
+#include "playout.h"
+#include "ring.h"
+#include "screen.h"
 
 #define ESC 27 /**< Kod znaku ESCAPE. */
 #define EOT 4 /**< Kod znaku końca pliku. */
@@ -22,6 +36,72 @@
 #define FG_TO_BG_OFFSET 10 /**< Różnica międzu numerem koloru tła a tekstu. */
 #define BG_COLOR_1 BLUE_FG + FG_TO_BG_OFFSET /**< Pierwszy kolor tła. */
 #define BG_COLOR_2 CYAN_FG + FG_TO_BG_OFFSET /**< Drugi kolor tła. */
+#define STATUS_SIZE 64 /**< Rozmiar bufora na napis w wierszu stanu. */
+#define FRAME_MS 16 /**< Najkrótszy odstęp między klatkami w ms. */
+#define MS_PER_SECOND 1000 /**< Liczba milisekund w sekundzie. */
+
+/**
+ * Rodzaj gracza.
+ */
+typedef enum {
+    HUMAN, /**< Ruchy wybiera człowiek. */
+    AI_PLAYOUTS, /**< Ruchy wybierają rozgrywki Monte Carlo. */
+    AI_TREE /**< Ruchy wybiera przeszukiwanie drzewa gry. */
+} player_kind_t;
+
+/**
+ * Widoczny fragment planszy.
+ * Pod widocznymi wierszami planszy jest wiersz stanu aktualnego gracza.
+ */
+typedef struct {
+    screen_t screen; /**< Ekran terminala. */
+    viewport_t port; /**< Widoczne pola planszy. */
+    uint64_t busy_count; /**< Liczba pól zajętych przez aktualnego gracza. */
+    uint64_t free_count; /**< Liczba pól, które aktualny gracz może zająć. */
+    bool golden; /**< Czy aktualny gracz może wykonać złoty ruch. */
+    double rate; /**< Liczba iteracji na sekundę ostatniego ruchu komputera
+                  * lub zero. */
+    uint64_t seconds; /**< Czas trwania tury w sekundach. */
+} view_t;
+
+/**
+ * Ruch komputera liczony w osobnym wątku.
+ * Wątek wybiera i wykonuje ruch na kopii gry, więc w tym czasie gra może być
+ * wypisywana, a ruch jest powtarzany na grze po zakończeniu wątku.
+ */
+typedef struct {
+    pthread_t thread; /**< Wątek. */
+    gamma_t *copy; /**< Kopia gry. */
+    player_kind_t kind; /**< Sposób wyboru ruchu. */
+    uint32_t player; /**< Numer gracza. */
+    playout_stat_t move; /**< Wykonany ruch. */
+    double rate; /**< Liczba iteracji na sekundę. */
+    bool done; /**< Czy wątek wykonał ruch. */
+    bool running; /**< Czy wątek został uruchomiony i nie został dołączony. */
+    atomic_bool finished; /**< Czy wątek skończył pracę. */
+    int wake; /**< Eventfd, przez który wątek zgłasza koniec pracy. */
+} ai_t;
+
+/**
+ * Stan trybu interaktywnego.
+ */
+typedef struct {
+    view_t view; /**< Widok planszy. */
+    input_t *in; /**< Wejście z klawiszami. */
+    ai_t ai; /**< Ruch komputera. */
+    player_kind_t *kinds; /**< Rodzaje graczy lub NULL. */
+    int wake; /**< Eventfd budzący pętlę zdarzeń po ruchu komputera i zmianie
+               * rozmiaru terminala lub -1. */
+    uint64_t turn_start; /**< Początek tury w ms. */
+    uint64_t last_frame; /**< Chwila wypisania ostatniej klatki w ms. */
+    bool over; /**< Czy gra się skończyła. */
+} session_t;
+
+/** Czy od ostatniej klatki zmienił się rozmiar terminala. */
+static volatile sig_atomic_t resized = 0;
+
+/** Eventfd budzący pętlę zdarzeń po zmianie rozmiaru terminala lub -1. */
+static int resize_wake = -1;
 
 /** @brief Podaje numer następnego gracza po ACTUAL w grze o LIMIT graczach.
  * @param[in] actual - aktualny numer,
@@ -36,34 +116,118 @@ static uint32_t next(uint32_t actual, uint32_t limit);
  */
 static void enable_raw_mode(struct termios *orig_termios);
 
+/** @brief Podaje bieżący czas.
+ * @return Czas zegara monotonicznego w milisekundach.
+ */
+static uint64_t now_ms(void);
+
 /** @brief Wykonuje akcje gracza.
- * Wykonuję akcję (ruch, złoty ruch lub pominięcie ruchu) lub pozwala na ruch
- * kursorem w trybie interaktywnym gry GAME.
- * @param g - wskaźnik na strukturę przechowującą grę,
- * @return Wartość TRUE jeżeli gracz wykonał akcję, a FALSE w przeciwnym
+ * Wykonuję akcję (ruch, złoty ruch, ruch komputera lub pominięcie ruchu) lub
+ * pozwala na ruch kursorem w trybie interaktywnym gry GAME. Klawisze 'a'
+ * i 't' wykonują jeden ruch komputera za gracza, wybrany rozgrywkami lub
+ * przeszukiwaniem drzewa gry, a 'A' i 'T' oddają komputerowi wszystkie
+ * dalsze ruchy gracza. Gdy komputer liczy ruch, działają tylko ruchy kursorem
+ * i zakończenie gry.
+ * @param g         - wskaźnik na strukturę przechowującą grę,
+ * @param[in,out] s - wskaźnik na stan trybu interaktywnego,
+ * @param[in] key   - kod klawisza,
+ */
+static void player_action(gamma_t *g, session_t *s, int key);
+
+/** @brief Rozpoczyna turę następnego gracza, który ma ruch.
+ * Pomija graczy bez ruchu, a gdy żaden gracz nie ma ruchu, kończy grę.
+ * Za gracza komputerowego zaczyna liczyć ruch.
+ * @param[in,out] g - wskaźnik na strukturę przechowującą grę,
+ * @param[in,out] s - wskaźnik na stan trybu interaktywnego,
+ */
+static void start_turn(gamma_t *g, session_t *s);
+
+/** @brief Kończy turę aktualnego gracza.
+ * @param[in,out] g - wskaźnik na strukturę przechowującą grę,
+ * @param[in,out] s - wskaźnik na stan trybu interaktywnego,
+ */
+static void end_turn(gamma_t *g, session_t *s);
+
+/** @brief Kończy grę na żądanie gracza.
+ * Czeka na zakończenie liczenia ruchu komputera i odrzuca ten ruch.
+ * @param[in,out] g - wskaźnik na strukturę przechowującą grę,
+ * @param[in,out] s - wskaźnik na stan trybu interaktywnego,
+ */
+static void quit(gamma_t *g, session_t *s);
+
+/** @brief Liczy ruch komputera w osobnym wątku.
+ * @param[in,out] arg - wskaźnik na ruch komputera,
+ * @return NULL.
+ */
+static void *ai_thread(void *arg);
+
+/** @brief Zaczyna liczyć ruch komputera za aktualnego gracza w tle.
+ * @param[in,out] g - wskaźnik na strukturę przechowującą grę,
+ * @param[in,out] s - wskaźnik na stan trybu interaktywnego,
+ * @param[in] kind  - sposób wyboru ruchu,
+ * @return Wartość TRUE, jeżeli wątek został uruchomiony, a FALSE, gdy nie
+ * udało się skopiować gry lub utworzyć wątku.
+ */
+static bool start_ai(gamma_t *g, session_t *s, player_kind_t kind);
+
+/** @brief Wykonuje ruch policzony w tle i kończy turę.
+ * @param[in,out] g - wskaźnik na strukturę przechowującą grę,
+ * @param[in,out] s - wskaźnik na stan trybu interaktywnego,
+ */
+static void finish_ai(gamma_t *g, session_t *s);
+
+/** @brief Wykonuje wszystkie całe klawisze z bufora wejścia.
+ * Na końcu wejścia kończy grę.
+ * @param[in,out] g - wskaźnik na strukturę przechowującą grę,
+ * @param[in,out] s - wskaźnik na stan trybu interaktywnego,
+ */
+static void read_keys(gamma_t *g, session_t *s);
+
+/** @brief Podaje czas do najbliższego zdarzenia zegarowego.
+ * Zdarzeniami są kolejna sekunda tury i oczekująca klatka.
+ * @param[in] s - wskaźnik na stan trybu interaktywnego,
+ * @return Czas w milisekundach.
+ */
+static int next_timeout(const session_t *s);
+
+/** @brief Czeka na zdarzenie i je obsługuje.
+ * Zdarzeniami są klawisze, koniec liczenia ruchu komputera, zmiana rozmiaru
+ * terminala i zdarzenia zegarowe. Klatka jest wypisywana najwyżej raz na
+ * @ref FRAME_MS ms, więc szybko wciskane klawisze dają jedną klatkę.
+ * @param[in,out] g - wskaźnik na strukturę przechowującą grę,
+ * @param[in,out] s - wskaźnik na stan trybu interaktywnego,
+ */
+static void wait_events(gamma_t *g, session_t *s);
+
+/** @brief Wykonuje ruch komputera za aktualnego gracza.
+ * Wybiera ruch i przesuwa kursor na pole ruchu. Liczy w wątku wywołującym,
+ * gdy nie udało się uruchomić osobnego wątku.
+ * @param[in,out] g - wskaźnik na strukturę przechowującą grę,
+ * @param[in,out] v - wskaźnik na widok planszy,
+ * @param[in] kind  - sposób wyboru ruchu,
+ * @return Wartość TRUE jeżeli komputer wykonał ruch, a FALSE w przeciwnym
  * przypadku.
  */
-static bool player_action(gamma_t *g);
+static bool ai_action(gamma_t *g, view_t *v, player_kind_t kind);
 
-/** @brief Wykonuje ruch kursorem terminala.
- * Wykonuje ruch kursorem terminala w grze GAME w trybie interaktywnym.
+/** @brief Wykonuje ruch kursorem gry.
+ * Wykonuje ruch kursorem w grze GAME w trybie interaktywnym.
  * Ruch wykonuje na podstawie następego odczytanego znaku z wejścia według
  * ANSI escape codes tj. A-góra, B-dół, C-prawo, D-lewo.
  * @param[in,out] g - wskaźnik na strukturę przechowującą grę,
+ * @param[in,out] v - wskaźnik na widok planszy,
+ * @param[in] c     - znak sekwencji,
  */
-static void move_cursor(gamma_t *g);
-
-/** @brief Podaje maksimum z dwóch liczb: X i Y.
- * @param[in] x - porównywana liczba,
- * @param[in] y - porównywana liczba,
- * @return Większa z liczb X i Y
- */
-static uint32_t max(uint32_t x, uint32_t y);
+static void move_cursor(gamma_t *g, view_t *v, int c);
 
-/** @brief Przywraca zapisane położenie kursora.
- * @param[in] g - wskaźnik na strukturę przechowującą grę,
+/** @brief Przenosi kursor gry na dane pole.
+ * Przewija widok, jeśli pole nie jest widoczne.
+ * @param[in,out] g - wskaźnik na strukturę przechowującą grę,
+ * @param[in,out] v - wskaźnik na widok planszy,
+ * @param[in] x     - odcięta pola,
+ * @param[in] y     - rzędna pola,
  */
-static void restore_cursor(gamma_t *g);
+static void place_cursor(gamma_t *g, view_t *v, uint32_t x, uint32_t y);
 
 /** @brief Podaje numer koloru tła w ANSI escape codes.
  * Podaje numer koloru tła pola (X, Y) w ANSI escape codes, tworząc szachownice.
@@ -82,34 +246,44 @@ static int bg_color(uint32_t x, uint32_t y);
  */
 static int fg_color(uint32_t x, uint32_t y);
 
-/** @brief Podaje liczbę cyfr danej liczby.
- * Podaje liczbę cyfr danej liczby całkowitej w zapisie dziesiętnym.
- * @param[in] n       – liczba,
- * @return Liczba cyfr danej liczby.
+/** @brief Zapamiętuje zmianę rozmiaru terminala.
+ * @param[in] signal - numer sygnału,
  * */
-static uint32_t digit_count(uint32_t n);
-
-/** @brief Sprawdza, czy wydruk planszy i opis zmieści się w terminalu.
- * @param[in] g - wskaźnik na strukturę przechowującą grę,
- * @return Wartość TRUE, jeżeli wydruk planszy i opis zmieści się w terminalu.
- * FALSE w przeciwnym przypadku.
+static void on_resize(int signal);
+
+/** @brief Dopasowuje widok do rozmiaru terminala.
+ * Tworzy ekran wielkości terminala, a widok obejmuje tyle pól planszy, ile
+ * się na nim mieści, zostawiając wiersz na stan gracza. Przy zmianie rozmiaru
+ * terminala stary ekran jest zastępowany nowym dopiero wtedy, gdy udało się
+ * go utworzyć.
+ * @param[in] g     - wskaźnik na strukturę przechowującą grę,
+ * @param[in,out] v - wskaźnik na widok planszy,
+ * @param[in] opened - czy widok ma już ekran,
+ * @return Wartość TRUE, jeżeli udało się odczytać rozmiar terminala
+ * i utworzyć ekran, a FALSE w przeciwnym przypadku.
  * */
-static bool check_terminal_size(gamma_t *g);
+static bool fit_view(gamma_t *g, view_t *v, bool opened);
 
 /** @brief Przywraca poprzednie ustawienia terminala.
- * Przywraca poprzednie ustawienia terminala i pokazuje kursor.
  * @param[in] orig_termios - struktura terminala,
  * */
 static void restore_terminal(struct termios orig_termios);
 
 /** @brief Wypisuje pole szachownicy gry.
- * Wypisuje pole nad którym aktualnie jest kursor gry, uwzględniając wzór
- * szachownicy. Jeżeli HIGHLITED to wypisuje pole w negatywie. Cofa kursor do
- * lewego krańca pola po wypisaniu.
- * @param[in] g           - wskaźnik na strukturę przechowującą grę,
- * @param[in] highlighted - czy ma być wypisane w negatywie,
+ * Wypisuje na ekran pole (X, Y), jeśli jest widoczne, uwzględniając wzór
+ * szachownicy. Pole pod kursorem gry jest wypisywane w negatywie.
+ * @param[in] g     - wskaźnik na strukturę przechowującą grę,
+ * @param[in,out] v - wskaźnik na widok planszy,
+ * @param[in] x     - odcięta pola,
+ * @param[in] y     - rzędna pola,
  * */
-static void print_field(gamma_t *g, bool highlighted);
+static void print_field(gamma_t *g, view_t *v, uint32_t x, uint32_t y);
+
+/** @brief Wypisuje wiersz stanu aktualnego gracza.
+ * @param[in] g     - wskaźnik na strukturę przechowującą grę,
+ * @param[in,out] v - wskaźnik na widok planszy,
+ * */
+static void print_status(gamma_t *g, view_t *v);
 
 /** @brief Wypisuje podsumowanie gry.
  * Wypisuje podsumowanie: dla każdego gracza ile pól zajął.
@@ -117,11 +291,19 @@ static void print_field(gamma_t *g, bool highlighted);
  * */
 static void print_scoreboard(gamma_t *g);
 
-/** @brief Wypisuje startową planszę gry.
- * Wypisuje startową planszę gry w formie szachownicy.
- * @param[in] g - wskaźnik na strukturę przechowującą grę,
+/** @brief Wypisuje widoczny fragment planszy.
+ * Wypisuje na ekran widoczne pola w formie szachownicy i wiersz stanu.
+ * @param[in] g     - wskaźnik na strukturę przechowującą grę,
+ * @param[in,out] v - wskaźnik na widok planszy,
  * */
-static void print_initial_board(gamma_t *g);
+static void print_view(gamma_t *g, view_t *v);
+
+/** @brief Wypisuje klatkę.
+ * Najpierw dopasowuje widok do terminala, jeśli zmienił się jego rozmiar.
+ * @param[in] g     - wskaźnik na strukturę przechowującą grę,
+ * @param[in,out] v - wskaźnik na widok planszy,
+ * */
+static void show_frame(gamma_t *g, view_t *v);
 
 static void enable_raw_mode(struct termios *orig_termios) {
     tcgetattr(STDIN_FILENO, orig_termios);
@@ -129,29 +311,10 @@ static void enable_raw_mode(struct termios *orig_termios) {
     raw.c_lflag &= ~ECHO;
     raw.c_lflag &= ~ICANON;
     tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw);
-    printf("%c[?25l", ESC);
 }
 
-static void restore_cursor(gamma_t *g) {
-    printf("%c[%d;%dH", ESC, g->height - g->y, g->x * g->frame + 1);
-}
-
-
 static void restore_terminal(struct termios orig_termios) {
     tcsetattr(STDIN_FILENO, TCSAFLUSH, &orig_termios);
-    printf("%c[?25h", ESC);
-}
-
-static uint32_t digit_count(uint32_t n) {
-    if (n == 0) {
-        return 1;
-    }
-    int digits = 0;
-    while (n != 0) {
-        n /= DECIMAL_BASE;
-        ++digits;
-    }
-    return digits;
 }
 
 static int bg_color(uint32_t x, uint32_t y) {
@@ -162,32 +325,104 @@ static int bg_color(uint32_t x, uint32_t y) {
     }
 }
 
-static bool check_terminal_size(gamma_t *g) {
+static void on_resize(int signal) {
+    (void) signal;
+    resized = 1;
+    if (resize_wake != -1) {
+        ring_kick(resize_wake);
+    }
+}
+
+static bool fit_view(gamma_t *g, view_t *v, bool opened) {
     struct winsize w;
-    ioctl(0, TIOCGWINSZ, &w);
-    return (w.ws_col >= max(g->frame * g->width,
-                            11 + g->frame +
-                            2 * digit_count(g->width * g->height))) &&
-           (w.ws_row >= g->height + g->player_count);
+    if (ioctl(STDIN_FILENO, TIOCGWINSZ, &w) == -1 || w.ws_row == 0 ||
+        w.ws_col == 0) {
+        return false;
+    }
+    screen_t s;
+    if (!screen_init(&s, STDOUT_FILENO, w.ws_row, w.ws_col)) {
+        return false;
+    }
+    if (opened) {
+        screen_free(&v->screen);
+    }
+    v->screen = s;
+    interactive_fit(g, &v->port, w.ws_row, w.ws_col);
+    print_view(g, v);
+    return true;
 }
 
-static void print_field(gamma_t *g, bool highlighted) {
-    uint32_t owner = get_owner(g, g->x, g->y);
-    if (highlighted) {
-        printf("%c[%d;%dm", ESC, BLACK_FG, WHITE_FG + FG_TO_BG_OFFSET);
-    } else {
-        printf("%c[%d;%dm", ESC, fg_color(g->x, g->y),
-               bg_color(g->x, g->y));
+void interactive_fit(const gamma_t *g, viewport_t *p, uint32_t rows,
+                     uint32_t cols) {
+    /* Nawet w bardzo małym terminalu widać co najmniej pole pod kursorem. */
+    p->rows = rows > 1 ? rows - 1 : 1;
+    p->rows = p->rows < g->height ? p->rows : g->height;
+    p->fields = cols >= g->frame ? cols / g->frame : 1;
+    p->fields = p->fields < g->width ? p->fields : g->width;
+    p->left = p->left + p->fields <= g->width ? p->left
+                                              : g->width - p->fields;
+    p->top = p->top + p->rows <= g->height ? p->top : g->height - p->rows;
+    interactive_scroll(g, p);
+}
+
+bool interactive_scroll(const gamma_t *g, viewport_t *p) {
+    uint32_t row = g->height - 1 - g->y;
+    uint32_t left = p->left;
+    uint32_t top = p->top;
+    if (g->x < p->left) {
+        p->left = g->x;
+    } else if (g->x >= p->left + p->fields) {
+        p->left = g->x - p->fields + 1;
+    }
+    if (row < p->top) {
+        p->top = row;
+    } else if (row >= p->top + p->rows) {
+        p->top = row - p->rows + 1;
+    }
+    return p->left != left || p->top != top;
+}
+
+static void print_field(gamma_t *g, view_t *v, uint32_t x, uint32_t y) {
+    const viewport_t *p = &v->port;
+    uint32_t row = g->height - 1 - y;
+    if (x < p->left || x >= p->left + p->fields || row < p->top ||
+        row >= p->top + p->rows) {
+        return;
     }
+    bool highlighted = x == g->x && y == g->y;
+    uint32_t owner = get_owner(g, x, y);
+    int fg = highlighted ? BLACK_FG : fg_color(x, y);
+    int bg = highlighted ? WHITE_FG + FG_TO_BG_OFFSET : bg_color(x, y);
+    char label[DECIMAL_BASE + 2];
     if (owner == 0) {
-        printf("%-*c", g->frame, '.');
+        snprintf(label, sizeof(label), "%-*c", g->frame, '.');
     } else {
-        printf("%-*d", g->frame, owner);
+        snprintf(label, sizeof(label), "%-*u", g->frame, owner);
     }
-    printf("%c[0m", ESC);
-    for (uint32_t i = 0; i < g->frame; ++i) {
-        printf("%c[D", ESC);
+    screen_text(&v->screen, row - p->top, (x - p->left) * g->frame, label,
+                fg, bg);
+}
+
+static void print_status(gamma_t *g, view_t *v) {
+    char text[STATUS_SIZE];
+    screen_t *s = &v->screen;
+    uint32_t row = v->port.rows;
+    snprintf(text, sizeof(text), "PLAYER %u %lu %lu", g->player,
+             v->busy_count, v->free_count);
+    uint32_t col = screen_text(s, row, 0, text, SCREEN_DEFAULT,
+                               SCREEN_DEFAULT);
+    if (v->golden) {
+        col = screen_text(s, row, col, " G", YELLOW_FG,
+                          BLACK_FG + FG_TO_BG_OFFSET);
     }
+    if (v->rate > 0) {
+        snprintf(text, sizeof(text), " AI %.0f/s", v->rate);
+        col = screen_text(s, row, col, text, SCREEN_DEFAULT, SCREEN_DEFAULT);
+    }
+    snprintf(text, sizeof(text), " %lu:%02lu", v->seconds / 60,
+             v->seconds % 60);
+    col = screen_text(s, row, col, text, SCREEN_DEFAULT, SCREEN_DEFAULT);
+    screen_clear(s, row, col);
 }
 
 static int fg_color(uint32_t x, uint32_t y) {
@@ -198,14 +433,6 @@ static int fg_color(uint32_t x, uint32_t y) {
     }
 }
 
-static uint32_t max(uint32_t x, uint32_t y) {
-    if (x > y) {
-        return x;
-    } else {
-        return y;
-    }
-}
-
 static void print_scoreboard(gamma_t *g) {
     int fg_color = WHITE_FG;
     int bg_color = BLACK_FG + FG_TO_BG_OFFSET;
@@ -219,130 +446,373 @@ static void print_scoreboard(gamma_t *g) {
     }
 }
 
-static void print_initial_board(gamma_t *g) {
-    for (uint32_t i = 0; i < g->height; ++i) {
-        for (uint32_t j = 0; j < g->width; ++j) {
-            printf("%c[%d;%dm", ESC, fg_color(j, i), bg_color(j, i));
-            printf(".");
-            for (uint32_t k = 0; k < g->frame - 1; ++k) {
-                printf(" ");
+static void print_view(gamma_t *g, view_t *v) {
+    const viewport_t *p = &v->port;
+    for (uint32_t i = 0; i < p->rows; ++i) {
+        uint32_t y = g->height - 1 - (p->top + i);
+        for (uint32_t j = 0; j < p->fields; ++j) {
+            print_field(g, v, p->left + j, y);
+        }
+        /* Przy ułamkowym polu na końcu wiersza zostaje pusta reszta. */
+        screen_clear(&v->screen, i, p->fields * g->frame);
+    }
+    print_status(g, v);
+}
+
+
+static void show_frame(gamma_t *g, view_t *v) {
+    if (resized) {
+        resized = 0;
+        fit_view(g, v, true);
+    }
+    screen_flush(&v->screen);
+}
+
+static uint64_t now_ms(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * MS_PER_SECOND +
+           (uint64_t) now.tv_nsec / 1000000;
+}
+
+int interactive_key(input_t *in) {
+    while (in->start < in->end) {
+        const char *data = in->data + in->start;
+        size_t size = in->end - in->start;
+        if (data[0] != ESC) {
+            ++in->start;
+            in->scan = in->start;
+            return (unsigned char) data[0];
+        }
+        if (size < 2 || (data[1] == '[' && size < 3)) {
+            if (in->eof) {
+                in->start = in->end;
+                in->scan = in->start;
             }
-            printf("%c[0m", ESC);
+            return KEY_NONE;
+        }
+        in->start += data[1] == '[' ? 3 : 2;
+        in->scan = in->start;
+        if (data[1] == '[') {
+            return KEY_CSI + (unsigned char) data[2];
         }
-        printf("%c[F", ESC);
     }
+    return KEY_NONE;
 }
 
-void interactive_mode(gamma_t *g) {
-    if (!check_terminal_size(g)) {
-        printf("Niewystarczający rozmiar terminala.\n");
+void interactive_mode(gamma_t *g, input_t *in) {
+    /* Ekran pisze wprost do deskryptora, więc printf musi być przed nim. */
+    fflush(stdout);
+    session_t s;
+    s.view.port.left = 0;
+    s.view.port.top = 0;
+    s.view.busy_count = 0;
+    s.view.free_count = 0;
+    s.view.golden = false;
+    s.view.rate = 0;
+    s.view.seconds = 0;
+    if (!fit_view(g, &s.view, false)) {
+        printf("Nie można odczytać rozmiaru terminala.\n");
         return;
     }
+    s.in = in;
+    s.ai.running = false;
+    s.turn_start = now_ms();
+    s.last_frame = 0;
+    s.over = false;
+    /* Bez eventfd ruchy komputera są liczone w wątku wywołującym. */
+    s.wake = eventfd(0, 0);
+    resize_wake = s.wake;
+    struct sigaction resize, previous;
+    resize.sa_handler = on_resize;
+    sigemptyset(&resize.sa_mask);
+    resize.sa_flags = 0;
+    sigaction(SIGWINCH, &resize, &previous);
     struct termios orig_termios; /* Domyślny terminal. */
     enable_raw_mode(&orig_termios);
-    printf("%c[2J", ESC);
-    printf("%c[;H", ESC);
-    restore_cursor(g);
-    print_initial_board(g);
-    restore_cursor(g);
-    printf("%c[%d;%dm", ESC, BLACK_FG, WHITE_FG + FG_TO_BG_OFFSET);
-    printf(".");
-    for (uint32_t k = 0; k < g->frame - 1; ++k) {
-        printf(" ");
-    }
-    printf("%c[0m", ESC);
-    while (g->counter < g->player_count) {
-        uint64_t busy_count = gamma_busy_fields(g, g->player);
-        uint64_t free_count = gamma_free_fields(g, g->player);
-        bool golden_possible = gamma_golden_possible(g, g->player);
+    /* Bez pamięci na tę tablicę gra toczy się tylko między ludźmi. */
+    s.kinds = calloc(g->player_count + 1, sizeof(player_kind_t));
+    start_turn(g, &s);
+    /* Klawisze mogły zostać wczytane razem z poleceniem rozpoczęcia gry. */
+    read_keys(g, &s);
+    while (!s.over) {
+        wait_events(g, &s);
+    }
+    free(s.kinds);
+    screen_clear(&s.view.screen, s.view.port.rows, 0);
+    screen_leave(&s.view.screen, s.view.port.rows);
+    screen_free(&s.view.screen);
+    restore_terminal(orig_termios);
+    sigaction(SIGWINCH, &previous, NULL);
+    resize_wake = -1;
+    if (s.wake != -1) {
+        close(s.wake);
+    }
+    print_scoreboard(g);
+}
 
-        if (!golden_possible && !free_count) {
+static uint32_t next(uint32_t actual, uint32_t limit) {
+    if (actual == limit) {
+        return 1;
+    }
+    return actual + 1;
+}
+
+static void start_turn(gamma_t *g, session_t *s) {
+    view_t *v = &s->view;
+    while (g->counter < g->player_count) {
+        if (!gamma_can_move(g, g->player)) {
             g->player = next(g->player, g->player_count);
             ++(g->counter);
             continue;
-        } else {
-            g->counter = 0;
         }
-        printf("%c[%dE", ESC, g->y + 1);
-        printf("%c[2K", ESC);
-        printf("PLAYER %d %lu %lu", g->player, busy_count, free_count);
-        if (golden_possible) {
-            printf("%c[%d;%dm", ESC, YELLOW_FG,
-                   BLACK_FG + FG_TO_BG_OFFSET);
-            printf(" G");
-            printf("%c[0m", ESC);
+        g->counter = 0;
+        v->busy_count = gamma_busy_fields(g, g->player);
+        v->free_count = gamma_free_fields(g, g->player);
+        v->golden = gamma_golden_possible(g, g->player);
+        v->seconds = 0;
+        s->turn_start = now_ms();
+        print_status(g, v);
+        player_kind_t kind = s->kinds != NULL ? s->kinds[g->player] : HUMAN;
+        if (kind == HUMAN || start_ai(g, s, kind)) {
+            return;
         }
-        restore_cursor(g);
-        while (!player_action(g));
+        ai_action(g, v, kind);
         g->player = next(g->player, g->player_count);
     }
-    printf("%c[%dE", ESC, g->y + 1);
-    printf("%c[2K", ESC);
-    restore_terminal(orig_termios);
-    print_scoreboard(g);
+    s->over = true;
 }
 
-static uint32_t next(uint32_t actual, uint32_t limit) {
-    if (actual == limit) {
-        return 1;
+static void end_turn(gamma_t *g, session_t *s) {
+    g->player = next(g->player, g->player_count);
+    start_turn(g, s);
+}
+
+static void quit(gamma_t *g, session_t *s) {
+    if (s->ai.running) {
+        pthread_join(s->ai.thread, NULL);
+        gamma_delete(s->ai.copy);
+        s->ai.running = false;
     }
-    return actual + 1;
+    g->counter = g->player_count;
+    s->over = true;
 }
 
-static bool player_action(gamma_t *g) {
-    int c = getchar();
-    switch (c) {
-        case ESC:
-            if (getchar() != '[') {
-                break;
-            }
-            move_cursor(g);
-            break;
+static void *ai_thread(void *arg) {
+    ai_t *ai = arg;
+    if (ai->kind == AI_TREE) {
+        mcts_config_t config;
+        mcts_defaults(&config);
+        ai->done = mcts_move(ai->copy, ai->player, &config, &ai->move,
+                             &ai->rate);
+    } else {
+        playout_config_t config;
+        playout_defaults(&config);
+        ai->done = playout_move(ai->copy, ai->player, &config, &ai->move,
+                                &ai->rate);
+    }
+    atomic_store(&ai->finished, true);
+    ring_kick(ai->wake);
+    return NULL;
+}
+
+static bool start_ai(gamma_t *g, session_t *s, player_kind_t kind) {
+    ai_t *ai = &s->ai;
+    if (s->wake == -1 || (ai->copy = gamma_fork(g)) == NULL) {
+        return false;
+    }
+    ai->kind = kind;
+    ai->player = g->player;
+    ai->rate = s->view.rate;
+    ai->done = false;
+    ai->wake = s->wake;
+    atomic_init(&ai->finished, false);
+    if (pthread_create(&ai->thread, NULL, ai_thread, ai) != 0) {
+        gamma_delete(ai->copy);
+        return false;
+    }
+    ai->running = true;
+    return true;
+}
+
+static void finish_ai(gamma_t *g, session_t *s) {
+    ai_t *ai = &s->ai;
+    pthread_join(ai->thread, NULL);
+    gamma_delete(ai->copy);
+    ai->running = false;
+    s->view.rate = ai->rate;
+    if (ai->done) {
+        uint32_t x = ai->move.field.x;
+        uint32_t y = ai->move.field.y;
+        if (ai->move.golden) {
+            gamma_golden_move(g, ai->player, x, y);
+        } else {
+            gamma_move(g, ai->player, x, y);
+        }
+        place_cursor(g, &s->view, x, y);
+    }
+    end_turn(g, s);
+}
+
+static void read_keys(gamma_t *g, session_t *s) {
+    int key;
+    while (!s->over && (key = interactive_key(s->in)) != KEY_NONE) {
+        player_action(g, s, key);
+    }
+    if (!s->over && s->in->eof && s->in->start == s->in->end) {
+        quit(g, s);
+    }
+}
+
+static int next_timeout(const session_t *s) {
+    uint64_t now = now_ms();
+    uint64_t due = s->turn_start + (s->view.seconds + 1) * MS_PER_SECOND;
+    if (resized || screen_dirty(&s->view.screen)) {
+        uint64_t frame = s->last_frame + FRAME_MS;
+        due = frame < due ? frame : due;
+    }
+    return due > now ? (int) (due - now) : 0;
+}
+
+static void wait_events(gamma_t *g, session_t *s) {
+    struct pollfd fds[2];
+    nfds_t count = 0;
+    if (s->wake != -1) {
+        fds[count].fd = s->wake;
+        fds[count].events = POLLIN;
+        ++count;
+    }
+    bool reading = !s->in->eof;
+    if (reading) {
+        fds[count].fd = s->in->fd;
+        fds[count].events = POLLIN;
+        ++count;
+    }
+    /* Zmiana rozmiaru terminala może też przerwać czekanie sygnałem. */
+    int ready = poll(fds, count, next_timeout(s));
+    if (ready > 0 && s->wake != -1 && fds[0].revents != 0) {
+        /* Zdarzenia są w flagach, a licznik jest tylko zerowany. */
+        ring_wait(s->wake);
+    }
+    if (s->ai.running && atomic_load(&s->ai.finished)) {
+        finish_ai(g, s);
+    }
+    if (ready > 0 && reading && fds[count - 1].revents != 0) {
+        input_fill(s->in);
+    }
+    read_keys(g, s);
+    if (s->over) {
+        return;
+    }
+    view_t *v = &s->view;
+    uint64_t now = now_ms();
+    uint64_t seconds = (now - s->turn_start) / MS_PER_SECOND;
+    if (seconds != v->seconds) {
+        v->seconds = seconds;
+        print_status(g, v);
+    }
+    if ((resized || screen_dirty(&v->screen)) &&
+        now - s->last_frame >= FRAME_MS) {
+        show_frame(g, v);
+        s->last_frame = now;
+    }
+}
+
+static bool ai_action(gamma_t *g, view_t *v, player_kind_t kind) {
+    playout_stat_t move;
+    bool done;
+    if (kind == AI_TREE) {
+        mcts_config_t config;
+        mcts_defaults(&config);
+        done = mcts_move(g, g->player, &config, &move, &v->rate);
+    } else {
+        playout_config_t config;
+        playout_defaults(&config);
+        done = playout_move(g, g->player, &config, &move, &v->rate);
+    }
+    if (!done) {
+        return false;
+    }
+    place_cursor(g, v, move.field.x, move.field.y);
+    return true;
+}
+
+static void player_action(gamma_t *g, session_t *s, int key) {
+    view_t *v = &s->view;
+    if (key >= KEY_CSI) {
+        move_cursor(g, v, key - KEY_CSI);
+        return;
+    }
+    if (key == EOT) {
+        quit(g, s);
+        return;
+    }
+    if (s->ai.running) {
+        return;
+    }
+    switch (key) {
         case ' ':
             if (gamma_move(g, g->player, g->x, g->y)) {
-                print_field(g, true);
-                return true;
+                print_field(g, v, g->x, g->y);
+                end_turn(g, s);
             }
             break;
         case 'g':
         case 'G':
             if (gamma_golden_move(g, g->player, g->x, g->y)) {
-                print_field(g, true);
-                return true;
+                print_field(g, v, g->x, g->y);
+                end_turn(g, s);
             }
             break;
+        case 'A':
+        case 'T':
+            if (s->kinds != NULL) {
+                s->kinds[g->player] = key == 'A' ? AI_PLAYOUTS : AI_TREE;
+            }
+            /* FALLTHROUGH */
+        case 'a':
+        case 't': {
+            player_kind_t kind = key == 'a' || key == 'A' ? AI_PLAYOUTS
+                                                          : AI_TREE;
+            if (!start_ai(g, s, kind)) {
+                ai_action(g, v, kind);
+                end_turn(g, s);
+            }
+            break;
+        }
         case 'c':
         case 'C':
-            return true;
-        case EOT:
-            g->counter = g->player_count;
-            return true;
+            end_turn(g, s);
+            break;
         default:
             break;
     }
-    return false;
 }
 
-static void move_cursor(gamma_t *g) {
-    int c = getchar();
-    print_field(g, false);
-    if (c == 'A' && g->y < g->height - 1) {
-        printf("%c[%c", ESC, c);
-        ++(g->y);
-    } else if (c == 'B' && g->y > 0) {
-        printf("%c[%c", ESC, c);
-        --(g->y);
-    } else if (c == 'C' && g->x < g->width - 1) {
-        for (uint32_t i = 0; i < g->frame; ++i) {
-            printf("%c[%c", ESC, c);
-        }
-        ++(g->x);
-    } else if (c == 'D' && g->x > 0) {
-        for (uint32_t i = 0; i < g->frame; ++i) {
-            printf("%c[%c", ESC, c);
-        }
-        --(g->x);
+static void move_cursor(gamma_t *g, view_t *v, int c) {
+    uint32_t x = g->x;
+    uint32_t y = g->y;
+    if (c == 'A' && y < g->height - 1) {
+        ++y;
+    } else if (c == 'B' && y > 0) {
+        --y;
+    } else if (c == 'C' && x < g->width - 1) {
+        ++x;
+    } else if (c == 'D' && x > 0) {
+        --x;
     }
-    print_field(g, true);
+    place_cursor(g, v, x, y);
 }
 
+static void place_cursor(gamma_t *g, view_t *v, uint32_t x, uint32_t y) {
+    uint32_t old_x = g->x;
+    uint32_t old_y = g->y;
+    g->x = x;
+    g->y = y;
+    if (interactive_scroll(g, &v->port)) {
+        print_view(g, v);
+    } else {
+        print_field(g, v, old_x, old_y);
+        print_field(g, v, x, y);
+    }
+}
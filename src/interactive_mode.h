@@ -5,14 +5,66 @@
  */
 
 #include <termios.h>
+#include "gamma.h"
+#include "input.h"
 
 #ifndef GAMMA_INTERACTIVE_MODE_H
 #define GAMMA_INTERACTIVE_MODE_H
 
+#define KEY_NONE (-1) /**< Brak całego klawisza w buforze wejścia. */
+#define KEY_CSI 256 /**< Przesunięcie kodów sekwencji ESC [ znak, np.
+                     * strzałek. */
+
+/**
+ * Widoczne pola planszy.
+ */
+typedef struct {
+    uint32_t left; /**< Odcięta pierwszego widocznego pola. */
+    uint32_t top; /**< Numer pierwszego widocznego wiersza, licząc od góry
+                   * planszy. */
+    uint32_t fields; /**< Liczba widocznych pól w wierszu. */
+    uint32_t rows; /**< Liczba widocznych wierszy planszy. */
+} viewport_t;
+
+/** @brief Dopasowuje widoczne pola do rozmiaru terminala.
+ * Widać tyle pól planszy, ile mieści się w terminalu, z wierszem na stan
+ * gracza, ale zawsze co najmniej pole pod kursorem gry. Widoczne pola są
+ * przesuwane tak, aby nie wychodziły poza planszę i obejmowały pole pod
+ * kursorem.
+ * @param[in] g     - wskaźnik na strukturę przechowującą grę,
+ * @param[in,out] p - wskaźnik na widoczne pola,
+ * @param[in] rows  - liczba wierszy terminala, liczba dodatnia,
+ * @param[in] cols  - liczba kolumn terminala, liczba dodatnia.
+ */
+void interactive_fit(const gamma_t *g, viewport_t *p, uint32_t rows,
+                     uint32_t cols);
+
+/** @brief Przewija widoczne pola tak, aby było widać pole pod kursorem gry.
+ * @param[in] g     - wskaźnik na strukturę przechowującą grę,
+ * @param[in,out] p - wskaźnik na widoczne pola,
+ * @return Wartość TRUE, jeżeli widok został przewinięty, a FALSE
+ * w przeciwnym przypadku.
+ */
+bool interactive_scroll(const gamma_t *g, viewport_t *p);
+
+/** @brief Podaje następny klawisz z bufora wejścia.
+ * Sekwencja ESC [ znak daje kod @ref KEY_CSI powiększony o znak, a ESC
+ * z innym znakiem jest pomijane. Niepełna sekwencja czeka w buforze na
+ * dalsze znaki, a na końcu pliku jest pomijana.
+ * @param[in,out] in - wskaźnik na wejście,
+ * @return Kod klawisza lub @ref KEY_NONE, gdy w buforze nie ma całego
+ * klawisza.
+ */
+int interactive_key(input_t *in);
+
 /** @brief Rozpoczyna interaktywny tryb wejścia.
- * Rozpoczyna interaktywny tryb wejścia dla gry G.
- * @param[in,out] g - wskaźnik na strukturę przechowującą grę,
+ * Rozpoczyna interaktywny tryb wejścia dla gry G. Pętla zdarzeń czeka
+ * jednocześnie na klawisze, na ruch komputera liczony w osobnym wątku, na
+ * zmianę rozmiaru terminala i na zegar tury, więc w czasie liczenia ruchu
+ * można przesuwać kursor, a plansza jest odświeżana.
+ * @param[in,out] g  - wskaźnik na strukturę przechowującą grę,
+ * @param[in,out] in - wskaźnik na wejście, z którego są czytane klawisze,
  */
-void interactive_mode(gamma_t *g);
+void interactive_mode(gamma_t *g, input_t *in);
 
 #endif //GAMMA_INTERACTIVE_MODE_H
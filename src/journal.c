@@ -0,0 +1,99 @@
+/** @file
+ * Implementacja dziennika ruchów pozwalającego cofać i powtarzać ruchy.
+ *
+ * @author Marcin Malejky
+ */
+
+#include <stdlib.h>
+#include "journal.h"
+
+#define INITIAL_CAPACITY 64 /**< Początkowa pojemność tablic dziennika. */
+
+/** @brief Zapewnia miejsce na kolejny element tablicy.
+ * @param[in,out] array    – wskaźnik na tablicę,
+ * @param[in,out] capacity – wskaźnik na pojemność tablicy,
+ * @param[in] length       – liczba elementów tablicy,
+ * @param[in] size         – rozmiar elementu w bajtach,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy nie udało się
+ * zaalokować pamięci.
+ */
+static bool grow(void **array, uint64_t *capacity, uint64_t length,
+                 size_t size);
+
+static bool grow(void **array, uint64_t *capacity, uint64_t length,
+                 size_t size) {
+    if (length < *capacity) {
+        return true;
+    }
+    uint64_t new_capacity = *capacity ? 2 * *capacity : INITIAL_CAPACITY;
+    if (new_capacity > SIZE_MAX / size) {
+        return false;
+    }
+    void *new_array = realloc(*array, size * new_capacity);
+    if (!new_array) {
+        return false;
+    }
+    *array = new_array;
+    *capacity = new_capacity;
+    return true;
+}
+
+void journal_init(journal_t *j) {
+    j->entries = NULL;
+    j->length = 0;
+    j->capacity = 0;
+    j->moves = NULL;
+    j->done = 0;
+    j->total = 0;
+    j->move_capacity = 0;
+    j->enabled = false;
+    j->lost = false;
+}
+
+void journal_free(journal_t *j) {
+    free(j->entries);
+    free(j->moves);
+    journal_init(j);
+}
+
+void journal_clear(journal_t *j) {
+    j->length = 0;
+    j->done = 0;
+    j->total = 0;
+    j->lost = false;
+}
+
+void journal_begin(journal_t *j, uint32_t player, uint32_t field,
+                   bool golden) {
+    if (!j->enabled) {
+        return;
+    }
+    if (!grow((void **) &j->moves, &j->move_capacity, j->done,
+              sizeof(journal_move_t))) {
+        j->lost = true;
+        return;
+    }
+    journal_move_t move = {j->length, player, field, golden};
+    j->moves[(j->done)++] = move;
+    j->total = j->done;
+}
+
+void journal_log(journal_t *j, journal_kind_t kind, uint32_t index,
+                 uint64_t old) {
+    if (!j->enabled || j->lost) {
+        return;
+    }
+    if (!grow((void **) &j->entries, &j->capacity, j->length,
+              sizeof(journal_entry_t))) {
+        j->lost = true;
+        return;
+    }
+    journal_entry_t entry = {old, index, kind};
+    j->entries[(j->length)++] = entry;
+}
+
+void journal_end(journal_t *j) {
+    if (j->lost) {
+        journal_clear(j);
+    }
+}
@@ -0,0 +1,112 @@
+/** @file
+ * Interfejs dziennika ruchów pozwalającego cofać i powtarzać ruchy.
+ *
+ * @author Marcin Malejky
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef GAMMA_JOURNAL_H
+#define GAMMA_JOURNAL_H
+
+/**
+ * Rodzaj zmienionej wartości.
+ */
+typedef enum {
+    JOURNAL_OWNER, /**< Posiadacz pola o numerze @p index. */
+    JOURNAL_AREA_ID, /**< Węzeł obszaru pola o numerze @p index. */
+    JOURNAL_PARENT, /**< Rodzic węzła lasu obszarów o numerze @p index. */
+    JOURNAL_SIZE, /**< Rozmiar zbioru węzła o numerze @p index. */
+    JOURNAL_NODES, /**< Liczba utworzonych węzłów lasu obszarów. */
+    JOURNAL_AREA_COUNT, /**< Liczba obszarów gracza @p index. */
+    JOURNAL_OCCUPIED, /**< Liczba pól gracza @p index. */
+    JOURNAL_FRONTIER, /**< Liczba wolnych pól obok pól gracza @p index. */
+    JOURNAL_GOLDEN, /**< Czy gracz @p index wykonał złoty ruch. */
+    JOURNAL_FREE, /**< Liczba wolnych pól planszy. */
+    JOURNAL_HASH, /**< Skrót pozycji. */
+    JOURNAL_TURN /**< Gracz na ruchu. */
+} journal_kind_t;
+
+/**
+ * Poprzednia wartość zmienionej części stanu gry.
+ */
+typedef struct {
+    uint64_t old; /**< Wartość sprzed zmiany. */
+    uint32_t index; /**< Numer pola, węzła lub gracza. */
+    uint32_t kind; /**< Rodzaj wartości, jeden z @ref journal_kind_t. */
+} journal_entry_t;
+
+/**
+ * Wykonany ruch.
+ */
+typedef struct {
+    uint64_t first; /**< Numer pierwszego wpisu zmian ruchu. */
+    uint32_t player; /**< Numer gracza. */
+    uint32_t field; /**< Numer pola. */
+    bool golden; /**< Czy ruch był złotym ruchem. */
+} journal_move_t;
+
+/**
+ * Dziennik ruchów.
+ * Dla każdego ruchu zapisuje tylko wartości zmienione przez ten ruch, więc
+ * cofnięcie ruchu kosztuje tyle, ile jego wykonanie. Ruchy cofnięte zostają
+ * w dzienniku, dopóki nie zostanie wykonany inny ruch.
+ */
+typedef struct {
+    journal_entry_t *entries; /**< Tablica wpisów zmian. */
+    uint64_t length; /**< Liczba wpisów zmian. */
+    uint64_t capacity; /**< Pojemność tablicy wpisów. */
+    journal_move_t *moves; /**< Tablica ruchów. */
+    uint64_t done; /**< Liczba wykonanych i niecofniętych ruchów. */
+    uint64_t total; /**< Liczba ruchów razem z cofniętymi. */
+    uint64_t move_capacity; /**< Pojemność tablicy ruchów. */
+    bool enabled; /**< Czy dziennik zapisuje zmiany. */
+    bool lost; /**< Czy nie udało się zapisać zmiany bieżącego ruchu. */
+} journal_t;
+
+/** @brief Inicjalizuje pusty, wyłączony dziennik.
+ * @param[out] j – wskaźnik na dziennik.
+ */
+void journal_init(journal_t *j);
+
+/** @brief Zwalnia pamięć dziennika.
+ * @param[in,out] j – wskaźnik na dziennik.
+ */
+void journal_free(journal_t *j);
+
+/** @brief Usuwa wszystkie ruchy z dziennika.
+ * @param[in,out] j – wskaźnik na dziennik.
+ */
+void journal_clear(journal_t *j);
+
+/** @brief Rozpoczyna zapisywanie ruchu.
+ * Ruch zastępuje wszystkie cofnięte ruchy. Jeśli nie uda się zaalokować
+ * pamięci, oznacza ruch jako niezapisany.
+ * @param[in,out] j  – wskaźnik na dziennik,
+ * @param[in] player – numer gracza,
+ * @param[in] field  – numer pola,
+ * @param[in] golden – czy ruch jest złotym ruchem.
+ */
+void journal_begin(journal_t *j, uint32_t player, uint32_t field,
+                   bool golden);
+
+/** @brief Zapisuje poprzednią wartość zmienianej części stanu gry.
+ * Nic nie robi, jeśli dziennik jest wyłączony. Jeśli nie uda się
+ * zaalokować pamięci, oznacza ruch jako niezapisany.
+ * @param[in,out] j – wskaźnik na dziennik,
+ * @param[in] kind  – rodzaj wartości,
+ * @param[in] index – numer pola, węzła lub gracza,
+ * @param[in] old   – wartość sprzed zmiany.
+ */
+void journal_log(journal_t *j, journal_kind_t kind, uint32_t index,
+                 uint64_t old);
+
+/** @brief Kończy zapisywanie ruchu.
+ * Jeśli nie udało się zapisać wszystkich zmian ruchu, usuwa cały dziennik,
+ * bo wcześniejszych ruchów nie da się już cofnąć.
+ * @param[in,out] j – wskaźnik na dziennik.
+ */
+void journal_end(journal_t *j);
+
+#endif //GAMMA_JOURNAL_H
@@ -0,0 +1,660 @@
+/** @file
+ * Implementacja przeszukiwania drzewa gry metodą Monte Carlo (UCT).
+ *
+ * @author Marcin Malejky
+ */
+
+#define _POSIX_C_SOURCE 200809L /**< Dostęp do sysconf. */
+
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "gamma.h"
+#include "mcts.h"
+#include "pool.h"
+#include "zobrist.h"
+
+#define MCTS_DEFAULT_BUDGET 1000 /**< Domyślny czas przeszukiwania w ms. */
+#define MCTS_EXPLORATION 1.4 /**< Domyślna stała eksploracji. */
+#define MCTS_MAX_THREADS 64 /**< Największa liczba wątków. */
+#define MCTS_EDGES 64 /**< Liczba krawędzi tworzonych przy rozwinięciu. */
+#define MCTS_MAX_NODES (UINT32_C(1) << 20) /**< Limit węzłów wątku. */
+#define MCTS_MAX_EDGES (UINT32_C(1) << 22) /**< Limit krawędzi wątku. */
+#define MCTS_TABLE_MIN 1024 /**< Początkowa pojemność tablicy węzłów. */
+#define MCTS_NONE UINT32_MAX /**< Brak węzła. */
+#define MCTS_TURN 4 /**< Rodzaj klucza skrótu gracza na ruchu w drzewie,
+                      * który pomija graczy bez ruchu. */
+#define NOBODY 0 /**< Domyślny posiadacz pustego pola. */
+
+/**
+ * Etap dokładania krawędzi węzła.
+ */
+typedef enum {
+    WIDEN_MOVES, /**< Wyliczanie zwykłych ruchów. */
+    WIDEN_GOLDEN, /**< Wyliczanie złotych ruchów. */
+    WIDEN_DONE /**< Węzeł ma krawędzie wszystkich legalnych ruchów. */
+} widen_t;
+
+/**
+ * Węzeł drzewa, czyli pozycja razem z graczem na ruchu.
+ * Krawędzie węzła tworzą listę w puli krawędzi. Pierwsze @ref MCTS_EDGES
+ * z nich to losowa próbka legalnych ruchów, która leży w puli w jednym
+ * ciągu, a następne są dokładane w kolejności wyliczania ruchów, gdy węzeł
+ * ma coraz więcej odwiedzin.
+ */
+typedef struct {
+    uint64_t hash; /**< Skrót pozycji i gracza na ruchu. */
+    uint64_t visits; /**< Liczba iteracji przechodzących przez węzeł. */
+    uint64_t cursor; /**< Pozycja wyliczania ruchów do dołożenia. */
+    uint32_t player; /**< Gracz na ruchu, 0 w pozycji końcowej. */
+    uint32_t edge_first; /**< Numer pierwszej krawędzi w puli krawędzi. */
+    uint32_t edge_last; /**< Numer ostatniej krawędzi w puli krawędzi. */
+    uint32_t edge_count; /**< Liczba krawędzi. */
+    uint32_t sampled; /**< Liczba krawędzi losowej próbki. */
+    widen_t widen; /**< Etap dokładania krawędzi. */
+    bool expanded; /**< Czy krawędzie zostały utworzone. */
+} node_t;
+
+/**
+ * Krawędź drzewa, czyli ruch z pozycji węzła.
+ * Statystyki są trzymane na krawędziach, bo węzeł osiągalny z wielu pozycji
+ * ma wspólną liczbę odwiedzin, a ocena ruchu zależy od pozycji, z której
+ * ruch jest wykonywany.
+ */
+typedef struct {
+    gamma_field_t field; /**< Pole ruchu. */
+    uint32_t child; /**< Węzeł po ruchu lub @ref MCTS_NONE. */
+    uint32_t visits; /**< Liczba iteracji przez krawędź. */
+    uint32_t wins; /**< Liczba wygranych wykonującego ruch w połówkach. */
+    uint32_t next; /**< Następna krawędź węzła lub @ref MCTS_NONE. */
+    bool golden; /**< Czy ruch jest złotym ruchem. */
+} edge_t;
+
+/**
+ * Krok ścieżki od korzenia.
+ */
+typedef struct {
+    uint32_t node; /**< Węzeł, z którego wykonano ruch. */
+    uint32_t edge; /**< Krawędź wykonanego ruchu. */
+} step_t;
+
+/**
+ * Stan jednego wątku przeszukiwania.
+ * Wątek zmienia tylko własne kopie gry i własne drzewo.
+ */
+typedef struct {
+    gamma_t *base; /**< Kopia gry w pozycji początkowej. */
+    gamma_t *work; /**< Kopia gry, na której są wykonywane ruchy. */
+    const mcts_config_t *config; /**< Ustawienia przeszukiwania. */
+    uint32_t player; /**< Gracz na ruchu w korzeniu. */
+    uint32_t root; /**< Numer węzła korzenia. */
+    pool_t nodes; /**< Pula węzłów. */
+    pool_t edges; /**< Pula krawędzi. */
+    uint32_t *table; /**< Tablica mieszająca numerów węzłów powiększonych
+                       * o 1, 0 oznacza puste miejsce. */
+    uint64_t table_mask; /**< Pojemność tablicy mieszającej minus 1. */
+    uint64_t table_count; /**< Liczba węzłów w tablicy mieszającej. */
+    step_t *path; /**< Ścieżka bieżącej iteracji. */
+    uint64_t path_capacity; /**< Pojemność ścieżki. */
+    uint64_t random; /**< Stan generatora liczb losowych. */
+    uint64_t iterations; /**< Liczba zakończonych iteracji. */
+    double deadline; /**< Czas zakończenia przeszukiwania. */
+    gamma_field_t buffer[PLAYOUT_BUFFER]; /**< Bufor na wyliczane ruchy. */
+    edge_t sample[MCTS_EDGES]; /**< Próbka ruchów rozwijanego węzła. */
+} searcher_t;
+
+/** @brief Podaje następnego gracza, który może wykonać ruch.
+ * @param[in] g      – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player – numer gracza, który wykonał ruch,
+ * @return Numer gracza lub 0, gdy nikt nie może wykonać ruchu.
+ */
+static uint32_t next_player(gamma_t *g, uint32_t player);
+
+/** @brief Podaje węzeł pozycji, tworząc go w razie potrzeby.
+ * @param[in,out] s  – wskaźnik na stan wątku,
+ * @param[in] hash   – skrót pozycji,
+ * @param[in] player – gracz na ruchu,
+ * @return Numer węzła lub @ref MCTS_NONE, gdy osiągnięto limit węzłów lub
+ * nie udało się zaalokować pamięci.
+ */
+static uint32_t node_for(searcher_t *s, uint64_t hash, uint32_t player);
+
+/** @brief Powiększa tablicę mieszającą dwukrotnie.
+ * @param[in,out] s – wskaźnik na stan wątku,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy nie udało się
+ * zaalokować pamięci.
+ */
+static bool grow_table(searcher_t *s);
+
+/** @brief Tworzy krawędzie węzła.
+ * Przy więcej niż @ref MCTS_EDGES legalnych ruchach tworzy krawędzie dla
+ * losowej próbki ruchów, a pozostałe dokłada później @ref widen.
+ * @param[in,out] s      – wskaźnik na stan wątku,
+ * @param[in] index      – numer węzła,
+ * @param[in,out] random – wskaźnik na stan generatora,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy osiągnięto
+ * limit krawędzi lub nie udało się zaalokować pamięci.
+ */
+static bool expand(searcher_t *s, uint32_t index, uint64_t *random);
+
+/** @brief Dokłada węzłowi krawędź ruchu spoza losowej próbki.
+ * Progresywne poszerzanie: węzeł dostaje kolejną krawędź, dopóki kwadrat
+ * liczby krawędzi dołożonych ponad próbkę jest mniejszy od liczby jego
+ * odwiedzin. Ruchy są brane w kolejności wyliczania, z pominięciem ruchów
+ * z próbki, więc każdy legalny ruch w końcu dostaje krawędź. Kopia robocza
+ * musi być w pozycji węzła.
+ * @param[in,out] s – wskaźnik na stan wątku,
+ * @param[in,out] n – wskaźnik na rozwinięty węzeł.
+ */
+static void widen(searcher_t *s, node_t *n);
+
+/** @brief Sprawdza, czy ruch należy do losowej próbki węzła.
+ * @param[in] s      – wskaźnik na stan wątku,
+ * @param[in] n      – wskaźnik na rozwinięty węzeł,
+ * @param[in] field  – pole ruchu,
+ * @param[in] golden – czy ruch jest złotym ruchem,
+ * @return Wartość @p true, jeśli ruch ma krawędź z próbki, a @p false
+ * w przeciwnym przypadku.
+ */
+static bool sampled(const searcher_t *s, const node_t *n,
+                    gamma_field_t field, bool golden);
+
+/** @brief Wybiera krawędź według wzoru UCT.
+ * @param[in] s – wskaźnik na stan wątku,
+ * @param[in] n – wskaźnik na rozwinięty węzeł z krawędziami,
+ * @return Numer krawędzi w puli krawędzi.
+ */
+static uint32_t select_edge(const searcher_t *s, const node_t *n);
+
+/** @brief Zapewnia miejsce na @p n kroków ścieżki.
+ * @param[in,out] s – wskaźnik na stan wątku,
+ * @param[in] n     – liczba kroków,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy nie udało się
+ * zaalokować pamięci.
+ */
+static bool reserve_path(searcher_t *s, uint64_t n);
+
+/** @brief Przywraca kopię roboczą do pozycji korzenia.
+ * @param[in,out] s – wskaźnik na stan wątku,
+ * @param[in] made  – liczba ruchów iteracji,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy nie udało się
+ * zaalokować pamięci.
+ */
+static bool rewind(searcher_t *s, uint64_t made);
+
+/** @brief Wykonuje jedną iterację przeszukiwania.
+ * Schodzi od korzenia według wzoru UCT do węzła odwiedzanego po raz
+ * pierwszy, dogrywa grę losowo i aktualizuje statystyki ścieżki.
+ * @param[in,out] s – wskaźnik na stan wątku,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy nie udało się
+ * przywrócić pozycji korzenia.
+ */
+static bool iterate(searcher_t *s);
+
+/** @brief Przeszukuje drzewo wątku do upływu czasu.
+ * @param[in,out] arg – wskaźnik na stan wątku,
+ * @return NULL.
+ */
+static void *searcher_run(void *arg);
+
+/** @brief Zwalnia pamięć wątku.
+ * @param[in,out] s – wskaźnik na stan wątku.
+ */
+static void searcher_free(searcher_t *s);
+
+static uint32_t next_player(gamma_t *g, uint32_t player) {
+    for (uint32_t i = 1; i <= g->player_count; ++i) {
+        uint32_t next = (player + i - 1) % g->player_count + 1;
+        if (gamma_can_move(g, next)) {
+            return next;
+        }
+    }
+    return 0;
+}
+
+static bool grow_table(searcher_t *s) {
+    uint64_t capacity = s->table ? 2 * (s->table_mask + 1) : MCTS_TABLE_MIN;
+    uint32_t *table = calloc(capacity, sizeof(uint32_t));
+    if (!table) {
+        return false;
+    }
+    for (uint64_t i = 0; s->table && i <= s->table_mask; ++i) {
+        if (s->table[i] != 0) {
+            const node_t *n = pool_at(&s->nodes, s->table[i] - 1);
+            uint64_t j = n->hash & (capacity - 1);
+            while (table[j] != 0) {
+                j = (j + 1) & (capacity - 1);
+            }
+            table[j] = s->table[i];
+        }
+    }
+    free(s->table);
+    s->table = table;
+    s->table_mask = capacity - 1;
+    return true;
+}
+
+static uint32_t node_for(searcher_t *s, uint64_t hash, uint32_t player) {
+    hash ^= zobrist_key(MCTS_TURN, player);
+    if ((s->table_count + 1) * 2 > (s->table ? s->table_mask + 1 : 0) &&
+        !grow_table(s)) {
+        return MCTS_NONE;
+    }
+    uint64_t i = hash & s->table_mask;
+    while (s->table[i] != 0) {
+        const node_t *n = pool_at(&s->nodes, s->table[i] - 1);
+        if (n->hash == hash) {
+            return s->table[i] - 1;
+        }
+        i = (i + 1) & s->table_mask;
+    }
+    uint32_t index;
+    if (!pool_alloc(&s->nodes, 1, &index)) {
+        return MCTS_NONE;
+    }
+    node_t *n = pool_at(&s->nodes, index);
+    n->hash = hash;
+    n->visits = 0;
+    n->player = player;
+    n->cursor = 0;
+    n->edge_first = MCTS_NONE;
+    n->edge_last = MCTS_NONE;
+    n->edge_count = 0;
+    n->sampled = 0;
+    n->widen = WIDEN_DONE;
+    n->expanded = false;
+    s->table[i] = index + 1;
+    ++(s->table_count);
+    return index;
+}
+
+static bool expand(searcher_t *s, uint32_t index, uint64_t *random) {
+    node_t *n = pool_at(&s->nodes, index);
+    uint64_t seen = 0;
+    uint32_t count = 0;
+    for (int golden = 0; golden <= 1; ++golden) {
+        uint64_t cursor = 0;
+        uint64_t m;
+        do {
+            m = golden
+                ? gamma_legal_golden_moves_next(s->work, n->player, &cursor,
+                                                s->buffer, PLAYOUT_BUFFER)
+                : gamma_legal_moves_next(s->work, n->player, &cursor,
+                                         s->buffer, PLAYOUT_BUFFER);
+            for (uint64_t i = 0; i < m; ++i) {
+                /* Losowanie z rezerwuarem jak przy ruchach rozgrywek. */
+                uint64_t slot = seen++;
+                if (slot < MCTS_EDGES) {
+                    ++count;
+                } else {
+                    slot = playout_random(random) % seen;
+                }
+                if (slot < MCTS_EDGES) {
+                    edge_t edge = {s->buffer[i], MCTS_NONE, 0, 0, MCTS_NONE,
+                                   golden};
+                    s->sample[slot] = edge;
+                }
+            }
+        } while (m == PLAYOUT_BUFFER);
+    }
+    uint32_t first = MCTS_NONE;
+    if (count > 0 && !pool_alloc(&s->edges, count, &first)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        edge_t *e = pool_at(&s->edges, first + i);
+        *e = s->sample[i];
+        e->next = i + 1 < count ? first + i + 1 : MCTS_NONE;
+    }
+    n->edge_first = first;
+    n->edge_last = count > 0 ? first + count - 1 : MCTS_NONE;
+    n->edge_count = count;
+    n->sampled = count;
+    n->cursor = 0;
+    n->widen = seen > MCTS_EDGES ? WIDEN_MOVES : WIDEN_DONE;
+    n->expanded = true;
+    return true;
+}
+
+static bool sampled(const searcher_t *s, const node_t *n,
+                    gamma_field_t field, bool golden) {
+    for (uint32_t i = 0; i < n->sampled; ++i) {
+        const edge_t *e = pool_at(&s->edges, n->edge_first + i);
+        if (e->field.x == field.x && e->field.y == field.y &&
+            e->golden == golden) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void widen(searcher_t *s, node_t *n) {
+    uint64_t extra = n->edge_count - n->sampled;
+    if (n->widen == WIDEN_DONE || extra * extra >= n->visits) {
+        return;
+    }
+    while (n->widen != WIDEN_DONE) {
+        bool golden = n->widen == WIDEN_GOLDEN;
+        uint64_t m = golden
+                     ? gamma_legal_golden_moves_next(s->work, n->player,
+                                                     &n->cursor, s->buffer, 1)
+                     : gamma_legal_moves_next(s->work, n->player, &n->cursor,
+                                              s->buffer, 1);
+        if (m == 0) {
+            ++(n->widen);
+            n->cursor = 0;
+        } else if (!sampled(s, n, s->buffer[0], golden)) {
+            uint32_t index;
+            /* Po osiągnięciu limitu krawędzi węzeł zostaje przy tych, które
+             * ma. */
+            if (!pool_alloc(&s->edges, 1, &index)) {
+                n->widen = WIDEN_DONE;
+                return;
+            }
+            edge_t edge = {s->buffer[0], MCTS_NONE, 0, 0, MCTS_NONE, golden};
+            *(edge_t *) pool_at(&s->edges, index) = edge;
+            ((edge_t *) pool_at(&s->edges, n->edge_last))->next = index;
+            n->edge_last = index;
+            ++(n->edge_count);
+            return;
+        }
+    }
+}
+
+static uint32_t select_edge(const searcher_t *s, const node_t *n) {
+    double log_visits = log((double) n->visits + 1);
+    double best_value = -1;
+    uint32_t best = n->edge_first;
+    for (uint32_t i = n->edge_first; i != MCTS_NONE;) {
+        const edge_t *e = pool_at(&s->edges, i);
+        if (e->visits == 0) {
+            return i;
+        }
+        double value = e->wins / (2.0 * e->visits) +
+                       s->config->exploration *
+                       sqrt(log_visits / e->visits);
+        if (value > best_value) {
+            best_value = value;
+            best = i;
+        }
+        i = e->next;
+    }
+    return best;
+}
+
+static bool reserve_path(searcher_t *s, uint64_t n) {
+    if (n <= s->path_capacity) {
+        return true;
+    }
+    uint64_t capacity = s->path_capacity ? 2 * s->path_capacity : 64;
+    step_t *path = realloc(s->path, sizeof(step_t) * capacity);
+    if (!path) {
+        return false;
+    }
+    s->path = path;
+    s->path_capacity = capacity;
+    return true;
+}
+
+static bool rewind(searcher_t *s, uint64_t made) {
+    uint64_t undone = 0;
+    while (undone < made && gamma_undo(s->work)) {
+        ++undone;
+    }
+    if (undone == made) {
+        return true;
+    }
+    /* Dziennik zgubił ruchy, więc zostaje kopia pozycji korzenia. */
+    gamma_delete(s->work);
+    s->work = gamma_fork(s->base);
+    if (!s->work) {
+        return false;
+    }
+    gamma_set_journal(s->work, true);
+    return true;
+}
+
+static bool iterate(searcher_t *s) {
+    gamma_t *g = s->work;
+    uint32_t index = s->root;
+    uint32_t to_move = s->player;
+    uint64_t depth = 0;
+    while (index != MCTS_NONE) {
+        node_t *n = pool_at(&s->nodes, index);
+        to_move = n->player;
+        /* Nowy węzeł jest rozwijany dopiero przy drugich odwiedzinach. */
+        if (to_move == NOBODY || (index != s->root && n->visits == 0) ||
+            (!n->expanded && !expand(s, index, &s->random)) ||
+            n->edge_count == 0 || !reserve_path(s, depth + 1)) {
+            break;
+        }
+        widen(s, n);
+        uint32_t chosen = select_edge(s, n);
+        edge_t *e = pool_at(&s->edges, chosen);
+        uint32_t x = e->field.x;
+        uint32_t y = e->field.y;
+        bool done = e->golden ? gamma_golden_move(g, to_move, x, y)
+                              : gamma_move(g, to_move, x, y);
+        if (!done) {
+            break;
+        }
+        s->path[depth].node = index;
+        s->path[depth].edge = chosen;
+        ++depth;
+        if (e->child == MCTS_NONE) {
+            uint32_t next = next_player(g, to_move);
+            e->child = node_for(s, gamma_hash(g), next);
+            to_move = next;
+        }
+        index = e->child;
+    }
+    uint64_t made = depth;
+    if (to_move != NOBODY) {
+        made += playout_finish(g, to_move, s->config->policy, &s->random,
+                               s->buffer);
+    }
+    /* Wynik gracza zależy tylko od największej liczby pól i tego, ilu
+     * graczy ją ma. */
+    uint64_t best = 0;
+    uint32_t leaders = 0;
+    for (uint32_t i = 1; i <= g->player_count; ++i) {
+        uint64_t busy = gamma_busy_fields(g, i);
+        if (busy > best) {
+            best = busy;
+            leaders = 1;
+        } else if (busy == best) {
+            ++leaders;
+        }
+    }
+    for (uint64_t i = 0; i < depth; ++i) {
+        node_t *n = pool_at(&s->nodes, s->path[i].node);
+        edge_t *e = pool_at(&s->edges, s->path[i].edge);
+        ++(n->visits);
+        ++(e->visits);
+        if (gamma_busy_fields(g, n->player) == best) {
+            e->wins += leaders == 1 ? 2 : 1;
+        }
+    }
+    if (index != MCTS_NONE) {
+        ++(((node_t *) pool_at(&s->nodes, index))->visits);
+    }
+    ++(s->iterations);
+    return rewind(s, made);
+}
+
+static void *searcher_run(void *arg) {
+    searcher_t *s = arg;
+    s->work = gamma_fork(s->base);
+    if (!s->work) {
+        return NULL;
+    }
+    gamma_set_journal(s->work, true);
+    s->root = node_for(s, gamma_hash(s->work), s->player);
+    /* Korzeń jest rozwijany tym samym ziarnem we wszystkich wątkach, więc
+     * krawędzie korzeni są takie same i można je zsumować. */
+    uint64_t random = playout_seed(s->config->seed, 0);
+    if (s->root == MCTS_NONE || !expand(s, s->root, &random)) {
+        s->root = MCTS_NONE;
+        return NULL;
+    }
+    const node_t *root = pool_at(&s->nodes, s->root);
+    while (root->edge_count > 0 && playout_now() < s->deadline &&
+           iterate(s));
+    return NULL;
+}
+
+static void searcher_free(searcher_t *s) {
+    gamma_delete(s->work);
+    gamma_delete(s->base);
+    pool_free(&s->nodes);
+    pool_free(&s->edges);
+    free(s->table);
+    free(s->path);
+}
+
+void mcts_defaults(mcts_config_t *config) {
+    config->threads = 0;
+    config->budget_ms = MCTS_DEFAULT_BUDGET;
+    config->seed = (uint64_t) time(NULL);
+    config->policy = PLAYOUT_HEURISTIC;
+    config->exploration = MCTS_EXPLORATION;
+}
+
+bool mcts_search(gamma_t *g, uint32_t player, const mcts_config_t *config,
+                 playout_result_t *result) {
+    if (!g || !config || !result || player < 1 || player > g->player_count) {
+        return false;
+    }
+    result->moves = NULL;
+    result->count = 0;
+    result->playouts = 0;
+    result->seconds = 0;
+    uint32_t threads = config->threads;
+    if (threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (uint32_t) cpus : 1;
+    }
+    if (threads > MCTS_MAX_THREADS) {
+        threads = MCTS_MAX_THREADS;
+    }
+    searcher_t *searchers = calloc(threads, sizeof(searcher_t));
+    if (!searchers) {
+        return false;
+    }
+    pthread_t ids[MCTS_MAX_THREADS];
+    bool started[MCTS_MAX_THREADS];
+    bool ok = true;
+    /* Kopie są tworzone przed uruchomieniem wątków, bo tworzenie kopii
+     * zmienia oryginał. */
+    for (uint32_t i = 0; i < threads; ++i) {
+        searcher_t *s = &searchers[i];
+        pool_init(&s->nodes, sizeof(node_t), MCTS_MAX_NODES);
+        pool_init(&s->edges, sizeof(edge_t), MCTS_MAX_EDGES);
+        s->config = config;
+        s->player = player;
+        s->root = MCTS_NONE;
+        s->random = playout_seed(config->seed, i + 1);
+        s->base = gamma_fork(g);
+        ok = ok && s->base != NULL;
+    }
+    uint64_t budget = config->budget_ms < MCTS_MAX_BUDGET
+                      ? config->budget_ms : MCTS_MAX_BUDGET;
+    double start = playout_now();
+    for (uint32_t i = 0; ok && i < threads; ++i) {
+        searchers[i].deadline = start + budget / 1e3;
+        started[i] = pthread_create(&ids[i], NULL, searcher_run,
+                                    &searchers[i]) == 0;
+        if (!started[i]) {
+            /* Bez nowego wątku przeszukiwanie odbywa się w wątku
+             * wywołującym. */
+            searcher_run(&searchers[i]);
+        }
+    }
+    for (uint32_t i = 0; ok && i < threads; ++i) {
+        if (started[i]) {
+            pthread_join(ids[i], NULL);
+        }
+    }
+    result->seconds = playout_now() - start;
+    /* Krawędzie korzeni wszystkich wątków zaczynają się tą samą próbką,
+     * a dalej mają ruchy w tej samej kolejności wyliczania, więc krawędzie
+     * korzenia o tym samym numerze na liście to ten sam ruch. Wynik zawiera
+     * krawędzie najdłuższej listy. */
+    const searcher_t *widest = NULL;
+    for (uint32_t i = 0; ok && i < threads; ++i) {
+        const searcher_t *s = &searchers[i];
+        if (s->root != MCTS_NONE &&
+            (!widest ||
+             ((const node_t *) pool_at(&s->nodes, s->root))->edge_count >
+             ((const node_t *) pool_at(&widest->nodes,
+                                       widest->root))->edge_count)) {
+            widest = s;
+        }
+    }
+    if (widest != NULL) {
+        const node_t *root = pool_at(&widest->nodes, widest->root);
+        result->moves = malloc(sizeof(playout_stat_t) *
+                               (root->edge_count ? root->edge_count : 1));
+        ok = result->moves != NULL;
+        uint32_t j = 0;
+        for (uint32_t i = root->edge_first; ok && i != MCTS_NONE; ++j) {
+            const edge_t *e = pool_at(&widest->edges, i);
+            playout_stat_t move = {e->field, e->golden, 0, 0};
+            result->moves[j] = move;
+            i = e->next;
+        }
+        result->count = ok ? root->edge_count : 0;
+    } else {
+        ok = false;
+    }
+    for (uint32_t i = 0; i < threads; ++i) {
+        searcher_t *s = &searchers[i];
+        if (ok && s->root != MCTS_NONE) {
+            const node_t *root = pool_at(&s->nodes, s->root);
+            uint32_t j = 0;
+            for (uint32_t k = root->edge_first; k != MCTS_NONE; ++j) {
+                const edge_t *e = pool_at(&s->edges, k);
+                result->moves[j].visits += e->visits;
+                result->moves[j].wins += e->wins;
+                k = e->next;
+            }
+            result->playouts += s->iterations;
+        }
+        searcher_free(s);
+    }
+    free(searchers);
+    if (!ok) {
+        playout_result_free(result);
+    }
+    return ok;
+}
+
+bool mcts_move(gamma_t *g, uint32_t player, const mcts_config_t *config,
+               playout_stat_t *move, double *rate) {
+    playout_result_t result;
+    if (!mcts_search(g, player, config, &result)) {
+        return false;
+    }
+    const playout_stat_t *best = NULL;
+    for (uint64_t i = 0; i < result.count; ++i) {
+        if (!best || result.moves[i].visits > best->visits) {
+            best = &result.moves[i];
+        }
+    }
+    bool done = false;
+    if (best != NULL) {
+        done = best->golden
+               ? gamma_golden_move(g, player, best->field.x, best->field.y)
+               : gamma_move(g, player, best->field.x, best->field.y);
+        if (done && move != NULL) {
+            *move = *best;
+        }
+    }
+    if (rate != NULL) {
+        *rate = playout_rate(&result);
+    }
+    playout_result_free(&result);
+    return done;
+}
@@ -0,0 +1,70 @@
+/** @file
+ * Interfejs przeszukiwania drzewa gry metodą Monte Carlo (UCT).
+ *
+ * @author Marcin Malejky
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "playout.h"
+
+#ifndef GAMMA_MCTS_H
+#define GAMMA_MCTS_H
+
+#define MCTS_MAX_BUDGET 10000 /**< Największy czas przeszukiwania w ms. */
+
+struct gamma;
+
+/**
+ * Ustawienia przeszukiwania.
+ */
+typedef struct {
+    uint32_t threads; /**< Liczba wątków, 0 oznacza liczbę procesorów. */
+    uint64_t budget_ms; /**< Czas przeszukiwania w milisekundach, dłuższy
+                          *  jest skracany do @ref MCTS_MAX_BUDGET. */
+    uint64_t seed; /**< Ziarno generatora liczb losowych. */
+    playout_policy_t policy; /**< Sposób wyboru ruchów w rozgrywkach. */
+    double exploration; /**< Stała eksploracji we wzorze UCT. */
+} mcts_config_t;
+
+/** @brief Podaje domyślne ustawienia przeszukiwania.
+ * @param[out] config – wskaźnik na ustawienia.
+ */
+void mcts_defaults(mcts_config_t *config);
+
+/** @brief Przeszukuje drzewo gry od bieżącej pozycji.
+ * Każdy wątek buduje własne drzewo na jednej własnej kopii gry: schodzi
+ * w dół drzewa, wykonując ruchy, dogrywa grę losowo, a potem cofa wszystkie
+ * ruchy przez dziennik. Węzły drzewa są identyfikowane skrótem pozycji, więc
+ * pozycje osiągnięte różnymi kolejnościami ruchów mają wspólny węzeł.
+ * Węzeł dostaje najpierw krawędzie losowej próbki ruchów, a krawędzie
+ * pozostałych ruchów są dokładane w miarę jego odwiedzin, więc przy
+ * dostatecznie długim przeszukiwaniu każdy legalny ruch zostaje zbadany.
+ * Statystyki ruchów z korzenia są na koniec sumowane ze wszystkich wątków.
+ * Gra @p g nie może być zmieniana w trakcie wywołania.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza wykonującego ruch,
+ * @param[in] config  – wskaźnik na ustawienia,
+ * @param[out] result – wskaźnik na wynik, który należy zwolnić przez
+ *                      @ref playout_result_free; @p playouts to liczba
+ *                      iteracji przeszukiwania,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy któryś parametr
+ * jest niepoprawny lub nie udało się zaalokować pamięci.
+ */
+bool mcts_search(struct gamma *g, uint32_t player,
+                 const mcts_config_t *config, playout_result_t *result);
+
+/** @brief Wykonuje ruch gracza komputerowego.
+ * Przeszukuje drzewo gry i wykonuje najczęściej odwiedzany ruch z korzenia.
+ * @param[in,out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player – numer gracza,
+ * @param[in] config – wskaźnik na ustawienia,
+ * @param[out] move  – wskaźnik na statystyki wykonanego ruchu lub NULL,
+ * @param[out] rate  – wskaźnik na liczbę iteracji na sekundę lub NULL,
+ * @return Wartość @p true, jeśli ruch został wykonany, a @p false, gdy
+ * gracz nie ma ruchu lub nie udało się zaalokować pamięci.
+ */
+bool mcts_move(struct gamma *g, uint32_t player, const mcts_config_t *config,
+               playout_stat_t *move, double *rate);
+
+#endif //GAMMA_MCTS_H
@@ -0,0 +1,71 @@
+/** @file
+ * Implementacja wyliczania legalnych ruchów gracza.
+ *
+ * @author Marcin Malejky
+ */
+
+#include "gamma.h"
+#include "moves.h"
+
+#define NOBODY 0 /**< Domyślny posiadacz pustego pola. */
+
+/** @brief Podaje słowo pól, które mogą być ruchem gracza.
+ * @param[in] g      – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player – numer gracza,
+ * @param[in] golden – czy chodzi o złote ruchy,
+ * @param[in] word   – numer słowa planszy,
+ * @return Słowo, którego bit @p i jest ustawiony, gdy pole
+ * @p BOARD_WORD_BITS * @p word + @p i spełnia warunki ruchu zależne tylko od
+ * posiadaczy pól. Złote ruchy wymagają jeszcze sprawdzenia rozspójnienia.
+ */
+static uint64_t candidate_word(gamma_t *g, uint32_t player, bool golden,
+                               uint64_t word);
+
+static uint64_t candidate_word(gamma_t *g, uint32_t player, bool golden,
+                               uint64_t word) {
+    board_t *b = &g->board;
+    /* Gracz z pełnym limitem obszarów może tylko powiększać obszary. */
+    bool bordering = g->area_count[player] >= g->areas_limit;
+    uint64_t mask;
+    if (golden) {
+        mask = ~board_owned_word(b, NOBODY, word) &
+               ~board_owned_word(b, player, word) &
+               ~board_owned_word(b, b->border, word);
+    } else {
+        mask = board_owned_word(b, NOBODY, word);
+    }
+    if (mask != 0 && bordering) {
+        mask &= board_adjacent_word(b, player, word);
+    }
+    return mask;
+}
+
+uint64_t moves_list(gamma_t *g, uint32_t player, bool golden,
+                    uint64_t *cursor, gamma_field_t *buffer, uint64_t cap) {
+    board_t *b = &g->board;
+    uint64_t count = 0;
+    uint64_t field = *cursor;
+    while (count < cap && field < b->size) {
+        uint64_t word = field / BOARD_WORD_BITS;
+        uint64_t mask = candidate_word(g, player, golden, word) &
+                        UINT64_MAX << field % BOARD_WORD_BITS;
+        field = (word + 1) * BOARD_WORD_BITS;
+        while (mask != 0) {
+            uint64_t next = word * BOARD_WORD_BITS + __builtin_ctzll(mask);
+            if (next >= b->size) {
+                break;
+            }
+            if (count == cap) {
+                field = next;
+                break;
+            }
+            if (!golden || golden_safe(g, next)) {
+                gamma_field_t move = {board_x(b, next), board_y(b, next)};
+                buffer[count++] = move;
+            }
+            mask &= mask - 1;
+        }
+    }
+    *cursor = field < b->size ? field : b->size;
+    return count;
+}
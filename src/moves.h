@@ -0,0 +1,40 @@
+/** @file
+ * Interfejs wyliczania legalnych ruchów gracza.
+ *
+ * @author Marcin Malejky
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef GAMMA_MOVES_H
+#define GAMMA_MOVES_H
+
+struct gamma;
+
+/**
+ * Współrzędne pola planszy.
+ */
+typedef struct {
+    uint32_t x; /**< Numer kolumny. */
+    uint32_t y; /**< Numer wiersza. */
+} gamma_field_t;
+
+/** @brief Zapisuje kolejne pola, na których gracz może wykonać ruch.
+ * Przegląda planszę słowami od pola @p *cursor w kolejności numerów pól
+ * i zapisuje najwyżej @p cap pól. Sprawdza tylko pola, które mogą być ruchem
+ * według masek słów planszy, a przy złotych ruchach sprawdza rozspójnienie
+ * obszaru poprzedniego właściciela.
+ * @param[in,out] g      – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player     – poprawny numer gracza,
+ * @param[in] golden     – czy wyliczać złote ruchy zamiast zwykłych,
+ * @param[in,out] cursor – numer pola, od którego zacząć; po powrocie numer
+ *                         pola, od którego należy kontynuować,
+ * @param[out] buffer    – tablica na co najmniej @p cap pól,
+ * @param[in] cap        – największa liczba zapisanych pól,
+ * @return Liczba zapisanych pól.
+ */
+uint64_t moves_list(struct gamma *g, uint32_t player, bool golden,
+                    uint64_t *cursor, gamma_field_t *buffer, uint64_t cap);
+
+#endif //GAMMA_MOVES_H
@@ -0,0 +1,138 @@
+/** @file
+ * Implementacja buforowanego wyjścia na deskryptor pliku.
+ *
+ * @author Marcin Malejky
+ */
+
+#define _POSIX_C_SOURCE 200809L /**< Dostęp do write. */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "output.h"
+
+#define MAX_DIGITS 20 /**< Największa liczba cyfr liczby 64-bitowej. */
+
+/** @brief Przekazuje ciąg znaków do deskryptora, pomijając błędy zapisu.
+ * Błędy zapisu są pomijane, tak jak przy wypisywaniu przez printf, a zapisany
+ * ciąg jest wtedy traktowany jako przekazany.
+ * @param[in] fd – deskryptor pliku,
+ * @param[in] s  – ciąg znaków,
+ * @param[in] n  – liczba znaków,
+ * @return Liczba przekazanych znaków, mniejsza od @p n tylko wtedy, gdy
+ * deskryptor jest nieblokujący i nie przyjmie teraz więcej danych.
+ */
+static size_t write_all(int fd, const char *s, size_t n);
+
+/** @brief Powiększa bufor tak, aby zmieściło się w nim co najmniej SIZE
+ * znaków.
+ * @param[in,out] o – wskaźnik na wyjście,
+ * @param[in] size  – liczba znaków,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy nie udało się
+ * zaalokować pamięci.
+ */
+static bool grow(output_t *o, size_t size);
+
+static size_t write_all(int fd, const char *s, size_t n) {
+    size_t written = output_write_fd(fd, s, n);
+    return written < n && errno != EAGAIN ? n : written;
+}
+
+static bool grow(output_t *o, size_t size) {
+    size_t capacity = 2 * o->capacity > size ? 2 * o->capacity : size;
+    char *data = realloc(o->data, capacity);
+    if (data == NULL) {
+        return false;
+    }
+    o->data = data;
+    o->capacity = capacity;
+    return true;
+}
+
+size_t output_write_fd(int fd, const char *s, size_t n) {
+    size_t done = 0;
+    while (done < n) {
+        ssize_t written = write(fd, s + done, n - done);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            break;
+        }
+        done += written;
+    }
+    return done;
+}
+
+bool output_fd_sink(void *fd, const char *s, size_t n) {
+    return output_write_fd(*(int *) fd, s, n) == n;
+}
+
+void output_init(output_t *o, int fd, size_t capacity) {
+    o->fd = fd;
+    o->length = 0;
+    o->data = malloc(capacity);
+    o->capacity = o->data != NULL ? capacity : 0;
+}
+
+void output_free(output_t *o) {
+    output_flush(o);
+    free(o->data);
+    o->data = NULL;
+    o->capacity = 0;
+}
+
+void output_flush(output_t *o) {
+    if (o->fd == OUTPUT_MEMORY) {
+        return;
+    }
+    size_t written = write_all(o->fd, o->data, o->length);
+    if (written > 0) {
+        memmove(o->data, o->data + written, o->length - written);
+        o->length -= written;
+    }
+}
+
+bool output_write(output_t *o, const char *s, size_t n) {
+    if (n > o->capacity - o->length) {
+        output_flush(o);
+        if (o->length == 0 && n >= o->capacity && o->fd != OUTPUT_MEMORY) {
+            size_t written = write_all(o->fd, s, n);
+            s += written;
+            n -= written;
+            if (n == 0) {
+                return true;
+            }
+        }
+        if (n > o->capacity - o->length && !grow(o, o->length + n)) {
+            return false;
+        }
+    }
+    memcpy(o->data + o->length, s, n);
+    o->length += n;
+    return true;
+}
+
+bool output_sink(void *o, const char *s, size_t n) {
+    return output_write(o, s, n);
+}
+
+void output_uint(output_t *o, uint64_t value) {
+    char digits[MAX_DIGITS];
+    int i = MAX_DIGITS;
+    do {
+        digits[--i] = (char) ('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    output_write(o, digits + i, MAX_DIGITS - i);
+}
+
+void output_int(output_t *o, int64_t value) {
+    if (value < 0) {
+        output_char(o, '-');
+        output_uint(o, -(uint64_t) value);
+    } else {
+        output_uint(o, value);
+    }
+}
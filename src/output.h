@@ -0,0 +1,119 @@
+/** @file
+ * Interfejs buforowanego wyjścia na deskryptor pliku.
+ *
+ * @author Marcin Malejky
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef GAMMA_OUTPUT_H
+#define GAMMA_OUTPUT_H
+
+#define OUTPUT_CAPACITY 65536 /**< Domyślny rozmiar bufora wyjścia. */
+#define OUTPUT_MEMORY (-1) /**< Deskryptor wyjścia zbierającego dane tylko
+                            * w pamięci. */
+
+/**
+ * Buforowane wyjście.
+ * Zbiera wypisywane znaki i przekazuje je do deskryptora dużymi blokami.
+ * Bez bufora (gdy nie udało się go zaalokować) każdy zapis trafia od razu
+ * do deskryptora. Dane, których nieblokujący deskryptor nie przyjął, zostają
+ * w buforze, a bufor w razie potrzeby rośnie. Wyjście z deskryptorem
+ * @ref OUTPUT_MEMORY niczego nie wypisuje, tylko zbiera dane w buforze.
+ */
+typedef struct {
+    int fd; /**< Deskryptor pliku wyjścia. */
+    char *data; /**< Bufor lub NULL. */
+    size_t length; /**< Liczba znaków w buforze. */
+    size_t capacity; /**< Rozmiar bufora. */
+} output_t;
+
+/** @brief Przekazuje ciąg znaków do deskryptora z pominięciem bufora.
+ * Ponawia zapis po częściowym zapisie i po przerwaniu sygnałem.
+ * @param[in] fd – deskryptor pliku,
+ * @param[in] s  – ciąg znaków,
+ * @param[in] n  – liczba znaków,
+ * @return Liczba przekazanych znaków, mniejsza od @p n, gdy zapis się nie
+ * powiódł lub nieblokujący deskryptor nie przyjmie teraz więcej danych,
+ * co rozróżnia wartość errno.
+ */
+size_t output_write_fd(int fd, const char *s, size_t n);
+
+/** @brief Przekazuje do deskryptora ciąg znaków z funkcji wypisującej.
+ * Ma postać funkcji odbierającej kawałki wydruku, tak jak @ref output_sink,
+ * ale pisze bez bufora.
+ * @param[in] fd – wskaźnik na deskryptor pliku,
+ * @param[in] s  – ciąg znaków,
+ * @param[in] n  – liczba znaków,
+ * @return Wartość @p true, jeśli przekazano cały ciąg, a @p false, gdy
+ * zapis się nie powiódł, co przerywa wypisywanie.
+ */
+bool output_fd_sink(void *fd, const char *s, size_t n);
+
+/** @brief Inicjalizuje wyjście.
+ * @param[out] o      – wskaźnik na wyjście,
+ * @param[in] fd      – deskryptor pliku,
+ * @param[in] capacity – rozmiar bufora.
+ */
+void output_init(output_t *o, int fd, size_t capacity);
+
+/** @brief Wypisuje zawartość bufora i zwalnia go.
+ * @param[in,out] o – wskaźnik na wyjście.
+ */
+void output_free(output_t *o);
+
+/** @brief Wypisuje zawartość bufora do deskryptora.
+ * Gdy deskryptor jest nieblokujący, w buforze może zostać część danych.
+ * @param[in,out] o – wskaźnik na wyjście.
+ */
+void output_flush(output_t *o);
+
+/** @brief Wypisuje ciąg znaków.
+ * Długie ciągi są przekazywane do deskryptora z pominięciem bufora.
+ * @param[in,out] o – wskaźnik na wyjście,
+ * @param[in] s     – ciąg znaków,
+ * @param[in] n     – liczba znaków,
+ * @return Wartość @p true, jeśli ciąg został wypisany lub zapamiętany
+ * w buforze, a @p false, gdy nie udało się powiększyć bufora.
+ */
+bool output_write(output_t *o, const char *s, size_t n);
+
+/** @brief Wypisuje ciąg znaków przekazany przez funkcję wypisującą.
+ * Ma postać funkcji odbierającej kawałki wydruku, np. planszy przez
+ * @ref gamma_board_write.
+ * @param[in,out] o – wskaźnik na wyjście,
+ * @param[in] s     – ciąg znaków,
+ * @param[in] n     – liczba znaków,
+ * @return Wartość @p true, jeśli ciąg został wypisany lub zapamiętany
+ * w buforze, a @p false, gdy nie udało się powiększyć bufora, co przerywa
+ * wypisywanie.
+ */
+bool output_sink(void *o, const char *s, size_t n);
+
+/** @brief Wypisuje liczbę bez znaku w zapisie dziesiętnym.
+ * @param[in,out] o – wskaźnik na wyjście,
+ * @param[in] value – liczba.
+ */
+void output_uint(output_t *o, uint64_t value);
+
+/** @brief Wypisuje liczbę ze znakiem w zapisie dziesiętnym.
+ * @param[in,out] o – wskaźnik na wyjście,
+ * @param[in] value – liczba.
+ */
+void output_int(output_t *o, int64_t value);
+
+/** @brief Wypisuje znak.
+ * @param[in,out] o – wskaźnik na wyjście,
+ * @param[in] c     – znak.
+ */
+static inline void output_char(output_t *o, char c) {
+    if (o->length < o->capacity) {
+        o->data[o->length++] = c;
+    } else {
+        output_write(o, &c, 1);
+    }
+}
+
+#endif //GAMMA_OUTPUT_H
@@ -0,0 +1,280 @@
+/** @file
+ * Implementacja tablic stron współdzielonych między kopiami gry.
+ *
+ * @author Marcin Malejky
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "pages.h"
+
+/** @brief Alokuje tabelę stron.
+ * @param[in] length – liczba stron,
+ * @return Wskaźnik na tabelę z jednym odwołaniem lub NULL, gdy nie udało się
+ * zaalokować pamięci.
+ */
+static page_table_t *new_table(uint64_t length);
+
+/** @brief Alokuje niezainicjowaną stronę.
+ * @return Wskaźnik na stronę z jednym odwołaniem lub NULL, gdy nie udało się
+ * zaalokować pamięci.
+ */
+static page_t *alloc_page(void);
+
+/** @brief Alokuje stronę wypełnioną jednym bajtem.
+ * @param[in] fill – bajt, którym jest wypełniana strona,
+ * @return Wskaźnik na stronę z jednym odwołaniem lub NULL, gdy nie udało się
+ * zaalokować pamięci.
+ */
+static page_t *new_page(unsigned char fill);
+
+/** @brief Usuwa odwołanie do strony i zwalnia ją, jeśli było ostatnie.
+ * @param[in,out] page – wskaźnik na stronę.
+ */
+static void release_page(page_t *page);
+
+/** @brief Usuwa odwołanie do tabeli i zwalnia ją, jeśli było ostatnie.
+ * @param[in,out] table – wskaźnik na tabelę.
+ */
+static void release_table(page_table_t *table);
+
+/** @brief Powiększa ciągły blok tablicy.
+ * @param[in,out] p  – wskaźnik na tablicę będącą ciągłym blokiem,
+ * @param[in] length – nowa liczba stron, większa od obecnej,
+ * @param[in] fill   – bajt, którym są wypełniane nowe strony,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy nie udało się
+ * zaalokować pamięci.
+ */
+static bool grow_block(pages_t *p, uint64_t length, unsigned char fill);
+
+/** @brief Dzieli ciągły blok tablicy na strony.
+ * @param[in,out] p – wskaźnik na tablicę będącą ciągłym blokiem,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy nie udało się
+ * zaalokować pamięci. Wtedy tablica pozostaje ciągłym blokiem.
+ */
+static bool split_block(pages_t *p);
+
+static page_table_t *new_table(uint64_t length) {
+    if (length > (SIZE_MAX - sizeof(page_table_t)) / sizeof(page_t *)) {
+        return NULL;
+    }
+    page_table_t *table = malloc(sizeof(page_table_t) +
+                                 sizeof(page_t *) * length);
+    if (table != NULL) {
+        atomic_init(&table->refs, 1);
+        table->length = length;
+    }
+    return table;
+}
+
+static page_t *alloc_page(void) {
+    page_t *page = aligned_alloc(PAGE_ALIGN, sizeof(page_t));
+    if (page != NULL) {
+        atomic_init(&page->refs, 1);
+        page->next = NULL;
+    }
+    return page;
+}
+
+static page_t *new_page(unsigned char fill) {
+    page_t *page = alloc_page();
+    if (page != NULL) {
+        memset(page->data, fill, PAGE_BYTES);
+    }
+    return page;
+}
+
+static void release_page(page_t *page) {
+    if (atomic_fetch_sub_explicit(&page->refs, 1, memory_order_acq_rel) == 1) {
+        free(page);
+    }
+}
+
+static void release_table(page_table_t *table) {
+    if (atomic_fetch_sub_explicit(&table->refs, 1,
+                                  memory_order_acq_rel) == 1) {
+        for (uint64_t i = 0; i < table->length; ++i) {
+            release_page(table->page[i]);
+        }
+        free(table);
+    }
+}
+
+static bool grow_block(pages_t *p, uint64_t length, unsigned char fill) {
+    if (length > SIZE_MAX / PAGE_BYTES) {
+        return false;
+    }
+    unsigned char *base = aligned_alloc(PAGE_ALIGN, length * PAGE_BYTES);
+    if (!base) {
+        return false;
+    }
+    uint64_t used = p->length * PAGE_BYTES;
+    if (p->base != NULL) {
+        memcpy(base, p->base, used);
+        free(p->base);
+    }
+    memset(base + used, fill, length * PAGE_BYTES - used);
+    p->base = base;
+    p->length = length;
+    return true;
+}
+
+static bool split_block(pages_t *p) {
+    page_table_t *table = new_table(p->length);
+    if (!table) {
+        return false;
+    }
+    for (uint64_t i = 0; i < p->length; ++i) {
+        table->page[i] = alloc_page();
+        if (!table->page[i]) {
+            while (i > 0) {
+                free(table->page[--i]);
+            }
+            free(table);
+            return false;
+        }
+        memcpy(table->page[i]->data, p->base + i * PAGE_BYTES, PAGE_BYTES);
+    }
+    free(p->base);
+    p->base = NULL;
+    p->table = table;
+    p->page = table->page;
+    return true;
+}
+
+void page_pool_init(page_pool_t *pool) {
+    pool->free = NULL;
+    pool->count = 0;
+}
+
+void page_pool_free(page_pool_t *pool) {
+    while (pool->free != NULL) {
+        page_t *next = pool->free->next;
+        free(pool->free);
+        pool->free = next;
+    }
+    pool->count = 0;
+}
+
+bool page_pool_reserve(page_pool_t *pool, uint64_t n) {
+    while (pool->count < n) {
+        page_t *page = aligned_alloc(PAGE_ALIGN, sizeof(page_t));
+        if (!page) {
+            return false;
+        }
+        page->next = pool->free;
+        pool->free = page;
+        ++(pool->count);
+    }
+    return true;
+}
+
+bool pages_init(pages_t *p, page_pool_t *pool, uint32_t element,
+                uint64_t count, unsigned char fill) {
+    p->base = NULL;
+    p->page = NULL;
+    p->table = NULL;
+    p->pool = pool;
+    p->per_page = PAGE_BYTES / element;
+    p->length = 0;
+    /* Pusta tablica też ma blok, aby odróżnić ją od podzielonej na strony. */
+    return grow_block(p, count > 0 ? (count + p->per_page - 1) / p->per_page
+                                   : 1, fill);
+}
+
+void pages_free(pages_t *p) {
+    if (p->table != NULL) {
+        release_table(p->table);
+    }
+    free(p->base);
+    p->base = NULL;
+    p->table = NULL;
+    p->page = NULL;
+}
+
+bool pages_grow(pages_t *p, uint64_t count, unsigned char fill) {
+    uint64_t length = (count + p->per_page - 1) / p->per_page;
+    if (length <= p->length) {
+        return true;
+    }
+    if (p->base != NULL) {
+        return grow_block(p, length, fill);
+    }
+    page_table_t *old = p->table;
+    page_table_t *table = new_table(length);
+    if (!table) {
+        return false;
+    }
+    for (uint64_t i = old->length; i < length; ++i) {
+        table->page[i] = new_page(fill);
+        if (!table->page[i]) {
+            while (i > old->length) {
+                free(table->page[--i]);
+            }
+            free(table);
+            return false;
+        }
+    }
+    for (uint64_t i = 0; i < old->length; ++i) {
+        table->page[i] = old->page[i];
+        atomic_fetch_add_explicit(&table->page[i]->refs, 1,
+                                  memory_order_relaxed);
+    }
+    release_table(old);
+    p->table = table;
+    p->page = table->page;
+    p->length = length;
+    return true;
+}
+
+bool pages_share(pages_t *copy, pages_t *p, page_pool_t *pool) {
+    if (p->base != NULL && !split_block(p)) {
+        return false;
+    }
+    *copy = *p;
+    copy->pool = pool;
+    atomic_fetch_add_explicit(&p->table->refs, 1, memory_order_relaxed);
+    return true;
+}
+
+bool pages_prepare(pages_t *p) {
+    if (p->base != NULL) {
+        return true;
+    }
+    page_table_t *old = p->table;
+    if (atomic_load_explicit(&old->refs, memory_order_acquire) == 1) {
+        return true;
+    }
+    page_table_t *table = new_table(old->length);
+    if (!table) {
+        return false;
+    }
+    for (uint64_t i = 0; i < old->length; ++i) {
+        table->page[i] = old->page[i];
+        atomic_fetch_add_explicit(&table->page[i]->refs, 1,
+                                  memory_order_relaxed);
+    }
+    release_table(old);
+    p->table = table;
+    p->page = table->page;
+    return true;
+}
+
+page_t *pages_copy(pages_t *p, uint64_t index) {
+    page_pool_t *pool = p->pool;
+    page_t *page = pool->free;
+    pool->free = page->next;
+    --(pool->count);
+    page_t *old = p->page[index];
+    atomic_init(&page->refs, 1);
+    page->next = NULL;
+    memcpy(page->data, old->data, PAGE_BYTES);
+    p->page[index] = page;
+    /* Jeśli inna kopia zwolniła stronę w międzyczasie, wraca ona do puli. */
+    if (atomic_fetch_sub_explicit(&old->refs, 1, memory_order_acq_rel) == 1) {
+        old->next = pool->free;
+        pool->free = old;
+        ++(pool->count);
+    }
+    return page;
+}
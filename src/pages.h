@@ -0,0 +1,223 @@
+/** @file
+ * Interfejs tablic stron współdzielonych między kopiami gry.
+ *
+ * @author Marcin Malejky
+ */
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef GAMMA_PAGES_H
+#define GAMMA_PAGES_H
+
+#define PAGE_BYTES 16384 /**< Rozmiar danych jednej strony w bajtach. */
+#define PAGE_ALIGN 64 /**< Wyrównanie danych strony w bajtach. */
+
+/**
+ * Strona, czyli kawałek tablicy o stałym rozmiarze.
+ * Strona może należeć do wielu tabel stron. Wtedy jest tylko do odczytu,
+ * a zapis wymaga skopiowania jej do nowej strony.
+ */
+typedef struct page {
+    atomic_uint refs; /**< Liczba tabel stron wskazujących na stronę. */
+    struct page *next; /**< Następna strona w puli wolnych stron. */
+    _Alignas(PAGE_ALIGN) unsigned char data[PAGE_BYTES]; /**< Dane. */
+} page_t;
+
+/**
+ * Tabela stron jednej tablicy.
+ * Tabela może należeć do wielu kopii gry. Wtedy przed pierwszym zapisem jest
+ * kopiowana, a kopia zwiększa liczniki odwołań wszystkich stron.
+ */
+typedef struct {
+    atomic_uint refs; /**< Liczba tablic wskazujących na tabelę. */
+    uint64_t length; /**< Liczba stron. */
+    page_t *page[]; /**< Strony tablicy. */
+} page_table_t;
+
+/**
+ * Pula wolnych stron.
+ * Strony potrzebne do skopiowania współdzielonych stron w trakcie ruchu są
+ * rezerwowane przed ruchem, więc zapis nigdy nie wymaga alokacji pamięci.
+ */
+typedef struct {
+    page_t *free; /**< Lista wolnych stron. */
+    uint64_t count; /**< Liczba wolnych stron. */
+} page_pool_t;
+
+/**
+ * Tablica elementów o stałym rozmiarze.
+ * Dopóki tablica nie była współdzielona, jej dane leżą w jednym ciągłym
+ * bloku @p base i dostęp do elementu to jedno dodawanie. Pierwsze
+ * @ref pages_share dzieli blok na strony, które od tej chwili są
+ * kopiowane przy zapisie.
+ */
+typedef struct {
+    unsigned char *base; /**< Ciągły blok danych albo NULL, jeśli tablica
+                           *  jest podzielona na strony. */
+    page_t **page; /**< Strony tablicy, czyli @p table->page. */
+    page_table_t *table; /**< Tabela stron. */
+    page_pool_t *pool; /**< Pula stron używanych przy kopiowaniu. */
+    uint64_t per_page; /**< Liczba elementów na stronie. */
+    uint64_t length; /**< Liczba stron, także dla ciągłego bloku. */
+} pages_t;
+
+/** @brief Inicjalizuje pustą pulę stron.
+ * @param[out] pool – wskaźnik na pulę.
+ */
+void page_pool_init(page_pool_t *pool);
+
+/** @brief Zwalnia wszystkie strony puli.
+ * @param[in,out] pool – wskaźnik na pulę.
+ */
+void page_pool_free(page_pool_t *pool);
+
+/** @brief Zapewnia, że pula ma co najmniej @p n wolnych stron.
+ * @param[in,out] pool – wskaźnik na pulę,
+ * @param[in] n        – liczba stron,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy nie udało się
+ * zaalokować pamięci.
+ */
+bool page_pool_reserve(page_pool_t *pool, uint64_t n);
+
+/** @brief Inicjalizuje tablicę wypełnioną jednym bajtem.
+ * Tablica jest ciągłym blokiem aż do pierwszego @ref pages_share.
+ * @param[out] p          – wskaźnik na tablicę,
+ * @param[in] pool        – wskaźnik na pulę stron,
+ * @param[in] element     – rozmiar elementu w bajtach, potęga dwójki
+ *                          niewiększa od @ref PAGE_BYTES,
+ * @param[in] count       – liczba elementów,
+ * @param[in] fill        – bajt, którym jest wypełniana tablica,
+ * @return Wartość @p true, jeśli pomyślnie zaalokowano pamięć, a @p false
+ * w przeciwnym przypadku.
+ */
+bool pages_init(pages_t *p, page_pool_t *pool, uint32_t element,
+                uint64_t count, unsigned char fill);
+
+/** @brief Zwalnia tablicę.
+ * Strony współdzielone z innymi tablicami są zwalniane dopiero przez
+ * ostatnią z nich.
+ * @param[in,out] p – wskaźnik na tablicę.
+ */
+void pages_free(pages_t *p);
+
+/** @brief Powiększa tablicę.
+ * Nowe elementy są wypełnione bajtem @p fill.
+ * @param[in,out] p – wskaźnik na tablicę,
+ * @param[in] count – nowa liczba elementów,
+ * @param[in] fill  – bajt, którym są wypełniane nowe strony,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy nie udało się
+ * zaalokować pamięci.
+ */
+bool pages_grow(pages_t *p, uint64_t count, unsigned char fill);
+
+/** @brief Tworzy tablicę współdzielącą wszystkie strony z @p p.
+ * Kosztuje tyle, co zwiększenie jednego licznika. Jeśli @p p jest jeszcze
+ * ciągłym blokiem, najpierw jest raz dzielona na strony.
+ * @param[out] copy – wskaźnik na nową tablicę,
+ * @param[in,out] p – wskaźnik na kopiowaną tablicę,
+ * @param[in] pool  – wskaźnik na pulę stron nowej tablicy,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy nie udało się
+ * zaalokować pamięci. Wtedy @p p pozostaje bez zmian.
+ */
+bool pages_share(pages_t *copy, pages_t *p, page_pool_t *pool);
+
+/** @brief Przygotowuje tablicę do zapisu.
+ * Kopiuje tabelę stron, jeśli jest współdzielona. Każdy zapis przez
+ * @ref pages_write musi być poprzedzony tym wywołaniem od ostatniego
+ * @ref pages_share dla tej tablicy.
+ * @param[in,out] p – wskaźnik na tablicę,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy nie udało się
+ * zaalokować pamięci.
+ */
+bool pages_prepare(pages_t *p);
+
+/** @brief Podaje liczbę stron tablicy.
+ * @param[in] p – wskaźnik na tablicę,
+ * @return Liczba stron.
+ */
+static inline uint64_t pages_count(const pages_t *p) {
+    return p->length;
+}
+
+/** @brief Podaje numer strony elementu.
+ * Rozmiar elementu jest podawany przy każdym dostępie, aby po rozwinięciu
+ * funkcji przesunięcia były stałymi.
+ * @param[in] index   – numer elementu,
+ * @param[in] element – rozmiar elementu w bajtach,
+ * @return Numer strony.
+ */
+static inline uint64_t pages_index(uint64_t index, uint32_t element) {
+    return index / (PAGE_BYTES / element);
+}
+
+/** @brief Podaje przesunięcie elementu na jego stronie.
+ * @param[in] index   – numer elementu,
+ * @param[in] element – rozmiar elementu w bajtach,
+ * @return Przesunięcie w bajtach.
+ */
+static inline uint64_t pages_offset(uint64_t index, uint32_t element) {
+    return index % (PAGE_BYTES / element) * element;
+}
+
+/** @brief Podaje adres elementu do odczytu.
+ * @param[in] p       – wskaźnik na tablicę,
+ * @param[in] index   – numer elementu,
+ * @param[in] element – rozmiar elementu w bajtach,
+ * @return Adres elementu.
+ */
+static inline const void *pages_read(const pages_t *p, uint64_t index,
+                                     uint32_t element) {
+    if (p->base != NULL) {
+        return p->base + index * element;
+    }
+    return p->page[pages_index(index, element)]->data +
+           pages_offset(index, element);
+}
+
+/** @brief Sprawdza, czy element można zmienić bez kopiowania strony.
+ * @param[in] p       – wskaźnik na tablicę,
+ * @param[in] index   – numer elementu,
+ * @param[in] element – rozmiar elementu w bajtach,
+ * @return Wartość @p true, jeśli tablica jest ciągłym blokiem lub strona
+ * elementu należy tylko do tej tablicy, a @p false w przeciwnym przypadku.
+ */
+static inline bool pages_writable(const pages_t *p, uint64_t index,
+                                  uint32_t element) {
+    return p->base != NULL ||
+           (atomic_load_explicit(&p->table->refs,
+                                 memory_order_acquire) == 1 &&
+            atomic_load_explicit(&p->page[pages_index(index, element)]->refs,
+                                 memory_order_acquire) == 1);
+}
+
+/** @brief Kopiuje współdzieloną stronę do strony z puli.
+ * @param[in,out] p – wskaźnik na przygotowaną tablicę,
+ * @param[in] index – numer strony,
+ * @return Wskaźnik na nową stronę.
+ */
+page_t *pages_copy(pages_t *p, uint64_t index);
+
+/** @brief Podaje adres elementu do zapisu.
+ * Kopiuje stronę elementu, jeśli jest współdzielona. Wymaga
+ * przygotowania tablicy przez @ref pages_prepare i zarezerwowania stron
+ * w puli na wszystkie kopiowane strony.
+ * @param[in,out] p   – wskaźnik na tablicę,
+ * @param[in] index   – numer elementu,
+ * @param[in] element – rozmiar elementu w bajtach,
+ * @return Adres elementu.
+ */
+static inline void *pages_write(pages_t *p, uint64_t index,
+                                uint32_t element) {
+    if (p->base != NULL) {
+        return p->base + index * element;
+    }
+    page_t *page = p->page[pages_index(index, element)];
+    if (atomic_load_explicit(&page->refs, memory_order_acquire) != 1) {
+        page = pages_copy(p, pages_index(index, element));
+    }
+    return page->data + pages_offset(index, element);
+}
+
+#endif //GAMMA_PAGES_H
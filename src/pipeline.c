@@ -0,0 +1,412 @@
+/** @file
+ * Implementacja potokowego trybu wsadowego gry gamma.
+ *
+ * Paczki poleceń krążą między wątkiem czytającym, który wypełnia je
+ * rozebranymi poleceniami, a wątkiem wywołującym, który je wykonuje
+ * i oddaje. Wyniki trafiają do bloków stałego rozmiaru, które krążą między
+ * wątkiem wywołującym a wątkiem piszącym. Wątek wywołujący przekazuje blok
+ * do wypisania po każdej paczce i wtedy, gdy blok się zapełni, np. w trakcie
+ * wydruku planszy, więc pamięć na wyniki nie zależy od rozmiaru planszy.
+ * Każdą z czterech kolejek zapełnia jeden wątek i opróżnia jeden wątek.
+ * Wątek zasypia na eventfd tylko przy pustej kolejce, a budzi go ten, kto
+ * dopisze do niej element.
+ *
+ * @author Marcin Malejky
+ */
+
+#define _POSIX_C_SOURCE 200809L /**< Dostęp do sched_yield. */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "batch_mode.h"
+#include "command.h"
+#include "output.h"
+#include "pipeline.h"
+#include "ring.h"
+
+/**
+ * Rozebrane polecenie.
+ */
+typedef struct {
+    command_t c; /**< Polecenie. */
+    uint32_t line_number; /**< Numer wiersza polecenia. */
+    bool valid; /**< Czy wiersz jest poprawnym poleceniem. */
+} entry_t;
+
+/**
+ * Błąd w paczce.
+ */
+typedef struct {
+    size_t offset; /**< Długość wyników wypisywanych przed błędem. */
+    uint32_t line_number; /**< Numer wiersza z błędem. */
+} failure_t;
+
+/**
+ * Paczka poleceń.
+ */
+typedef struct {
+    entry_t entries[PIPELINE_BATCH]; /**< Polecenia. */
+    size_t count; /**< Liczba poleceń. */
+} batch_t;
+
+/**
+ * Blok wyników poleceń.
+ * Bufor wyników ma stały rozmiar i nigdy nie rośnie. Błędy należą do
+ * poleceń jednej paczki, więc jest ich najwyżej tyle, ile poleceń w paczce.
+ */
+typedef struct {
+    failure_t failures[PIPELINE_BATCH]; /**< Błędy w kolejności wierszy. */
+    size_t failure_count; /**< Liczba błędów. */
+    output_t results; /**< Wyniki poleceń. */
+} block_t;
+
+/**
+ * Kolejka paczek lub bloków, na której opróżniający ją wątek może zasnąć.
+ */
+typedef struct {
+    ring_t ring; /**< Wskaźniki na paczki lub bloki. */
+    ring_waker_t waker; /**< Budzik wątku opróżniającego. */
+} channel_t;
+
+/**
+ * Stan potoku.
+ */
+typedef struct {
+    gamma_t *g; /**< Gra. */
+    input_t *in; /**< Wejście. */
+    uint32_t line_number; /**< Numer ostatnio wczytanego wiersza. */
+    channel_t spare; /**< Wolne paczki dla wątku czytającego. */
+    channel_t parsed; /**< Paczki do wykonania. */
+    channel_t executed; /**< Bloki do wypisania. */
+    channel_t drained; /**< Wolne bloki dla wątku wywołującego. */
+    batch_t *batches[PIPELINE_BATCHES]; /**< Wszystkie paczki. */
+    block_t *blocks[PIPELINE_BATCHES]; /**< Wszystkie bloki. */
+    block_t *block; /**< Blok wypełniany przez wątek wywołujący. */
+    output_t out; /**< Standardowe wyjście. */
+    pthread_t reader; /**< Wątek czytający. */
+    pthread_t writer; /**< Wątek piszący. */
+} pipeline_t;
+
+/** @brief Tworzy pustą kolejkę paczek.
+ * @param[out] ch – wskaźnik na kolejkę,
+ * @return Wartość @p true, jeśli się udało, a @p false w przeciwnym
+ * przypadku.
+ */
+static bool channel_init(channel_t *ch);
+
+/** @brief Zwalnia kolejkę paczek.
+ * @param[in,out] ch – wskaźnik na kolejkę.
+ */
+static void channel_free(channel_t *ch);
+
+/** @brief Dopisuje element do kolejki i budzi wątek, który na niego czeka.
+ * @param[in,out] ch – wskaźnik na kolejkę,
+ * @param[in] item   – wskaźnik na paczkę lub blok albo NULL na koniec pracy.
+ */
+static void channel_put(channel_t *ch, void *item);
+
+/** @brief Wyjmuje element z kolejki, czekając na niego, gdy kolejka jest
+ * pusta.
+ * @param[in,out] ch    – wskaźnik na kolejkę,
+ * @param[in,out] flush – wyjście do opróżnienia przed czekaniem lub NULL,
+ * @return Wskaźnik na paczkę lub blok albo NULL na koniec pracy.
+ */
+static void *channel_get(channel_t *ch, output_t *flush);
+
+/** @brief Dopisuje wiersz do paczki.
+ * Pełną paczkę przekazuje do wykonania i bierze następną.
+ * @param[in,out] p – wskaźnik na stan potoku,
+ * @param[in,out] b – wskaźnik na paczkę,
+ * @param[in] line  – wiersz,
+ * @param[in] size  – długość wiersza,
+ * @return Wskaźnik na paczkę, do której należy dopisywać dalej.
+ */
+static batch_t *add_line(pipeline_t *p, batch_t *b, const char *line,
+                         size_t size);
+
+/** @brief Wczytuje i rozbiera wiersze wejścia do jego końca.
+ * @param[in,out] arg – wskaźnik na stan potoku,
+ * @return NULL.
+ */
+static void *read_lines(void *arg);
+
+/** @brief Wypisuje wyniki paczek aż do końca pracy.
+ * @param[in,out] arg – wskaźnik na stan potoku,
+ * @return NULL.
+ */
+static void *write_results(void *arg);
+
+/** @brief Przekazuje wypełniany blok do wypisania i bierze wolny blok.
+ * @param[in,out] p – wskaźnik na stan potoku.
+ */
+static void hand_off(pipeline_t *p);
+
+/** @brief Dopisuje kawałek wydruku planszy do bloku wyników.
+ * Zapełnione bloki przekazuje do wypisania.
+ * @param[in,out] arg – wskaźnik na stan potoku,
+ * @param[in] data    – kawałek wydruku,
+ * @param[in] size    – długość kawałka,
+ * @return Wartość @p true.
+ */
+static bool stream_results(void *arg, const char *data, size_t size);
+
+/** @brief Wykonuje polecenie, dopisując jego wynik do bloku wyników.
+ * @param[in,out] p – wskaźnik na stan potoku,
+ * @param[in] c     – wskaźnik na polecenie,
+ * @return Wartość @p true, jeśli polecenie zostało wykonane, a @p false,
+ * gdy nie jest poleceniem gry.
+ */
+static bool execute(pipeline_t *p, const command_t *c);
+
+/** @brief Wykonuje polecenia paczek aż do końca pracy.
+ * @param[in,out] p – wskaźnik na stan potoku.
+ */
+static void execute_batches(pipeline_t *p);
+
+/** @brief Przygotowuje potok.
+ * @param[out] p          – wskaźnik na stan potoku,
+ * @param[in] g           – wskaźnik na grę,
+ * @param[in] in          – wskaźnik na wejście,
+ * @param[in] line_number – numer poprzednio wczytanego wiersza,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy nie udało się
+ * zaalokować pamięci lub utworzyć eventfd.
+ */
+static bool pipeline_init(pipeline_t *p, gamma_t *g, input_t *in,
+                          uint32_t line_number);
+
+/** @brief Wypisuje pozostałe wyniki i zwalnia potok.
+ * @param[in,out] p – wskaźnik na stan potoku.
+ */
+static void pipeline_free(pipeline_t *p);
+
+static bool channel_init(channel_t *ch) {
+    bool waker = ring_waker_init(&ch->waker);
+    /* Poza wszystkimi paczkami mieści się też znacznik końca pracy. */
+    return ring_init(&ch->ring, sizeof(void *), 2 * PIPELINE_BATCHES) &&
+           waker;
+}
+
+static void channel_free(channel_t *ch) {
+    ring_free(&ch->ring);
+    ring_waker_free(&ch->waker);
+}
+
+static void channel_put(channel_t *ch, void *item) {
+    while (!ring_push(&ch->ring, &item)) {
+        sched_yield();
+    }
+    ring_wake(&ch->waker);
+}
+
+static void *channel_get(channel_t *ch, output_t *flush) {
+    void *item;
+    while (!ring_pop(&ch->ring, &item)) {
+        if (flush != NULL && flush->length > 0) {
+            output_flush(flush);
+            continue;
+        }
+        ring_prepare_sleep(&ch->waker);
+        if (!ring_empty(&ch->ring)) {
+            ring_cancel_sleep(&ch->waker);
+        } else if (!ring_sleep(&ch->waker)) {
+            sched_yield();
+        }
+    }
+    return item;
+}
+
+static batch_t *add_line(pipeline_t *p, batch_t *b, const char *line,
+                         size_t size) {
+    ++p->line_number;
+    entry_t *e = &b->entries[b->count];
+    command_status_t status = command_parse(line, size, &e->c);
+    if (status == COMMAND_OMIT) {
+        return b;
+    }
+    e->line_number = p->line_number;
+    e->valid = status == COMMAND_OK;
+    if (++b->count == PIPELINE_BATCH) {
+        channel_put(&p->parsed, b);
+        b = channel_get(&p->spare, NULL);
+    }
+    return b;
+}
+
+static void *read_lines(void *arg) {
+    pipeline_t *p = arg;
+    batch_t *b = channel_get(&p->spare, NULL);
+    const char *line;
+    size_t size;
+    for (;;) {
+        while (input_next(p->in, &line, &size)) {
+            b = add_line(p, b, line, size);
+        }
+        /* Przed czekaniem na wejście oddajemy to, co już wczytano. */
+        if (b->count > 0) {
+            channel_put(&p->parsed, b);
+            b = channel_get(&p->spare, NULL);
+        }
+        if (!input_fill(p->in)) {
+            break;
+        }
+    }
+    /* Na końcu wejścia zostaje najwyżej niepełny wiersz. */
+    if (input_line(p->in, &line, &size)) {
+        b = add_line(p, b, line, size);
+    }
+    channel_put(&p->parsed, b);
+    channel_put(&p->parsed, NULL);
+    return NULL;
+}
+
+static void *write_results(void *arg) {
+    pipeline_t *p = arg;
+    block_t *k;
+    while ((k = channel_get(&p->executed, &p->out)) != NULL) {
+        const char *data = k->results.data;
+        size_t done = 0;
+        for (size_t i = 0; i < k->failure_count; ++i) {
+            output_write(&p->out, data + done, k->failures[i].offset - done);
+            done = k->failures[i].offset;
+            output_flush(&p->out);
+            fprintf(stderr, "ERROR %d\n", k->failures[i].line_number);
+        }
+        output_write(&p->out, data + done, k->results.length - done);
+        k->failure_count = 0;
+        k->results.length = 0;
+        channel_put(&p->drained, k);
+    }
+    return NULL;
+}
+
+static void hand_off(pipeline_t *p) {
+    channel_put(&p->executed, p->block);
+    p->block = channel_get(&p->drained, NULL);
+}
+
+static bool stream_results(void *arg, const char *data, size_t size) {
+    pipeline_t *p = arg;
+    while (size > 0) {
+        output_t *results = &p->block->results;
+        size_t n = results->capacity - results->length;
+        if (n > size) {
+            n = size;
+        }
+        output_write(results, data, n);
+        data += n;
+        size -= n;
+        if (results->length == results->capacity) {
+            hand_off(p);
+        }
+    }
+    return true;
+}
+
+static bool execute(pipeline_t *p, const command_t *c) {
+    if (c->kind == 'p') {
+        return gamma_board_write(p->g, stream_results, p);
+    }
+    /* Wynik innego polecenia to jeden krótki wiersz. */
+    if (p->block->results.capacity - p->block->results.length <
+        PIPELINE_LINE) {
+        hand_off(p);
+    }
+    return command_execute(p->g, c, &p->block->results, 0);
+}
+
+static void execute_batches(pipeline_t *p) {
+    batch_t *b;
+    p->block = channel_get(&p->drained, NULL);
+    while ((b = channel_get(&p->parsed, NULL)) != NULL) {
+        for (size_t i = 0; i < b->count; ++i) {
+            entry_t *e = &b->entries[i];
+            if (!e->valid || !execute(p, &e->c)) {
+                block_t *k = p->block;
+                failure_t *f = &k->failures[k->failure_count++];
+                f->offset = k->results.length;
+                f->line_number = e->line_number;
+            }
+        }
+        b->count = 0;
+        channel_put(&p->spare, b);
+        hand_off(p);
+    }
+    channel_put(&p->executed, p->block);
+    channel_put(&p->executed, NULL);
+}
+
+static bool pipeline_init(pipeline_t *p, gamma_t *g, input_t *in,
+                          uint32_t line_number) {
+    p->g = g;
+    p->in = in;
+    p->line_number = line_number;
+    bool ok = channel_init(&p->spare);
+    ok = channel_init(&p->parsed) && ok;
+    ok = channel_init(&p->executed) && ok;
+    ok = channel_init(&p->drained) && ok;
+    for (size_t i = 0; i < PIPELINE_BATCHES; ++i) {
+        p->batches[i] = malloc(sizeof(batch_t));
+        p->blocks[i] = malloc(sizeof(block_t));
+        if (p->blocks[i] != NULL) {
+            p->blocks[i]->failure_count = 0;
+            output_init(&p->blocks[i]->results, OUTPUT_MEMORY,
+                        OUTPUT_CAPACITY);
+        }
+        if (p->batches[i] == NULL || p->blocks[i] == NULL ||
+            p->blocks[i]->results.capacity == 0) {
+            ok = false;
+            continue;
+        }
+        p->batches[i]->count = 0;
+        if (ok) {
+            channel_put(&p->spare, p->batches[i]);
+            channel_put(&p->drained, p->blocks[i]);
+        }
+    }
+    output_init(&p->out, STDOUT_FILENO, OUTPUT_CAPACITY);
+    return ok;
+}
+
+static void pipeline_free(pipeline_t *p) {
+    output_free(&p->out);
+    for (size_t i = 0; i < PIPELINE_BATCHES; ++i) {
+        free(p->batches[i]);
+        if (p->blocks[i] != NULL) {
+            output_free(&p->blocks[i]->results);
+            free(p->blocks[i]);
+        }
+    }
+    channel_free(&p->drained);
+    channel_free(&p->executed);
+    channel_free(&p->parsed);
+    channel_free(&p->spare);
+}
+
+void pipeline_mode(gamma_t *g, input_t *in, uint32_t *line_number) {
+    /* Wyniki wypisane wcześniej przez printf muszą poprzedzać wyniki
+     * wypisywane bezpośrednio do deskryptora. */
+    fflush(stdout);
+    pipeline_t p;
+    if (!pipeline_init(&p, g, in, *line_number) ||
+        pthread_create(&p.writer, NULL, write_results, &p) != 0) {
+        pipeline_free(&p);
+        batch_mode(g, in, line_number);
+        return;
+    }
+    if (pthread_create(&p.reader, NULL, read_lines, &p) != 0) {
+        channel_put(&p.executed, NULL);
+        pthread_join(p.writer, NULL);
+        pipeline_free(&p);
+        batch_mode(g, in, line_number);
+        return;
+    }
+
+    execute_batches(&p);
+    pthread_join(p.reader, NULL);
+    pthread_join(p.writer, NULL);
+    *line_number = p.line_number;
+    pipeline_free(&p);
+}
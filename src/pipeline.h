@@ -0,0 +1,39 @@
+/** @file
+ * Interfejs potokowego trybu wsadowego gry gamma.
+ *
+ * Wątek czytający rozbiera wiersze wejścia, wątek wywołujący wykonuje
+ * polecenia, a wątek piszący wypisuje wyniki. Wątki przekazują sobie całe
+ * paczki poleceń przez ograniczone kolejki bez blokad, więc czytanie
+ * i wypisywanie odbywa się w tym samym czasie co obliczenia silnika.
+ * Wyjście jest takie samo jak w trybie wsadowym.
+ *
+ * @author Marcin Malejky
+ */
+
+#include <stdint.h>
+#include "gamma.h"
+#include "input.h"
+
+#ifndef GAMMA_PIPELINE_H
+#define GAMMA_PIPELINE_H
+
+#define PIPELINE_BATCH 4096 /**< Największa liczba poleceń w paczce. */
+#define PIPELINE_BATCHES 16 /**< Liczba paczek i liczba bloków wyników,
+                             * potęga dwójki. */
+#define PIPELINE_LINE 128 /**< Miejsce w bloku wyników na wynik polecenia
+                           * innego niż wydruk planszy. */
+
+/** @brief Rozpoczyna potokowy tryb wsadowy.
+ * Działa jak @ref batch_mode. Paczka jest przekazywana dalej, gdy jest
+ * pełna lub gdy wątek czytający ma czekać na dalsze wejście, a wątek
+ * piszący wypisuje wyniki, zanim zacznie czekać na następny blok wyników.
+ * Wydruki planszy przechodzą przez bloki stałego rozmiaru. Gdy nie
+ * udało się uruchomić wątków, polecenia są wykonywane przez
+ * @ref batch_mode.
+ * @param[in,out] g           - wskaźnik na strukturę przechowującą stan gry,
+ * @param[in,out] in          - wskaźnik na wejście,
+ * @param[in,out] line_number - wskaźnik na numer poprzednio wczytanej linii,
+ */
+void pipeline_mode(gamma_t *g, input_t *in, uint32_t *line_number);
+
+#endif //GAMMA_PIPELINE_H
@@ -0,0 +1,506 @@
+/** @file
+ * Implementacja rozgrywek Monte Carlo do wyboru ruchu gracza komputerowego.
+ *
+ * @author Marcin Malejky
+ */
+
+#define _POSIX_C_SOURCE 200809L /**< Dostęp do clock_gettime i sysconf. */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "gamma.h"
+#include "playout.h"
+
+#define PLAYOUT_DEFAULT_COUNT 2000 /**< Domyślna liczba rozgrywek. */
+#define PLAYOUT_MAX_THREADS 64 /**< Największa liczba wątków. */
+#define PLAYOUT_CANDIDATES 1024 /**< Największa liczba ruchów początkowych. */
+#define PLAYOUT_TRIES 8 /**< Liczba prób ruchu na losowym polu. */
+#define PLAYOUT_GOLDEN_ODDS 32 /**< Odwrotność szansy na złoty ruch, gdy
+                                 * gracz może zrobić zwykły ruch. */
+#define NOBODY 0 /**< Domyślny posiadacz pustego pola. */
+
+/**
+ * Stan jednego wątku rozgrywek.
+ * Wątek zmienia tylko własne kopie gry i własną pamięć, więc wątki nie
+ * potrzebują synchronizacji.
+ */
+typedef struct {
+    gamma_t *base; /**< Kopia gry w pozycji początkowej. */
+    gamma_t *work; /**< Kopia gry, na której są rozgrywane gry. */
+    const playout_stat_t *moves; /**< Ruchy początkowe, tylko do odczytu. */
+    uint64_t count; /**< Liczba ruchów początkowych. */
+    uint32_t player; /**< Numer gracza wykonującego ruch początkowy. */
+    playout_policy_t policy; /**< Sposób wyboru ruchów. */
+    uint64_t first; /**< Numer pierwszej rozgrywki wątku. */
+    uint64_t step; /**< Odstęp między numerami rozgrywek wątku. */
+    uint64_t playouts; /**< Liczba rozgrywek do rozegrania. */
+    uint64_t done; /**< Liczba zakończonych rozgrywek. */
+    uint64_t random; /**< Stan generatora liczb losowych. */
+    void *arena; /**< Pamięć wątku na poniższe tablice. */
+    uint64_t *visits; /**< Liczby rozgrywek ruchów początkowych. */
+    uint64_t *wins; /**< Liczby wygranych ruchów początkowych. */
+    gamma_field_t *buffer; /**< Bufor na wyliczane ruchy. */
+} worker_t;
+
+/** @brief Dopisuje ruch do losowej próbki ruchów.
+ * Losowanie z rezerwuarem: po obejrzeniu @p *seen ruchów każdy z nich jest
+ * w próbce z tym samym prawdopodobieństwem.
+ * @param[in,out] result – wskaźnik na wynik z próbką ruchów,
+ * @param[in,out] seen   – wskaźnik na liczbę obejrzanych ruchów,
+ * @param[in,out] random – wskaźnik na stan generatora,
+ * @param[in] field      – pole ruchu,
+ * @param[in] golden     – czy ruch jest złotym ruchem.
+ */
+static void sample_move(playout_result_t *result, uint64_t *seen,
+                        uint64_t *random, gamma_field_t field, bool golden);
+
+/** @brief Zapisuje próbkę ruchów gracza w wyniku.
+ * @param[in,out] g      – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player     – numer gracza,
+ * @param[in,out] random – wskaźnik na stan generatora,
+ * @param[out] result    – wskaźnik na wynik,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy nie udało się
+ * zaalokować pamięci.
+ */
+static bool collect_moves(gamma_t *g, uint32_t player, uint64_t *random,
+                          playout_result_t *result);
+
+/** @brief Przygotowuje wątek do rozgrywek.
+ * @param[out] w     – wskaźnik na stan wątku,
+ * @param[in,out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] count  – liczba ruchów początkowych,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy nie udało się
+ * zaalokować pamięci.
+ */
+static bool worker_init(worker_t *w, gamma_t *g, uint64_t count);
+
+/** @brief Zwalnia pamięć wątku.
+ * @param[in,out] w – wskaźnik na stan wątku.
+ */
+static void worker_free(worker_t *w);
+
+/** @brief Przywraca kopię roboczą do pozycji początkowej.
+ * Cofa ruchy rozgrywki. Jeśli dziennik nie zapisał wszystkich ruchów, na
+ * przykład z braku pamięci, tworzy nową kopię pozycji początkowej.
+ * @param[in,out] w – wskaźnik na stan wątku,
+ * @param[in] made  – liczba ruchów rozgrywki,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy nie udało się
+ * zaalokować pamięci.
+ */
+static bool rewind(worker_t *w, uint64_t made);
+
+/** @brief Sprawdza, czy pole sąsiaduje z polem gracza.
+ * @param[in] g      – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player – numer gracza,
+ * @param[in] x      – numer kolumny,
+ * @param[in] y      – numer wiersza,
+ * @return Wartość @p true, jeśli pole sąsiaduje z polem gracza, a @p false
+ * w przeciwnym przypadku.
+ */
+static bool bordering(gamma_t *g, uint32_t player, uint32_t x, uint32_t y);
+
+/** @brief Wykonuje ruch na losowym legalnym polu z wyliczonych ruchów.
+ * @param[in,out] g      – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player     – numer gracza,
+ * @param[in] golden     – czy wykonać złoty ruch,
+ * @param[in,out] random – wskaźnik na stan generatora,
+ * @param[out] buffer    – bufor na @ref PLAYOUT_BUFFER pól,
+ * @return Wartość @p true, jeśli ruch został wykonany, a @p false
+ * w przeciwnym przypadku.
+ */
+static bool listed_move(gamma_t *g, uint32_t player, bool golden,
+                        uint64_t *random, gamma_field_t *buffer);
+
+/** @brief Rozgrywa jedną grę od ruchu początkowego.
+ * @param[in,out] w – wskaźnik na stan wątku,
+ * @param[in] index – numer ruchu początkowego,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy nie udało się
+ * zaalokować pamięci.
+ */
+static bool play(worker_t *w, uint64_t index);
+
+/** @brief Rozgrywa wszystkie gry wątku.
+ * @param[in,out] arg – wskaźnik na stan wątku,
+ * @return NULL.
+ */
+static void *worker_run(void *arg);
+
+uint64_t playout_random(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+uint64_t playout_seed(uint64_t seed, uint64_t index) {
+    /* Jeden krok splitmix64 rozprasza bliskie ziarna. */
+    uint64_t z = seed + (index + 1) * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    return z != 0 ? z : 1;
+}
+
+double playout_now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double) t.tv_sec + (double) t.tv_nsec / 1e9;
+}
+
+static void sample_move(playout_result_t *result, uint64_t *seen,
+                        uint64_t *random, gamma_field_t field, bool golden) {
+    uint64_t slot = (*seen)++;
+    if (slot >= PLAYOUT_CANDIDATES) {
+        slot = playout_random(random) % *seen;
+        if (slot >= PLAYOUT_CANDIDATES) {
+            return;
+        }
+    } else {
+        ++(result->count);
+    }
+    playout_stat_t move = {field, golden, 0, 0};
+    result->moves[slot] = move;
+}
+
+static bool collect_moves(gamma_t *g, uint32_t player, uint64_t *random,
+                          playout_result_t *result) {
+    gamma_field_t buffer[PLAYOUT_BUFFER];
+    result->moves = malloc(sizeof(playout_stat_t) * PLAYOUT_CANDIDATES);
+    if (!result->moves) {
+        return false;
+    }
+    uint64_t seen = 0;
+    for (int golden = 0; golden <= 1; ++golden) {
+        uint64_t cursor = 0;
+        uint64_t n;
+        do {
+            n = golden ? gamma_legal_golden_moves_next(g, player, &cursor,
+                                                       buffer, PLAYOUT_BUFFER)
+                       : gamma_legal_moves_next(g, player, &cursor,
+                                                buffer, PLAYOUT_BUFFER);
+            for (uint64_t i = 0; i < n; ++i) {
+                sample_move(result, &seen, random, buffer[i], golden);
+            }
+        } while (n == PLAYOUT_BUFFER);
+    }
+    return true;
+}
+
+static bool worker_init(worker_t *w, gamma_t *g, uint64_t count) {
+    /* Jedna alokacja na wszystkie tablice wątku. */
+    w->arena = calloc(1, sizeof(uint64_t) * 2 * count +
+                         sizeof(gamma_field_t) * PLAYOUT_BUFFER);
+    w->base = gamma_fork(g);
+    w->work = NULL;
+    if (!w->arena || !w->base) {
+        return false;
+    }
+    w->visits = w->arena;
+    w->wins = w->visits + count;
+    w->buffer = (gamma_field_t *) (w->wins + count);
+    w->count = count;
+    w->done = 0;
+    return true;
+}
+
+static void worker_free(worker_t *w) {
+    gamma_delete(w->work);
+    gamma_delete(w->base);
+    free(w->arena);
+}
+
+static bool rewind(worker_t *w, uint64_t made) {
+    uint64_t undone = 0;
+    while (undone < made && gamma_undo(w->work)) {
+        ++undone;
+    }
+    if (undone == made) {
+        return true;
+    }
+    gamma_delete(w->work);
+    w->work = gamma_fork(w->base);
+    if (!w->work) {
+        return false;
+    }
+    gamma_set_journal(w->work, true);
+    return true;
+}
+
+static bool bordering(gamma_t *g, uint32_t player, uint32_t x, uint32_t y) {
+    return (x > 0 && get_owner(g, x - 1, y) == player) ||
+           (x + 1 < g->width && get_owner(g, x + 1, y) == player) ||
+           (y > 0 && get_owner(g, x, y - 1) == player) ||
+           (y + 1 < g->height && get_owner(g, x, y + 1) == player);
+}
+
+static bool listed_move(gamma_t *g, uint32_t player, bool golden,
+                        uint64_t *random, gamma_field_t *buffer) {
+    gamma_field_t chosen = {0, 0};
+    uint64_t seen = 0;
+    uint64_t cursor = 0;
+    uint64_t n;
+    do {
+        n = golden ? gamma_legal_golden_moves_next(g, player, &cursor,
+                                                   buffer, PLAYOUT_BUFFER)
+                   : gamma_legal_moves_next(g, player, &cursor,
+                                            buffer, PLAYOUT_BUFFER);
+        for (uint64_t i = 0; i < n; ++i) {
+            if (playout_random(random) % ++seen == 0) {
+                chosen = buffer[i];
+            }
+        }
+    } while (n == PLAYOUT_BUFFER);
+    if (seen == 0) {
+        return false;
+    }
+    return golden ? gamma_golden_move(g, player, chosen.x, chosen.y)
+                  : gamma_move(g, player, chosen.x, chosen.y);
+}
+
+bool playout_policy_move(gamma_t *g, uint32_t player, playout_policy_t policy,
+                         uint64_t *random, gamma_field_t *buffer) {
+    bool normal = gamma_free_fields(g, player) > 0;
+    bool golden = gamma_golden_possible(g, player);
+    if (golden && (!normal ||
+                   playout_random(random) % PLAYOUT_GOLDEN_ODDS == 0)) {
+        for (int i = 0; i < PLAYOUT_TRIES; ++i) {
+            uint64_t r = playout_random(random);
+            if (gamma_golden_move(g, player, r % g->width,
+                                  (r >> 32) % g->height)) {
+                return true;
+            }
+        }
+    }
+    if (normal) {
+        bool spare = false;
+        gamma_field_t fallback = {0, 0};
+        for (int i = 0; i < PLAYOUT_TRIES; ++i) {
+            uint64_t r = playout_random(random);
+            uint32_t x = r % g->width;
+            uint32_t y = (r >> 32) % g->height;
+            if (policy == PLAYOUT_HEURISTIC &&
+                get_owner(g, x, y) == NOBODY && !bordering(g, player, x, y)) {
+                /* Pole zakładające nowy obszar zostaje na później. */
+                if (!spare) {
+                    spare = true;
+                    fallback.x = x;
+                    fallback.y = y;
+                }
+                continue;
+            }
+            if (gamma_move(g, player, x, y)) {
+                return true;
+            }
+        }
+        if ((spare && gamma_move(g, player, fallback.x, fallback.y)) ||
+            listed_move(g, player, false, random, buffer)) {
+            return true;
+        }
+    }
+    return golden && listed_move(g, player, true, random, buffer);
+}
+
+uint64_t playout_finish(gamma_t *g, uint32_t player, playout_policy_t policy,
+                        uint64_t *random, gamma_field_t *buffer) {
+    uint64_t made = 0;
+    uint32_t passes = 0;
+    while (passes < g->player_count) {
+        if (playout_policy_move(g, player, policy, random, buffer)) {
+            ++made;
+            passes = 0;
+        } else {
+            ++passes;
+        }
+        player = player % g->player_count + 1;
+    }
+    return made;
+}
+
+uint64_t playout_score(gamma_t *g, uint32_t player) {
+    uint64_t own = gamma_busy_fields(g, player);
+    uint64_t best = 0;
+    for (uint32_t i = 1; i <= g->player_count; ++i) {
+        if (i != player && gamma_busy_fields(g, i) > best) {
+            best = gamma_busy_fields(g, i);
+        }
+    }
+    return own > best ? 2 : own == best ? 1 : 0;
+}
+
+static bool play(worker_t *w, uint64_t index) {
+    gamma_t *g = w->work;
+    const playout_stat_t *root = &w->moves[index];
+    uint32_t x = root->field.x;
+    uint32_t y = root->field.y;
+    bool done = root->golden ? gamma_golden_move(g, w->player, x, y)
+                             : gamma_move(g, w->player, x, y);
+    if (!done) {
+        /* Ruch początkowy jest legalny, więc zabrakło pamięci. */
+        return rewind(w, 0);
+    }
+    uint32_t next = w->player % g->player_count + 1;
+    uint64_t made = 1 + playout_finish(g, next, w->policy, &w->random,
+                                       w->buffer);
+    ++(w->visits[index]);
+    w->wins[index] += playout_score(g, w->player);
+    ++(w->done);
+    return rewind(w, made);
+}
+
+static void *worker_run(void *arg) {
+    worker_t *w = arg;
+    w->work = gamma_fork(w->base);
+    if (!w->work) {
+        return NULL;
+    }
+    gamma_set_journal(w->work, true);
+    for (uint64_t i = 0; i < w->playouts; ++i) {
+        if (!play(w, (w->first + i * w->step) % w->count)) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+void playout_defaults(playout_config_t *config) {
+    config->threads = 0;
+    config->playouts = PLAYOUT_DEFAULT_COUNT;
+    config->seed = (uint64_t) time(NULL);
+    config->policy = PLAYOUT_HEURISTIC;
+}
+
+bool playout_run(gamma_t *g, uint32_t player, const playout_config_t *config,
+                 playout_result_t *result) {
+    if (!g || !config || !result || player < 1 || player > g->player_count) {
+        return false;
+    }
+    result->moves = NULL;
+    result->count = 0;
+    result->playouts = 0;
+    result->seconds = 0;
+    uint64_t random = playout_seed(config->seed, 0);
+    if (!collect_moves(g, player, &random, result)) {
+        return false;
+    }
+    if (result->count == 0) {
+        return true;
+    }
+    uint32_t threads = config->threads;
+    if (threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (uint32_t) cpus : 1;
+    }
+    if (threads > PLAYOUT_MAX_THREADS) {
+        threads = PLAYOUT_MAX_THREADS;
+    }
+    if (threads > config->playouts) {
+        threads = config->playouts > 0 ? config->playouts : 1;
+    }
+    worker_t workers[PLAYOUT_MAX_THREADS];
+    pthread_t ids[PLAYOUT_MAX_THREADS];
+    bool started[PLAYOUT_MAX_THREADS];
+    bool ok = true;
+    uint32_t ready = 0;
+    /* Kopie są tworzone przed uruchomieniem wątków, bo tworzenie kopii
+     * zmienia oryginał. */
+    for (; ready < threads; ++ready) {
+        worker_t *w = &workers[ready];
+        if (!worker_init(w, g, result->count)) {
+            worker_free(w);
+            ok = false;
+            break;
+        }
+        w->moves = result->moves;
+        w->player = player;
+        w->policy = config->policy;
+        w->first = ready;
+        w->step = threads;
+        w->playouts = config->playouts / threads +
+                      (ready < config->playouts % threads);
+        w->random = playout_seed(config->seed, ready + 1);
+    }
+    double start = playout_now();
+    for (uint32_t i = 0; ok && i < threads; ++i) {
+        started[i] = pthread_create(&ids[i], NULL, worker_run,
+                                    &workers[i]) == 0;
+        if (!started[i]) {
+            /* Bez nowego wątku rozgrywki są grane w wątku wywołującym. */
+            worker_run(&workers[i]);
+        }
+    }
+    for (uint32_t i = 0; ok && i < threads; ++i) {
+        if (started[i]) {
+            pthread_join(ids[i], NULL);
+        }
+    }
+    result->seconds = playout_now() - start;
+    for (uint32_t i = 0; i < ready; ++i) {
+        worker_t *w = &workers[i];
+        for (uint64_t j = 0; ok && j < result->count; ++j) {
+            result->moves[j].visits += w->visits[j];
+            result->moves[j].wins += w->wins[j];
+        }
+        result->playouts += w->done;
+        worker_free(w);
+    }
+    if (!ok) {
+        playout_result_free(result);
+    }
+    return ok;
+}
+
+void playout_result_free(playout_result_t *result) {
+    if (result != NULL) {
+        free(result->moves);
+        result->moves = NULL;
+        result->count = 0;
+    }
+}
+
+const playout_stat_t *playout_best(const playout_result_t *result) {
+    const playout_stat_t *best = NULL;
+    for (uint64_t i = 0; i < result->count; ++i) {
+        const playout_stat_t *move = &result->moves[i];
+        /* Porównanie ilorazów wins / visits bez dzielenia. */
+        if (move->visits > 0 &&
+            (!best || move->wins * best->visits >
+                      best->wins * move->visits)) {
+            best = move;
+        }
+    }
+    return best;
+}
+
+double playout_rate(const playout_result_t *result) {
+    if (result->seconds <= 0) {
+        return 0;
+    }
+    return (double) result->playouts / result->seconds;
+}
+
+bool playout_move(gamma_t *g, uint32_t player, const playout_config_t *config,
+                  playout_stat_t *move, double *rate) {
+    playout_result_t result;
+    if (!playout_run(g, player, config, &result)) {
+        return false;
+    }
+    const playout_stat_t *best = playout_best(&result);
+    bool done = false;
+    if (best != NULL) {
+        done = best->golden
+               ? gamma_golden_move(g, player, best->field.x, best->field.y)
+               : gamma_move(g, player, best->field.x, best->field.y);
+        if (done && move != NULL) {
+            *move = *best;
+        }
+    }
+    if (rate != NULL) {
+        *rate = playout_rate(&result);
+    }
+    playout_result_free(&result);
+    return done;
+}
@@ -0,0 +1,173 @@
+/** @file
+ * Interfejs rozgrywek Monte Carlo do wyboru ruchu gracza komputerowego.
+ *
+ * @author Marcin Malejky
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "moves.h"
+
+#ifndef GAMMA_PLAYOUT_H
+#define GAMMA_PLAYOUT_H
+
+#define PLAYOUT_BUFFER 256 /**< Rozmiar bufora przy wyliczaniu ruchów. */
+
+struct gamma;
+
+/**
+ * Sposób wyboru ruchów w trakcie rozgrywki.
+ */
+typedef enum {
+    /** Losowy legalny ruch. */
+    PLAYOUT_RANDOM,
+    /** Losowy ruch, ale z pierwszeństwem pól sąsiadujących z polami gracza,
+     * które nie zużywają limitu obszarów. */
+    PLAYOUT_HEURISTIC
+} playout_policy_t;
+
+/**
+ * Ustawienia rozgrywek.
+ */
+typedef struct {
+    uint32_t threads; /**< Liczba wątków, 0 oznacza liczbę procesorów. */
+    uint64_t playouts; /**< Łączna liczba rozgrywek. */
+    uint64_t seed; /**< Ziarno generatora liczb losowych. */
+    playout_policy_t policy; /**< Sposób wyboru ruchów. */
+} playout_config_t;
+
+/**
+ * Statystyki jednego ruchu z pozycji początkowej.
+ */
+typedef struct {
+    gamma_field_t field; /**< Pole ruchu. */
+    bool golden; /**< Czy ruch jest złotym ruchem. */
+    uint64_t visits; /**< Liczba rozgrywek zaczętych tym ruchem. */
+    uint64_t wins; /**< Liczba wygranych w połówkach: 2 za wygraną,
+                     * 1 za remis. */
+} playout_stat_t;
+
+/**
+ * Wynik rozgrywek.
+ */
+typedef struct {
+    playout_stat_t *moves; /**< Statystyki ruchów. */
+    uint64_t count; /**< Liczba ruchów. */
+    uint64_t playouts; /**< Liczba zakończonych rozgrywek. */
+    double seconds; /**< Czas rozgrywek w sekundach. */
+} playout_result_t;
+
+/** @brief Podaje domyślne ustawienia rozgrywek.
+ * @param[out] config – wskaźnik na ustawienia.
+ */
+void playout_defaults(playout_config_t *config);
+
+/** @brief Rozgrywa losowe gry od bieżącej pozycji.
+ * Każda rozgrywka zaczyna się jednym z ruchów gracza @p player, po którym
+ * gracze wykonują ruchy według @p config->policy aż do końca gry. Ruchy
+ * początkowe są wybierane po kolei, więc każdy dostaje podobną liczbę
+ * rozgrywek. Przy bardzo wielu legalnych ruchach rozgrywany jest losowy
+ * podzbiór ruchów. Wątki grają na własnych kopiach gry z własnymi
+ * buforami i statystykami, które są sumowane po zakończeniu wszystkich
+ * wątków. Gra @p g nie może być zmieniana w trakcie wywołania.
+ * @param[in,out] g      – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player     – numer gracza,
+ * @param[in] config     – wskaźnik na ustawienia,
+ * @param[out] result    – wskaźnik na wynik, który należy zwolnić przez
+ *                         @ref playout_result_free,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy któryś parametr
+ * jest niepoprawny lub nie udało się zaalokować pamięci.
+ */
+bool playout_run(struct gamma *g, uint32_t player,
+                 const playout_config_t *config, playout_result_t *result);
+
+/** @brief Zwalnia wynik rozgrywek.
+ * @param[in,out] result – wskaźnik na wynik.
+ */
+void playout_result_free(playout_result_t *result);
+
+/** @brief Podaje ruch z największym odsetkiem wygranych.
+ * @param[in] result – wskaźnik na wynik,
+ * @return Wskaźnik na statystyki ruchu lub NULL, gdy żaden ruch nie został
+ * rozegrany.
+ */
+const playout_stat_t *playout_best(const playout_result_t *result);
+
+/** @brief Podaje liczbę rozgrywek na sekundę.
+ * @param[in] result – wskaźnik na wynik,
+ * @return Liczba rozgrywek na sekundę.
+ */
+double playout_rate(const playout_result_t *result);
+
+/** @brief Wykonuje ruch gracza komputerowego.
+ * Rozgrywa gry od bieżącej pozycji i wykonuje ruch z największym odsetkiem
+ * wygranych.
+ * @param[in,out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player – numer gracza,
+ * @param[in] config – wskaźnik na ustawienia,
+ * @param[out] move  – wskaźnik na statystyki wykonanego ruchu lub NULL,
+ * @param[out] rate  – wskaźnik na liczbę rozgrywek na sekundę lub NULL,
+ * @return Wartość @p true, jeśli ruch został wykonany, a @p false, gdy
+ * gracz nie ma ruchu lub nie udało się zaalokować pamięci.
+ */
+bool playout_move(struct gamma *g, uint32_t player,
+                  const playout_config_t *config, playout_stat_t *move,
+                  double *rate);
+
+/** @brief Podaje kolejną liczbę losową.
+ * Generator xorshift64*.
+ * @param[in,out] state – wskaźnik na niezerowy stan generatora,
+ * @return Liczba losowa.
+ */
+uint64_t playout_random(uint64_t *state);
+
+/** @brief Podaje stan generatora wyprowadzony z ziarna.
+ * @param[in] seed  – ziarno,
+ * @param[in] index – numer strumienia liczb losowych,
+ * @return Niezerowy stan generatora.
+ */
+uint64_t playout_seed(uint64_t seed, uint64_t index);
+
+/** @brief Podaje bieżący czas w sekundach.
+ * @return Czas monotoniczny w sekundach.
+ */
+double playout_now(void);
+
+/** @brief Wykonuje ruch gracza według sposobu wyboru ruchów.
+ * Najpierw próbuje kilku losowych pól, a dopiero gdy żadne nie pasuje,
+ * wylicza legalne ruchy.
+ * @param[in,out] g      – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player     – numer gracza,
+ * @param[in] policy     – sposób wyboru ruchów,
+ * @param[in,out] random – wskaźnik na stan generatora,
+ * @param[out] buffer    – bufor na @ref PLAYOUT_BUFFER pól,
+ * @return Wartość @p true, jeśli ruch został wykonany, a @p false, gdy
+ * gracz nie ma ruchu.
+ */
+bool playout_policy_move(struct gamma *g, uint32_t player,
+                         playout_policy_t policy, uint64_t *random,
+                         gamma_field_t *buffer);
+
+/** @brief Dogrywa grę do końca.
+ * Gracze po kolei, zaczynając od @p player, wykonują ruchy według
+ * @p policy, aż żaden z nich nie będzie mógł wykonać ruchu.
+ * @param[in,out] g      – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player     – numer pierwszego gracza,
+ * @param[in] policy     – sposób wyboru ruchów,
+ * @param[in,out] random – wskaźnik na stan generatora,
+ * @param[out] buffer    – bufor na @ref PLAYOUT_BUFFER pól,
+ * @return Liczba wykonanych ruchów.
+ */
+uint64_t playout_finish(struct gamma *g, uint32_t player,
+                        playout_policy_t policy, uint64_t *random,
+                        gamma_field_t *buffer);
+
+/** @brief Podaje wynik gracza w zakończonej grze.
+ * @param[in] g      – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player – numer gracza,
+ * @return 2, jeśli gracz ma najwięcej pól, 1, jeśli remisuje z innym graczem,
+ * a 0 w przeciwnym przypadku.
+ */
+uint64_t playout_score(struct gamma *g, uint32_t player);
+
+#endif //GAMMA_PLAYOUT_H
@@ -0,0 +1,62 @@
+/** @file
+ * Implementacja puli elementów o stałym rozmiarze.
+ *
+ * @author Marcin Malejky
+ */
+
+#include <stdlib.h>
+#include "pool.h"
+
+void pool_init(pool_t *p, uint32_t element, uint32_t limit) {
+    p->chunk = NULL;
+    p->chunks = 0;
+    p->chunk_capacity = 0;
+    p->element = element;
+    p->used = 0;
+    p->limit = limit;
+}
+
+void pool_free(pool_t *p) {
+    for (uint32_t i = 0; i < p->chunks; ++i) {
+        free(p->chunk[i]);
+    }
+    free(p->chunk);
+    pool_init(p, p->element, p->limit);
+}
+
+void pool_clear(pool_t *p) {
+    p->used = 0;
+}
+
+bool pool_alloc(pool_t *p, uint32_t n, uint32_t *index) {
+    uint32_t first = p->used;
+    /* Ciąg, który nie zmieściłby się w bieżącym kawałku, zaczyna nowy. */
+    if ((first & (POOL_CHUNK - 1)) + n > POOL_CHUNK) {
+        first = (first | (POOL_CHUNK - 1)) + 1;
+    }
+    if (n > p->limit || first > p->limit - n) {
+        return false;
+    }
+    uint32_t needed = (first + n - 1) / POOL_CHUNK + 1;
+    if (needed > p->chunks) {
+        if (p->chunks == p->chunk_capacity) {
+            uint32_t capacity = p->chunk_capacity ? 2 * p->chunk_capacity : 8;
+            unsigned char **chunk = realloc(p->chunk,
+                                            sizeof(unsigned char *) *
+                                            capacity);
+            if (!chunk) {
+                return false;
+            }
+            p->chunk = chunk;
+            p->chunk_capacity = capacity;
+        }
+        p->chunk[p->chunks] = malloc((uint64_t) p->element * POOL_CHUNK);
+        if (!p->chunk[p->chunks]) {
+            return false;
+        }
+        ++(p->chunks);
+    }
+    p->used = first + n;
+    *index = first;
+    return true;
+}
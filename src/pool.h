@@ -0,0 +1,69 @@
+/** @file
+ * Interfejs puli elementów o stałym rozmiarze.
+ *
+ * @author Marcin Malejky
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef GAMMA_POOL_H
+#define GAMMA_POOL_H
+
+#define POOL_CHUNK_BITS 12 /**< Logarytm liczby elementów w kawałku. */
+#define POOL_CHUNK (UINT32_C(1) << POOL_CHUNK_BITS) /**< Liczba elementów
+                                                       * w kawałku. */
+
+/**
+ * Pula elementów o stałym rozmiarze.
+ * Elementy są alokowane kawałkami i nigdy nie są przenoszone, więc wskaźniki
+ * na nie są ważne aż do wyczyszczenia puli. Elementy są numerowane kolejno,
+ * a ciąg elementów przydzielony jednym wywołaniem leży w jednym kawałku.
+ * Elementy nie są zwalniane pojedynczo, tylko wszystkie naraz.
+ */
+typedef struct {
+    unsigned char **chunk; /**< Kawałki pamięci. */
+    uint32_t chunks; /**< Liczba kawałków. */
+    uint32_t chunk_capacity; /**< Pojemność tablicy kawałków. */
+    uint32_t element; /**< Rozmiar elementu w bajtach. */
+    uint32_t used; /**< Liczba przydzielonych numerów elementów. */
+    uint32_t limit; /**< Największa liczba elementów. */
+} pool_t;
+
+/** @brief Inicjalizuje pustą pulę.
+ * @param[out] p      – wskaźnik na pulę,
+ * @param[in] element – rozmiar elementu w bajtach,
+ * @param[in] limit   – największa liczba elementów.
+ */
+void pool_init(pool_t *p, uint32_t element, uint32_t limit);
+
+/** @brief Zwalnia pamięć puli.
+ * @param[in,out] p – wskaźnik na pulę.
+ */
+void pool_free(pool_t *p);
+
+/** @brief Zwalnia wszystkie elementy, zachowując zaalokowane kawałki.
+ * @param[in,out] p – wskaźnik na pulę.
+ */
+void pool_clear(pool_t *p);
+
+/** @brief Przydziela ciąg kolejnych elementów.
+ * @param[in,out] p  – wskaźnik na pulę,
+ * @param[in] n      – liczba elementów, od 1 do @ref POOL_CHUNK,
+ * @param[out] index – wskaźnik na numer pierwszego elementu,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy pula osiągnęła
+ * limit lub nie udało się zaalokować pamięci.
+ */
+bool pool_alloc(pool_t *p, uint32_t n, uint32_t *index);
+
+/** @brief Podaje adres elementu.
+ * @param[in] p     – wskaźnik na pulę,
+ * @param[in] index – numer przydzielonego elementu,
+ * @return Adres elementu.
+ */
+static inline void *pool_at(const pool_t *p, uint32_t index) {
+    return p->chunk[index >> POOL_CHUNK_BITS] +
+           (uint64_t) (index & (POOL_CHUNK - 1)) * p->element;
+}
+
+#endif //GAMMA_POOL_H
@@ -0,0 +1,263 @@
+/** @file
+ * Implementacja wypisywania planszy gry gamma.
+ *
+ * @author Marcin Malejky
+ */
+
+#define _POSIX_C_SOURCE 200809L /**< Dostęp do sysconf. */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "output.h"
+#include "render.h"
+
+/**
+ * Część wydruku wypisywana przez jeden wątek.
+ */
+typedef struct {
+    const gamma_t *g; /**< Gra. */
+    uint32_t first; /**< Numer pierwszego wiersza wydruku. */
+    uint32_t count; /**< Liczba wierszy. */
+    char *buffer; /**< Miejsce pierwszego wiersza w buforze. */
+} part_t;
+
+/** @brief Podaje liczbę numerów graczy z gotowymi napisami.
+ * @param[in] g – wskaźnik na strukturę przechowującą stan gry,
+ * @return Liczba napisów, licząc napis pustego pola.
+ */
+static uint32_t label_count(const gamma_t *g);
+
+/** @brief Wypisuje napis pola o danym posiadaczu.
+ * @param[out] buffer – bufor na @ref gamma_t.frame znaków,
+ * @param[in] owner   – numer posiadacza pola lub zero dla pustego pola,
+ * @param[in] frame   – szerokość pola.
+ */
+static void write_label(char *buffer, uint32_t owner, uint32_t frame);
+
+/** @brief Przygotowuje napisy numerów graczy, jeśli ich jeszcze nie ma.
+ * Bez pamięci na napisy każde pole jest wypisywane od nowa.
+ * @param[in,out] g – wskaźnik na strukturę przechowującą stan gry.
+ */
+static void prepare_labels(gamma_t *g);
+
+/** @brief Odczytuje posiadaczy kolejnych pól.
+ * Posiadaczy zapisanych w tablicy czyta wprost ze stron, po jednym
+ * odczycie tabeli stron na stronę.
+ * @param[in] b       – wskaźnik na planszę,
+ * @param[in] field   – numer pierwszego pola,
+ * @param[in] n       – liczba pól,
+ * @param[out] owners – tablica na @p n numerów posiadaczy.
+ */
+static void read_owners(const board_t *b, uint32_t field, uint32_t n,
+                        uint32_t *owners);
+
+/** @brief Wypisuje kolejne pola jednego wiersza planszy.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] y       – numer wiersza planszy,
+ * @param[in] x       – numer pierwszej kolumny,
+ * @param[in] n       – liczba pól,
+ * @param[out] buffer – bufor na @p n * @ref gamma_t.frame znaków,
+ * @return Wskaźnik na koniec wypisanych znaków.
+ */
+static char *render_span(const gamma_t *g, uint32_t y, uint32_t x,
+                         uint32_t n, char *buffer);
+
+/** @brief Wypisuje część wydruku w jednym wątku.
+ * @param[in] arg – wskaźnik na część wydruku,
+ * @return NULL.
+ */
+static void *render_part(void *arg);
+
+static uint32_t label_count(const gamma_t *g) {
+    return g->player_count < RENDER_LABELS ? g->player_count + 1
+                                           : RENDER_LABELS;
+}
+
+static void write_label(char *buffer, uint32_t owner, uint32_t frame) {
+    uint32_t length = 0;
+    if (owner == 0) {
+        buffer[length++] = '.';
+    } else {
+        char digits[10];
+        uint32_t n = 0;
+        for (; owner != 0; owner /= 10) {
+            digits[n++] = (char) ('0' + owner % 10);
+        }
+        while (n > 0) {
+            buffer[length++] = digits[--n];
+        }
+    }
+    memset(buffer + length, ' ', frame - length);
+}
+
+static void prepare_labels(gamma_t *g) {
+    if (g->labels != NULL) {
+        return;
+    }
+    uint32_t count = label_count(g);
+    g->labels = malloc((size_t) count * g->frame);
+    for (uint32_t i = 0; g->labels != NULL && i < count; ++i) {
+        write_label(g->labels + (size_t) i * g->frame, i, g->frame);
+    }
+}
+
+static void read_owners(const board_t *b, uint32_t field, uint32_t n,
+                        uint32_t *owners) {
+    if (b->owner_size == 0) {
+        for (uint32_t i = 0; i < n; ++i) {
+            owners[i] = board_plane_owner(b, field + i);
+        }
+        return;
+    }
+    uint32_t per_page = PAGE_BYTES / b->owner_size;
+    for (uint32_t i = 0; i < n;) {
+        uint32_t run = per_page - (field + i) % per_page;
+        if (run > n - i) {
+            run = n - i;
+        }
+        const void *data = pages_read(&b->owner, field + i, b->owner_size);
+        uint32_t *out = owners + i;
+        if (b->owner_size == sizeof(uint8_t)) {
+            const uint8_t *in = data;
+            for (uint32_t j = 0; j < run; ++j) {
+                out[j] = in[j];
+            }
+        } else if (b->owner_size == sizeof(uint16_t)) {
+            const uint16_t *in = data;
+            for (uint32_t j = 0; j < run; ++j) {
+                out[j] = in[j];
+            }
+        } else {
+            memcpy(out, data, run * sizeof(uint32_t));
+        }
+        i += run;
+    }
+}
+
+static char *render_span(const gamma_t *g, uint32_t y, uint32_t x,
+                         uint32_t n, char *buffer) {
+    const board_t *b = &g->board;
+    uint32_t field = board_field(b, x, y);
+    uint32_t frame = g->frame;
+    uint32_t count = g->labels != NULL ? label_count(g) : 0;
+    const char *labels = g->labels;
+    uint32_t owners[RENDER_RUN];
+    for (uint32_t done = 0; done < n; done += RENDER_RUN) {
+        uint32_t run = n - done < RENDER_RUN ? n - done : RENDER_RUN;
+        read_owners(b, field + done, run, owners);
+        if (frame == 1 && count > 0) {
+            /* Przy jednocyfrowych numerach napis pola to jeden znak. */
+            for (uint32_t i = 0; i < run; ++i) {
+                *buffer++ = labels[owners[i]];
+            }
+            continue;
+        }
+        for (uint32_t i = 0; i < run; ++i) {
+            if (owners[i] < count) {
+                memcpy(buffer, labels + (size_t) owners[i] * frame, frame);
+            } else {
+                write_label(buffer, owners[i], frame);
+            }
+            buffer += frame;
+        }
+    }
+    return buffer;
+}
+
+static void *render_part(void *arg) {
+    const part_t *part = arg;
+    const gamma_t *g = part->g;
+    char *buffer = part->buffer;
+    for (uint32_t i = 0; i < part->count; ++i) {
+        uint32_t y = g->height - 1 - (part->first + i);
+        buffer = render_span(g, y, 0, g->width, buffer);
+        *buffer++ = '\n';
+    }
+    return NULL;
+}
+
+void render_rows(gamma_t *g, uint32_t first, uint32_t count, char *buffer) {
+    prepare_labels(g);
+    uint32_t threads = 1;
+    if ((uint64_t) count * g->width >= RENDER_PARALLEL) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (uint32_t) cpus : 1;
+    }
+    if (threads > RENDER_MAX_THREADS) {
+        threads = RENDER_MAX_THREADS;
+    }
+    if (threads > count) {
+        threads = count > 0 ? count : 1;
+    }
+    part_t parts[RENDER_MAX_THREADS];
+    pthread_t ids[RENDER_MAX_THREADS];
+    bool started[RENDER_MAX_THREADS];
+    size_t row_size = render_row_size(g);
+    for (uint32_t i = 0, done = 0; i < threads; ++i) {
+        uint32_t rows = count / threads + (i < count % threads);
+        part_t part = {g, first + done, rows, buffer + done * row_size};
+        parts[i] = part;
+        done += rows;
+    }
+    /* Wątek wywołujący wypisuje pierwszą część sam. */
+    for (uint32_t i = 1; i < threads; ++i) {
+        started[i] = pthread_create(&ids[i], NULL, render_part,
+                                    &parts[i]) == 0;
+        if (!started[i]) {
+            render_part(&parts[i]);
+        }
+    }
+    render_part(&parts[0]);
+    for (uint32_t i = 1; i < threads; ++i) {
+        if (started[i]) {
+            pthread_join(ids[i], NULL);
+        }
+    }
+}
+
+bool render_write(gamma_t *g, uint32_t first, uint32_t count,
+                  gamma_board_sink_t sink, void *arg) {
+    char *buffer = malloc(RENDER_CHUNK);
+    if (buffer == NULL) {
+        return false;
+    }
+    prepare_labels(g);
+    size_t row_size = render_row_size(g);
+    uint32_t end = first + count;
+    bool ok = true;
+    if (row_size <= RENDER_CHUNK) {
+        uint32_t rows = RENDER_CHUNK / row_size;
+        for (uint32_t row = first; ok && row < end; row += rows) {
+            uint32_t n = end - row < rows ? end - row : rows;
+            render_rows(g, row, n, buffer);
+            ok = sink(arg, buffer, n * row_size);
+        }
+    } else {
+        /* Wiersz dłuższy niż bufor jest wypisywany po kawałku. */
+        uint32_t fields = (RENDER_CHUNK - 1) / g->frame;
+        for (uint32_t row = first; ok && row < end; ++row) {
+            uint32_t y = g->height - 1 - row;
+            for (uint32_t x = 0; ok && x < g->width; x += fields) {
+                uint32_t n = g->width - x < fields ? g->width - x : fields;
+                char *last = render_span(g, y, x, n, buffer);
+                if (x + n == g->width) {
+                    *last++ = '\n';
+                }
+                ok = sink(arg, buffer, last - buffer);
+            }
+        }
+    }
+    free(buffer);
+    return ok;
+}
+
+bool render_fd(gamma_t *g, int fd) {
+    return render_write(g, 0, g->height, output_fd_sink, &fd);
+}
+
+void render_free(gamma_t *g) {
+    free(g->labels);
+    g->labels = NULL;
+}
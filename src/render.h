@@ -0,0 +1,77 @@
+/** @file
+ * Interfejs wypisywania planszy gry gamma.
+ *
+ * Każde pole zajmuje na wydruku @ref gamma_t.frame znaków: numer posiadacza
+ * wyrównany do lewej lub kropkę dla pustego pola, uzupełnione spacjami.
+ * Wiersze planszy są wypisywane od najwyższego, a każdy kończy się znakiem
+ * nowej linii, więc wszystkie mają tę samą długość i każdy wiersz można
+ * wypisać niezależnie od pozostałych.
+ *
+ * @author Marcin Malejky
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "gamma.h"
+
+#ifndef GAMMA_RENDER_H
+#define GAMMA_RENDER_H
+
+#define RENDER_LABELS 65536 /**< Liczba numerów graczy z gotowymi napisami. */
+#define RENDER_PARALLEL 262144 /**< Liczba pól opłacająca użycie wątków. */
+#define RENDER_MAX_THREADS 64 /**< Największa liczba wątków wypisujących. */
+#define RENDER_CHUNK 1048576 /**< Rozmiar bufora wypisywania strumieniowego. */
+#define RENDER_RUN 1024 /**< Liczba pól, których posiadaczy czyta się naraz. */
+
+/** @brief Podaje długość wiersza wydruku planszy.
+ * @param[in] g – wskaźnik na strukturę przechowującą stan gry,
+ * @return Liczba znaków wiersza razem ze znakiem nowej linii.
+ */
+static inline size_t render_row_size(const gamma_t *g) {
+    return (size_t) g->frame * g->width + 1;
+}
+
+/** @brief Wypisuje wiersze planszy do bufora.
+ * Duże fragmenty planszy są dzielone między wątki, z których każdy wypisuje
+ * swoje wiersze wprost w ich docelowe miejsce bufora. Napisy numerów
+ * graczy są przygotowywane przy pierwszym wydruku i zapamiętywane w grze.
+ * @param[in,out] g  – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] first  – numer pierwszego wiersza wydruku, licząc od zera od
+ *                     góry planszy,
+ * @param[in] count  – liczba wierszy,
+ * @param[out] buffer – bufor na @p count * @ref render_row_size znaków.
+ */
+void render_rows(gamma_t *g, uint32_t first, uint32_t count, char *buffer);
+
+/** @brief Przekazuje wiersze wydruku planszy kawałkami.
+ * Wiersze są wypisywane przez bufor stałego rozmiaru, a zbyt długie wiersze
+ * są dzielone na części, więc pamięć nie zależy od rozmiaru planszy.
+ * @param[in,out] g – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] first – numer pierwszego wiersza wydruku, licząc od zera od
+ *                    góry planszy,
+ * @param[in] count – liczba wierszy,
+ * @param[in] sink  – funkcja odbierająca kolejne kawałki wydruku,
+ * @param[in] arg   – pierwszy argument funkcji @p sink,
+ * @return Wartość @p true, jeśli przekazano wszystkie wiersze, a @p false,
+ * gdy nie udało się zaalokować bufora lub funkcja @p sink zwróciła
+ * @p false.
+ */
+bool render_write(gamma_t *g, uint32_t first, uint32_t count,
+                  gamma_board_sink_t sink, void *arg);
+
+/** @brief Wypisuje planszę do deskryptora pliku.
+ * Działa jak @ref render_write dla całej planszy.
+ * @param[in,out] g – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] fd    – deskryptor pliku,
+ * @return Wartość @p true, jeśli wypisano całą planszę, a @p false, gdy
+ * nie udało się zaalokować bufora lub zapis się nie powiódł.
+ */
+bool render_fd(gamma_t *g, int fd);
+
+/** @brief Zwalnia napisy numerów graczy zapamiętane w grze.
+ * @param[in,out] g – wskaźnik na strukturę przechowującą stan gry.
+ */
+void render_free(gamma_t *g);
+
+#endif //GAMMA_RENDER_H
@@ -0,0 +1,114 @@
+/** @file
+ * Implementacja kolejki cyklicznej jednego producenta i jednego konsumenta.
+ *
+ * @author Marcin Malejky
+ */
+
+#define _POSIX_C_SOURCE 200809L /**< Dostęp do read i write. */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include "ring.h"
+
+bool ring_init(ring_t *r, size_t element, size_t capacity) {
+    r->slots = malloc(element * capacity);
+    if (r->slots == NULL) {
+        return false;
+    }
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+    r->tail_seen = 0;
+    r->head_seen = 0;
+    r->mask = capacity - 1;
+    r->element = element;
+    return true;
+}
+
+void ring_free(ring_t *r) {
+    free(r->slots);
+    r->slots = NULL;
+}
+
+bool ring_push(ring_t *r, const void *item) {
+    size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    if (tail - r->head_seen > r->mask) {
+        r->head_seen = atomic_load_explicit(&r->head, memory_order_acquire);
+        if (tail - r->head_seen > r->mask) {
+            return false;
+        }
+    }
+    memcpy(r->slots + (tail & r->mask) * r->element, item, r->element);
+    atomic_store_explicit(&r->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+bool ring_pop(ring_t *r, void *item) {
+    size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    if (head == r->tail_seen) {
+        r->tail_seen = atomic_load_explicit(&r->tail, memory_order_acquire);
+        if (head == r->tail_seen) {
+            return false;
+        }
+    }
+    memcpy(item, r->slots + (head & r->mask) * r->element, r->element);
+    atomic_store_explicit(&r->head, head + 1, memory_order_release);
+    return true;
+}
+
+bool ring_empty(ring_t *r) {
+    atomic_thread_fence(memory_order_seq_cst);
+    size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    return head == atomic_load_explicit(&r->tail, memory_order_seq_cst);
+}
+
+bool ring_waker_init(ring_waker_t *w) {
+    atomic_init(&w->sleeping, false);
+    w->fd = eventfd(0, 0);
+    return w->fd != -1;
+}
+
+void ring_waker_free(ring_waker_t *w) {
+    if (w->fd != -1) {
+        close(w->fd);
+    }
+}
+
+void ring_kick(int fd) {
+    uint64_t one = 1;
+    if (write(fd, &one, sizeof(one)) < 0) {
+        /* Zapis nie udaje się tylko przy przepełnionym liczniku, a wtedy
+         * licznik jest niezerowy, więc wątek i tak wstanie. */
+    }
+}
+
+bool ring_wait(int fd) {
+    uint64_t count;
+    return read(fd, &count, sizeof(count)) >= 0 || errno == EINTR;
+}
+
+void ring_wake(ring_waker_t *w) {
+    /* Razem z barierą w ring_empty gwarantuje, że wątek, który zasypia,
+     * zobaczy nowy element albo zostanie obudzony: albo producent zobaczy
+     * ustawione sleeping, albo wątek zobaczy wstawiony element. */
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&w->sleeping, memory_order_relaxed)) {
+        ring_kick(w->fd);
+    }
+}
+
+void ring_prepare_sleep(ring_waker_t *w) {
+    atomic_store(&w->sleeping, true);
+}
+
+void ring_cancel_sleep(ring_waker_t *w) {
+    atomic_store(&w->sleeping, false);
+}
+
+bool ring_sleep(ring_waker_t *w) {
+    bool ok = ring_wait(w->fd);
+    atomic_store(&w->sleeping, false);
+    return ok;
+}
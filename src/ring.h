@@ -0,0 +1,140 @@
+/** @file
+ * Interfejs kolejki cyklicznej jednego producenta i jednego konsumenta.
+ *
+ * @author Marcin Malejky
+ */
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef GAMMA_RING_H
+#define GAMMA_RING_H
+
+#define RING_ALIGN 64 /**< Rozmiar linii pamięci podręcznej w bajtach. */
+
+/**
+ * Ograniczona kolejka bez blokad.
+ * Elementy wstawia tylko jeden wątek i wyjmuje tylko jeden wątek. Indeksy
+ * producenta i konsumenta leżą w osobnych liniach pamięci podręcznej, a każda
+ * strona pamięta ostatnio odczytany indeks drugiej strony, więc sięga po
+ * niego dopiero, gdy kolejka wydaje się pełna lub pusta.
+ */
+typedef struct {
+    _Alignas(RING_ALIGN) atomic_size_t head; /**< Indeks do wyjęcia. */
+    size_t tail_seen; /**< Ostatnio odczytany przez konsumenta @p tail. */
+    _Alignas(RING_ALIGN) atomic_size_t tail; /**< Indeks do wstawienia. */
+    size_t head_seen; /**< Ostatnio odczytany przez producenta @p head. */
+    _Alignas(RING_ALIGN) size_t mask; /**< Pojemność pomniejszona o 1. */
+    size_t element; /**< Rozmiar elementu w bajtach. */
+    unsigned char *slots; /**< Elementy. */
+} ring_t;
+
+/**
+ * Budzik wątku, który zasypia, gdy jego kolejki są puste.
+ * Wątek ogłasza zamiar zaśnięcia przez @ref ring_prepare_sleep, sprawdza
+ * swoje kolejki przez @ref ring_empty i śpi w @ref ring_sleep tylko wtedy,
+ * gdy wszystkie są puste. Producent po wstawieniu elementu wywołuje
+ * @ref ring_wake, które pisze do eventfd tylko wtedy, gdy wątek zasypia
+ * lub śpi, więc póki wątek pracuje, przekazanie elementu nie wymaga wywołań
+ * systemowych.
+ */
+typedef struct {
+    atomic_bool sleeping; /**< Czy wątek zasypia lub śpi. */
+    int fd; /**< Eventfd budzący wątek. */
+} ring_waker_t;
+
+/** @brief Tworzy pustą kolejkę.
+ * @param[out] r      – wskaźnik na kolejkę,
+ * @param[in] element – rozmiar elementu w bajtach,
+ * @param[in] capacity – pojemność, potęga dwójki,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy nie udało się
+ * zaalokować pamięci.
+ */
+bool ring_init(ring_t *r, size_t element, size_t capacity);
+
+/** @brief Zwalnia pamięć kolejki.
+ * @param[in,out] r – wskaźnik na kolejkę.
+ */
+void ring_free(ring_t *r);
+
+/** @brief Wstawia element na koniec kolejki.
+ * Wywoływana tylko przez producenta.
+ * @param[in,out] r – wskaźnik na kolejkę,
+ * @param[in] item  – wskaźnik na element,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy kolejka jest
+ * pełna.
+ */
+bool ring_push(ring_t *r, const void *item);
+
+/** @brief Wyjmuje element z początku kolejki.
+ * Wywoływana tylko przez konsumenta.
+ * @param[in,out] r – wskaźnik na kolejkę,
+ * @param[out] item – wskaźnik na miejsce na element,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy kolejka jest
+ * pusta.
+ */
+bool ring_pop(ring_t *r, void *item);
+
+/** @brief Sprawdza, czy kolejka jest pusta.
+ * Wynik jest pewny tylko dla konsumenta; wywołanie jest pełną barierą
+ * pamięci, więc nadaje się do sprawdzenia kolejki przed uśpieniem
+ * konsumenta.
+ * @param[in] r – wskaźnik na kolejkę,
+ * @return Wartość @p true, jeśli kolejka jest pusta, a @p false
+ * w przeciwnym przypadku.
+ */
+bool ring_empty(ring_t *r);
+
+/** @brief Tworzy budzik.
+ * @param[out] w – wskaźnik na budzik,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy nie udało się
+ * utworzyć eventfd.
+ */
+bool ring_waker_init(ring_waker_t *w);
+
+/** @brief Zamyka eventfd budzika.
+ * @param[in,out] w – wskaźnik na budzik.
+ */
+void ring_waker_free(ring_waker_t *w);
+
+/** @brief Zwiększa licznik eventfd, budząc czekający na nim wątek.
+ * Można ją wywołać w procedurze obsługi sygnału.
+ * @param[in] fd – eventfd.
+ */
+void ring_kick(int fd);
+
+/** @brief Czeka, aż licznik eventfd będzie niezerowy, i zeruje go.
+ * @param[in] fd – eventfd,
+ * @return Wartość @p true, jeśli licznik został odczytany lub czekanie
+ * przerwał sygnał, a @p false w razie innego błędu.
+ */
+bool ring_wait(int fd);
+
+/** @brief Budzi wątek, jeśli zasypia lub śpi.
+ * Wywoływana po wstawieniu elementu do kolejki wątku.
+ * @param[in,out] w – wskaźnik na budzik wątku.
+ */
+void ring_wake(ring_waker_t *w);
+
+/** @brief Ogłasza, że wątek zamierza zasnąć.
+ * Po niej wątek musi sprawdzić swoje kolejki przez @ref ring_empty.
+ * @param[in,out] w – wskaźnik na budzik wątku.
+ */
+void ring_prepare_sleep(ring_waker_t *w);
+
+/** @brief Odwołuje zamiar zaśnięcia, gdy kolejki nie są puste.
+ * @param[in,out] w – wskaźnik na budzik wątku.
+ */
+void ring_cancel_sleep(ring_waker_t *w);
+
+/** @brief Usypia wątek do obudzenia przez @ref ring_wake lub
+ * @ref ring_kick.
+ * Wywoływana po @ref ring_prepare_sleep, gdy kolejki wątku są puste.
+ * @param[in,out] w – wskaźnik na budzik wątku,
+ * @return Wartość jak dla @ref ring_wait.
+ */
+bool ring_sleep(ring_waker_t *w);
+
+#endif //GAMMA_RING_H
@@ -0,0 +1,254 @@
+/** @file
+ * Implementacja bufora ekranu terminala.
+ *
+ * @author Marcin Malejky
+ */
+
+#include <stdlib.h>
+#include "screen.h"
+
+#define ESC 27 /**< Kod znaku ESCAPE. */
+#define SCREEN_GAP 3 /**< Najdłuższa przerwa między zmianami w wierszu, którą
+                      * opłaca się wypisać ponownie zamiast przesuwać kursor. */
+
+/** @brief Sprawdza, czy komórki są takie same.
+ * @param[in] a – komórka,
+ * @param[in] b – komórka,
+ * @return Wartość @p true, jeśli komórki mają ten sam znak i kolory,
+ * a @p false w przeciwnym przypadku.
+ */
+static bool same(cell_t a, cell_t b);
+
+/** @brief Podaje komórkę pustego ekranu.
+ * @return Spacja w domyślnych kolorach.
+ */
+static cell_t blank(void);
+
+/** @brief Przenosi kursor terminala na daną komórkę.
+ * Krótką przerwę w tym samym wierszu wypisuje ponownie, dłuższą przeskakuje
+ * sekwencją przesunięcia w prawo, a w pozostałych przypadkach podaje
+ * położenie wprost.
+ * @param[in,out] s – wskaźnik na ekran,
+ * @param[in] row   – numer wiersza,
+ * @param[in] col   – numer kolumny.
+ */
+static void move_to(screen_t *s, uint32_t row, uint32_t col);
+
+/** @brief Ustawia kolory terminala, jeśli są inne niż bieżące.
+ * @param[in,out] s – wskaźnik na ekran,
+ * @param[in] fg    – kolor tekstu,
+ * @param[in] bg    – kolor tła.
+ */
+static void set_colors(screen_t *s, uint8_t fg, uint8_t bg);
+
+/** @brief Wypisuje komórkę następnej klatki na miejsce kursora.
+ * @param[in,out] s – wskaźnik na ekran,
+ * @param[in] row   – numer wiersza kursora,
+ * @param[in] col   – numer kolumny kursora.
+ */
+static void emit(screen_t *s, uint32_t row, uint32_t col);
+
+/** @brief Dopisuje do sekwencji klatki różnice w zmienionych wierszach.
+ * @param[in,out] s – wskaźnik na ekran.
+ */
+static void draw(screen_t *s);
+
+/** @brief Przekazuje sekwencje klatki terminalowi jednym zapisem.
+ * Zapis jest ponawiany tylko po częściowym zapisie i przerwaniu sygnałem.
+ * @param[in,out] s – wskaźnik na ekran.
+ */
+static void send(screen_t *s);
+
+static bool same(cell_t a, cell_t b) {
+    return a.c == b.c && a.fg == b.fg && a.bg == b.bg;
+}
+
+static cell_t blank(void) {
+    cell_t cell = {' ', SCREEN_DEFAULT, SCREEN_DEFAULT};
+    return cell;
+}
+
+static void move_to(screen_t *s, uint32_t row, uint32_t col) {
+    if (s->placed && s->row == row && s->col == col) {
+        return;
+    }
+    if (s->placed && s->row == row && s->col < col) {
+        const cell_t *line = s->front + (size_t) row * s->cols;
+        uint32_t gap = col - s->col;
+        bool plain = gap <= SCREEN_GAP;
+        for (uint32_t i = s->col; plain && i < col; ++i) {
+            plain = line[i].fg == s->fg && line[i].bg == s->bg;
+        }
+        if (plain) {
+            for (uint32_t i = s->col; i < col; ++i) {
+                output_char(&s->frame, line[i].c);
+            }
+        } else {
+            output_char(&s->frame, ESC);
+            output_char(&s->frame, '[');
+            output_uint(&s->frame, gap);
+            output_char(&s->frame, 'C');
+        }
+    } else {
+        output_char(&s->frame, ESC);
+        output_char(&s->frame, '[');
+        output_uint(&s->frame, row + 1);
+        output_char(&s->frame, ';');
+        output_uint(&s->frame, col + 1);
+        output_char(&s->frame, 'H');
+    }
+    s->placed = true;
+    s->row = row;
+    s->col = col;
+}
+
+static void set_colors(screen_t *s, uint8_t fg, uint8_t bg) {
+    if (s->fg == fg && s->bg == bg) {
+        return;
+    }
+    output_char(&s->frame, ESC);
+    output_char(&s->frame, '[');
+    if (fg == SCREEN_DEFAULT || bg == SCREEN_DEFAULT) {
+        output_char(&s->frame, '0');
+        if (fg != SCREEN_DEFAULT) {
+            output_char(&s->frame, ';');
+            output_uint(&s->frame, fg);
+        }
+        if (bg != SCREEN_DEFAULT) {
+            output_char(&s->frame, ';');
+            output_uint(&s->frame, bg);
+        }
+    } else {
+        output_uint(&s->frame, fg);
+        output_char(&s->frame, ';');
+        output_uint(&s->frame, bg);
+    }
+    output_char(&s->frame, 'm');
+    s->fg = fg;
+    s->bg = bg;
+}
+
+static void emit(screen_t *s, uint32_t row, uint32_t col) {
+    size_t i = (size_t) row * s->cols + col;
+    move_to(s, row, col);
+    set_colors(s, s->back[i].fg, s->back[i].bg);
+    output_char(&s->frame, s->back[i].c);
+    s->front[i] = s->back[i];
+    /* Za ostatnią kolumną terminale różnie zawijają wiersz. */
+    s->placed = ++s->col < s->cols;
+}
+
+static void draw(screen_t *s) {
+    for (uint32_t i = 0; i < s->dirty_count; ++i) {
+        uint32_t row = s->dirty[i];
+        size_t start = (size_t) row * s->cols;
+        for (uint32_t col = s->from[row]; col < s->to[row]; ++col) {
+            if (!same(s->front[start + col], s->back[start + col])) {
+                emit(s, row, col);
+            }
+        }
+        s->to[row] = 0;
+    }
+    s->dirty_count = 0;
+}
+
+static void send(screen_t *s) {
+    output_write_fd(s->fd, s->frame.data, s->frame.length);
+    s->frame.length = 0;
+}
+
+bool screen_init(screen_t *s, int fd, uint32_t rows, uint32_t cols) {
+    size_t size = (size_t) rows * cols;
+    s->fd = fd;
+    s->rows = rows;
+    s->cols = cols;
+    s->front = malloc(size * sizeof(cell_t));
+    s->back = malloc(size * sizeof(cell_t));
+    s->from = malloc(rows * sizeof(uint32_t));
+    s->to = calloc(rows, sizeof(uint32_t));
+    s->dirty = malloc(rows * sizeof(uint32_t));
+    s->dirty_count = 0;
+    /* W pamięci bufor klatki rośnie zamiast wypisywać jej część. */
+    output_init(&s->frame, OUTPUT_MEMORY, OUTPUT_CAPACITY);
+    if (s->front == NULL || s->back == NULL || s->from == NULL ||
+        s->to == NULL || s->dirty == NULL || s->frame.data == NULL) {
+        screen_free(s);
+        return false;
+    }
+    for (size_t i = 0; i < size; ++i) {
+        s->front[i] = blank();
+        s->back[i] = blank();
+    }
+    s->placed = false;
+    s->row = 0;
+    s->col = 0;
+    s->fg = SCREEN_DEFAULT;
+    s->bg = SCREEN_DEFAULT;
+    static const char start[] = "\033[0m\033[?25l\033[2J";
+    output_write(&s->frame, start, sizeof(start) - 1);
+    return true;
+}
+
+void screen_free(screen_t *s) {
+    free(s->front);
+    free(s->back);
+    free(s->from);
+    free(s->to);
+    free(s->dirty);
+    output_free(&s->frame);
+    s->front = NULL;
+    s->back = NULL;
+    s->from = NULL;
+    s->to = NULL;
+    s->dirty = NULL;
+}
+
+void screen_put(screen_t *s, uint32_t row, uint32_t col, cell_t cell) {
+    if (row >= s->rows || col >= s->cols) {
+        return;
+    }
+    cell_t *target = &s->back[(size_t) row * s->cols + col];
+    if (same(*target, cell)) {
+        return;
+    }
+    *target = cell;
+    if (s->to[row] == 0) {
+        s->dirty[s->dirty_count++] = row;
+        s->from[row] = col;
+        s->to[row] = col + 1;
+    } else if (col < s->from[row]) {
+        s->from[row] = col;
+    } else if (col >= s->to[row]) {
+        s->to[row] = col + 1;
+    }
+}
+
+uint32_t screen_text(screen_t *s, uint32_t row, uint32_t col,
+                     const char *text, uint8_t fg, uint8_t bg) {
+    for (; *text != '\0'; ++text, ++col) {
+        cell_t cell = {*text, fg, bg};
+        screen_put(s, row, col, cell);
+    }
+    return col;
+}
+
+void screen_clear(screen_t *s, uint32_t row, uint32_t col) {
+    for (; col < s->cols; ++col) {
+        screen_put(s, row, col, blank());
+    }
+}
+
+void screen_flush(screen_t *s) {
+    draw(s);
+    send(s);
+}
+
+void screen_leave(screen_t *s, uint32_t row) {
+    draw(s);
+    set_colors(s, SCREEN_DEFAULT, SCREEN_DEFAULT);
+    s->placed = false;
+    move_to(s, row, 0);
+    static const char show[] = "\033[?25h";
+    output_write(&s->frame, show, sizeof(show) - 1);
+    send(s);
+}
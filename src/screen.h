@@ -0,0 +1,129 @@
+/** @file
+ * Interfejs bufora ekranu terminala.
+ *
+ * Ekran pamięta dwie kopie komórek: to, co jest teraz w terminalu, i to, co
+ * ma się w nim znaleźć po następnej klatce. Zapis do komórki tylko zmienia
+ * drugą kopię i poszerza zakres zmienionych kolumn jej wiersza. Klatka
+ * porównuje obie kopie wyłącznie w zmienionych zakresach, wypisuje różnice
+ * możliwie krótkimi sekwencjami ANSI i przekazuje je terminalowi jednym
+ * wywołaniem write, więc jej koszt zależy od liczby zmian, a nie od
+ * rozmiaru ekranu.
+ *
+ * @author Marcin Malejky
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "output.h"
+
+#ifndef GAMMA_SCREEN_H
+#define GAMMA_SCREEN_H
+
+#define SCREEN_DEFAULT 0 /**< Numer domyślnego koloru tekstu lub tła. */
+
+/**
+ * Komórka ekranu.
+ */
+typedef struct {
+    char c; /**< Znak. */
+    uint8_t fg; /**< Kolor tekstu w ANSI escape codes lub
+                 * @ref SCREEN_DEFAULT. */
+    uint8_t bg; /**< Kolor tła w ANSI escape codes lub
+                 * @ref SCREEN_DEFAULT. */
+} cell_t;
+
+/**
+ * Ekran terminala z buforem następnej klatki.
+ */
+typedef struct {
+    int fd; /**< Deskryptor terminala. */
+    uint32_t rows; /**< Liczba wierszy. */
+    uint32_t cols; /**< Liczba kolumn. */
+    cell_t *front; /**< Komórki wypisane w terminalu. */
+    cell_t *back; /**< Komórki następnej klatki. */
+    uint32_t *from; /**< Początek zakresu zmienionych kolumn wiersza. */
+    uint32_t *to; /**< Koniec zakresu zmienionych kolumn wiersza, zero dla
+                   * wiersza bez zmian. */
+    uint32_t *dirty; /**< Numery wierszy ze zmianami. */
+    uint32_t dirty_count; /**< Liczba wierszy ze zmianami. */
+    output_t frame; /**< Sekwencje bieżącej klatki. */
+    bool placed; /**< Czy położenie kursora terminala jest znane. */
+    uint32_t row; /**< Wiersz kursora terminala. */
+    uint32_t col; /**< Kolumna kursora terminala. */
+    uint8_t fg; /**< Bieżący kolor tekstu terminala. */
+    uint8_t bg; /**< Bieżący kolor tła terminala. */
+} screen_t;
+
+/** @brief Tworzy pusty ekran.
+ * Pierwsza klatka czyści terminal i ukrywa kursor.
+ * @param[out] s  – wskaźnik na ekran,
+ * @param[in] fd  – deskryptor terminala,
+ * @param[in] rows – liczba wierszy,
+ * @param[in] cols – liczba kolumn,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy nie udało się
+ * zaalokować pamięci.
+ */
+bool screen_init(screen_t *s, int fd, uint32_t rows, uint32_t cols);
+
+/** @brief Zwalnia ekran.
+ * Nie wypisuje niczego do terminala.
+ * @param[in,out] s – wskaźnik na ekran.
+ */
+void screen_free(screen_t *s);
+
+/** @brief Ustawia komórkę następnej klatki.
+ * Komórki poza ekranem są pomijane.
+ * @param[in,out] s – wskaźnik na ekran,
+ * @param[in] row   – numer wiersza,
+ * @param[in] col   – numer kolumny,
+ * @param[in] cell  – nowa zawartość komórki.
+ */
+void screen_put(screen_t *s, uint32_t row, uint32_t col, cell_t cell);
+
+/** @brief Wpisuje napis do kolejnych komórek wiersza.
+ * Część napisu poza ekranem jest pomijana.
+ * @param[in,out] s – wskaźnik na ekran,
+ * @param[in] row   – numer wiersza,
+ * @param[in] col   – numer kolumny pierwszego znaku,
+ * @param[in] text  – napis,
+ * @param[in] fg    – kolor tekstu,
+ * @param[in] bg    – kolor tła,
+ * @return Numer kolumny za ostatnim znakiem napisu.
+ */
+uint32_t screen_text(screen_t *s, uint32_t row, uint32_t col,
+                     const char *text, uint8_t fg, uint8_t bg);
+
+/** @brief Czyści wiersz od danej kolumny do końca.
+ * @param[in,out] s – wskaźnik na ekran,
+ * @param[in] row   – numer wiersza,
+ * @param[in] col   – numer pierwszej czyszczonej kolumny.
+ */
+void screen_clear(screen_t *s, uint32_t row, uint32_t col);
+
+/** @brief Sprawdza, czy od ostatniej klatki coś się zmieniło.
+ * @param[in] s – wskaźnik na ekran,
+ * @return Wartość @p true, jeśli następna klatka może coś wypisać, a @p false
+ * w przeciwnym przypadku.
+ */
+static inline bool screen_dirty(const screen_t *s) {
+    return s->dirty_count > 0 || s->frame.length > 0;
+}
+
+/** @brief Wypisuje klatkę.
+ * Przekazuje terminalowi jednym wywołaniem write sekwencje zmieniające
+ * jego zawartość na komórki następnej klatki. Gdy nic się nie zmieniło,
+ * niczego nie wypisuje.
+ * @param[in,out] s – wskaźnik na ekran.
+ */
+void screen_flush(screen_t *s);
+
+/** @brief Kończy rysowanie na ekranie.
+ * Wypisuje ostatnią klatkę, przywraca domyślne kolory, przenosi kursor na
+ * początek danego wiersza i pokazuje go, tak aby dalej można było pisać
+ * zwykłym printf.
+ * @param[in,out] s – wskaźnik na ekran,
+ * @param[in] row   – numer wiersza.
+ */
+void screen_leave(screen_t *s, uint32_t row);
+
+#endif //GAMMA_SCREEN_H
@@ -0,0 +1,976 @@
+/** @file
+ * Implementacja serwera prowadzącego wiele gier gamma naraz.
+ *
+ * Wątek główny obsługuje połączenia: czyta i rozbiera wiersze, a polecenia
+ * gier przekazuje wątkom roboczym. Gra o numerze @p id należy zawsze do
+ * wątku @p id mod liczba wątków, więc jej stan zmienia tylko jeden wątek,
+ * a jej polecenia są wykonywane w kolejności nadejścia. Zapytanie
+ * o liczniki wszystkich gier trafia do każdego wątku roboczego, a wątek
+ * główny sumuje ich odpowiedzi. Wątek odpowiada po wykonaniu wcześniejszych
+ * poleceń, więc suma obejmuje wszystkie polecenia wysłane przed zapytaniem.
+ * Wątek główny łączą z każdym wątkiem roboczym dwie kolejki jednego
+ * producenta i jednego konsumenta: poleceń i odpowiedzi. Na ścieżce
+ * polecenia nie ma blokad, a eventfd budzi tylko wątki, które zasnęły przy
+ * pustej kolejce.
+ *
+ * Wątek roboczy zachowuje usunięte gry, a nowa gra o tych samych wymiarach
+ * planszy i liczbie graczy zajmuje pamięć ostatnio usuniętej zamiast
+ * alokować własną.
+ *
+ * @author Marcin Malejky
+ */
+
+#define _POSIX_C_SOURCE 200809L /**< Dostęp do gniazd i sigaction. */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "command.h"
+#include "input.h"
+#include "output.h"
+#include "playout.h"
+#include "ring.h"
+#include "server.h"
+
+#define SERVER_EVENTS 64 /**< Liczba zdarzeń odbieranych naraz. */
+#define SERVER_BACKLOG 128 /**< Długość kolejki połączeń do przyjęcia. */
+#define SERVER_PENDING 16777216 /**< Limit odpowiedzi czekających na klienta. */
+#define SERVER_MAX_SHARDS 64 /**< Największa liczba wątków roboczych. */
+#define SERVER_QUEUE 4096 /**< Pojemność kolejek wątku roboczego. */
+#define SERVER_INLINE 40 /**< Długość odpowiedzi mieszczącej się w kolejce. */
+#define SERVER_CHUNK 16384 /**< Największa długość kawałka odpowiedzi. */
+#define SERVER_PREFIX 16 /**< Miejsce na numer gry przed wierszem planszy. */
+#define SERVER_BATCH 4096 /**< Liczba wierszy pliku między odbiorami. */
+#define SERVER_SPARE 64 /**< Liczba usuniętych gier zachowanych do ponownego
+                          *  użycia przez jeden wątek roboczy. */
+#define MICROSECONDS 1e6 /**< Liczba mikrosekund w sekundzie. */
+
+/**
+ * Miejsce na grę.
+ */
+typedef struct {
+    gamma_t *g; /**< Gra lub NULL, gdy miejsce jest wolne. */
+    uint64_t commands; /**< Liczba wykonanych poleceń gry. */
+    double created; /**< Czas utworzenia gry w sekundach. */
+} game_t;
+
+/**
+ * Połączenie z klientem.
+ */
+typedef struct connection {
+    int fd; /**< Deskryptor połączenia. */
+    input_t in; /**< Wejście połączenia. */
+    output_t out; /**< Wyjście odpowiedzi. */
+    bool console; /**< Czy to standardowe wejście i wyjście. */
+    bool watched; /**< Czy deskryptor jest obserwowany przez epoll. */
+    bool dirty; /**< Czy połączenie jest na liście do uporządkowania. */
+    struct connection *next; /**< Następne połączenie na tej liście. */
+    uint32_t line_number; /**< Numer ostatnio wczytanego wiersza. */
+    uint32_t events; /**< Zdarzenia obserwowane przez epoll. */
+    uint64_t inflight; /**< Liczba poleceń czekających na odpowiedź. */
+} connection_t;
+
+/**
+ * Zapytanie o liczniki wszystkich gier czekające na odpowiedzi wątków.
+ */
+typedef struct {
+    uint32_t waiting; /**< Liczba wątków, które jeszcze nie odpowiedziały. */
+    uint64_t games; /**< Suma liczb gier z odpowiedzi. */
+    uint64_t commands; /**< Suma liczb wykonanych poleceń z odpowiedzi. */
+} totals_t;
+
+/**
+ * Polecenie przekazywane wątkowi roboczemu.
+ */
+typedef struct {
+    connection_t *c; /**< Połączenie, z którego przyszło polecenie. */
+    uint32_t id; /**< Numer gry lub numer wątku dla zapytania o liczniki
+                   * wszystkich gier. */
+    uint32_t line_number; /**< Numer wiersza polecenia. */
+    totals_t *totals; /**< Zapytanie o liczniki wszystkich gier lub NULL. */
+    command_t cmd; /**< Polecenie. */
+} request_t;
+
+/**
+ * Odpowiedź wątku roboczego.
+ */
+typedef struct {
+    connection_t *c; /**< Połączenie, do którego trafi odpowiedź. */
+    uint32_t line_number; /**< Numer wiersza polecenia. */
+    uint32_t length; /**< Długość odpowiedzi. */
+    bool error; /**< Czy polecenie było niepoprawne. */
+    bool more; /**< Czy po tym kawałku odpowiedzi przyjdą następne. */
+    totals_t *totals; /**< Zapytanie o liczniki wszystkich gier lub NULL. */
+    uint64_t games; /**< Liczba gier wątku w odpowiedzi na zapytanie. */
+    uint64_t commands; /**< Liczba wykonanych poleceń wątku w odpowiedzi na
+                         * zapytanie. */
+    char *text; /**< Długa odpowiedź lub NULL. */
+    char inline_text[SERVER_INLINE]; /**< Krótka odpowiedź. */
+} reply_t;
+
+struct server;
+
+/**
+ * Wątek roboczy wraz z jego kolejkami.
+ */
+typedef struct {
+    ring_t requests; /**< Polecenia od wątku głównego. */
+    ring_t replies; /**< Odpowiedzi dla wątku głównego. */
+    ring_waker_t waker; /**< Budzik wątku. */
+    atomic_bool stop; /**< Czy wątek ma się zakończyć. */
+    bool pending; /**< Czy od ostatniego budzenia dostał polecenia. */
+    uint32_t games; /**< Liczba gier wątku. */
+    uint64_t commands; /**< Liczba wykonanych poleceń gier. */
+    output_t scratch; /**< Bufor, w którym powstaje kawałek odpowiedzi. */
+    gamma_t *spare[SERVER_SPARE]; /**< Usunięte gry do ponownego użycia. */
+    uint32_t spare_count; /**< Liczba usuniętych gier do ponownego użycia. */
+    struct server *server; /**< Serwer. */
+    pthread_t thread; /**< Wątek. */
+} shard_t;
+
+/**
+ * Stan wydruku planszy.
+ */
+typedef struct {
+    shard_t *sh; /**< Wątek roboczy wypisujący planszę. */
+    const request_t *r; /**< Polecenie wydruku. */
+    bool row_start; /**< Czy następny znak zaczyna wiersz. */
+} board_print_t;
+
+/**
+ * Stan serwera.
+ */
+typedef struct server {
+    game_t *games; /**< Tablica @ref SERVER_GAMES miejsc na gry. */
+    shard_t *shards; /**< Wątki robocze. */
+    uint32_t shard_count; /**< Liczba wątków roboczych. */
+    ring_waker_t notify; /**< Budzik wątku głównego. */
+    connection_t *dirty; /**< Połączenia do uporządkowania. */
+    bool done; /**< Czy zamknięto standardowe wejście. */
+    double started; /**< Czas startu serwera w sekundach. */
+} server_t;
+
+/** @brief Tworzy połączenie.
+ * @param[in] fd      – deskryptor wejścia połączenia,
+ * @param[in] out_fd  – deskryptor wyjścia odpowiedzi,
+ * @param[in] console – czy to standardowe wejście i wyjście,
+ * @return Wskaźnik na połączenie lub NULL, gdy nie udało się zaalokować
+ * pamięci.
+ */
+static connection_t *connection_new(int fd, int out_fd, bool console);
+
+/** @brief Wysyła odpowiedzi, zamyka i usuwa połączenie.
+ * @param[in,out] c – wskaźnik na połączenie.
+ */
+static void connection_free(connection_t *c);
+
+/** @brief Zgłasza błąd w wierszu połączenia.
+ * @param[in,out] c       – wskaźnik na połączenie,
+ * @param[in] line_number – numer wiersza.
+ */
+static void reply_error(connection_t *c, uint32_t line_number);
+
+/** @brief Przenosi do odpowiedzi tekst zebrany w buforze wątku.
+ * Opróżnia bufor wątku.
+ * @param[in,out] sh    – wskaźnik na wątek roboczy,
+ * @param[in,out] reply – wskaźnik na odpowiedź,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy nie udało się
+ * zaalokować pamięci na tekst.
+ */
+static bool take_text(shard_t *sh, reply_t *reply);
+
+/** @brief Przekazuje odpowiedź wątkowi głównemu.
+ * Czeka, gdy kolejka odpowiedzi jest pełna.
+ * @param[in,out] sh – wskaźnik na wątek roboczy,
+ * @param[in] reply  – wskaźnik na odpowiedź.
+ */
+static void push_reply(shard_t *sh, const reply_t *reply);
+
+/** @brief Wypisuje kawałek wydruku planszy, poprzedzając każdy jego
+ * wiersz numerem gry.
+ * Gdy bufor wątku się zapełni, przekazuje go wątkowi głównemu jako kawałek
+ * odpowiedzi, więc pamięć nie zależy od rozmiaru planszy.
+ * @param[in,out] arg – wskaźnik na stan wydruku,
+ * @param[in] data    – kawałek wydruku,
+ * @param[in] size    – długość kawałka,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy nie udało się
+ * zaalokować pamięci na kawałek odpowiedzi.
+ */
+static bool print_rows(void *arg, const char *data, size_t size);
+
+/** @brief Wypisuje planszę, poprzedzając każdy jej wiersz numerem gry.
+ * @param[in,out] sh – wskaźnik na wątek roboczy,
+ * @param[in] r      – wskaźnik na polecenie wydruku,
+ * @param[in] g      – wskaźnik na grę,
+ * @return Wartość @p true, jeśli wypisano całą planszę, a @p false
+ * w przeciwnym przypadku.
+ */
+static bool print_board(shard_t *sh, const request_t *r, gamma_t *g);
+
+/** @brief Tworzy grę dla polecenia @p B.
+ * Używa ostatnio usuniętej gry wątku, jeśli ma te same wymiary planszy
+ * i liczbę graczy, a w przeciwnym przypadku zwalnia ją i alokuje nową grę.
+ * @param[in,out] sh – wskaźnik na wątek roboczy,
+ * @param[in] args   – argumenty polecenia @p B,
+ * @return Wskaźnik na grę lub NULL, gdy nie udało się zaalokować pamięci
+ * lub któryś z argumentów jest niepoprawny.
+ */
+static gamma_t *take_game(shard_t *sh, const uint32_t *args);
+
+/** @brief Usuwa grę, zachowując ją do ponownego użycia, jeśli jest miejsce.
+ * @param[in,out] sh – wskaźnik na wątek roboczy,
+ * @param[in] g      – wskaźnik na grę.
+ */
+static void release_game(shard_t *sh, gamma_t *g);
+
+/** @brief Wykonuje polecenie dotyczące gry.
+ * Wywoływana tylko przez wątek roboczy, do którego należy gra. Wynik
+ * zbiera w buforze wątku.
+ * @param[in,out] sh – wskaźnik na wątek roboczy,
+ * @param[in] r      – wskaźnik na polecenie,
+ * @return Wartość @p true, jeśli polecenie zostało wykonane, a @p false,
+ * gdy jest niepoprawne lub nie udało się wypisać jego wyniku.
+ */
+static bool serve_command(shard_t *sh, const request_t *r);
+
+/** @brief Wykonuje polecenie i przekazuje odpowiedź wątkowi głównemu.
+ * @param[in,out] sh – wskaźnik na wątek roboczy,
+ * @param[in] r      – wskaźnik na polecenie.
+ */
+static void execute(shard_t *sh, const request_t *r);
+
+/** @brief Wykonuje polecenia wątku roboczego aż do końca pracy serwera.
+ * @param[in,out] arg – wskaźnik na wątek roboczy,
+ * @return NULL.
+ */
+static void *shard_run(void *arg);
+
+/** @brief Przekazuje polecenie wątkowi, do którego należy gra.
+ * Gdy kolejka wątku jest pełna, odbiera odpowiedzi, żeby wątek nie czekał
+ * na miejsce w kolejce odpowiedzi.
+ * @param[in,out] s – wskaźnik na stan serwera,
+ * @param[in] r     – wskaźnik na polecenie.
+ */
+static void dispatch(server_t *s, const request_t *r);
+
+/** @brief Przekazuje zapytanie o liczniki wszystkich gier każdemu wątkowi.
+ * @param[in,out] s – wskaźnik na stan serwera,
+ * @param[in,out] c – wskaźnik na połączenie, z którego przyszło zapytanie.
+ */
+static void dispatch_totals(server_t *s, connection_t *c);
+
+/** @brief Dodaje odpowiedź wątku do zapytania o liczniki wszystkich gier.
+ * Po ostatniej odpowiedzi wypisuje sumę i usuwa zapytanie.
+ * @param[in,out] s     – wskaźnik na stan serwera,
+ * @param[in] reply     – wskaźnik na odpowiedź wątku.
+ */
+static void add_totals(server_t *s, const reply_t *reply);
+
+/** @brief Budzi śpiące wątki robocze, które dostały polecenia.
+ * @param[in,out] s – wskaźnik na stan serwera.
+ */
+static void wake_shards(server_t *s);
+
+/** @brief Dopisuje do połączeń odpowiedzi ze wszystkich wątków roboczych.
+ * @param[in,out] s – wskaźnik na stan serwera.
+ */
+static void collect(server_t *s);
+
+/** @brief Przygotowuje wątek główny do uśpienia.
+ * Po powrocie z wartością @p true każda nowa odpowiedź obudzi wątek główny
+ * przez budzik @p notify.
+ * @param[in,out] s – wskaźnik na stan serwera,
+ * @return Wartość @p true, jeśli nie ma odpowiedzi do odebrania, a @p false
+ * w przeciwnym przypadku.
+ */
+static bool may_sleep(server_t *s);
+
+/** @brief Dopisuje połączenie do listy do uporządkowania.
+ * @param[in,out] s – wskaźnik na stan serwera,
+ * @param[in,out] c – wskaźnik na połączenie.
+ */
+static void mark(server_t *s, connection_t *c);
+
+/** @brief Wysyła odpowiedzi połączeń z listy i zmienia ich zdarzenia.
+ * Zamyka połączenia, które skończyły wejście i wysłały odpowiedzi na
+ * wszystkie polecenia. Odpowiedzi, których klient jeszcze nie odebrał,
+ * czekają w buforze połączenia. Gdy jest ich więcej niż
+ * @ref SERVER_PENDING bajtów, serwer przestaje czytać polecenia tego
+ * połączenia, aż klient je odbierze.
+ * @param[in,out] s – wskaźnik na stan serwera,
+ * @param[in] epoll – deskryptor epoll lub -1.
+ */
+static void settle(server_t *s, int epoll);
+
+/** @brief Obsługuje wiersz z wejścia połączenia.
+ * @param[in,out] s – wskaźnik na stan serwera,
+ * @param[in,out] c – wskaźnik na połączenie,
+ * @param[in] line  – wiersz,
+ * @param[in] size  – długość wiersza.
+ */
+static void serve_line(server_t *s, connection_t *c, const char *line,
+                       size_t size);
+
+/** @brief Obsługuje wszystkie całe wiersze wczytane z połączenia.
+ * @param[in,out] s – wskaźnik na stan serwera,
+ * @param[in,out] c – wskaźnik na połączenie.
+ */
+static void serve_lines(server_t *s, connection_t *c);
+
+/** @brief Obsługuje połączenie do końca jego wejścia, czytając blokująco.
+ * Czeka też na odpowiedzi na wszystkie polecenia.
+ * @param[in,out] s – wskaźnik na stan serwera,
+ * @param[in,out] c – wskaźnik na połączenie.
+ */
+static void serve_to_end(server_t *s, connection_t *c);
+
+/** @brief Otwiera gniazdo uniksowe do nasłuchiwania.
+ * @param[in] path – ścieżka gniazda,
+ * @return Deskryptor gniazda lub -1 w razie błędu.
+ */
+static int listen_on(const char *path);
+
+/** @brief Zmienia zdarzenia obserwowane dla połączenia.
+ * Połączenie bez zdarzeń przestaje być obserwowane.
+ * @param[in] epoll     – deskryptor epoll,
+ * @param[in,out] c     – wskaźnik na połączenie,
+ * @param[in] events    – zdarzenia.
+ */
+static void watch(int epoll, connection_t *c, uint32_t events);
+
+/** @brief Przyjmuje nowe połączenie.
+ * Gniazdo połączenia jest nieblokujące, więc klient, który nie odbiera
+ * odpowiedzi, nie wstrzymuje serwera.
+ * @param[in] epoll    – deskryptor epoll,
+ * @param[in] listener – deskryptor gniazda nasłuchującego.
+ */
+static void accept_connection(int epoll, int listener);
+
+/** @brief Obsługuje zdarzenia połączeń aż do końca pracy serwera.
+ * @param[in,out] s    – wskaźnik na stan serwera,
+ * @param[in] epoll    – deskryptor epoll,
+ * @param[in] listener – deskryptor gniazda nasłuchującego lub -1.
+ */
+static void event_loop(server_t *s, int epoll, int listener);
+
+/** @brief Uruchamia wątki robocze, po jednym na procesor.
+ * @param[in,out] s – wskaźnik na stan serwera,
+ * @return Wartość @p true, jeśli uruchomiono co najmniej jeden wątek,
+ * a @p false w przeciwnym przypadku.
+ */
+static bool start_shards(server_t *s);
+
+/** @brief Kończy wątki robocze po wykonaniu ich poleceń.
+ * @param[in,out] s – wskaźnik na stan serwera.
+ */
+static void stop_shards(server_t *s);
+
+static connection_t *connection_new(int fd, int out_fd, bool console) {
+    connection_t *c = malloc(sizeof(connection_t));
+    if (c == NULL) {
+        return NULL;
+    }
+    c->fd = fd;
+    input_init(&c->in, fd, NULL);
+    output_init(&c->out, out_fd, OUTPUT_CAPACITY);
+    c->console = console;
+    c->watched = false;
+    c->dirty = false;
+    c->next = NULL;
+    c->line_number = 0;
+    c->events = 0;
+    c->inflight = 0;
+    return c;
+}
+
+static void connection_free(connection_t *c) {
+    output_free(&c->out);
+    input_free(&c->in);
+    if (!c->console) {
+        close(c->fd);
+    }
+    free(c);
+}
+
+static void reply_error(connection_t *c, uint32_t line_number) {
+    if (c->console) {
+        output_flush(&c->out);
+        fprintf(stderr, "ERROR %d\n", line_number);
+    } else {
+        output_write(&c->out, "ERROR ", 6);
+        output_int(&c->out, (int32_t) line_number);
+        output_char(&c->out, '\n');
+    }
+}
+
+static bool take_text(shard_t *sh, reply_t *reply) {
+    output_t *out = &sh->scratch;
+    reply->length = out->length;
+    out->length = 0;
+    if (reply->length <= SERVER_INLINE) {
+        memcpy(reply->inline_text, out->data, reply->length);
+        return true;
+    }
+    reply->text = malloc(reply->length);
+    if (reply->text == NULL) {
+        reply->length = 0;
+        return false;
+    }
+    memcpy(reply->text, out->data, reply->length);
+    return true;
+}
+
+static void push_reply(shard_t *sh, const reply_t *reply) {
+    while (!ring_push(&sh->replies, reply)) {
+        ring_wake(&sh->server->notify);
+        sched_yield();
+    }
+}
+
+static bool print_rows(void *arg, const char *data, size_t size) {
+    board_print_t *p = arg;
+    output_t *out = &p->sh->scratch;
+    while (size > 0) {
+        if (out->capacity - out->length < SERVER_PREFIX) {
+            reply_t reply = {.c = p->r->c, .line_number = p->r->line_number,
+                             .more = true};
+            if (!take_text(p->sh, &reply)) {
+                return false;
+            }
+            /* Wątek główny wypisuje kawałki, zanim wątek skończy wydruk. */
+            push_reply(p->sh, &reply);
+            ring_wake(&p->sh->server->notify);
+        }
+        if (p->row_start) {
+            output_uint(out, p->r->id);
+            output_char(out, ' ');
+        }
+        const char *end = memchr(data, '\n', size);
+        size_t length = end != NULL ? (size_t) (end - data + 1) : size;
+        if (length > out->capacity - out->length) {
+            length = out->capacity - out->length;
+        }
+        output_write(out, data, length);
+        p->row_start = data[length - 1] == '\n';
+        data += length;
+        size -= length;
+    }
+    return true;
+}
+
+static bool print_board(shard_t *sh, const request_t *r, gamma_t *g) {
+    board_print_t p = {sh, r, true};
+    return gamma_board_write(g, print_rows, &p);
+}
+
+static gamma_t *take_game(shard_t *sh, const uint32_t *args) {
+    if (sh->spare_count > 0) {
+        gamma_t *g = sh->spare[--sh->spare_count];
+        if (gamma_reset(g, args[0], args[1], args[2], args[3])) {
+            return g;
+        }
+        gamma_delete(g);
+    }
+    return gamma_new(args[0], args[1], args[2], args[3]);
+}
+
+static void release_game(shard_t *sh, gamma_t *g) {
+    if (sh->spare_count < SERVER_SPARE) {
+        sh->spare[sh->spare_count++] = g;
+    } else {
+        gamma_delete(g);
+    }
+}
+
+static bool serve_command(shard_t *sh, const request_t *r) {
+    output_t *out = &sh->scratch;
+    uint32_t id = r->id;
+    const command_t *cmd = &r->cmd;
+    if (id >= SERVER_GAMES) {
+        return false;
+    }
+    game_t *game = &sh->server->games[id];
+    if (cmd->kind == 'B') {
+        if (game->g != NULL) {
+            return false;
+        }
+        game->g = take_game(sh, cmd->args);
+        if (game->g == NULL) {
+            return false;
+        }
+        game->commands = 0;
+        game->created = playout_now();
+        ++sh->games;
+    } else if (game->g == NULL) {
+        return false;
+    } else if (cmd->kind == 'd') {
+        release_game(sh, game->g);
+        game->g = NULL;
+        --sh->games;
+    } else if (cmd->kind == 's') {
+        output_uint(out, id);
+        output_char(out, ' ');
+        output_uint(out, game->commands);
+        output_char(out, ' ');
+        output_uint(out, (playout_now() - game->created) * MICROSECONDS);
+        output_char(out, '\n');
+        return true;
+    } else if (strchr("mgbfqpA", cmd->kind) != NULL) {
+        ++game->commands;
+        ++sh->commands;
+        if (cmd->kind == 'p') {
+            return print_board(sh, r, game->g);
+        }
+        output_uint(out, id);
+        output_char(out, ' ');
+        /* Przeszukiwanie zajmuje tylko wątek gry, aby nie wstrzymywać
+         * gier pozostałych wątków. */
+        return command_execute(game->g, cmd, out, 1);
+    } else {
+        return false;
+    }
+    output_uint(out, id);
+    output_write(out, " OK\n", 4);
+    return true;
+}
+
+static void execute(shard_t *sh, const request_t *r) {
+    reply_t reply = {.c = r->c, .line_number = r->line_number};
+    if (r->totals != NULL) {
+        reply.totals = r->totals;
+        reply.games = sh->games;
+        reply.commands = sh->commands;
+    } else {
+        sh->scratch.length = 0;
+        reply.error = !serve_command(sh, r) || !take_text(sh, &reply);
+    }
+    push_reply(sh, &reply);
+}
+
+static void *shard_run(void *arg) {
+    shard_t *sh = arg;
+    request_t r;
+    for (;;) {
+        bool any = false;
+        while (ring_pop(&sh->requests, &r)) {
+            execute(sh, &r);
+            any = true;
+        }
+        if (any) {
+            ring_wake(&sh->server->notify);
+        }
+        ring_prepare_sleep(&sh->waker);
+        if (!ring_empty(&sh->requests)) {
+            ring_cancel_sleep(&sh->waker);
+            continue;
+        }
+        if (atomic_load(&sh->stop) || !ring_sleep(&sh->waker)) {
+            return NULL;
+        }
+    }
+}
+
+static void dispatch(server_t *s, const request_t *r) {
+    shard_t *sh = &s->shards[r->id % s->shard_count];
+    sh->pending = true;
+    while (!ring_push(&sh->requests, r)) {
+        wake_shards(s);
+        collect(s);
+        sh->pending = true;
+        sched_yield();
+    }
+    ++r->c->inflight;
+}
+
+static void dispatch_totals(server_t *s, connection_t *c) {
+    totals_t *totals = malloc(sizeof(totals_t));
+    if (totals == NULL) {
+        reply_error(c, c->line_number);
+        return;
+    }
+    totals->waiting = s->shard_count;
+    totals->games = 0;
+    totals->commands = 0;
+    request_t r = {.c = c, .line_number = c->line_number, .totals = totals};
+    for (uint32_t i = 0; i < s->shard_count; ++i) {
+        r.id = i;
+        dispatch(s, &r);
+    }
+}
+
+static void add_totals(server_t *s, const reply_t *reply) {
+    totals_t *totals = reply->totals;
+    totals->games += reply->games;
+    totals->commands += reply->commands;
+    if (--totals->waiting > 0) {
+        return;
+    }
+    output_t *out = &reply->c->out;
+    output_uint(out, totals->games);
+    output_char(out, ' ');
+    output_uint(out, totals->commands);
+    output_char(out, ' ');
+    output_uint(out, (playout_now() - s->started) * MICROSECONDS);
+    output_char(out, '\n');
+    free(totals);
+}
+
+static void wake_shards(server_t *s) {
+    for (uint32_t i = 0; i < s->shard_count; ++i) {
+        shard_t *sh = &s->shards[i];
+        if (sh->pending) {
+            ring_wake(&sh->waker);
+        }
+        sh->pending = false;
+    }
+}
+
+static void collect(server_t *s) {
+    reply_t reply;
+    for (uint32_t i = 0; i < s->shard_count; ++i) {
+        while (ring_pop(&s->shards[i].replies, &reply)) {
+            connection_t *c = reply.c;
+            if (reply.totals != NULL) {
+                add_totals(s, &reply);
+            } else if (reply.error) {
+                reply_error(c, reply.line_number);
+            } else if (reply.text != NULL) {
+                output_write(&c->out, reply.text, reply.length);
+                free(reply.text);
+            } else {
+                output_write(&c->out, reply.inline_text, reply.length);
+            }
+            if (!reply.more) {
+                --c->inflight;
+            }
+            mark(s, c);
+        }
+    }
+}
+
+static bool may_sleep(server_t *s) {
+    ring_prepare_sleep(&s->notify);
+    for (uint32_t i = 0; i < s->shard_count; ++i) {
+        if (!ring_empty(&s->shards[i].replies)) {
+            ring_cancel_sleep(&s->notify);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void mark(server_t *s, connection_t *c) {
+    if (!c->dirty) {
+        c->dirty = true;
+        c->next = s->dirty;
+        s->dirty = c;
+    }
+}
+
+static void settle(server_t *s, int epoll) {
+    while (s->dirty != NULL) {
+        connection_t *c = s->dirty;
+        s->dirty = c->next;
+        c->dirty = false;
+        if (c->out.length > 0) {
+            output_flush(&c->out);
+        }
+        uint32_t wanted = c->out.length > 0 ? EPOLLOUT : 0;
+        if (!c->in.eof && c->out.length <= SERVER_PENDING) {
+            wanted |= EPOLLIN;
+        }
+        if (epoll != -1 && wanted != c->events) {
+            watch(epoll, c, wanted);
+        }
+        if (wanted == 0 && c->inflight == 0) {
+            s->done |= c->console;
+            connection_free(c);
+        }
+    }
+}
+
+static void serve_line(server_t *s, connection_t *c, const char *line,
+                       size_t size) {
+    ++c->line_number;
+    if (size > 0 && (line[0] == '\n' || line[0] == '#')) {
+        return;
+    }
+    if (size == 2 && line[0] == 's' && line[1] == '\n') {
+        dispatch_totals(s, c);
+        return;
+    }
+
+    size_t i = 0;
+    uint64_t id = 0;
+    while (i < size && line[i] >= '0' && line[i] <= '9' && id <= UINT32_MAX) {
+        id = id * 10 + (line[i++] - '0');
+    }
+    if (i == 0 || i == size || id > UINT32_MAX || !command_space(line[i])) {
+        reply_error(c, c->line_number);
+        return;
+    }
+    while (i < size && command_space(line[i])) {
+        ++i;
+    }
+    request_t r = {.c = c, .id = id, .line_number = c->line_number};
+    if (command_parse(line + i, size - i, &r.cmd) != COMMAND_OK) {
+        reply_error(c, c->line_number);
+    } else {
+        dispatch(s, &r);
+    }
+}
+
+static void serve_lines(server_t *s, connection_t *c) {
+    const char *line;
+    size_t size;
+    while (input_next(&c->in, &line, &size)) {
+        serve_line(s, c, line, size);
+    }
+}
+
+static void serve_to_end(server_t *s, connection_t *c) {
+    const char *line;
+    size_t size;
+    for (uint32_t n = 1; input_line(&c->in, &line, &size); ++n) {
+        serve_line(s, c, line, size);
+        if (n % SERVER_BATCH == 0) {
+            wake_shards(s);
+            collect(s);
+        }
+    }
+    wake_shards(s);
+    mark(s, c);
+    while (!s->done) {
+        collect(s);
+        settle(s, -1);
+        if (!s->done && may_sleep(s) && !ring_sleep(&s->notify)) {
+            return;
+        }
+    }
+}
+
+static int listen_on(const char *path) {
+    struct sockaddr_un addr;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1) {
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) == -1 ||
+        listen(fd, SERVER_BACKLOG) == -1) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void watch(int epoll, connection_t *c, uint32_t events) {
+    struct epoll_event event = {.events = events, .data.ptr = c};
+    if (events == 0) {
+        epoll_ctl(epoll, EPOLL_CTL_DEL, c->fd, NULL);
+        c->watched = false;
+    } else if (!c->watched) {
+        c->watched = epoll_ctl(epoll, EPOLL_CTL_ADD, c->fd, &event) == 0;
+    } else {
+        epoll_ctl(epoll, EPOLL_CTL_MOD, c->fd, &event);
+    }
+    c->events = events;
+}
+
+static void accept_connection(int epoll, int listener) {
+    int fd = accept(listener, NULL, NULL);
+    if (fd == -1) {
+        return;
+    }
+    connection_t *c = connection_new(fd, fd, false);
+    if (c == NULL) {
+        close(fd);
+        return;
+    }
+    if (fcntl(fd, F_SETFL, O_NONBLOCK) != -1) {
+        watch(epoll, c, EPOLLIN);
+    }
+    if (!c->watched) {
+        connection_free(c);
+    }
+}
+
+static void event_loop(server_t *s, int epoll, int listener) {
+    struct epoll_event events[SERVER_EVENTS];
+    while (!s->done) {
+        int n = epoll_wait(epoll, events, SERVER_EVENTS, may_sleep(s) ? -1 : 0);
+        ring_cancel_sleep(&s->notify);
+        if (n == -1 && errno != EINTR) {
+            return;
+        }
+        for (int i = 0; i < n; ++i) {
+            void *ptr = events[i].data.ptr;
+            if (ptr == NULL) {
+                accept_connection(epoll, listener);
+                continue;
+            }
+            if (ptr == &s->notify) {
+                /* Epoll zgłosił niezerowy licznik, więc odczyt nie czeka. */
+                ring_wait(s->notify.fd);
+                continue;
+            }
+            connection_t *c = ptr;
+            if ((events[i].events & ~EPOLLOUT) != 0 && !c->in.eof &&
+                c->out.length <= SERVER_PENDING &&
+                (input_fill(&c->in) || c->in.eof)) {
+                const char *line;
+                size_t size;
+                serve_lines(s, c);
+                /* Na końcu wejścia zostaje najwyżej niepełny wiersz. */
+                if (c->in.eof && input_line(&c->in, &line, &size)) {
+                    serve_line(s, c, line, size);
+                }
+            }
+            mark(s, c);
+        }
+        wake_shards(s);
+        collect(s);
+        settle(s, epoll);
+    }
+}
+
+static bool start_shards(server_t *s) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t count = cpus > 0 ? (uint32_t) cpus : 1;
+    if (count > SERVER_MAX_SHARDS) {
+        count = SERVER_MAX_SHARDS;
+    }
+    s->shards = calloc(count, sizeof(shard_t));
+    if (s->shards == NULL) {
+        return false;
+    }
+    s->shard_count = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        shard_t *sh = &s->shards[i];
+        atomic_init(&sh->stop, false);
+        sh->games = 0;
+        sh->commands = 0;
+        sh->pending = false;
+        sh->spare_count = 0;
+        sh->server = s;
+        if (!ring_init(&sh->requests, sizeof(request_t), SERVER_QUEUE)) {
+            break;
+        }
+        if (!ring_init(&sh->replies, sizeof(reply_t), SERVER_QUEUE)) {
+            ring_free(&sh->requests);
+            break;
+        }
+        output_init(&sh->scratch, OUTPUT_MEMORY, SERVER_CHUNK);
+        bool waker = ring_waker_init(&sh->waker);
+        if (sh->scratch.capacity == 0 || !waker ||
+            pthread_create(&sh->thread, NULL, shard_run, sh) != 0) {
+            ring_waker_free(&sh->waker);
+            output_free(&sh->scratch);
+            ring_free(&sh->replies);
+            ring_free(&sh->requests);
+            break;
+        }
+        ++s->shard_count;
+    }
+    if (s->shard_count == 0) {
+        free(s->shards);
+        return false;
+    }
+    return true;
+}
+
+static void stop_shards(server_t *s) {
+    for (uint32_t i = 0; i < s->shard_count; ++i) {
+        shard_t *sh = &s->shards[i];
+        atomic_store(&sh->stop, true);
+        ring_kick(sh->waker.fd);
+        pthread_join(sh->thread, NULL);
+        for (uint32_t j = 0; j < sh->spare_count; ++j) {
+            gamma_delete(sh->spare[j]);
+        }
+        ring_waker_free(&sh->waker);
+        output_free(&sh->scratch);
+        ring_free(&sh->replies);
+        ring_free(&sh->requests);
+    }
+    free(s->shards);
+}
+
+int server_run(const char *path) {
+    server_t s;
+    s.games = calloc(SERVER_GAMES, sizeof(game_t));
+    bool notify = ring_waker_init(&s.notify);
+    s.dirty = NULL;
+    s.done = false;
+    s.started = playout_now();
+    if (s.games == NULL || !notify || !start_shards(&s)) {
+        ring_waker_free(&s.notify);
+        free(s.games);
+        return EXIT_FAILURE;
+    }
+
+    int status = EXIT_SUCCESS;
+    int epoll = epoll_create1(0);
+    struct epoll_event event = {.events = EPOLLIN, .data.ptr = &s.notify};
+    if (epoll == -1 ||
+        epoll_ctl(epoll, EPOLL_CTL_ADD, s.notify.fd, &event) == -1) {
+        status = EXIT_FAILURE;
+    } else if (path != NULL) {
+        /* Rozłączony klient nie może zakończyć procesu sygnałem. */
+        struct sigaction action = {.sa_handler = SIG_IGN};
+        sigaction(SIGPIPE, &action, NULL);
+        int listener = listen_on(path);
+        event.data.ptr = NULL;
+        if (listener == -1 ||
+            epoll_ctl(epoll, EPOLL_CTL_ADD, listener, &event) == -1) {
+            fprintf(stderr, "Nie można nasłuchiwać na gnieździe %s.\n", path);
+            status = EXIT_FAILURE;
+        } else {
+            event_loop(&s, epoll, listener);
+        }
+        if (listener != -1) {
+            close(listener);
+        }
+    } else {
+        connection_t *console = connection_new(STDIN_FILENO, STDOUT_FILENO,
+                                               true);
+        if (console == NULL) {
+            status = EXIT_FAILURE;
+        } else {
+            watch(epoll, console, EPOLLIN);
+            if (console->watched) {
+                event_loop(&s, epoll, -1);
+            } else {
+                /* Zwykłego pliku nie da się obserwować przez epoll, ale
+                 * odczyt z niego nigdy nie czeka. */
+                serve_to_end(&s, console);
+            }
+        }
+    }
+
+    if (epoll != -1) {
+        close(epoll);
+    }
+    stop_shards(&s);
+    ring_waker_free(&s.notify);
+    for (uint32_t i = 0; i < SERVER_GAMES; ++i) {
+        gamma_delete(s.games[i].g);
+    }
+    free(s.games);
+    return status;
+}
@@ -0,0 +1,47 @@
+/** @file
+ * Interfejs serwera prowadzącego wiele gier gamma naraz.
+ *
+ * Każdy wiersz wejścia zaczyna się numerem gry, po którym następuje
+ * polecenie:
+ * - @p id @p B @p width @p height @p players @p areas – tworzy grę,
+ * - @p id @p m, @p g, @p b, @p f, @p q, @p p, @p A – polecenia gry takie
+ *   jak w trybie wsadowym,
+ * - @p id @p s – wypisuje liczniki gry,
+ * - @p id @p d – usuwa grę.
+ * Wiersz @p s bez numeru gry wypisuje liczniki wszystkich gier. Każdy
+ * wiersz odpowiedzi zaczyna się numerem gry, a po nim jest wynik taki jak
+ * w trybie wsadowym albo @p OK po utworzeniu i usunięciu gry. Liczniki to
+ * liczba wykonanych poleceń i czas w mikrosekundach od utworzenia gry lub
+ * od startu serwera, a liczniki wszystkich gier poprzedza jeszcze liczba
+ * gier. Wiersze komentarzy i puste są pomijane, a niepoprawne są zgłaszane
+ * wierszem @p ERROR z numerem wiersza połączenia.
+ *
+ * Gry są rozdzielone między wątki robocze, po jednym na procesor. Polecenia
+ * jednej gry są wykonywane i potwierdzane w kolejności nadejścia, ale
+ * odpowiedzi dla różnych gier i błędy mogą przyjść w innej kolejności niż
+ * polecenia. Liczniki wszystkich gier obejmują wszystkie polecenia wysłane
+ * tym samym połączeniem przed zapytaniem o nie. Polecenie @p A przeszukuje
+ * drzewo gry tylko w wątku roboczym gry, więc wstrzymuje najwyżej gry tego
+ * wątku.
+ *
+ * @author Marcin Malejky
+ */
+
+#ifndef GAMMA_SERVER_H
+#define GAMMA_SERVER_H
+
+#define SERVER_GAMES 65536 /**< Liczba miejsc na gry, numery są mniejsze. */
+
+/** @brief Uruchamia serwer.
+ * Bez ścieżki serwer czyta polecenia ze standardowego wejścia, wypisuje
+ * odpowiedzi na standardowe wyjście, a błędy na standardowe wyjście
+ * diagnostyczne i kończy pracę na końcu wejścia. Ze ścieżką serwer
+ * nasłuchuje na gnieździe uniksowym i obsługuje wiele połączeń, odsyłając
+ * odpowiedzi i błędy tym samym połączeniem, aż do zakończenia procesu.
+ * Wszystkie połączenia mają dostęp do wszystkich gier.
+ * @param[in] path – ścieżka gniazda lub NULL,
+ * @return Kod wykonania programu.
+ */
+int server_run(const char *path);
+
+#endif //GAMMA_SERVER_H
@@ -0,0 +1,318 @@
+/** @file
+ * Implementacja sprawdzania, czy usunięcie pola rozspójnia obszar gracza.
+ *
+ * @author Marcin Malejky
+ */
+
+#include <stdlib.h>
+#include "gamma.h"
+#include "split.h"
+
+#define RING_SIZE 8 /**< Liczba pól otaczających pole. */
+#define INITIAL_CAPACITY 64 /**< Początkowa pojemność kolejki grupy. */
+
+/** @brief Podaje przesunięcia numeru pola do pól otaczających pole.
+ * Przesunięcia są podane w kolejności obiegu, a pola o parzystych indeksach
+ * sąsiadują z polem bokiem.
+ * @param[in] b     – wskaźnik na planszę,
+ * @param[out] ring – tablica przesunięć o długości @ref RING_SIZE.
+ */
+static void ring_offsets(const board_t *b, uint32_t *ring);
+
+/** @brief Rezerwuje nowe znaczniki odwiedzenia.
+ * Oznacza usuwane pole @p field, aby przeszukiwanie je omijało, i ustala
+ * znacznik pierwszej grupy.
+ * @param[in,out] s – wskaźnik na stan,
+ * @param[in] fields – liczba pól planszy razem z ramką,
+ * @param[in] field  – numer usuwanego pola,
+ * @return Wartość @p false, gdy nie udało się zaalokować pamięci.
+ */
+static bool next_epoch(split_t *s, uint64_t fields, uint32_t field);
+
+/** @brief Podaje znacznik odwiedzenia pola.
+ * @param[in] s     – wskaźnik na stan,
+ * @param[in] field – numer pola,
+ * @return Znacznik odwiedzenia pola.
+ */
+static uint32_t mark_of(const split_t *s, uint32_t field);
+
+/** @brief Ustawia znacznik odwiedzenia pola.
+ * @param[in,out] s – wskaźnik na stan,
+ * @param[in] field – numer pola,
+ * @param[in] mark  – znacznik,
+ * @return Wartość @p false, gdy nie udało się zaalokować pamięci.
+ */
+static bool set_mark(split_t *s, uint32_t field, uint32_t mark);
+
+/** @brief Dodaje pole do kolejki grupy i oznacza je jako odwiedzone.
+ * @param[in,out] s – wskaźnik na stan,
+ * @param[in] group – numer grupy,
+ * @param[in] field – numer pola,
+ * @return Wartość @p false, gdy nie udało się zaalokować pamięci.
+ */
+static bool push(split_t *s, uint32_t group, uint32_t field);
+
+/** @brief Podaje reprezentanta grupy wśród połączonych grup.
+ * @param[in] s     – wskaźnik na stan,
+ * @param[in] group – numer grupy,
+ * @return Numer reprezentanta.
+ */
+static uint32_t find(split_t *s, uint32_t group);
+
+/** @brief Liczy połączone grupy.
+ * @param[in] s            – wskaźnik na stan,
+ * @param[out] unfinished  – liczba grup z nierozwiniętymi polami,
+ * @param[out] open        – reprezentant pewnej grupy z nierozwiniętymi polami,
+ * @return Liczba połączonych grup.
+ */
+static uint32_t count_sets(split_t *s, uint32_t *unfinished, uint32_t *open);
+
+bool split_init(split_t *s, uint64_t fields, bool sparse) {
+    s->visit = NULL;
+    s->marks.keys = NULL;
+    s->marks.values = NULL;
+    bool ok = sparse ? fieldmap_init(&s->marks)
+                     : (s->visit = calloc(fields, sizeof(uint32_t))) != NULL;
+    for (uint32_t i = 0; i < SPLIT_MAX_PARTS; ++i) {
+        s->queue[i] = malloc(sizeof(uint32_t) * INITIAL_CAPACITY);
+        s->capacity[i] = INITIAL_CAPACITY;
+    }
+    s->epoch = 0;
+    s->groups = 0;
+    for (uint32_t i = 0; i < SPLIT_MAX_PARTS; ++i) {
+        ok = ok && s->queue[i] != NULL;
+    }
+    if (!ok) {
+        split_free(s);
+    }
+    return ok;
+}
+
+void split_free(split_t *s) {
+    free(s->visit);
+    s->visit = NULL;
+    fieldmap_free(&s->marks);
+    for (uint32_t i = 0; i < SPLIT_MAX_PARTS; ++i) {
+        free(s->queue[i]);
+        s->queue[i] = NULL;
+    }
+}
+
+static void ring_offsets(const board_t *b, uint32_t *ring) {
+    ring[0] = 1;
+    ring[1] = b->stride + 1;
+    ring[2] = b->stride;
+    ring[3] = b->stride - 1;
+    ring[4] = UINT32_MAX;
+    ring[5] = -b->stride - 1;
+    ring[6] = -b->stride;
+    ring[7] = -b->stride + 1;
+}
+
+static bool next_epoch(split_t *s, uint64_t fields, uint32_t field) {
+    if (s->epoch > UINT32_MAX - SPLIT_MAX_PARTS - 1) {
+        if (s->visit) {
+            for (uint64_t i = 0; i < fields; ++i) {
+                s->visit[i] = 0;
+            }
+        } else {
+            fieldmap_clear(&s->marks);
+        }
+        s->epoch = 0;
+    }
+    s->base = s->epoch + 2;
+    s->epoch += SPLIT_MAX_PARTS + 1;
+    return set_mark(s, field, s->base - 1);
+}
+
+static uint32_t mark_of(const split_t *s, uint32_t field) {
+    return s->visit ? s->visit[field] : fieldmap_get(&s->marks, field);
+}
+
+static bool set_mark(split_t *s, uint32_t field, uint32_t mark) {
+    if (s->visit) {
+        s->visit[field] = mark;
+    } else if (!fieldmap_reserve(&s->marks, 1)) {
+        return false;
+    } else {
+        fieldmap_set(&s->marks, field, mark);
+    }
+    return true;
+}
+
+static bool push(split_t *s, uint32_t group, uint32_t field) {
+    if (s->length[group] == s->capacity[group]) {
+        uint32_t *queue = realloc(s->queue[group],
+                                  sizeof(uint32_t) * 2 * s->capacity[group]);
+        if (!queue) {
+            return false;
+        }
+        s->queue[group] = queue;
+        s->capacity[group] *= 2;
+    }
+    if (!set_mark(s, field, s->base + group)) {
+        return false;
+    }
+    s->queue[group][(s->length[group])++] = field;
+    return true;
+}
+
+static uint32_t find(split_t *s, uint32_t group) {
+    while (s->set[group] != group) {
+        group = s->set[group];
+    }
+    return group;
+}
+
+static uint32_t count_sets(split_t *s, uint32_t *unfinished, uint32_t *open) {
+    uint32_t sets = 0;
+    *unfinished = 0;
+    for (uint32_t i = 0; i < s->groups; ++i) {
+        if (find(s, i) != i) {
+            continue;
+        }
+        ++sets;
+        for (uint32_t j = 0; j < s->groups; ++j) {
+            if (find(s, j) == i && s->head[j] < s->length[j]) {
+                ++(*unfinished);
+                *open = i;
+                break;
+            }
+        }
+    }
+    return sets;
+}
+
+bool split_check(gamma_t *g, uint32_t field, uint32_t *pieces) {
+    split_t *s = &g->split;
+    board_t *b = &g->board;
+    uint32_t player = board_owner(b, field);
+    uint32_t offsets[RING_SIZE];
+    ring_offsets(b, offsets);
+    bool ring[RING_SIZE];
+    uint32_t start = RING_SIZE;
+    for (uint32_t i = 0; i < RING_SIZE; ++i) {
+        ring[i] = board_owner(b, field + offsets[i]) == player;
+        if (!ring[i] && start == RING_SIZE) {
+            start = i;
+        }
+    }
+    s->groups = 0;
+    if (start == RING_SIZE) {
+        *pieces = 1;
+        return true;
+    }
+
+    /* Sąsiedzi połączeni przez otaczające pola tworzą jedną grupę. */
+    uint32_t seeds[SPLIT_MAX_PARTS];
+    bool seeded = false;
+    for (uint32_t k = 1; k <= RING_SIZE; ++k) {
+        uint32_t i = (start + k) % RING_SIZE;
+        if (!ring[i]) {
+            seeded = false;
+        } else if (i % 2 == 0 && !seeded) {
+            seeds[(s->groups)++] = field + offsets[i];
+            seeded = true;
+        }
+    }
+    if (s->groups <= 1) {
+        *pieces = s->groups;
+        s->groups = 0;
+        return true;
+    }
+
+    if (!next_epoch(s, b->size, field)) {
+        s->groups = 0;
+        return false;
+    }
+    for (uint32_t i = 0; i < s->groups; ++i) {
+        s->set[i] = i;
+        s->head[i] = 0;
+        s->length[i] = 0;
+        if (!push(s, i, seeds[i])) {
+            s->groups = 0;
+            return false;
+        }
+    }
+    uint32_t unfinished;
+    uint32_t open = 0;
+    uint32_t sets = count_sets(s, &unfinished, &open);
+    while (unfinished > 1) {
+        for (uint32_t i = 0; i < s->groups; ++i) {
+            if (s->head[i] == s->length[i]) {
+                continue;
+            }
+            uint32_t current = s->queue[i][(s->head[i])++];
+            for (uint32_t j = 0; j < BOARD_SIDES; ++j) {
+                uint32_t neighbour = current + b->side[j];
+                if (board_owner(b, neighbour) != player) {
+                    continue;
+                }
+                uint32_t mark = mark_of(s, neighbour);
+                if (mark < s->base - 1) {
+                    if (!push(s, i, neighbour)) {
+                        s->groups = 0;
+                        return false;
+                    }
+                } else if (mark >= s->base) {
+                    uint32_t root = find(s, i);
+                    s->set[find(s, mark - s->base)] = root;
+                }
+            }
+        }
+        sets = count_sets(s, &unfinished, &open);
+    }
+
+    if (unfinished == 1) {
+        s->keep = open;
+    } else {
+        /* Wszystkie części zostały przeszukane, zostaje największa. */
+        uint64_t best = 0;
+        for (uint32_t i = 0; i < s->groups; ++i) {
+            uint64_t size = 0;
+            for (uint32_t j = 0; j < s->groups; ++j) {
+                if (find(s, j) == i) {
+                    size += s->length[j];
+                }
+            }
+            if (find(s, i) == i && size >= best) {
+                best = size;
+                s->keep = i;
+            }
+        }
+    }
+    *pieces = sets;
+    return true;
+}
+
+void split_cut_fields(split_t *s, uint32_t part,
+                      void (*visit)(void *arg, uint32_t field), void *arg) {
+    for (uint32_t i = 0; i < s->groups; ++i) {
+        if (find(s, i) != i || i == s->keep) {
+            continue;
+        }
+        if (part > 0) {
+            --part;
+            continue;
+        }
+        for (uint32_t j = 0; j < s->groups; ++j) {
+            if (find(s, j) != i) {
+                continue;
+            }
+            for (uint32_t k = 0; k < s->length[j]; ++k) {
+                visit(arg, s->queue[j][k]);
+            }
+        }
+        return;
+    }
+}
+
+uint64_t split_cut_size(split_t *s) {
+    uint64_t size = 0;
+    for (uint32_t j = 0; j < s->groups; ++j) {
+        if (find(s, j) != s->keep) {
+            size += s->length[j];
+        }
+    }
+    return size;
+}
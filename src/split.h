@@ -0,0 +1,92 @@
+/** @file
+ * Interfejs sprawdzania, czy usunięcie pola rozspójnia obszar gracza.
+ *
+ * @author Marcin Malejky
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "fieldmap.h"
+
+#ifndef GAMMA_SPLIT_H
+#define GAMMA_SPLIT_H
+
+#define SPLIT_MAX_PARTS 4 /**< Maksymalna liczba części po usunięciu pola. */
+
+struct gamma;
+
+/**
+ * Stan sprawdzania rozspójnienia obszaru.
+ * Po usunięciu pola jego sąsiedzi należący do tego samego gracza są dzieleni
+ * na grupy połączone lokalnie (przez pola otaczające usuwane pole). Z każdej
+ * grupy rusza przeszukiwanie wszerz, a przeszukiwania wykonują kroki na zmianę.
+ * Przeszukiwania, które się spotkają, są łączone. Sprawdzanie kończy się, gdy
+ * najwyżej jedno połączone przeszukiwanie ma jeszcze nieodwiedzone pola, więc
+ * koszt jest proporcjonalny do rozmiaru mniejszych części, a nie całego
+ * obszaru.
+ */
+typedef struct {
+    uint32_t *visit; /**< Znaczniki odwiedzenia pól planszy lub NULL. */
+    fieldmap_t marks; /**< Znaczniki odwiedzenia pól, gdy @p visit jest
+                        *  NULL. */
+    uint32_t epoch; /**< Ostatnio użyty znacznik odwiedzenia. */
+    uint32_t base; /**< Znacznik pierwszej grupy w ostatnim sprawdzaniu. */
+    uint32_t groups; /**< Liczba grup w ostatnim sprawdzaniu. */
+    uint32_t *queue[SPLIT_MAX_PARTS]; /**< Pola odwiedzone z danej grupy. */
+    uint32_t length[SPLIT_MAX_PARTS]; /**< Liczba pól w kolejce grupy. */
+    uint32_t head[SPLIT_MAX_PARTS]; /**< Pierwsze nierozwinięte pole grupy. */
+    uint32_t capacity[SPLIT_MAX_PARTS]; /**< Pojemność kolejki grupy. */
+    uint32_t set[SPLIT_MAX_PARTS]; /**< Rodzic grupy wśród łączonych grup. */
+    uint32_t keep; /**< Grupa, której część zachowuje dotychczasowy obszar. */
+} split_t;
+
+/** @brief Inicjalizuje stan sprawdzania dla planszy o @p fields polach.
+ * @param[out] s     – wskaźnik na stan,
+ * @param[in] fields – liczba pól planszy razem z ramką,
+ * @param[in] sparse – czy trzymać znaczniki tylko odwiedzonych pól zamiast
+ *                     tablicy wszystkich pól,
+ * @return Wartość @p true, jeśli pomyślnie zaalokowano pamięć, a @p false
+ * w przeciwnym przypadku.
+ */
+bool split_init(split_t *s, uint64_t fields, bool sparse);
+
+/** @brief Zwalnia pamięć stanu sprawdzania.
+ * @param[in,out] s – wskaźnik na stan.
+ */
+void split_free(split_t *s);
+
+/** @brief Podaje liczbę części, na które rozpadnie się obszar.
+ * Podaje liczbę różnych obszarów właściciela pola @p field sąsiadujących
+ * z tym polem, gdyby zostało ono usunięte. Najpierw sprawdza otoczenie pola,
+ * a przeszukuje planszę tylko, gdy sąsiedzi nie są połączeni lokalnie.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] field   – numer zajętego pola,
+ * @param[out] pieces – liczba części obszaru,
+ * @return Wartość @p true, jeśli się udało, a @p false, gdy nie udało się
+ * zaalokować pamięci.
+ */
+bool split_check(struct gamma *g, uint32_t field, uint32_t *pieces);
+
+/** @brief Podaje pola części odciętej przy ostatnim sprawdzaniu.
+ * Części są numerowane od zera, a ich liczba jest o jeden mniejsza od
+ * liczby części zwróconej przez ostatnie wywołanie @ref split_check.
+ * Pozostała część, zwykle największa, nie jest wymieniana, więc może
+ * zachować dotychczasowy obszar bez odwiedzania jej pól. Podawane pola są
+ * ważne do następnego wywołania @ref split_check.
+ * @param[in] s       – wskaźnik na stan,
+ * @param[in] part    – numer części,
+ * @param[in] visit   – funkcja wywoływana dla każdego pola części,
+ * @param[in,out] arg – argument przekazywany do funkcji @p visit.
+ */
+void split_cut_fields(split_t *s, uint32_t part,
+                      void (*visit)(void *arg, uint32_t field), void *arg);
+
+/** @brief Podaje łączną liczbę pól części odciętych przy ostatnim
+ * sprawdzaniu.
+ * @param[in] s – wskaźnik na stan,
+ * @return Liczba pól, które odwiedzi @ref split_cut_fields dla wszystkich
+ * części.
+ */
+uint64_t split_cut_size(split_t *s);
+
+#endif //GAMMA_SPLIT_H
@@ -0,0 +1,51 @@
+/** @file
+ * Klucze skrótu Zobrista pozycji gry.
+ * Klucze nie są trzymane w tablicy, bo tablica kluczy dla każdej pary pola
+ * i gracza byłaby wielokrotnie większa od planszy. Każdy klucz jest
+ * wyliczany funkcją mieszającą z numeru klucza, co kosztuje kilka mnożeń.
+ *
+ * @author Marcin Malejky
+ */
+
+#include <stdint.h>
+
+#ifndef GAMMA_ZOBRIST_H
+#define GAMMA_ZOBRIST_H
+
+#define ZOBRIST_OWNER 1 /**< Rodzaj klucza posiadacza pola. */
+#define ZOBRIST_GOLDEN 2 /**< Rodzaj klucza wykonanego złotego ruchu. */
+#define ZOBRIST_TURN 3 /**< Rodzaj klucza gracza na ruchu. */
+
+/** @brief Podaje klucz o danym rodzaju i numerze.
+ * Krok generatora splitmix64 dla stanu wyznaczonego przez rodzaj i numer.
+ * @param[in] kind  – rodzaj klucza,
+ * @param[in] index – numer klucza danego rodzaju,
+ * @return Pseudolosowy klucz.
+ */
+static inline uint64_t zobrist_key(uint64_t kind, uint64_t index) {
+    uint64_t z = kind * 0xD1B54A32D192ED03ULL +
+                 (index + 1) * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/** @brief Podaje klucz posiadacza pola.
+ * @param[in] width   – szerokość planszy,
+ * @param[in] players – liczba graczy,
+ * @param[in] x       – numer kolumny,
+ * @param[in] y       – numer wiersza,
+ * @param[in] owner   – numer posiadacza pola,
+ * @return Klucz, równy 0 dla pustego pola, więc skrót pustej planszy nie
+ * zależy od jej rozmiaru.
+ */
+static inline uint64_t zobrist_owner(uint32_t width, uint32_t players,
+                                     uint32_t x, uint32_t y, uint32_t owner) {
+    if (owner == 0) {
+        return 0;
+    }
+    uint64_t field = (uint64_t) y * width + x;
+    return zobrist_key(ZOBRIST_OWNER, field * players + owner - 1);
+}
+
+#endif //GAMMA_ZOBRIST_H